@@ -1,3 +1,14 @@
 "C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\simple_shader.vert -o shaders\simple_shader.vert.spv
 "C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\simple_shader.frag -o shaders\simple_shader.frag.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\indirect.vert -o shaders\indirect.vert.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\indirect.frag -o shaders\indirect.frag.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\cull.comp -o shaders\cull.comp.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\cull_compact.comp -o shaders\cull_compact.comp.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\hiz_reduce.comp -o shaders\hiz_reduce.comp.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\fullscreen.vert -o shaders\fullscreen.vert.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\shading_variants.frag -o shaders\shading_variants.frag.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\bindless_object.vert -o shaders\bindless_object.vert.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\bound_object.vert -o shaders\bound_object.vert.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\streamed_texture.vert -o shaders\streamed_texture.vert.spv
+"C:\VulkanSDK\1.3.261.1\Bin\glslc.exe" shaders\streamed_texture.frag -o shaders\streamed_texture.frag.spv
 pause
\ No newline at end of file
@@ -1,9 +1,165 @@
 #include "first_app.hpp"
 
-void lve::FirstApp::run()
+#include "lve_pipeline_registry.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+	const std::string VERT_FILEPATH = "shaders/simple_shader.vert.spv";
+	const std::string FRAG_FILEPATH = "shaders/simple_shader.frag.spv";
+}
+
+lve::FirstApp::FirstApp(LvePresentPolicy presentPolicy)
+{
+	createStartupStages(presentPolicy);
+	startup.run();
+}
+
+lve::FirstApp::~FirstApp()
+{
+	shaderHotReload.reset();
+	vkDestroyPipelineLayout(lveDevice->device(), pipelineLayout, nullptr);
+}
+
+void lve::FirstApp::createStartupStages(LvePresentPolicy presentPolicy)
 {
-	while (!lveWindow.shouldClose())
+	using Stage = LveStartup::Stage;
+
+	// GLFW wants its windows created on the main thread
+	Stage window = startup.addStage("window", {}, [this]() {
+		lveWindow = std::make_unique<LveWindow>(WIDTH, HEIGHT, "Hello Vulkan!");
+	}, true);
+	Stage compiler = startup.addStage("shader compiler", {}, [this]() {
+		shaderCompiler = std::make_unique<LveShaderCompiler>();
+		prefetchCompiler = shaderCompiler.get();
+	});
+
+	// SPIR-V is read, or compiled from a newer source, while the instance and device are created;
+	// the device owns the compiler by then, which outlives the prefetch
+	std::vector<Stage> shaderLoads;
+	for (const std::string& path : { VERT_FILEPATH, FRAG_FILEPATH })
+	{
+		shaderLoads.push_back(startup.addStage("load " + path, { compiler }, [this, path]() {
+			prefetchCompiler->prefetch(path);
+		}));
+	}
+	Stage device = startup.addStage("device", { window, compiler }, [this]() {
+		lveDevice = std::make_unique<LveDevice>(*lveWindow, std::move(shaderCompiler));
+	});
+
+	Stage layout = startup.addStage("pipeline layout", { device }, [this]() { createPipelineLayout(); });
+	// the surface and swap chain stay on the main thread with the window
+	Stage renderer = startup.addStage("swap chain", { device }, [this, presentPolicy]() {
+		lveRenderer = std::make_unique<LveRenderer>(*lveWindow, *lveDevice, presentPolicy);
+	}, true);
+	Stage hotReload = startup.addStage("shader hot reload", { device }, [this]() {
+		shaderHotReload = std::make_unique<LveShaderHotReload>(*lveDevice, LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+	});
+
+	// on the calling thread because it waits for the builds it fans out to the pool
+	std::vector<Stage> pipelineDependencies = shaderLoads;
+	pipelineDependencies.push_back(layout);
+	pipelineDependencies.push_back(renderer);
+	Stage pipelines = startup.addStage("pipelines", pipelineDependencies, [this]() { createPipeline(); }, true);
+	startup.addStage("watch shaders", { pipelines, hotReload }, [this]() { watchShaders(); });
+}
+
+void lve::FirstApp::run(uint32_t maxFrames)
+{
+	lveDevice->pipelineCache().printReport(std::cout);
+	// roughly once a minute at 60 fps
+	lveDevice->allocator().setPeriodicDump(&std::cout, 3600);
+
+	uint32_t frames = 0;
+	while (!lveWindow->shouldClose() && (maxFrames == 0 || frames < maxFrames))
 	{
 		glfwPollEvents();
+		// edited shaders are swapped in between frames
+		shaderHotReload->update(lveRenderer->submittedFrameCount());
+		// a surface format change replaced the render pass; the skipped frame recorded nothing
+		if (lveRenderer->wasRenderPassChanged())
+		{
+			pipelineRenderPass = lveRenderer->getSwapChainRenderPass();
+			shaderHotReload->rebuildAll(lveRenderer->submittedFrameCount());
+			lveRenderer->resetRenderPassChangedFlag();
+		}
+		lveDevice->allocator().update();
+
+		if (auto commandBuffer = lveRenderer->beginFrame())
+		{
+			{
+				LveProfileScope mainPass{ lveDevice->profiler(), commandBuffer, "main pass", true };
+				lveRenderer->beginSwapChainRenderPass(commandBuffer);
+				lvePipeline->bind(commandBuffer);
+				vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+				lveRenderer->endSwapChainRenderPass(commandBuffer);
+			}
+			lveRenderer->endFrame();
+
+			if (frames++ == 0)
+			{
+				timeToFirstFrame = startup.mark("first frame");
+				startup.printSummary(std::cout);
+				std::cout << "shaders taken from the startup prefetch: " << lveDevice->shaderCompiler().prefetchHitCount() << std::endl;
+				startup.writeChromeTrace(STARTUP_TRACE_PATH);
+			}
+		}
+	}
+
+	vkDeviceWaitIdle(lveDevice->device());
+	lveDevice->profiler().printAverages(std::cout);
+	lveDevice->allocator().dumpStats(std::cout);
+	lveDevice->pipelineRegistry().printStats(std::cout);
+
+	const LveResizeStats& resizeStats = lveRenderer->resizeStats();
+	if (resizeStats.measuredResizes > 0)
+	{
+		std::cout << "swap chain recreated " << resizeStats.recreateCount << " times, last took "
+			<< resizeStats.lastRecreateMilliseconds << " ms; resize to first frame: average "
+			<< resizeStats.totalLatencyMilliseconds / resizeStats.measuredResizes << " ms, max "
+			<< resizeStats.maxLatencyMilliseconds << " ms" << std::endl;
+	}
+}
+
+void lve::FirstApp::createPipelineLayout()
+{
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 0;
+	pipelineLayoutInfo.pSetLayouts = nullptr;
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+	if (vkCreatePipelineLayout(lveDevice->device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout!");
 	}
 }
+
+void lve::FirstApp::createPipeline()
+{
+	pipelineRenderPass = lveRenderer->getSwapChainRenderPass();
+	auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+	pipelineConfig.renderPass = pipelineRenderPass;
+	pipelineConfig.pipelineLayout = pipelineLayout;
+
+	// further pipelines join this batch and are built in parallel on the pool
+	std::vector<PipelineBuildDesc> descs{ { VERT_FILEPATH, FRAG_FILEPATH, pipelineConfig } };
+	lvePipeline = LvePipeline::createPipelines(*lveDevice, descs, threadPool)[0].get();
+}
+
+void lve::FirstApp::watchShaders()
+{
+	auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+	pipelineConfig.pipelineLayout = pipelineLayout;
+
+	// also rebuilds the pipeline through rebuildAll when the render pass is replaced
+	auto buildPipeline = [this, pipelineConfig]()
+	{
+		auto config = pipelineConfig;
+		config.renderPass = pipelineRenderPass;
+		return std::make_unique<LvePipeline>(*lveDevice, VERT_FILEPATH, FRAG_FILEPATH, config);
+	};
+	shaderHotReload->watch<LvePipeline>(lvePipeline, { VERT_FILEPATH, FRAG_FILEPATH }, buildPipeline);
+}
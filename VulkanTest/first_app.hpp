@@ -3,6 +3,14 @@
 #include "lve_window.hpp"
 #include "lve_pipeline.hpp"
 #include "lve_device.hpp"
+#include "lve_renderer.hpp"
+#include "lve_shader_hot_reload.hpp"
+#include "lve_startup.hpp"
+#include "lve_thread_pool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
 
 namespace lve
 {
@@ -11,11 +19,42 @@ namespace lve
 	public:
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		static constexpr const char* STARTUP_TRACE_PATH = "startup_trace.json";
+
+		// Runs the startup stages; see createStartupStages for what runs in parallel.
+		FirstApp(LvePresentPolicy presentPolicy = LvePresentPolicy::LowLatency);
+		~FirstApp();
+
+		FirstApp(const FirstApp&) = delete;
+		FirstApp& operator=(const FirstApp&) = delete;
+
+		// 0 runs until the window is closed
+		void run(uint32_t maxFrames = 0);
+		// from the start of the constructor to the first presented frame; 0 until then
+		double timeToFirstFrameMilliseconds() const { return timeToFirstFrame; }
 
-		void run();
 	private:
-		LveWindow lveWindow{ WIDTH, HEIGHT, "Hello Vulkan!" };
-		LveDevice lveDevice{ lveWindow };
-		LvePipeline lvePipeline{ lveDevice, "shaders/simple_shader.vert.spv", "shaders/simple_shader.frag.spv", LvePipeline::defaultPipelineConfigInfo(WIDTH, HEIGHT) };
+		void createStartupStages(LvePresentPolicy presentPolicy);
+		void createPipelineLayout();
+		void createPipeline();
+		void watchShaders();
+
+		LveThreadPool threadPool;
+		// before everything it times
+		LveStartup startup{ threadPool };
+		double timeToFirstFrame = 0.0;
+
+		// created by the startup stages, in dependency order rather than declaration order
+		std::unique_ptr<LveWindow> lveWindow;
+		std::unique_ptr<LveShaderCompiler> shaderCompiler;  // until the device takes it over
+		LveShaderCompiler* prefetchCompiler = nullptr;
+		std::unique_ptr<LveDevice> lveDevice;
+		std::unique_ptr<LveRenderer> lveRenderer;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		// what pipelines are built against; hot reload builds read it on the watcher thread
+		std::atomic<VkRenderPass> pipelineRenderPass{ VK_NULL_HANDLE };
+		std::unique_ptr<LvePipeline> lvePipeline;
+		// declared last: it swaps lvePipeline and must stop before the pipeline goes away
+		std::unique_ptr<LveShaderHotReload> shaderHotReload;
 	};
-}
\ No newline at end of file
+}
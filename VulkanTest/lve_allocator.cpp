@@ -0,0 +1,783 @@
+#include "lve_allocator.hpp"
+
+// std headers
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+// true when the last byte of [aOffset, aOffset + aSize) and bOffset fall on the same page
+static bool onSamePage(
+    VkDeviceSize aOffset, VkDeviceSize aSize, VkDeviceSize bOffset, VkDeviceSize pageSize) {
+  VkDeviceSize aEndPage = (aOffset + aSize - 1) / pageSize;
+  VkDeviceSize bStartPage = bOffset / pageSize;
+  return aEndPage == bStartPage;
+}
+
+const char *memoryCategoryName(LveMemoryCategory category) {
+  switch (category) {
+    case LveMemoryCategory::General:
+      return "general";
+    case LveMemoryCategory::Mesh:
+      return "mesh";
+    case LveMemoryCategory::Texture:
+      return "texture";
+    case LveMemoryCategory::Staging:
+      return "staging";
+    case LveMemoryCategory::Uniform:
+      return "uniform";
+    case LveMemoryCategory::RenderTarget:
+      return "render target";
+    case LveMemoryCategory::Indirect:
+      return "indirect";
+    default:
+      return "unknown";
+  }
+}
+
+LveAllocator::LveAllocator(
+    VkPhysicalDevice physicalDevice,
+    VkDevice device,
+    VkDeviceSize bufferImageGranularity,
+    VkDeviceSize preferredBlockSize,
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2)
+    : physicalDevice{physicalDevice},
+      device{device},
+      getMemoryProperties2{getMemoryProperties2},
+      granularity{std::max<VkDeviceSize>(bufferImageGranularity, 1)},
+      preferredBlockSize{preferredBlockSize} {
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+  heapUsage.resize(memoryProperties.memoryHeapCount);
+  typeUsage.resize(memoryProperties.memoryTypeCount);
+  heapOverBudget.resize(memoryProperties.memoryHeapCount, false);
+}
+
+LveAllocator::~LveAllocator() {
+  size_t leaked = 0;
+  for (auto &block : blocks) {
+    if (!block) continue;
+    for (auto &entry : block->allocations) {
+      delete entry.second;
+      leaked++;
+    }
+    vkFreeMemory(device, block->memory, nullptr);
+  }
+  if (leaked > 0) {
+    std::cerr << "allocator: " << leaked << " allocation(s) still live at shutdown" << std::endl;
+  }
+}
+
+uint32_t LveAllocator::findMemoryType(
+    uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) &&
+        (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+      return i;
+    }
+  }
+  throw std::runtime_error("failed to find suitable memory type!");
+}
+
+bool LveAllocator::conflicts(LveResourceKind a, LveResourceKind b) const {
+  // linear resources (buffers, linear images) must not share a page with optimal images
+  return granularity > 1 &&
+         ((a == LveResourceKind::OptimalImage) != (b == LveResourceKind::OptimalImage));
+}
+
+VkDeviceSize LveAllocator::blockSizeFor(uint32_t memoryTypeIndex) const {
+  uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+  VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+  // small heaps (e.g. the 256MB BAR window) get smaller blocks so one block cannot exhaust them
+  if (heapSize <= 1024ull * 1024 * 1024) {
+    return std::min(preferredBlockSize, heapSize / 8);
+  }
+  return preferredBlockSize;
+}
+
+bool LveAllocator::tryAllocate(
+    Block &block,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    LveResourceKind kind,
+    VkDeviceSize &outOffset) {
+  auto best = block.freeRanges.end();
+  VkDeviceSize bestOffset = 0;
+  VkDeviceSize bestWaste = std::numeric_limits<VkDeviceSize>::max();
+
+  for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+    VkDeviceSize rangeStart = it->first;
+    VkDeviceSize rangeEnd = it->first + it->second;
+    if (it->second < size) continue;
+
+    VkDeviceSize offset = alignUp(rangeStart, alignment);
+    auto next = block.allocations.lower_bound(rangeStart);
+    if (next != block.allocations.begin()) {
+      const LveAllocation *prev = std::prev(next)->second;
+      if (conflicts(prev->kind, kind) &&
+          onSamePage(prev->offset, prev->size, offset, granularity)) {
+        offset = alignUp(offset, granularity);
+      }
+    }
+    if (offset + size > rangeEnd) continue;
+    if (next != block.allocations.end() && conflicts(next->second->kind, kind) &&
+        onSamePage(offset, size, next->first, granularity)) {
+      continue;
+    }
+
+    // best fit keeps large ranges intact for large requests
+    VkDeviceSize waste = it->second - size;
+    if (waste < bestWaste) {
+      best = it;
+      bestOffset = offset;
+      bestWaste = waste;
+      if (waste == 0) break;
+    }
+  }
+
+  if (best == block.freeRanges.end()) {
+    return false;
+  }
+
+  VkDeviceSize rangeStart = best->first;
+  VkDeviceSize rangeEnd = best->first + best->second;
+  block.freeRanges.erase(best);
+  if (bestOffset > rangeStart) {
+    block.freeRanges[rangeStart] = bestOffset - rangeStart;
+  }
+  if (bestOffset + size < rangeEnd) {
+    block.freeRanges[bestOffset + size] = rangeEnd - (bestOffset + size);
+  }
+  outOffset = bestOffset;
+  return true;
+}
+
+void LveAllocator::releaseRange(Block &block, VkDeviceSize offset, VkDeviceSize size) {
+  auto next = block.freeRanges.lower_bound(offset);
+  if (next != block.freeRanges.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      block.freeRanges.erase(prev);
+    }
+  }
+  if (next != block.freeRanges.end() && offset + size == next->first) {
+    size += next->second;
+    block.freeRanges.erase(next);
+  }
+  block.freeRanges[offset] = size;
+}
+
+size_t LveAllocator::createBlock(
+    uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceSize minSize, bool dedicated) {
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  // under memory pressure fall back to smaller blocks rather than failing outright
+  for (;;) {
+    allocInfo.allocationSize = size;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) == VK_SUCCESS) break;
+    if (size / 2 < minSize) {
+      throw std::runtime_error("failed to allocate device memory block!");
+    }
+    size /= 2;
+  }
+
+  auto block = std::make_unique<Block>();
+  block->memory = memory;
+  block->size = size;
+  block->memoryTypeIndex = memoryTypeIndex;
+  block->dedicated = dedicated;
+  block->freeRanges[0] = size;
+
+  if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    void *data = nullptr;
+    if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+      vkFreeMemory(device, memory, nullptr);
+      throw std::runtime_error("failed to map device memory block!");
+    }
+    block->mapped = static_cast<char *>(data);
+  }
+
+  for (size_t i = 0; i < blocks.size(); i++) {
+    if (!blocks[i]) {
+      blocks[i] = std::move(block);
+      return i;
+    }
+  }
+  blocks.push_back(std::move(block));
+  return blocks.size() - 1;
+}
+
+void LveAllocator::destroyBlock(size_t blockIndex) {
+  vkFreeMemory(device, blocks[blockIndex]->memory, nullptr);
+  blocks[blockIndex].reset();
+}
+
+void LveAllocator::releaseEmptyBlocks(uint32_t memoryTypeIndex) {
+  // keep a single empty block around so alternating alloc/free does not thrash vkAllocateMemory
+  bool keptOne = false;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    const auto &block = blocks[i];
+    if (!block || block->dedicated || block->memoryTypeIndex != memoryTypeIndex ||
+        block->usedBytes > 0) {
+      continue;
+    }
+    if (!keptOne) {
+      keptOne = true;
+      continue;
+    }
+    destroyBlock(i);
+  }
+}
+
+LveAllocation *LveAllocator::allocateLocked(
+    const VkMemoryRequirements &requirements,
+    uint32_t memoryTypeIndex,
+    LveResourceKind kind,
+    LveMemoryCategory category) {
+  VkDeviceSize blockSize = blockSizeFor(memoryTypeIndex);
+  VkDeviceSize offset = 0;
+  size_t blockIndex = SIZE_MAX;
+
+  if (requirements.size > blockSize / 2) {
+    blockIndex = createBlock(memoryTypeIndex, requirements.size, requirements.size, true);
+    tryAllocate(*blocks[blockIndex], requirements.size, requirements.alignment, kind, offset);
+  } else {
+    for (size_t i = 0; i < blocks.size(); i++) {
+      const auto &block = blocks[i];
+      if (!block || block->dedicated || block->memoryTypeIndex != memoryTypeIndex) continue;
+      if (block->size - block->usedBytes < requirements.size) continue;
+      if (tryAllocate(*block, requirements.size, requirements.alignment, kind, offset)) {
+        blockIndex = i;
+        break;
+      }
+    }
+    if (blockIndex == SIZE_MAX) {
+      blockIndex = createBlock(memoryTypeIndex, blockSize, requirements.size, false);
+      if (!tryAllocate(*blocks[blockIndex], requirements.size, requirements.alignment, kind, offset)) {
+        throw std::runtime_error("failed to sub-allocate from a fresh memory block!");
+      }
+    }
+  }
+
+  Block &block = *blocks[blockIndex];
+  auto allocation = new LveAllocation{};
+  allocation->memory = block.memory;
+  allocation->offset = offset;
+  allocation->size = requirements.size;
+  allocation->memoryTypeIndex = memoryTypeIndex;
+  allocation->mapped = block.mapped ? block.mapped + offset : nullptr;
+  allocation->blockIndex = blockIndex;
+  allocation->kind = kind;
+  allocation->category = category;
+
+  block.allocations[offset] = allocation;
+  block.usedBytes += requirements.size;
+  trackLocked(category, memoryTypeIndex, requirements.size, true);
+  return allocation;
+}
+
+void LveAllocator::freeLocked(LveAllocation *allocation) {
+  size_t blockIndex = allocation->blockIndex;
+  Block &block = *blocks[blockIndex];
+  block.allocations.erase(allocation->offset);
+  releaseRange(block, allocation->offset, allocation->size);
+  block.usedBytes -= allocation->size;
+  uint32_t memoryTypeIndex = allocation->memoryTypeIndex;
+  trackLocked(allocation->category, memoryTypeIndex, allocation->size, false);
+  delete allocation;
+
+  if (block.dedicated) {
+    destroyBlock(blockIndex);
+  } else if (block.usedBytes == 0) {
+    releaseEmptyBlocks(memoryTypeIndex);
+  }
+}
+
+void LveAllocator::trackLocked(
+    LveMemoryCategory category, uint32_t memoryTypeIndex, VkDeviceSize size, bool allocated) {
+  uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+  uint32_t categoryIndex = static_cast<uint32_t>(category);
+  for (LveUsageCounter *counter :
+       {&heapUsage[heapIndex], &typeUsage[memoryTypeIndex], &categoryUsage[categoryIndex]}) {
+    if (allocated) {
+      counter->allocationCount++;
+      counter->currentBytes += size;
+      counter->peakBytes = std::max(counter->peakBytes, counter->currentBytes);
+    } else {
+      counter->allocationCount--;
+      counter->currentBytes -= size;
+    }
+  }
+
+  Threshold &threshold = thresholds[categoryIndex];
+  VkDeviceSize current = categoryUsage[categoryIndex].currentBytes;
+  if (threshold.bytes > 0 && (current > threshold.bytes) != threshold.exceeded) {
+    threshold.exceeded = !threshold.exceeded;
+    pendingCrossings.push_back(
+        {threshold.callback, category, current, threshold.bytes, threshold.exceeded});
+  }
+}
+
+void LveAllocator::notifyThresholds(std::vector<ThresholdCrossing> &crossings) {
+  for (auto &crossing : crossings) {
+    crossing.callback(
+        crossing.category,
+        crossing.currentBytes,
+        crossing.thresholdBytes,
+        crossing.exceeded);
+  }
+}
+
+LveAllocation *LveAllocator::allocate(
+    const VkMemoryRequirements &requirements,
+    uint32_t memoryTypeIndex,
+    LveResourceKind kind,
+    LveMemoryCategory category) {
+  LveAllocation *allocation;
+  std::vector<ThresholdCrossing> crossings;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    allocation = allocateLocked(requirements, memoryTypeIndex, kind, category);
+    crossings.swap(pendingCrossings);
+  }
+  notifyThresholds(crossings);
+  return allocation;
+}
+
+void LveAllocator::free(LveAllocation *allocation) {
+  if (allocation == nullptr) return;
+  std::vector<ThresholdCrossing> crossings;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    freeLocked(allocation);
+    crossings.swap(pendingCrossings);
+  }
+  notifyThresholds(crossings);
+}
+
+LveAllocation *LveAllocator::createBuffer(
+    const VkBufferCreateInfo &bufferInfo,
+    VkMemoryPropertyFlags properties,
+    VkBuffer &buffer,
+    LveMemoryCategory category) {
+  if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create buffer!");
+  }
+
+  VkMemoryRequirements memRequirements;
+  vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+  LveAllocation *allocation;
+  try {
+    allocation = allocate(
+        memRequirements,
+        findMemoryType(memRequirements.memoryTypeBits, properties),
+        LveResourceKind::Buffer,
+        category);
+  } catch (...) {
+    vkDestroyBuffer(device, buffer, nullptr);
+    buffer = VK_NULL_HANDLE;
+    throw;
+  }
+  if (vkBindBufferMemory(device, buffer, allocation->memory, allocation->offset) != VK_SUCCESS) {
+    destroyBuffer(buffer, allocation);
+    buffer = VK_NULL_HANDLE;
+    throw std::runtime_error("failed to bind buffer memory!");
+  }
+
+  // queue family lists are not retained, so concurrently shared buffers are never relocated
+  if (bufferInfo.sharingMode == VK_SHARING_MODE_EXCLUSIVE && bufferInfo.pNext == nullptr) {
+    allocation->buffer = buffer;
+    allocation->bufferInfo = bufferInfo;
+  }
+  return allocation;
+}
+
+LveAllocation *LveAllocator::createImage(
+    const VkImageCreateInfo &imageInfo,
+    VkMemoryPropertyFlags properties,
+    VkImage &image,
+    LveMemoryCategory category) {
+  if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create image!");
+  }
+
+  VkMemoryRequirements memRequirements;
+  vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+  LveResourceKind kind = imageInfo.tiling == VK_IMAGE_TILING_LINEAR
+                             ? LveResourceKind::LinearImage
+                             : LveResourceKind::OptimalImage;
+  LveAllocation *allocation;
+  try {
+    allocation = allocate(
+        memRequirements,
+        findMemoryType(memRequirements.memoryTypeBits, properties),
+        kind,
+        category);
+  } catch (...) {
+    vkDestroyImage(device, image, nullptr);
+    image = VK_NULL_HANDLE;
+    throw;
+  }
+  if (vkBindImageMemory(device, image, allocation->memory, allocation->offset) != VK_SUCCESS) {
+    destroyImage(image, allocation);
+    image = VK_NULL_HANDLE;
+    throw std::runtime_error("failed to bind image memory!");
+  }
+  return allocation;
+}
+
+void LveAllocator::destroyBuffer(VkBuffer buffer, LveAllocation *allocation) {
+  vkDestroyBuffer(device, buffer, nullptr);
+  free(allocation);
+}
+
+void LveAllocator::destroyImage(VkImage image, LveAllocation *allocation) {
+  vkDestroyImage(device, image, nullptr);
+  free(allocation);
+}
+
+LveDefragmentation LveAllocator::beginDefragmentation(
+    VkCommandBuffer commandBuffer, VkDeviceSize maxBytesToMove) {
+  std::lock_guard<std::mutex> lock{mutex};
+  LveDefragmentation result;
+
+  for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < blocks.size(); i++) {
+      const auto &block = blocks[i];
+      if (block && !block->dedicated && block->memoryTypeIndex == type && block->usedBytes > 0) {
+        candidates.push_back(i);
+      }
+    }
+    if (candidates.size() < 2) continue;
+
+    // evacuate the emptiest blocks first, filling the fullest ones
+    std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b) {
+      return blocks[a]->usedBytes < blocks[b]->usedBytes;
+    });
+
+    // a block that received moves is never evacuated in the same pass: its new contents are only
+    // written by copies in this command buffer, and copying them on would read them unsynchronized
+    std::vector<bool> received(candidates.size(), false);
+    for (size_t source = 0; source + 1 < candidates.size(); source++) {
+      if (received[source]) continue;
+      Block &src = *blocks[candidates[source]];
+
+      // a block that keeps even one pinned allocation cannot be released, so leave it alone
+      std::vector<LveAllocation *> movable;
+      bool pinned = false;
+      for (auto &entry : src.allocations) {
+        if (entry.second->buffer == VK_NULL_HANDLE) {
+          pinned = true;
+          break;
+        }
+        movable.push_back(entry.second);
+      }
+      if (pinned || src.usedBytes + result.bytesMoved > maxBytesToMove) continue;
+
+      for (LveAllocation *allocation : movable) {
+        VkBuffer newBuffer;
+        if (vkCreateBuffer(device, &allocation->bufferInfo, nullptr, &newBuffer) != VK_SUCCESS) {
+          throw std::runtime_error("failed to create buffer during defragmentation!");
+        }
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device, newBuffer, &memRequirements);
+
+        size_t dstCandidate = SIZE_MAX;
+        VkDeviceSize dstOffset = 0;
+        for (size_t dst = candidates.size() - 1; dst > source; dst--) {
+          if (tryAllocate(
+                  *blocks[candidates[dst]],
+                  memRequirements.size,
+                  memRequirements.alignment,
+                  LveResourceKind::Buffer,
+                  dstOffset)) {
+            dstCandidate = dst;
+            break;
+          }
+        }
+        if (dstCandidate == SIZE_MAX) {
+          vkDestroyBuffer(device, newBuffer, nullptr);
+          break;
+        }
+
+        size_t dstIndex = candidates[dstCandidate];
+        Block &dstBlock = *blocks[dstIndex];
+        if (vkBindBufferMemory(device, newBuffer, dstBlock.memory, dstOffset) != VK_SUCCESS) {
+          // the allocation stays where it is, so the source block cannot be released this pass
+          releaseRange(dstBlock, dstOffset, memRequirements.size);
+          vkDestroyBuffer(device, newBuffer, nullptr);
+          break;
+        }
+        received[dstCandidate] = true;
+
+        if (result.moves.empty()) {
+          VkMemoryBarrier barrier{};
+          barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+          barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+          barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+          vkCmdPipelineBarrier(
+              commandBuffer,
+              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+              VK_PIPELINE_STAGE_TRANSFER_BIT,
+              0,
+              1,
+              &barrier,
+              0,
+              nullptr,
+              0,
+              nullptr);
+        }
+        VkBufferCopy copyRegion{};
+        copyRegion.size = allocation->bufferInfo.size;
+        vkCmdCopyBuffer(commandBuffer, allocation->buffer, newBuffer, 1, &copyRegion);
+
+        // the old range stays occupied by a placeholder until the copy is known to be done
+        auto placeholder = new LveAllocation{*allocation};
+        placeholder->buffer = VK_NULL_HANDLE;
+        src.allocations[allocation->offset] = placeholder;
+        result.releases.push_back(
+            {allocation->blockIndex, allocation->offset, allocation->size, placeholder});
+        result.moves.push_back({allocation, allocation->buffer, newBuffer});
+        result.bytesMoved += allocation->size;
+
+        dstBlock.usedBytes += memRequirements.size;
+        dstBlock.allocations[dstOffset] = allocation;
+        // the placeholder keeps the old size accounted until endDefragmentation releases it
+        trackLocked(allocation->category, type, memRequirements.size, true);
+
+        allocation->memory = dstBlock.memory;
+        allocation->offset = dstOffset;
+        allocation->size = memRequirements.size;
+        allocation->mapped = dstBlock.mapped ? dstBlock.mapped + dstOffset : nullptr;
+        allocation->blockIndex = dstIndex;
+        allocation->buffer = newBuffer;
+      }
+    }
+  }
+
+  if (!result.moves.empty()) {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+  }
+  return result;
+}
+
+void LveAllocator::endDefragmentation(LveDefragmentation &defragmentation) {
+  for (auto &move : defragmentation.moves) {
+    vkDestroyBuffer(device, move.oldBuffer, nullptr);
+  }
+
+  std::vector<ThresholdCrossing> crossings;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    std::vector<uint32_t> touchedTypes;
+    for (auto &release : defragmentation.releases) {
+      Block &block = *blocks[release.blockIndex];
+      block.allocations.erase(release.offset);
+      releaseRange(block, release.offset, release.size);
+      block.usedBytes -= release.size;
+      touchedTypes.push_back(block.memoryTypeIndex);
+      trackLocked(
+          release.placeholder->category, block.memoryTypeIndex, release.size, false);
+      delete release.placeholder;
+    }
+    for (uint32_t type : touchedTypes) {
+      releaseEmptyBlocks(type);
+    }
+    crossings.swap(pendingCrossings);
+  }
+  notifyThresholds(crossings);
+
+  defragmentation.releases.clear();
+  defragmentation.moves.clear();
+}
+
+LveAllocatorStats LveAllocator::getStats() {
+  std::lock_guard<std::mutex> lock{mutex};
+  LveAllocatorStats stats{};
+  stats.heaps.resize(memoryProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+    stats.heaps[i].heapSize = memoryProperties.memoryHeaps[i].size;
+  }
+
+  VkDeviceSize totalFree = 0;
+  double weightedFragmentation = 0.0;
+  for (const auto &block : blocks) {
+    if (!block) continue;
+    stats.blockCount++;
+    stats.deviceMemoryAllocations++;
+    if (block->dedicated) stats.dedicatedBlockCount++;
+    stats.allocationCount += static_cast<uint32_t>(block->allocations.size());
+    stats.blockBytes += block->size;
+    stats.usedBytes += block->usedBytes;
+
+    auto &heap = stats.heaps[memoryProperties.memoryTypes[block->memoryTypeIndex].heapIndex];
+    heap.blockBytes += block->size;
+    heap.usedBytes += block->usedBytes;
+
+    VkDeviceSize blockFree = 0;
+    VkDeviceSize largestFree = 0;
+    for (const auto &range : block->freeRanges) {
+      blockFree += range.second;
+      largestFree = std::max(largestFree, range.second);
+    }
+    if (blockFree > 0) {
+      weightedFragmentation += (1.0 - static_cast<double>(largestFree) / blockFree) * blockFree;
+      totalFree += blockFree;
+    }
+  }
+  if (totalFree > 0) {
+    stats.fragmentation = static_cast<float>(weightedFragmentation / totalFree);
+  }
+  return stats;
+}
+
+LveMemoryUsage LveAllocator::getMemoryUsage() {
+  LveMemoryUsage usage{};
+  std::vector<VkDeviceSize> blockBytes(memoryProperties.memoryHeapCount, 0);
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    usage.heaps = heapUsage;
+    usage.memoryTypes = typeUsage;
+    usage.categories = categoryUsage;
+    for (const auto &block : blocks) {
+      if (!block) continue;
+      blockBytes[memoryProperties.memoryTypes[block->memoryTypeIndex].heapIndex] += block->size;
+    }
+  }
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+  budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  if (getMemoryProperties2 != nullptr) {
+    VkPhysicalDeviceMemoryProperties2KHR properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+    properties2.pNext = &budget;
+    getMemoryProperties2(physicalDevice, &properties2);
+    usage.driverBudget = true;
+  }
+
+  usage.heapBudgets.resize(memoryProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+    auto &heap = usage.heapBudgets[i];
+    heap.heapSize = memoryProperties.memoryHeaps[i].size;
+    if (usage.driverBudget) {
+      heap.budgetBytes = budget.heapBudget[i];
+      heap.usageBytes = budget.heapUsage[i];
+    } else {
+      // without the extension leave headroom for other processes and driver internals
+      heap.budgetBytes = heap.heapSize / 10 * 8;
+      heap.usageBytes = blockBytes[i];
+    }
+  }
+  return usage;
+}
+
+void LveAllocator::resetPeaks() {
+  std::lock_guard<std::mutex> lock{mutex};
+  for (auto &counter : heapUsage) counter.peakBytes = counter.currentBytes;
+  for (auto &counter : typeUsage) counter.peakBytes = counter.currentBytes;
+  for (auto &counter : categoryUsage) counter.peakBytes = counter.currentBytes;
+}
+
+void LveAllocator::setCategoryThreshold(
+    LveMemoryCategory category,
+    VkDeviceSize thresholdBytes,
+    LveMemoryThresholdCallback callback) {
+  std::lock_guard<std::mutex> lock{mutex};
+  uint32_t categoryIndex = static_cast<uint32_t>(category);
+  Threshold &threshold = thresholds[categoryIndex];
+  threshold.bytes = thresholdBytes;
+  threshold.callback = thresholdBytes > 0 ? std::move(callback) : nullptr;
+  // a category already above a new threshold reports the crossing on its next allocation or free
+  threshold.exceeded = false;
+}
+
+void LveAllocator::setPeriodicDump(std::ostream *out, uint32_t intervalFrames) {
+  dumpStream = out;
+  dumpInterval = std::max(intervalFrames, 1u);
+}
+
+void LveAllocator::update() {
+  frameCounter++;
+  bool dumpDue = dumpStream != nullptr && frameCounter % dumpInterval == 0;
+  // querying the driver budget is not free, so check it every few frames only
+  if (!dumpDue && frameCounter % 16 != 0) return;
+
+  LveMemoryUsage usage = getMemoryUsage();
+  const double MiB = 1024.0 * 1024.0;
+  for (size_t i = 0; i < usage.heapBudgets.size(); i++) {
+    const auto &heap = usage.heapBudgets[i];
+    bool over = heap.usageBytes > heap.budgetBytes;
+    if (over && !heapOverBudget[i]) {
+      std::cerr << "allocator: heap " << i << " is over budget, " << heap.usageBytes / MiB
+                << " / " << heap.budgetBytes / MiB << " MiB" << std::endl;
+    }
+    heapOverBudget[i] = over;
+  }
+  if (dumpDue) {
+    dumpStats(*dumpStream);
+  }
+}
+
+void LveAllocator::dumpStats(std::ostream &out) {
+  LveAllocatorStats stats = getStats();
+  LveMemoryUsage usage = getMemoryUsage();
+  const double MiB = 1024.0 * 1024.0;
+  out << "allocator: " << stats.blockCount << " blocks (" << stats.dedicatedBlockCount
+      << " dedicated), " << stats.allocationCount << " allocations, "
+      << stats.usedBytes / MiB << " / " << stats.blockBytes / MiB << " MiB used, fragmentation "
+      << stats.fragmentation << std::endl;
+  for (size_t i = 0; i < stats.heaps.size(); i++) {
+    const auto &heap = stats.heaps[i];
+    const auto &budget = usage.heapBudgets[i];
+    if (heap.blockBytes == 0 && !usage.driverBudget) continue;
+    out << "\theap " << i << ": " << heap.usedBytes / MiB << " / " << heap.blockBytes / MiB
+        << " MiB used of " << heap.heapSize / MiB << " MiB, peak "
+        << usage.heaps[i].peakBytes / MiB << " MiB, budget " << budget.usageBytes / MiB << " / "
+        << budget.budgetBytes / MiB << (usage.driverBudget ? " MiB" : " MiB (estimated)")
+        << std::endl;
+  }
+  for (size_t i = 0; i < usage.memoryTypes.size(); i++) {
+    const auto &type = usage.memoryTypes[i];
+    if (type.peakBytes == 0) continue;
+    out << "\ttype " << i << " (heap " << memoryProperties.memoryTypes[i].heapIndex
+        << "): " << type.allocationCount << " allocations, " << type.currentBytes / MiB
+        << " MiB, peak " << type.peakBytes / MiB << " MiB" << std::endl;
+  }
+  for (uint32_t i = 0; i < LVE_MEMORY_CATEGORY_COUNT; i++) {
+    const auto &category = usage.categories[i];
+    if (category.peakBytes == 0) continue;
+    out << "\t" << memoryCategoryName(static_cast<LveMemoryCategory>(i)) << ": "
+        << category.allocationCount << " allocations, " << category.currentBytes / MiB
+        << " MiB, peak " << category.peakBytes / MiB << " MiB" << std::endl;
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace lve {
+
+// Resources that may not share a bufferImageGranularity page with each other.
+enum class LveResourceKind { Buffer, LinearImage, OptimalImage };
+
+// What an allocation is for. Usage is accounted per category as well as per heap and memory type.
+enum class LveMemoryCategory : uint32_t {
+  General,
+  Mesh,
+  Texture,
+  Staging,
+  Uniform,
+  RenderTarget,
+  Indirect,
+  Count
+};
+constexpr uint32_t LVE_MEMORY_CATEGORY_COUNT = static_cast<uint32_t>(LveMemoryCategory::Count);
+const char *memoryCategoryName(LveMemoryCategory category);
+
+struct LveAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  uint32_t memoryTypeIndex = 0;
+  void *mapped = nullptr;  // set for host-visible memory, which stays mapped for its lifetime
+
+ private:
+  friend class LveAllocator;
+  size_t blockIndex = 0;
+  LveResourceKind kind = LveResourceKind::Buffer;
+  LveMemoryCategory category = LveMemoryCategory::General;
+  // only buffers can be relocated by defragmentation
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VkBufferCreateInfo bufferInfo{};
+};
+
+struct LveHeapStats {
+  VkDeviceSize heapSize = 0;
+  VkDeviceSize blockBytes = 0;
+  VkDeviceSize usedBytes = 0;
+};
+
+struct LveAllocatorStats {
+  uint32_t blockCount = 0;
+  uint32_t dedicatedBlockCount = 0;
+  uint32_t allocationCount = 0;
+  uint32_t deviceMemoryAllocations = 0;  // live vkAllocateMemory objects
+  VkDeviceSize blockBytes = 0;
+  VkDeviceSize usedBytes = 0;
+  // 0 when all free space is one contiguous range, approaching 1 as it splinters
+  float fragmentation = 0.0f;
+  std::vector<LveHeapStats> heaps;
+};
+
+struct LveUsageCounter {
+  uint32_t allocationCount = 0;
+  VkDeviceSize currentBytes = 0;
+  VkDeviceSize peakBytes = 0;  // highest currentBytes since creation or resetPeaks
+};
+
+struct LveHeapBudget {
+  VkDeviceSize heapSize = 0;
+  VkDeviceSize budgetBytes = 0;  // how much this process can use before the driver starts paging
+  VkDeviceSize usageBytes = 0;
+};
+
+struct LveMemoryUsage {
+  // true when the heap budgets are live from VK_EXT_memory_budget and cover every allocation of
+  // the process; otherwise budgets are 80% of each heap and usage is the allocator's own blocks
+  bool driverBudget = false;
+  std::vector<LveHeapBudget> heapBudgets;
+  // bytes handed out to allocations, by heap index, memory type index and category
+  std::vector<LveUsageCounter> heaps;
+  std::vector<LveUsageCounter> memoryTypes;
+  std::array<LveUsageCounter, LVE_MEMORY_CATEGORY_COUNT> categories;
+};
+
+// exceeded is true when the category rose above thresholdBytes and false when it fell back below.
+using LveMemoryThresholdCallback = std::function<void(
+    LveMemoryCategory category,
+    VkDeviceSize currentBytes,
+    VkDeviceSize thresholdBytes,
+    bool exceeded)>;
+
+struct LveDefragMove {
+  LveAllocation *allocation;
+  VkBuffer oldBuffer;
+  VkBuffer newBuffer;
+};
+
+struct LveDefragmentation {
+  std::vector<LveDefragMove> moves;
+  VkDeviceSize bytesMoved = 0;
+
+ private:
+  friend class LveAllocator;
+  struct Release {
+    size_t blockIndex;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    LveAllocation *placeholder;  // keeps the old range occupied until the copy has completed
+  };
+  std::vector<Release> releases;
+};
+
+// Sub-allocates device memory out of large per-memory-type blocks so that the number of live
+// vkAllocateMemory objects stays far below maxMemoryAllocationCount. Requests larger than half a
+// block get a dedicated block of their own.
+//
+// Every allocation is tagged with a category and accounted by heap, memory type and category,
+// with peaks, so getMemoryUsage can tell which system is filling which heap long before an
+// allocation fails.
+class LveAllocator {
+ public:
+  static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+  LveAllocator(
+      VkPhysicalDevice physicalDevice,
+      VkDevice device,
+      VkDeviceSize bufferImageGranularity,
+      VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE,
+      PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr);
+  ~LveAllocator();
+
+  LveAllocator(const LveAllocator &) = delete;
+  LveAllocator &operator=(const LveAllocator &) = delete;
+
+  LveAllocation *allocate(
+      const VkMemoryRequirements &requirements,
+      uint32_t memoryTypeIndex,
+      LveResourceKind kind,
+      LveMemoryCategory category = LveMemoryCategory::General);
+  void free(LveAllocation *allocation);
+
+  // Creates the buffer, allocates and binds memory for it. The allocation remembers the buffer so
+  // that beginDefragmentation can relocate it.
+  LveAllocation *createBuffer(
+      const VkBufferCreateInfo &bufferInfo,
+      VkMemoryPropertyFlags properties,
+      VkBuffer &buffer,
+      LveMemoryCategory category = LveMemoryCategory::General);
+  LveAllocation *createImage(
+      const VkImageCreateInfo &imageInfo,
+      VkMemoryPropertyFlags properties,
+      VkImage &image,
+      LveMemoryCategory category = LveMemoryCategory::General);
+  void destroyBuffer(VkBuffer buffer, LveAllocation *allocation);
+  void destroyImage(VkImage image, LveAllocation *allocation);
+
+  // Compaction pass: relocates buffers out of the least occupied blocks into denser ones,
+  // recording the copies into commandBuffer. After the command buffer has completed, callers
+  // swap their handles from oldBuffer to newBuffer and hand the result to endDefragmentation,
+  // which destroys the old buffers and releases any blocks that became empty.
+  LveDefragmentation beginDefragmentation(
+      VkCommandBuffer commandBuffer, VkDeviceSize maxBytesToMove = VK_WHOLE_SIZE);
+  void endDefragmentation(LveDefragmentation &defragmentation);
+
+  LveAllocatorStats getStats();
+  // Current and peak usage by heap, memory type and category, and the budget of every heap.
+  LveMemoryUsage getMemoryUsage();
+  void resetPeaks();
+  void dumpStats(std::ostream &out);
+
+  // Calls callback whenever the bytes of category cross thresholdBytes in either direction; a
+  // threshold of 0 removes it. The callback runs on the thread whose allocation or free crossed,
+  // after the allocator lock has been released, so it may allocate and free itself.
+  void setCategoryThreshold(
+      LveMemoryCategory category,
+      VkDeviceSize thresholdBytes,
+      LveMemoryThresholdCallback callback);
+
+  // Writes dumpStats to out every intervalFrames calls of update; a null out stops the dump.
+  void setPeriodicDump(std::ostream *out, uint32_t intervalFrames);
+
+  // Call once per frame. Warns once when a heap goes over its budget and runs the periodic dump.
+  void update();
+
+ private:
+  struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    VkDeviceSize usedBytes = 0;
+    uint32_t memoryTypeIndex = 0;
+    bool dedicated = false;
+    char *mapped = nullptr;
+    std::map<VkDeviceSize, VkDeviceSize> freeRanges;  // offset -> size
+    std::map<VkDeviceSize, LveAllocation *> allocations;  // offset -> allocation
+  };
+
+  bool tryAllocate(
+      Block &block, VkDeviceSize size, VkDeviceSize alignment, LveResourceKind kind,
+      VkDeviceSize &outOffset);
+  void releaseRange(Block &block, VkDeviceSize offset, VkDeviceSize size);
+  size_t createBlock(
+      uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceSize minSize, bool dedicated);
+  void destroyBlock(size_t blockIndex);
+  void releaseEmptyBlocks(uint32_t memoryTypeIndex);
+  struct Threshold {
+    VkDeviceSize bytes = 0;
+    LveMemoryThresholdCallback callback;
+    bool exceeded = false;
+  };
+  struct ThresholdCrossing {
+    LveMemoryThresholdCallback callback;
+    LveMemoryCategory category;
+    VkDeviceSize currentBytes;
+    VkDeviceSize thresholdBytes;
+    bool exceeded;
+  };
+
+  LveAllocation *allocateLocked(
+      const VkMemoryRequirements &requirements,
+      uint32_t memoryTypeIndex,
+      LveResourceKind kind,
+      LveMemoryCategory category);
+  void freeLocked(LveAllocation *allocation);
+  void trackLocked(
+      LveMemoryCategory category, uint32_t memoryTypeIndex, VkDeviceSize size, bool allocated);
+  static void notifyThresholds(std::vector<ThresholdCrossing> &crossings);
+  uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+  bool conflicts(LveResourceKind a, LveResourceKind b) const;
+  VkDeviceSize blockSizeFor(uint32_t memoryTypeIndex) const;
+
+  VkPhysicalDevice physicalDevice;
+  VkDevice device;
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2;  // null without the budget
+  VkDeviceSize granularity;
+  VkDeviceSize preferredBlockSize;
+
+  std::mutex mutex;
+  // destroyed blocks leave an empty slot so that block indices held by allocations stay valid
+  std::vector<std::unique_ptr<Block>> blocks;
+
+  std::vector<LveUsageCounter> heapUsage;
+  std::vector<LveUsageCounter> typeUsage;
+  std::array<LveUsageCounter, LVE_MEMORY_CATEGORY_COUNT> categoryUsage{};
+  std::array<Threshold, LVE_MEMORY_CATEGORY_COUNT> thresholds{};
+  // crossings found under the lock, handed to their callbacks once it is released
+  std::vector<ThresholdCrossing> pendingCrossings;
+
+  // only touched by update and setPeriodicDump, which run on the frame thread
+  std::ostream *dumpStream = nullptr;
+  uint32_t dumpInterval = 0;
+  uint64_t frameCounter = 0;
+  std::vector<bool> heapOverBudget;
+};
+
+}  // namespace lve
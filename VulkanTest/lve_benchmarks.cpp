@@ -0,0 +1,1824 @@
+#include "lve_benchmarks.hpp"
+
+#include "lve_bindless_heap.hpp"
+#include "lve_culling_system.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_indirect_draw_system.hpp"
+#include "lve_mesh_file.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_mesh_pool.hpp"
+#include "lve_obj_loader.hpp"
+#include "lve_parallel_recorder.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_pipeline_registry.hpp"
+#include "lve_render_graph.hpp"
+#include "lve_renderer.hpp"
+#include "lve_scene.hpp"
+#include "lve_specialization.hpp"
+#include "lve_texture_streamer.hpp"
+#include "lve_thread_pool.hpp"
+#include "lve_uniform_ring.hpp"
+
+// std headers
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace lve {
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct AllocOp {
+  bool create;
+  VkDeviceSize size;
+  VkBufferUsageFlags usage;
+  VkMemoryPropertyFlags properties;
+  size_t victim;  // index into the live list when destroying
+};
+
+std::vector<AllocOp> makeAllocationSequence(int iterations, size_t maxLive) {
+  std::mt19937 rng{1234};
+  std::uniform_real_distribution<double> unit{0.0, 1.0};
+  std::vector<AllocOp> ops;
+  size_t live = 0;
+  for (int i = 0; i < iterations; i++) {
+    AllocOp op{};
+    op.create = live == 0 || (live < maxLive && unit(rng) < 0.55);
+    if (op.create) {
+      // log-uniform between 256 bytes and 4 MiB, the spread of small meshes and textures
+      op.size = static_cast<VkDeviceSize>(std::exp2(8.0 + unit(rng) * 14.0));
+      bool staging = unit(rng) < 0.25;
+      op.usage = staging ? VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                         : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+      op.properties = staging ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                              : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+      live++;
+    } else {
+      op.victim = static_cast<size_t>(unit(rng) * live) % live;
+      live--;
+    }
+    ops.push_back(op);
+  }
+  return ops;
+}
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+VkRenderPass createBenchmarkRenderPass(LveDevice &device) {
+  VkAttachmentDescription colorAttachment{};
+  colorAttachment.format = VK_FORMAT_B8G8R8A8_UNORM;
+  colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+  colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  VkAttachmentReference colorAttachmentRef{};
+  colorAttachmentRef.attachment = 0;
+  colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+  VkSubpassDescription subpass{};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments = &colorAttachmentRef;
+
+  VkRenderPassCreateInfo renderPassInfo{};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  renderPassInfo.attachmentCount = 1;
+  renderPassInfo.pAttachments = &colorAttachment;
+  renderPassInfo.subpassCount = 1;
+  renderPassInfo.pSubpasses = &subpass;
+
+  VkRenderPass renderPass;
+  if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark render pass!");
+  }
+  return renderPass;
+}
+
+// Distinct fixed-function states over the default config: 4 cull modes x 2 winding orders x
+// 2 blend modes x 8 depth compare ops x 2 depth write modes x 2 topologies = 512 permutations.
+std::vector<PipelineBuildDesc> makePipelinePermutations(
+    int count, VkRenderPass renderPass, VkPipelineLayout pipelineLayout) {
+  const VkCullModeFlags cullModes[] = {
+      VK_CULL_MODE_NONE, VK_CULL_MODE_FRONT_BIT, VK_CULL_MODE_BACK_BIT,
+      VK_CULL_MODE_FRONT_AND_BACK};
+  const VkPrimitiveTopology topologies[] = {
+      VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP};
+
+  std::vector<PipelineBuildDesc> descs;
+  for (int i = 0; i < count; i++) {
+    int variant = i % 512;
+    PipelineBuildDesc desc{};
+    desc.vertFilepath = "shaders/simple_shader.vert.spv";
+    desc.fragFilepath = "shaders/simple_shader.frag.spv";
+    desc.config = LvePipeline::defaultPipelineConfigInfo();
+    desc.config.rasterizationInfo.cullMode = cullModes[variant % 4];
+    desc.config.rasterizationInfo.frontFace =
+        (variant / 4) % 2 ? VK_FRONT_FACE_COUNTER_CLOCKWISE : VK_FRONT_FACE_CLOCKWISE;
+    desc.config.colorBlendAttachment.blendEnable = (variant / 8) % 2 ? VK_TRUE : VK_FALSE;
+    desc.config.depthStencilInfo.depthCompareOp = static_cast<VkCompareOp>((variant / 16) % 8);
+    desc.config.depthStencilInfo.depthWriteEnable = (variant / 128) % 2 ? VK_TRUE : VK_FALSE;
+    desc.config.inputAssemblyInfo.topology = topologies[(variant / 256) % 2];
+    desc.config.renderPass = renderPass;
+    desc.config.pipelineLayout = pipelineLayout;
+    descs.push_back(desc);
+  }
+  return descs;
+}
+
+VkPipelineCache createEmptyPipelineCache(LveDevice &device) {
+  VkPipelineCacheCreateInfo cacheInfo{};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  VkPipelineCache cache;
+  if (vkCreatePipelineCache(device.device(), &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark pipeline cache!");
+  }
+  return cache;
+}
+
+void buildPipelines(
+    LveDevice &device,
+    const std::vector<PipelineBuildDesc> &descs,
+    uint32_t threadCount,
+    uint32_t maxPipelinesPerCall,
+    VkPipelineCache cache,
+    const char *label) {
+  LveThreadPool threadPool{threadCount};
+  PipelineBatchOptions options{};
+  options.maxPipelinesPerCall = maxPipelinesPerCall;
+  options.cache = cache;
+
+  auto start = Clock::now();
+  auto futures = LvePipeline::createPipelines(device, descs, threadPool, options);
+  std::vector<std::unique_ptr<LvePipeline>> pipelines;
+  double firstReadySeconds = 0.0;
+  for (auto &future : futures) {
+    pipelines.push_back(future.get());
+    if (pipelines.size() == 1) firstReadySeconds = secondsSince(start);
+  }
+  double seconds = secondsSince(start);
+
+  std::cout << "\t" << label << ": " << seconds * 1000.0 << " ms on "
+            << threadPool.threadCount() << " threads, " << descs.size() / seconds
+            << " pipelines/s, first ready after " << firstReadySeconds * 1000.0 << " ms"
+            << std::endl;
+}
+
+// Small closed meshes for the instanced scene, colored per vertex.
+void addBenchmarkMeshes(LveMeshPool &meshPool, std::vector<LveMeshHandle> &meshes) {
+  std::vector<LveVertex> cube;
+  for (int i = 0; i < 8; i++) {
+    float x = (i & 1) ? 0.5f : -0.5f;
+    float y = (i & 2) ? 0.5f : -0.5f;
+    float z = (i & 4) ? 0.5f : -0.5f;
+    cube.push_back({{x, y, z}, {x + 0.5f, y + 0.5f, z + 0.5f}});
+  }
+  meshes.push_back(meshPool.addMesh(
+      cube,
+      {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+       2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3}));
+
+  std::vector<LveVertex> tetrahedron = {
+      {{0.5f, 0.5f, 0.5f}, {1.0f, 0.2f, 0.2f}},
+      {{-0.5f, -0.5f, 0.5f}, {0.2f, 1.0f, 0.2f}},
+      {{-0.5f, 0.5f, -0.5f}, {0.2f, 0.2f, 1.0f}},
+      {{0.5f, -0.5f, -0.5f}, {1.0f, 1.0f, 0.2f}}};
+  meshes.push_back(meshPool.addMesh(tetrahedron, {0, 1, 2, 0, 3, 1, 0, 2, 3, 1, 3, 2}));
+
+  std::vector<LveVertex> octahedron = {
+      {{0.5f, 0.0f, 0.0f}, {1.0f, 0.5f, 0.0f}},
+      {{-0.5f, 0.0f, 0.0f}, {0.0f, 0.5f, 1.0f}},
+      {{0.0f, 0.5f, 0.0f}, {0.5f, 1.0f, 0.0f}},
+      {{0.0f, -0.5f, 0.0f}, {0.5f, 0.0f, 1.0f}},
+      {{0.0f, 0.0f, 0.5f}, {1.0f, 1.0f, 1.0f}},
+      {{0.0f, 0.0f, -0.5f}, {0.3f, 0.3f, 0.3f}}};
+  meshes.push_back(meshPool.addMesh(
+      octahedron,
+      {0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5}));
+}
+
+// Square grid in the z = 0.5 plane, two triangles per cell, with one submesh.
+LveMeshData makeGridMesh(uint32_t triangles) {
+  uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(triangles / 2.0)));
+  LveMeshData mesh{};
+  mesh.vertices.reserve(size_t{side + 1} * (side + 1));
+  for (uint32_t y = 0; y <= side; y++) {
+    for (uint32_t x = 0; x <= side; x++) {
+      float u = static_cast<float>(x) / side;
+      float v = static_cast<float>(y) / side;
+      mesh.vertices.push_back({{u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.5f}, {u, v, 1.0f - u}});
+    }
+  }
+  mesh.indices.reserve(size_t{side} * side * 6);
+  for (uint32_t y = 0; y < side; y++) {
+    for (uint32_t x = 0; x < side; x++) {
+      uint32_t corner = y * (side + 1) + x;
+      uint32_t quad[6] = {
+          corner, corner + 1, corner + side + 1, corner + 1, corner + side + 2, corner + side + 1};
+      mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+    }
+  }
+  mesh.submeshes.push_back({0, static_cast<uint32_t>(mesh.indices.size()), 0, 0});
+  return mesh;
+}
+
+void writeObj(const std::string &path, const LveMeshData &mesh) {
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  if (!out.is_open()) {
+    throw std::runtime_error("failed to open " + path + "!");
+  }
+  for (const auto &vertex : mesh.vertices) {
+    out << "v " << vertex.position[0] << ' ' << vertex.position[1] << ' ' << vertex.position[2]
+        << ' ' << vertex.color[0] << ' ' << vertex.color[1] << ' ' << vertex.color[2] << '\n';
+  }
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    out << "f " << mesh.indices[i] + 1 << ' ' << mesh.indices[i + 1] + 1 << ' '
+        << mesh.indices[i + 2] + 1 << '\n';
+  }
+}
+
+// An uncompressed RGBA8 KTX2 texture with a full mip chain, levels stored coarsest first as the
+// format asks. Each level is a checker in a tint of its own, so the resident level shows.
+void writeKtx2(const std::string &path, uint32_t size, uint32_t seed) {
+  static const unsigned char identifier[12] =
+      {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+  uint32_t levelCount = 1;
+  while ((size >> levelCount) > 0) levelCount++;
+
+  LveKtx2Header header{};
+  std::memcpy(header.identifier, identifier, sizeof(identifier));
+  header.vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+  header.typeSize = 1;
+  header.pixelWidth = size;
+  header.pixelHeight = size;
+  header.faceCount = 1;
+  header.levelCount = levelCount;
+
+  std::vector<LveKtx2Level> levels(levelCount);
+  uint64_t offset = sizeof(LveKtx2Header) + sizeof(LveKtx2Level) * levelCount;
+  for (uint32_t level = levelCount; level-- > 0;) {
+    uint64_t levelSize = std::max(1u, size >> level);
+    levels[level].byteOffset = offset;
+    levels[level].byteLength = levelSize * levelSize * 4;
+    levels[level].uncompressedByteLength = levels[level].byteLength;
+    offset += levels[level].byteLength;
+  }
+
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  if (!out.is_open()) {
+    throw std::runtime_error("failed to open " + path + "!");
+  }
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(levels.data()), sizeof(LveKtx2Level) * levelCount);
+  std::vector<unsigned char> texels;
+  for (uint32_t level = levelCount; level-- > 0;) {
+    uint32_t levelSize = std::max(1u, size >> level);
+    texels.resize(static_cast<size_t>(levelSize) * levelSize * 4);
+    unsigned char tint[3] = {
+        static_cast<unsigned char>(64 + 48 * ((level + seed) % 4)),
+        static_cast<unsigned char>(64 + 48 * ((level + seed * 3) % 4)),
+        static_cast<unsigned char>(255 - 24 * level)};
+    for (uint32_t y = 0; y < levelSize; y++) {
+      for (uint32_t x = 0; x < levelSize; x++) {
+        bool dark = ((x * 8 / levelSize) + (y * 8 / levelSize)) % 2 != 0;
+        unsigned char *texel = &texels[(static_cast<size_t>(y) * levelSize + x) * 4];
+        for (int channel = 0; channel < 3; channel++) {
+          texel[channel] = dark ? tint[channel] / 2 : tint[channel];
+        }
+        texel[3] = 255;
+      }
+    }
+    out.write(reinterpret_cast<const char *>(texels.data()), texels.size());
+  }
+  if (!out) {
+    throw std::runtime_error("failed to write " + path + "!");
+  }
+}
+
+// Reads every index so a lazily mapped file is paged in before the clock stops.
+uint64_t touchIndices(const uint32_t *indices, uint32_t count) {
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < count; i++) sum += indices[i];
+  return sum;
+}
+
+// Nearest-rank percentile of an ascending sorted sample.
+double percentile(const std::vector<double> &sorted, double p) {
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+}  // namespace
+
+int runFrameBenchmark(LveDevice &device, const LveFrameBenchmarkOptions &options) {
+  // each scene is the app's triangle drawn with a different cost profile
+  uint32_t drawCount = 1;
+  uint32_t instanceCount = 1;
+  if (options.scene == "draw-calls") {
+    drawCount = 10000;  // CPU recording and submission bound
+  } else if (options.scene == "overdraw") {
+    instanceCount = 256;  // fill rate bound: every instance covers the same pixels
+  } else if (
+      options.scene != "triangle" && options.scene != "instanced" && options.scene != "culled") {
+    throw std::runtime_error("unknown benchmark scene: " + options.scene);
+  }
+  if (options.frames <= 0) {
+    throw std::runtime_error("frame benchmark needs at least one measured frame!");
+  }
+
+  LveRenderer renderer{device, VkExtent2D{options.width, options.height}};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  VkPipelineLayout pipelineLayout;
+  if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark pipeline layout!");
+  }
+  auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+  pipelineConfig.renderPass = renderer.getSwapChainRenderPass();
+  pipelineConfig.pipelineLayout = pipelineLayout;
+  auto pipeline = std::make_unique<LvePipeline>(
+      device,
+      "shaders/simple_shader.vert.spv",
+      "shaders/simple_shader.frag.spv",
+      pipelineConfig);
+
+  // instanced: 100k objects over three meshes, drawn with one indirect call
+  // culled: the same objects zoomed in 4x, culled on the GPU before they are drawn
+  std::unique_ptr<LveMeshPool> meshPool;
+  std::unique_ptr<LveIndirectDrawSystem> indirectDrawSystem;
+  std::unique_ptr<LveCullingSystem> cullingSystem;
+  std::array<float, 16> viewProjection{};
+  if (options.scene == "instanced" || options.scene == "culled") {
+    const uint32_t columns = 400;
+    const uint32_t rows = 250;
+    meshPool = std::make_unique<LveMeshPool>(device, 1024, 4096);
+    std::vector<LveMeshHandle> meshes;
+    addBenchmarkMeshes(*meshPool, meshes);
+    indirectDrawSystem = std::make_unique<LveIndirectDrawSystem>(
+        device,
+        *meshPool,
+        renderer.getSwapChainRenderPass(),
+        columns * rows);
+    for (uint32_t material = 0; material < 8; material++) {
+      indirectDrawSystem->setMaterialColor(
+          material, 0.4f + 0.08f * material, 1.0f - 0.1f * material, 0.6f);
+    }
+    for (uint32_t i = 0; i < columns * rows; i++) {
+      float x = -1.0f + (2.0f * (i % columns) + 1.0f) / columns;
+      float y = -1.0f + (2.0f * (i / columns) + 1.0f) / rows;
+      float angle = 0.001f * i;
+      indirectDrawSystem->addInstance(
+          meshes[i % meshes.size()],
+          {x, y, 0.0f},
+          1.6f / columns,
+          {0.0f, std::sin(angle), 0.0f, std::cos(angle)},
+          i % 8);
+    }
+    device.uploadManager().wait(meshPool->lastUpload());
+    indirectDrawSystem->upload(renderer);
+
+    // orthographic: x and y are already in clip space, z in [-1, 1] maps to depth [0, 1]
+    viewProjection[0] = 1.0f;
+    viewProjection[5] = 1.0f;
+    viewProjection[10] = 0.5f;
+    viewProjection[14] = 0.5f;
+    viewProjection[15] = 1.0f;
+
+    if (options.scene == "culled") {
+      viewProjection[0] = 4.0f;
+      viewProjection[5] = 4.0f;
+      cullingSystem = std::make_unique<LveCullingSystem>(
+          device,
+          *indirectDrawSystem,
+          VkExtent2D{options.width, options.height});
+    }
+  }
+
+  // frame time is beginFrame to beginFrame, so one extra frame closes the last measurement
+  std::vector<double> frameMilliseconds;
+  std::vector<double> cpuWaitMilliseconds;
+  int totalFrames = options.warmupFrames + options.frames + 1;
+  for (int frame = 0; frame < totalFrames; frame++) {
+    if (frame == options.warmupFrames && !options.tracePath.empty()) {
+      device.profiler().startTrace();
+    }
+    VkCommandBuffer commandBuffer = renderer.beginFrame();
+    if (frame > options.warmupFrames) {
+      frameMilliseconds.push_back(renderer.lastFrameStats().frameMilliseconds);
+      cpuWaitMilliseconds.push_back(renderer.lastFrameStats().cpuWaitMilliseconds);
+    }
+    if (cullingSystem) {
+      cullingSystem->cull(
+          commandBuffer,
+          renderer.getFrameIndex(),
+          viewProjection,
+          renderer.getPreviousDepth());
+    }
+    {
+      LveProfileScope scenePass{device.profiler(), commandBuffer, options.scene, true};
+      renderer.beginSwapChainRenderPass(commandBuffer);
+      if (indirectDrawSystem) {
+        indirectDrawSystem->render(commandBuffer, viewProjection);
+      } else {
+        pipeline->bind(commandBuffer);
+        for (uint32_t draw = 0; draw < drawCount; draw++) {
+          vkCmdDraw(commandBuffer, 3, instanceCount, 0, 0);
+        }
+      }
+      renderer.endSwapChainRenderPass(commandBuffer);
+    }
+    renderer.endFrame();
+  }
+  vkDeviceWaitIdle(device.device());
+  device.profiler().printAverages(std::cout);
+  if (!options.tracePath.empty()) {
+    device.profiler().writeChromeTrace(options.tracePath);
+  }
+  LveCullingStats cullingStats{};
+  if (cullingSystem) cullingStats = cullingSystem->lastStats();
+  cullingSystem.reset();
+  indirectDrawSystem.reset();
+  meshPool.reset();
+  pipeline.reset();
+  vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+
+  double totalMilliseconds = 0.0;
+  for (double milliseconds : frameMilliseconds) totalMilliseconds += milliseconds;
+  double totalWaitMilliseconds = 0.0;
+  for (double milliseconds : cpuWaitMilliseconds) totalWaitMilliseconds += milliseconds;
+  std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+
+  std::ofstream out{options.outputPath};
+  if (!out.is_open()) {
+    throw std::runtime_error("failed to open " + options.outputPath + "!");
+  }
+  out << "{\n"
+      << "  \"scene\": \"" << options.scene << "\",\n"
+      << "  \"device\": \"" << device.properties.deviceName << "\",\n"
+      << "  \"width\": " << options.width << ",\n"
+      << "  \"height\": " << options.height << ",\n"
+      << "  \"frames\": " << frameMilliseconds.size() << ",\n"
+      << "  \"warmup_frames\": " << options.warmupFrames << ",\n"
+      << "  \"mean_ms\": " << totalMilliseconds / frameMilliseconds.size() << ",\n"
+      << "  \"min_ms\": " << frameMilliseconds.front() << ",\n"
+      << "  \"p50_ms\": " << percentile(frameMilliseconds, 50.0) << ",\n"
+      << "  \"p95_ms\": " << percentile(frameMilliseconds, 95.0) << ",\n"
+      << "  \"p99_ms\": " << percentile(frameMilliseconds, 99.0) << ",\n"
+      << "  \"max_ms\": " << frameMilliseconds.back() << ",\n"
+      << "  \"mean_cpu_wait_ms\": " << totalWaitMilliseconds / cpuWaitMilliseconds.size();
+  if (options.scene == "culled") {
+    out << ",\n"
+        << "  \"visible_instances\": " << cullingStats.visibleInstances << ",\n"
+        << "  \"frustum_culled_instances\": " << cullingStats.frustumCulledInstances << ",\n"
+        << "  \"occlusion_culled_instances\": " << cullingStats.occlusionCulledInstances << ",\n"
+        << "  \"visible_draw_commands\": " << cullingStats.visibleDrawCommands;
+  }
+  out << "\n"
+      << "}" << std::endl;
+
+  std::cout << "frame benchmark: " << options.scene << ", " << frameMilliseconds.size()
+            << " frames, p50 " << percentile(frameMilliseconds, 50.0) << " ms, p95 "
+            << percentile(frameMilliseconds, 95.0) << " ms, p99 "
+            << percentile(frameMilliseconds, 99.0) << " ms -> " << options.outputPath
+            << std::endl;
+  return 0;
+}
+
+int runRenderGraphBenchmark(LveDevice &device, int frames) {
+  if (frames <= 0) {
+    throw std::runtime_error("render graph benchmark needs at least one frame!");
+  }
+  const VkExtent2D extent{1920, 1080};
+  const VkExtent2D halfExtent{extent.width / 2, extent.height / 2};
+  VkFormat depthFormat = device.findSupportedFormat(
+      {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+  // the frame ends up here, as it would in a swap chain image
+  const VkFormat outputFormat = VK_FORMAT_R8G8B8A8_UNORM;
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = extent.width;
+  imageInfo.extent.height = extent.height;
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = outputFormat;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  VkImage outputImage;
+  LveAllocation *outputMemory;
+  device.createImageWithInfo(
+      imageInfo,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      outputImage,
+      outputMemory,
+      LveMemoryCategory::RenderTarget);
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = outputImage;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = outputFormat;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.levelCount = 1;
+  viewInfo.subresourceRange.layerCount = 1;
+  VkImageView outputView;
+  if (vkCreateImageView(device.device(), &viewInfo, nullptr, &outputView) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark output image view!");
+  }
+
+  // The passes record nothing of their own: what is measured is what the graph adds around
+  // them, the render passes, clears and barriers.
+  using Usage = LveRenderGraphUsage;
+  auto compileStart = std::chrono::high_resolution_clock::now();
+  LveRenderGraph graph{device};
+  auto depth = graph.createImage("depth", depthFormat, extent);
+  auto albedo = graph.createImage("albedo", VK_FORMAT_R8G8B8A8_UNORM, extent);
+  auto normal = graph.createImage("normal", VK_FORMAT_R16G16B16A16_SFLOAT, extent);
+  auto ao = graph.createImage("ao", VK_FORMAT_R32_SFLOAT, extent);
+  auto aoBlurred = graph.createImage("ao blurred", VK_FORMAT_R32_SFLOAT, extent);
+  auto hdr = graph.createImage("hdr", VK_FORMAT_R16G16B16A16_SFLOAT, extent);
+  auto bloom = graph.createImage("bloom", VK_FORMAT_R16G16B16A16_SFLOAT, halfExtent);
+  auto bloomBlurred = graph.createImage("bloom blurred", VK_FORMAT_R16G16B16A16_SFLOAT, halfExtent);
+  auto debug = graph.createImage("debug", VK_FORMAT_R8G8B8A8_UNORM, extent);
+  auto output = graph.importImage(
+      "output",
+      outputFormat,
+      extent,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+  graph.setImportedImage(output, outputImage, outputView);
+
+  auto prepass = graph.addPass("depth prepass", nullptr);
+  graph.use(prepass, depth, Usage::DepthAttachment);
+  graph.clearDepth(prepass, depth);
+  auto gbuffer = graph.addPass("gbuffer", nullptr);
+  graph.use(gbuffer, albedo, Usage::ColorAttachment);
+  graph.use(gbuffer, normal, Usage::ColorAttachment);
+  graph.use(gbuffer, depth, Usage::DepthAttachment);
+  graph.clearColor(gbuffer, albedo, {});
+  graph.clearColor(gbuffer, normal, {});
+  auto ssao = graph.addPass("ssao", nullptr);
+  graph.use(ssao, depth, Usage::Sampled);
+  graph.use(ssao, normal, Usage::Sampled);
+  graph.use(ssao, ao, Usage::StorageWrite);
+  auto ssaoBlur = graph.addPass("ssao blur", nullptr);
+  graph.use(ssaoBlur, ao, Usage::Sampled);
+  graph.use(ssaoBlur, aoBlurred, Usage::StorageWrite);
+  auto lighting = graph.addPass("lighting", nullptr);
+  graph.use(lighting, albedo, Usage::Sampled);
+  graph.use(lighting, normal, Usage::Sampled);
+  graph.use(lighting, aoBlurred, Usage::Sampled);
+  graph.use(lighting, depth, Usage::DepthReadOnly);
+  graph.use(lighting, depth, Usage::Sampled);
+  graph.use(lighting, hdr, Usage::ColorAttachment);
+  graph.clearColor(lighting, hdr, {});
+  auto bloomExtract = graph.addPass("bloom extract", nullptr);
+  graph.use(bloomExtract, hdr, Usage::Sampled);
+  graph.use(bloomExtract, bloom, Usage::StorageWrite);
+  auto bloomBlur = graph.addPass("bloom blur", nullptr);
+  graph.use(bloomBlur, bloom, Usage::Sampled);
+  graph.use(bloomBlur, bloomBlurred, Usage::StorageWrite);
+  auto tonemap = graph.addPass("tonemap", nullptr);
+  graph.use(tonemap, hdr, Usage::Sampled);
+  graph.use(tonemap, bloomBlurred, Usage::Sampled);
+  graph.use(tonemap, output, Usage::ColorAttachment);
+  // nothing reads it, so it is culled along with its image
+  auto debugView = graph.addPass("debug view", nullptr);
+  graph.use(debugView, normal, Usage::Sampled);
+  graph.use(debugView, debug, Usage::ColorAttachment);
+  graph.compile();
+  double compileMilliseconds = std::chrono::duration<double, std::milli>(
+                                   std::chrono::high_resolution_clock::now() - compileStart)
+                                   .count();
+
+  double recordMilliseconds = 0.0;
+  auto frameStart = std::chrono::high_resolution_clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+    auto recordStart = std::chrono::high_resolution_clock::now();
+    graph.execute(commandBuffer);
+    recordMilliseconds += std::chrono::duration<double, std::milli>(
+                              std::chrono::high_resolution_clock::now() - recordStart)
+                              .count();
+    device.endSingleTimeCommands(commandBuffer);
+  }
+  double frameMilliseconds = std::chrono::duration<double, std::milli>(
+                                 std::chrono::high_resolution_clock::now() - frameStart)
+                                 .count();
+
+  graph.printReport(std::cout);
+  const LveRenderGraphStats &stats = graph.stats();
+  std::cout << "render graph benchmark: " << extent.width << "x" << extent.height
+            << ", compiled in " << compileMilliseconds << " ms, " << frames
+            << " frames recorded in " << recordMilliseconds / frames << " ms and submitted in "
+            << frameMilliseconds / frames << " ms on average; " << stats.imageBarriers
+            << " barriers in " << stats.barrierBatches << " calls against "
+            << stats.imageUses << " for a barrier per use, "
+            << (stats.transientBytes - stats.aliasedBytes) / (1024 * 1024) << " of "
+            << stats.transientBytes / (1024 * 1024) << " MiB of transient images saved"
+            << std::endl;
+
+  vkDeviceWaitIdle(device.device());
+  vkDestroyImageView(device.device(), outputView, nullptr);
+  device.destroyImage(outputImage, outputMemory);
+  return 0;
+}
+
+int runMeshLoadBenchmark(LveDevice &device, uint32_t triangles) {
+  constexpr int RUNS = 5;
+  const std::string objPath = "mesh_benchmark.obj";
+  const std::string meshPath = "mesh_benchmark.lvemesh";
+
+  {
+    LveMeshData mesh = makeGridMesh(triangles);
+    writeObj(objPath, mesh);
+    LveMeshFile::write(meshPath, mesh);
+    std::cout << "mesh load benchmark: " << mesh.indices.size() / 3 << " triangles, "
+              << mesh.vertices.size() << " vertices, best of " << RUNS << " runs"
+              << " (both files are in the page cache after being written)" << std::endl;
+  }
+
+  double objSeconds = 1e30;
+  double mappedSeconds = 1e30;
+  uint64_t objChecksum = 0;
+  uint64_t mappedChecksum = 0;
+  for (int run = 0; run < RUNS; run++) {
+    auto start = Clock::now();
+    LveMeshData mesh = LveObjLoader::load(objPath);
+    objChecksum = touchIndices(mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()));
+    objSeconds = std::min(objSeconds, secondsSince(start));
+
+    start = Clock::now();
+    LveMeshFile file{meshPath};
+    mappedChecksum = touchIndices(file.indices(), file.indexCount());
+    mappedSeconds = std::min(mappedSeconds, secondsSince(start));
+  }
+  if (objChecksum != mappedChecksum) {
+    throw std::runtime_error("obj and mesh file loads disagree!");
+  }
+
+  // load and upload: a fresh pool per run so both paths copy into empty buffers
+  double objUploadSeconds = 1e30;
+  double mappedUploadSeconds = 1e30;
+  for (int run = 0; run < RUNS; run++) {
+    auto start = Clock::now();
+    {
+      LveMeshData mesh = LveObjLoader::load(objPath);
+      LveMeshPool meshPool{
+          device,
+          static_cast<uint32_t>(mesh.vertices.size()),
+          static_cast<uint32_t>(mesh.indices.size())};
+      meshPool.addMesh(mesh.vertices, mesh.indices);
+      device.uploadManager().wait(meshPool.lastUpload());
+      objUploadSeconds = std::min(objUploadSeconds, secondsSince(start));
+    }
+
+    start = Clock::now();
+    {
+      LveMeshFile file{meshPath};
+      LveMeshPool meshPool{device, file.vertexCount(), file.indexCount()};
+      meshPool.addMeshFile(file);
+      device.uploadManager().wait(meshPool.lastUpload());
+      mappedUploadSeconds = std::min(mappedUploadSeconds, secondsSince(start));
+    }
+  }
+
+  std::cout << "\tload obj:           " << objSeconds * 1000.0 << " ms" << std::endl;
+  std::cout << "\tload mapped:        " << mappedSeconds * 1000.0 << " ms ("
+            << objSeconds / mappedSeconds << "x)" << std::endl;
+  std::cout << "\tload+upload obj:    " << objUploadSeconds * 1000.0 << " ms" << std::endl;
+  std::cout << "\tload+upload mapped: " << mappedUploadSeconds * 1000.0 << " ms ("
+            << objUploadSeconds / mappedUploadSeconds << "x)" << std::endl;
+  return 0;
+}
+
+int runLodBenchmark(LveDevice &device, uint32_t triangles, int frames) {
+  if (frames <= 0) {
+    throw std::runtime_error("lod benchmark needs at least one frame!");
+  }
+  const std::string meshPath = "lod_benchmark.lvemesh";
+  const VkExtent2D extent{1280, 720};
+  const float verticalFov = 1.0f;  // radians
+  const uint32_t columns = 32;
+  const uint32_t rows = 64;
+
+  // ripples across the grid give the simplifier something to lose, unlike a flat plane
+  {
+    LveMeshData mesh = makeGridMesh(triangles);
+    for (LveVertex &vertex : mesh.vertices) {
+      vertex.position[2] +=
+          0.05f * std::sin(9.0f * vertex.position[0]) * std::cos(7.0f * vertex.position[1]);
+    }
+    LveMeshOptimizer::optimize(mesh).print(std::cout);
+    LveMeshFile::write(meshPath, mesh);
+  }
+  LveMeshFile file{meshPath};
+  LveMeshPool meshPool{device, file.vertexCount(), file.indexCount()};
+  LveMeshLodChain chain = meshPool.addMeshFile(file)[0];
+  device.uploadManager().wait(meshPool.lastUpload());
+
+  std::cout << "lod benchmark: " << columns * rows << " instances, " << chain.levels.size()
+            << " levels" << std::endl;
+  for (size_t level = 0; level < chain.levels.size(); level++) {
+    std::cout << "\tlevel " << level << ": " << chain.levels[level].indexCount / 3
+              << " triangles, error " << chain.errors[level] << std::endl;
+  }
+
+  LveRenderer renderer{device, extent};
+  LveIndirectDrawSystem indirectDrawSystem{
+      device, meshPool, renderer.getSwapChainRenderPass(), columns * rows};
+  // tinted by level, so a capture shows where the switches happen
+  for (uint32_t level = 0; level < chain.levels.size(); level++) {
+    indirectDrawSystem.setMaterialColor(level, 1.0f - 0.2f * level, 0.4f + 0.15f * level, 0.6f);
+  }
+
+  // looking down +z from the origin; depth 0 at the near plane, 1 at the far one
+  const float nearPlane = 0.1f;
+  const float farPlane = 500.0f;
+  const float focal = 1.0f / std::tan(0.5f * verticalFov);
+  std::array<float, 16> viewProjection{};
+  viewProjection[0] = focal * extent.height / extent.width;
+  viewProjection[5] = focal;
+  viewProjection[10] = farPlane / (farPlane - nearPlane);
+  viewProjection[11] = 1.0f;
+  viewProjection[14] = -farPlane * nearPlane / (farPlane - nearPlane);
+
+  LveLodSelector selector{verticalFov, extent.height};
+  auto run = [&](const char *name, bool selectLevels) {
+    vkDeviceWaitIdle(device.device());
+    indirectDrawSystem.clearInstances();
+    std::vector<uint32_t> instancesPerLevel(chain.levels.size(), 0);
+    uint64_t drawnTriangles = 0;
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < columns * rows; i++) {
+      std::array<float, 3> translation{
+          (static_cast<float>(i % columns) - 0.5f * columns) * 2.5f,
+          -2.0f,
+          3.0f + 2.5f * static_cast<float>(i / columns)};
+      uint32_t level = 0;
+      if (selectLevels) {
+        indirectDrawSystem.addInstance(
+            chain, selector, translation, 1.0f, {0.0f, 0.0f, 0.0f, 1.0f}, 0, &level);
+      } else {
+        indirectDrawSystem.addInstance(
+            chain.levels[0], translation, 1.0f, {0.0f, 0.0f, 0.0f, 1.0f}, 0);
+      }
+      instancesPerLevel[level]++;
+      drawnTriangles += chain.levels[level].indexCount / 3;
+    }
+    double selectMilliseconds = secondsSince(start) * 1000.0;
+    indirectDrawSystem.upload(renderer);
+
+    double totalMilliseconds = 0.0;
+    for (int frame = 0; frame <= frames; frame++) {
+      VkCommandBuffer commandBuffer = renderer.beginFrame();
+      // frame time is beginFrame to beginFrame, so the first one measures nothing of this run
+      if (frame > 0) totalMilliseconds += renderer.lastFrameStats().frameMilliseconds;
+      renderer.beginSwapChainRenderPass(commandBuffer);
+      indirectDrawSystem.render(commandBuffer, viewProjection);
+      renderer.endSwapChainRenderPass(commandBuffer);
+      renderer.endFrame();
+    }
+
+    std::cout << "\t" << name << ": " << drawnTriangles << " triangles per frame, "
+              << totalMilliseconds / frames << " ms per frame, instances per level";
+    for (uint32_t count : instancesPerLevel) std::cout << " " << count;
+    std::cout << " (added in " << selectMilliseconds << " ms)" << std::endl;
+    return drawnTriangles;
+  };
+  uint64_t fullTriangles = run("full detail", false);
+  uint64_t selectedTriangles = run("selected   ", true);
+  std::cout << "\tlevel selection draws " << 100.0 * selectedTriangles / fullTriangles
+            << "% of the full-detail triangles at under a pixel of error" << std::endl;
+
+  vkDeviceWaitIdle(device.device());
+  return 0;
+}
+
+int runRecordingBenchmark(LveDevice &device, uint32_t draws, int frames) {
+  if (frames <= 0 || draws == 0) {
+    throw std::runtime_error("recording benchmark needs at least one frame and one draw!");
+  }
+  // small target: the GPU cost of the draws should stay out of the measurement
+  const VkExtent2D extent{256, 256};
+  LveRenderer renderer{device, extent};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  VkPipelineLayout pipelineLayout;
+  if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark pipeline layout!");
+  }
+  auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+  pipelineConfig.renderPass = renderer.getSwapChainRenderPass();
+  pipelineConfig.pipelineLayout = pipelineLayout;
+  LvePipeline pipeline{
+      device, "shaders/simple_shader.vert.spv", "shaders/simple_shader.frag.spv", pipelineConfig};
+
+  // returns the median CPU time spent recording the render pass, in milliseconds
+  auto runFrames = [&](const std::function<void(VkCommandBuffer)> &recordPass) {
+    std::vector<double> recordMilliseconds;
+    for (int frame = 0; frame < frames; frame++) {
+      VkCommandBuffer commandBuffer = renderer.beginFrame();
+      auto start = Clock::now();
+      recordPass(commandBuffer);
+      recordMilliseconds.push_back(secondsSince(start) * 1000.0);
+      renderer.endFrame();
+    }
+    vkDeviceWaitIdle(device.device());
+    std::sort(recordMilliseconds.begin(), recordMilliseconds.end());
+    return percentile(recordMilliseconds, 50.0);
+  };
+
+  std::cout << "recording benchmark: " << draws << " draws, median of " << frames << " frames"
+            << std::endl;
+  double inlineMilliseconds = runFrames([&](VkCommandBuffer commandBuffer) {
+    renderer.beginSwapChainRenderPass(commandBuffer);
+    pipeline.bind(commandBuffer);
+    for (uint32_t draw = 0; draw < draws; draw++) {
+      vkCmdDraw(commandBuffer, 3, 1, 0, draw);
+    }
+    renderer.endSwapChainRenderPass(commandBuffer);
+  });
+  std::cout << "\tinline:  " << inlineMilliseconds << " ms" << std::endl;
+
+  uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<uint32_t> threadCounts;
+  for (uint32_t threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+  threadCounts.push_back(maxThreads);
+
+  double oneThreadMilliseconds = 0.0;
+  for (uint32_t threads : threadCounts) {
+    LveThreadPool threadPool{threads};
+    LveParallelRecorder recorder{device, threadPool, LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT};
+    // several chunks per thread, so threads that finish early have something to steal
+    uint32_t chunkSize = std::max(256u, draws / (4 * threads));
+    double milliseconds = runFrames([&](VkCommandBuffer commandBuffer) {
+      recorder.beginFrame(static_cast<uint32_t>(renderer.getFrameIndex()));
+      renderer.beginSwapChainRenderPass(
+          commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+      recorder.record(
+          commandBuffer,
+          renderer.getSwapChainRenderPass(),
+          renderer.getCurrentFramebuffer(),
+          draws,
+          chunkSize,
+          [&pipeline, extent](VkCommandBuffer secondary, uint32_t first, uint32_t count) {
+            pipeline.bind(secondary);
+            LvePipeline::setViewportAndScissor(secondary, extent);
+            for (uint32_t draw = first; draw < first + count; draw++) {
+              vkCmdDraw(secondary, 3, 1, 0, draw);
+            }
+          });
+      renderer.endSwapChainRenderPass(commandBuffer);
+    });
+    if (threads == 1) oneThreadMilliseconds = milliseconds;
+    std::cout << "\t" << threads << " threads: " << milliseconds << " ms, "
+              << oneThreadMilliseconds / milliseconds << "x over 1 thread, "
+              << inlineMilliseconds / milliseconds << "x over inline" << std::endl;
+  }
+
+  vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+  return 0;
+}
+
+int runSceneBenchmark(uint32_t objects, int frames) {
+  if (frames <= 0 || objects == 0) {
+    throw std::runtime_error("scene benchmark needs at least one frame and one object!");
+  }
+  const uint32_t roots = std::min(objects, 1024u);
+  const uint32_t movingPerFrame = std::max(1u, objects / 100);
+
+  struct Config {
+    const char *name;
+    bool useSimd;
+    uint32_t threads;  // 0 runs without a thread pool
+  };
+  uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+  const Config configs[] = {
+      {"scalar, 1 thread", false, 0},
+      {"simd, 1 thread", true, 0},
+      {"simd, all threads", true, hardwareThreads}};
+
+  std::cout << "scene benchmark: " << objects << " objects, median of " << frames
+            << " frames, simd width " << LveScene::simdWidth() << ", " << hardwareThreads
+            << " hardware threads" << std::endl;
+
+  double baselineMilliseconds[2] = {0.0, 0.0};
+  for (const Config &config : configs) {
+    std::unique_ptr<LveThreadPool> threadPool;
+    if (config.threads > 0) threadPool = std::make_unique<LveThreadPool>(config.threads);
+    LveScene scene{threadPool.get(), config.useSimd};
+
+    std::vector<LveSceneObjectId> ids;
+    ids.reserve(objects);
+    for (uint32_t i = 0; i < objects; i++) {
+      LveSceneObjectId parent = i < roots ? LVE_SCENE_NO_PARENT : ids[(i - roots) / 8];
+      LveTransform transform{};
+      transform.translation = {static_cast<float>(i % 8), 1.0f, 0.0f};
+      transform.scale = {0.9f, 0.9f, 0.9f};
+      LveBoundingSphere bounds{};
+      bounds.radius = 0.5f;
+      ids.push_back(scene.createObject(parent, transform, bounds, i));
+    }
+    LveSceneUpdateStats built = scene.update();
+
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<uint32_t> pick{0, objects - 1};
+    // moving every root dirties the whole hierarchy below it
+    auto runFrames = [&](bool everything) {
+      std::vector<double> milliseconds;
+      for (int frame = 0; frame < frames; frame++) {
+        float angle = 0.01f * static_cast<float>(frame);
+        std::array<float, 4> rotation{0.0f, std::sin(angle), 0.0f, std::cos(angle)};
+        if (everything) {
+          for (uint32_t i = 0; i < roots; i++) scene.setRotation(ids[i], rotation);
+        } else {
+          for (uint32_t i = 0; i < movingPerFrame; i++) scene.setRotation(ids[pick(rng)], rotation);
+        }
+        auto start = Clock::now();
+        scene.update();
+        milliseconds.push_back(secondsSince(start) * 1000.0);
+      }
+      std::sort(milliseconds.begin(), milliseconds.end());
+      return percentile(milliseconds, 50.0);
+    };
+
+    double results[2] = {runFrames(true), runFrames(false)};
+    if (!config.useSimd) {
+      baselineMilliseconds[0] = results[0];
+      baselineMilliseconds[1] = results[1];
+    }
+    std::cout << "\t" << config.name << " (" << built.depthLevels << " levels):" << std::endl;
+    for (int i = 0; i < 2; i++) {
+      std::cout << "\t\t" << (i == 0 ? "all moving: " : "1% moving:  ") << results[i] << " ms, "
+                << objects / (results[i] * 1000.0) << " M objects/s, "
+                << baselineMilliseconds[i] / results[i] << "x over scalar" << std::endl;
+    }
+  }
+  return 0;
+}
+
+int runDescriptorBenchmark(LveDevice &device, uint32_t setsPerFrame, int frames) {
+  if (frames <= 0 || setsPerFrame == 0) {
+    throw std::runtime_error("descriptor benchmark needs at least one frame and one set!");
+  }
+  const uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+  VkBuffer buffer;
+  LveAllocation *bufferMemory;
+  device.createBuffer(
+      256,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      buffer,
+      bufferMemory);
+
+  // a uniform buffer and a storage buffer, like a typical per-draw set
+  std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+  bindings[0] = {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+  bindings[1] = {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+  std::array<VkDescriptorPoolSize, 2> poolSizes{};
+  poolSizes[0] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1};
+  poolSizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
+
+  auto writeSet = [&](VkDescriptorSet set) {
+    VkDescriptorBufferInfo bufferInfo{buffer, 0, VK_WHOLE_SIZE};
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t i = 0; i < writes.size(); i++) {
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].dstSet = set;
+      writes[i].dstBinding = i;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = bindings[i].descriptorType;
+      writes[i].pBufferInfo = &bufferInfo;
+    }
+    vkUpdateDescriptorSets(
+        device.device(),
+        static_cast<uint32_t>(writes.size()),
+        writes.data(),
+        0,
+        nullptr);
+  };
+
+  std::cout << "descriptor benchmark: " << setsPerFrame << " sets per frame, median of "
+            << frames << " frames" << std::endl;
+
+  // ad hoc: a layout and a pool per set, destroyed when its frame comes around again. Nothing is
+  // submitted, so the frames in flight only model how long the objects would have to live.
+  struct AdHocSet {
+    VkDescriptorSetLayout layout;
+    VkDescriptorPool pool;
+  };
+  std::vector<std::vector<AdHocSet>> adHocFrames(framesInFlight);
+  std::vector<double> adHocMilliseconds;
+  for (int frame = 0; frame < frames; frame++) {
+    auto start = Clock::now();
+    auto &frameSets = adHocFrames[frame % framesInFlight];
+    for (const AdHocSet &adHoc : frameSets) {
+      vkDestroyDescriptorPool(device.device(), adHoc.pool, nullptr);
+      vkDestroyDescriptorSetLayout(device.device(), adHoc.layout, nullptr);
+    }
+    frameSets.clear();
+    for (uint32_t i = 0; i < setsPerFrame; i++) {
+      AdHocSet adHoc{};
+      VkDescriptorSetLayoutCreateInfo layoutInfo{};
+      layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+      layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+      layoutInfo.pBindings = bindings.data();
+      VkDescriptorPoolCreateInfo poolInfo{};
+      poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+      poolInfo.maxSets = 1;
+      poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+      poolInfo.pPoolSizes = poolSizes.data();
+      if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &adHoc.layout) !=
+              VK_SUCCESS ||
+          vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &adHoc.pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create ad hoc descriptor objects!");
+      }
+      VkDescriptorSetAllocateInfo allocInfo{};
+      allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+      allocInfo.descriptorPool = adHoc.pool;
+      allocInfo.descriptorSetCount = 1;
+      allocInfo.pSetLayouts = &adHoc.layout;
+      VkDescriptorSet set;
+      if (vkAllocateDescriptorSets(device.device(), &allocInfo, &set) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate ad hoc descriptor set!");
+      }
+      writeSet(set);
+      frameSets.push_back(adHoc);
+    }
+    adHocMilliseconds.push_back(secondsSince(start) * 1000.0);
+  }
+  for (auto &frameSets : adHocFrames) {
+    for (const AdHocSet &adHoc : frameSets) {
+      vkDestroyDescriptorPool(device.device(), adHoc.pool, nullptr);
+      vkDestroyDescriptorSetLayout(device.device(), adHoc.layout, nullptr);
+    }
+  }
+  std::sort(adHocMilliseconds.begin(), adHocMilliseconds.end());
+  double adHocMedian = percentile(adHocMilliseconds, 50.0);
+  std::cout << "\tad hoc:   " << adHocMedian << " ms, " << 2 * setsPerFrame
+            << " objects created per frame" << std::endl;
+
+  LveDescriptorAllocator allocator{device.device(), framesInFlight};
+  LveDescriptorAllocatorStats lastStats;
+  uint32_t totalPoolsCreated = 0;
+  std::vector<double> linearMilliseconds;
+  for (int frame = 0; frame < frames; frame++) {
+    auto start = Clock::now();
+    allocator.beginFrame(static_cast<uint32_t>(frame) % framesInFlight);
+    for (uint32_t i = 0; i < setsPerFrame; i++) {
+      // looked up per set on purpose, to include the cache in the measurement
+      VkDescriptorSetLayout layout = device.descriptorLayoutCache().getLayout(bindings);
+      writeSet(allocator.allocate(layout));
+    }
+    linearMilliseconds.push_back(secondsSince(start) * 1000.0);
+    lastStats = allocator.frameStats();
+    totalPoolsCreated += lastStats.poolsCreated;
+  }
+  std::sort(linearMilliseconds.begin(), linearMilliseconds.end());
+  double linearMedian = percentile(linearMilliseconds, 50.0);
+  std::cout << "\tlinear:   " << linearMedian << " ms (" << adHocMedian / linearMedian
+            << "x), last frame " << lastStats.setsAllocated << " sets, " << lastStats.poolResets
+            << " pool resets, " << lastStats.poolsCreated << " pools created; " << totalPoolsCreated
+            << " pools over the run, " << device.descriptorLayoutCache().layoutCount()
+            << " cached layouts" << std::endl;
+
+  device.destroyBuffer(buffer, bufferMemory);
+  return 0;
+}
+
+int runBindlessBenchmark(LveDevice &device, uint32_t objects, int frames) {
+  if (frames <= 0 || objects == 0) {
+    throw std::runtime_error("bindless benchmark needs at least one frame and one object!");
+  }
+  if (!device.supportsBindless()) {
+    throw std::runtime_error("bindless benchmark needs descriptor indexing!");
+  }
+  const uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+  LveRenderer renderer{device, VkExtent2D{1280, 720}, framesInFlight};
+  LveBindlessHeap heap{device, framesInFlight, 16, 16, objects};
+  if (heap.capacity(LveBindlessHeap::STORAGE_BUFFER_BINDING) < objects) {
+    throw std::runtime_error(
+        "the device fits " +
+        std::to_string(heap.capacity(LveBindlessHeap::STORAGE_BUFFER_BINDING)) +
+        " storage buffers in the bindless heap, fewer than the objects!");
+  }
+
+  // per object: xy offset, scale, padding and a color, in a range of one shared buffer
+  const VkDeviceSize objectSize = sizeof(float) * 8;
+  const VkDeviceSize stride = std::max<VkDeviceSize>(
+      objectSize, device.properties.limits.minStorageBufferOffsetAlignment);
+  VkBuffer objectBuffer;
+  LveAllocation *objectMemory;
+  device.createBuffer(
+      stride * objects,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      objectBuffer,
+      objectMemory);
+  uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(objects))));
+  for (uint32_t i = 0; i < objects; i++) {
+    float u = (static_cast<float>(i % columns) + 0.5f) / columns;
+    float v = (static_cast<float>(i / columns) + 0.5f) / columns;
+    float data[8] = {u * 2.0f - 1.0f, v * 2.0f - 1.0f, 1.8f / columns, 0.0f, u, v, 1.0f - u, 0.0f};
+    std::memcpy(static_cast<char *>(objectMemory->mapped) + stride * i, data, sizeof(data));
+  }
+
+  // a set per object, as the engine binds resources without the heap
+  VkDescriptorSetLayoutBinding binding{
+      0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+  VkDescriptorSetLayout objectSetLayout = device.descriptorLayoutCache().getLayout({binding});
+  VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, objects};
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.maxSets = objects;
+  poolInfo.poolSizeCount = 1;
+  poolInfo.pPoolSizes = &poolSize;
+  VkDescriptorPool objectPool;
+  if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &objectPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark descriptor pool!");
+  }
+  std::vector<VkDescriptorSetLayout> setLayouts(objects, objectSetLayout);
+  std::vector<VkDescriptorSet> objectSets(objects);
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = objectPool;
+  allocInfo.descriptorSetCount = objects;
+  allocInfo.pSetLayouts = setLayouts.data();
+  if (vkAllocateDescriptorSets(device.device(), &allocInfo, objectSets.data()) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate benchmark descriptor sets!");
+  }
+  std::vector<LveBindlessHandle> handles(objects);
+  for (uint32_t i = 0; i < objects; i++) {
+    VkDescriptorBufferInfo bufferInfo{objectBuffer, stride * i, objectSize};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = objectSets[i];
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+    handles[i] = heap.addStorageBuffer(objectBuffer, stride * i, objectSize);
+  }
+
+  VkPushConstantRange pushConstantRange{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t)};
+  auto createLayout = [&device](VkDescriptorSetLayout setLayout, const VkPushConstantRange *push) {
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = push ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = push;
+    VkPipelineLayout pipelineLayout;
+    if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create benchmark pipeline layout!");
+    }
+    return pipelineLayout;
+  };
+  VkPipelineLayout boundLayout = createLayout(objectSetLayout, nullptr);
+  VkPipelineLayout bindlessLayout = createLayout(heap.getDescriptorSetLayout(), &pushConstantRange);
+
+  auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+  pipelineConfig.renderPass = renderer.getSwapChainRenderPass();
+  pipelineConfig.pipelineLayout = boundLayout;
+  LvePipeline boundPipeline{
+      device, "shaders/bound_object.vert.spv", "shaders/indirect.frag.spv", pipelineConfig};
+  pipelineConfig.pipelineLayout = bindlessLayout;
+  LvePipeline bindlessPipeline{
+      device, "shaders/bindless_object.vert.spv", "shaders/indirect.frag.spv", pipelineConfig};
+
+  std::cout << "bindless benchmark: " << objects << " objects, median of " << frames
+            << " frames" << std::endl;
+
+  // returns the median CPU time spent recording the frame's draws, in milliseconds
+  auto runFrames = [&](const std::function<void(VkCommandBuffer)> &record) {
+    std::vector<double> recordMilliseconds;
+    for (int frame = 0; frame < frames; frame++) {
+      VkCommandBuffer commandBuffer = renderer.beginFrame();
+      heap.beginFrame(static_cast<uint32_t>(renderer.getFrameIndex()));
+      renderer.beginSwapChainRenderPass(commandBuffer);
+      auto start = Clock::now();
+      record(commandBuffer);
+      recordMilliseconds.push_back(secondsSince(start) * 1000.0);
+      renderer.endSwapChainRenderPass(commandBuffer);
+      renderer.endFrame();
+    }
+    vkDeviceWaitIdle(device.device());
+    std::sort(recordMilliseconds.begin(), recordMilliseconds.end());
+    return percentile(recordMilliseconds, 50.0);
+  };
+
+  double boundMilliseconds = runFrames([&](VkCommandBuffer commandBuffer) {
+    boundPipeline.bind(commandBuffer);
+    for (uint32_t i = 0; i < objects; i++) {
+      vkCmdBindDescriptorSets(
+          commandBuffer,
+          VK_PIPELINE_BIND_POINT_GRAPHICS,
+          boundLayout,
+          0,
+          1,
+          &objectSets[i],
+          0,
+          nullptr);
+      vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+    }
+  });
+  std::cout << "\tset per object: " << boundMilliseconds << " ms, " << objects
+            << " descriptor set binds per frame" << std::endl;
+
+  double bindlessMilliseconds = runFrames([&](VkCommandBuffer commandBuffer) {
+    bindlessPipeline.bind(commandBuffer);
+    heap.bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bindlessLayout);
+    for (uint32_t i = 0; i < objects; i++) {
+      vkCmdPushConstants(
+          commandBuffer,
+          bindlessLayout,
+          VK_SHADER_STAGE_VERTEX_BIT,
+          0,
+          sizeof(uint32_t),
+          &handles[i]);
+      vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+    }
+  });
+  std::cout << "\tbindless heap:  " << bindlessMilliseconds << " ms ("
+            << boundMilliseconds / bindlessMilliseconds << "x), 1 descriptor set bind per frame"
+            << std::endl;
+
+  for (LveBindlessHandle handle : handles) heap.freeStorageBuffer(handle);
+  vkDestroyPipelineLayout(device.device(), bindlessLayout, nullptr);
+  vkDestroyPipelineLayout(device.device(), boundLayout, nullptr);
+  vkDestroyDescriptorPool(device.device(), objectPool, nullptr);
+  device.destroyBuffer(objectBuffer, objectMemory);
+  return 0;
+}
+
+int runUniformBenchmark(LveDevice &device, uint32_t objects, int frames) {
+  if (frames <= 0 || objects == 0) {
+    throw std::runtime_error("uniform benchmark needs at least one frame and one object!");
+  }
+  const uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+  LveRenderer renderer{device, VkExtent2D{64, 64}, framesInFlight};
+
+  // a model matrix and a color per object
+  struct ObjectUniforms {
+    std::array<float, 16> model;
+    std::array<float, 4> color;
+  };
+  ObjectUniforms uniforms{};
+  uniforms.model = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+  uniforms.color = {1.0f, 0.5f, 0.25f, 1.0f};
+
+  // returns the median CPU time spent writing the frame's uniforms, in milliseconds
+  auto runFrames = [&](const std::function<void(uint32_t frameIndex, VkFence fence)> &write) {
+    std::vector<double> writeMilliseconds;
+    for (int frame = 0; frame < frames; frame++) {
+      renderer.beginFrame();
+      auto start = Clock::now();
+      write(static_cast<uint32_t>(renderer.getFrameIndex()), renderer.getCurrentFrameFence());
+      writeMilliseconds.push_back(secondsSince(start) * 1000.0);
+      renderer.endFrame();
+    }
+    vkDeviceWaitIdle(device.device());
+    std::sort(writeMilliseconds.begin(), writeMilliseconds.end());
+    return percentile(writeMilliseconds, 50.0);
+  };
+
+  std::cout << "uniform benchmark: " << objects << " objects of " << sizeof(ObjectUniforms)
+            << " bytes, median of " << frames << " frames" << std::endl;
+
+  // ad hoc: a buffer per object, destroyed when its frame slot comes around again
+  struct AdHocBuffer {
+    VkBuffer buffer;
+    LveAllocation *memory;
+  };
+  std::vector<std::vector<AdHocBuffer>> adHocFrames(framesInFlight);
+  double adHocMilliseconds = runFrames([&](uint32_t frameIndex, VkFence) {
+    auto &frameBuffers = adHocFrames[frameIndex];
+    for (const AdHocBuffer &adHoc : frameBuffers) {
+      device.destroyBuffer(adHoc.buffer, adHoc.memory);
+    }
+    frameBuffers.clear();
+    for (uint32_t i = 0; i < objects; i++) {
+      AdHocBuffer adHoc{};
+      device.createBuffer(
+          sizeof(ObjectUniforms),
+          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+          adHoc.buffer,
+          adHoc.memory,
+          LveMemoryCategory::Uniform);
+      uniforms.color[0] = static_cast<float>(i);
+      std::memcpy(adHoc.memory->mapped, &uniforms, sizeof(ObjectUniforms));
+      frameBuffers.push_back(adHoc);
+    }
+  });
+  for (auto &frameBuffers : adHocFrames) {
+    for (const AdHocBuffer &adHoc : frameBuffers) {
+      device.destroyBuffer(adHoc.buffer, adHoc.memory);
+    }
+  }
+  std::cout << "\tbuffer per object: " << adHocMilliseconds << " ms" << std::endl;
+
+  // room for every frame in flight plus the one being written, each write padded to the offset
+  // alignment the ring picks for uniform and storage use
+  const VkPhysicalDeviceLimits &limits = device.properties.limits;
+  VkDeviceSize alignment = std::max<VkDeviceSize>(
+      std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1),
+      limits.minStorageBufferOffsetAlignment);
+  VkDeviceSize alignedObjectSize = (sizeof(ObjectUniforms) + alignment - 1) / alignment * alignment;
+  VkDeviceSize worstCaseFrame = VkDeviceSize{objects} * alignedObjectSize;
+  VkDeviceSize ringSize =
+      std::max(LveUniformRing::DEFAULT_SIZE, (framesInFlight + 1) * worstCaseFrame);
+  LveUniformRing ring{device, framesInFlight, ringSize};
+  uint32_t totalOverruns = 0;
+  double ringMilliseconds = runFrames([&](uint32_t frameIndex, VkFence fence) {
+    ring.beginFrame(frameIndex, fence);
+    for (uint32_t i = 0; i < objects; i++) {
+      uniforms.color[0] = static_cast<float>(i);
+      ring.write(uniforms);
+    }
+    totalOverruns += ring.frameStats().overruns;
+  });
+  LveUniformRingStats lastStats = ring.frameStats();
+  std::cout << "\tuniform ring:      " << ringMilliseconds << " ms ("
+            << adHocMilliseconds / ringMilliseconds << "x), " << lastStats.bytesWritten
+            << " bytes written and " << lastStats.bytesUsed << " used per frame at "
+            << ring.alignment() << " byte alignment, " << totalOverruns << " overruns"
+            << std::endl;
+  return 0;
+}
+
+int runSpecializationBenchmark(LveDevice &device, int frames) {
+  if (frames <= 0) {
+    throw std::runtime_error("specialization benchmark needs at least one frame!");
+  }
+  if (!device.profiler().isEnabled()) {
+    throw std::runtime_error("specialization benchmark needs GPU timestamps!");
+  }
+  const VkExtent2D extent{1920, 1080};
+  const uint32_t layers = 8;  // full screen triangles per frame, so the fragment shader dominates
+  LveRenderer renderer{device, extent};
+
+  // the constants of shading_variants.frag, which reads the same values as push constants when
+  // they are left unspecialized
+  struct ShadingVariant {
+    int32_t shadingModel;
+    int32_t lightCount;
+    static constexpr auto specializationFields() {
+      return std::make_tuple(
+          lveSpecializationField(0, &ShadingVariant::shadingModel),
+          lveSpecializationField(1, &ShadingVariant::lightCount));
+    }
+  };
+  const ShadingVariant variants[] = {{0, 1}, {0, 8}, {1, 8}, {2, 4}};
+  const char *const shadingModels[] = {"lambert", "blinn-phong", "toon"};
+
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  pushConstantRange.size = sizeof(ShadingVariant);
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  VkPipelineLayout pipelineLayout;
+  if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark pipeline layout!");
+  }
+
+  // every layer covers every pixel, so depth testing would reject all but the first
+  auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+  pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+  pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+  pipelineConfig.renderPass = renderer.getSwapChainRenderPass();
+  pipelineConfig.pipelineLayout = pipelineLayout;
+  const std::string vertFilepath = "shaders/fullscreen.vert.spv";
+  const std::string fragFilepath = "shaders/shading_variants.frag.spv";
+
+  auto branching =
+      std::make_unique<LvePipeline>(device, vertFilepath, fragFilepath, pipelineConfig);
+  std::vector<std::unique_ptr<LvePipeline>> specialized;
+  for (const ShadingVariant &variant : variants) {
+    auto variantConfig = pipelineConfig;
+    variantConfig.specialization = LveSpecializationConstants::from(variant);
+    specialized.push_back(
+        std::make_unique<LvePipeline>(device, vertFilepath, fragFilepath, variantConfig));
+  }
+
+  auto render = [&](const std::string &name, LvePipeline &pipeline, const ShadingVariant &push) {
+    for (int frame = 0; frame < frames; frame++) {
+      VkCommandBuffer commandBuffer = renderer.beginFrame();
+      {
+        LveProfileScope scope{device.profiler(), commandBuffer, name};
+        renderer.beginSwapChainRenderPass(commandBuffer);
+        pipeline.bind(commandBuffer);
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(ShadingVariant),
+            &push);
+        vkCmdDraw(commandBuffer, 3, layers, 0, 0);
+        renderer.endSwapChainRenderPass(commandBuffer);
+      }
+      renderer.endFrame();
+    }
+  };
+  std::vector<std::string> names;
+  for (size_t i = 0; i < specialized.size(); i++) {
+    names.push_back(
+        std::string{shadingModels[variants[i].shadingModel]} + ", " +
+        std::to_string(variants[i].lightCount) + " lights");
+    render("branching " + names[i], *branching, variants[i]);
+    render("specialized " + names[i], *specialized[i], variants[i]);
+  }
+  vkDeviceWaitIdle(device.device());
+
+  std::map<std::string, double> averages;
+  for (const LveProfileScopeStats &stats : device.profiler().getAverages()) {
+    averages[stats.name] = stats.averageMilliseconds;
+  }
+  std::cout << "specialization benchmark: " << extent.width << "x" << extent.height << ", "
+            << layers << " full screen layers, average GPU time of the last "
+            << std::min<size_t>(frames, LveProfiler::AVERAGE_WINDOW) << " frames" << std::endl;
+  for (const std::string &name : names) {
+    double branchingMilliseconds = averages["branching " + name];
+    double specializedMilliseconds = averages["specialized " + name];
+    std::cout << "\t" << name << ": push constant branches " << branchingMilliseconds
+              << " ms, specialized " << specializedMilliseconds << " ms ("
+              << branchingMilliseconds / specializedMilliseconds << "x)" << std::endl;
+  }
+
+  specialized.clear();
+  branching.reset();
+  vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+  return 0;
+}
+
+int runTextureStreamingBenchmark(LveDevice &device, uint32_t textureCount, int frames) {
+  if (frames <= 0 || textureCount == 0) {
+    throw std::runtime_error("texture streaming benchmark needs at least one frame and texture!");
+  }
+  const uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+  const VkExtent2D extent{1280, 720};
+  const uint32_t textureSize = 1024;
+  LveRenderer renderer{device, extent, framesInFlight};
+  LveThreadPool threadPool{};
+  LveTextureStreamerOptions options{};
+  // a full chain of one texture takes about 5.3 MiB, so zooming in has to trade levels
+  options.budgetBytes = 32ull * 1024 * 1024;
+  options.framesInFlight = framesInFlight;
+  LveTextureStreamer streamer{device, threadPool, options};
+
+  std::vector<LveTextureId> textures;
+  for (uint32_t i = 0; i < textureCount; i++) {
+    std::string path = "texture_streaming_benchmark_" + std::to_string(i) + ".ktx2";
+    writeKtx2(path, textureSize, i);
+    textures.push_back(streamer.load(path));
+  }
+
+  VkSamplerCreateInfo samplerInfo{};
+  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  samplerInfo.magFilter = VK_FILTER_LINEAR;
+  samplerInfo.minFilter = VK_FILTER_LINEAR;
+  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+  VkSampler sampler;
+  if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark sampler!");
+  }
+
+  // the image view changes whenever a texture is swapped, so the sets are written per frame
+  VkDescriptorSetLayoutBinding binding{
+      0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
+  VkDescriptorSetLayout setLayout = device.descriptorLayoutCache().getLayout({binding});
+  LveDescriptorAllocator descriptorAllocator{device.device(), framesInFlight};
+
+  VkPushConstantRange pushConstantRange{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 4};
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &setLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  VkPipelineLayout pipelineLayout;
+  if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark pipeline layout!");
+  }
+  auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+  pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+  pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+  pipelineConfig.renderPass = renderer.getSwapChainRenderPass();
+  pipelineConfig.pipelineLayout = pipelineLayout;
+  LvePipeline pipeline{
+      device,
+      "shaders/streamed_texture.vert.spv",
+      "shaders/streamed_texture.frag.spv",
+      pipelineConfig};
+
+  std::cout << "texture streaming benchmark: " << textureCount << " textures of " << textureSize
+            << "x" << textureSize << ", " << options.budgetBytes / (1024 * 1024)
+            << " MiB budget, " << frames << " frames" << std::endl;
+
+  // a grid of quads filling the screen, zoomed in until the middle one is twice the screen wide
+  const uint32_t columns =
+      static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(textureCount))));
+  const float cell = 2.0f / columns;
+  std::vector<double> updateMilliseconds;
+  uint32_t mostBiased = 0;
+  for (int frame = 0; frame < frames; frame++) {
+    VkCommandBuffer commandBuffer = renderer.beginFrame();
+    uint32_t frameIndex = static_cast<uint32_t>(renderer.getFrameIndex());
+    auto start = Clock::now();
+    streamer.update(frameIndex, commandBuffer);
+    updateMilliseconds.push_back(secondsSince(start) * 1000.0);
+    mostBiased = std::max(mostBiased, streamer.getStats().biasedTextures);
+    descriptorAllocator.beginFrame(frameIndex);
+
+    float progress = frames > 1 ? static_cast<float>(frame) / (frames - 1) : 1.0f;
+    float zoom = std::pow(2.0f * columns, progress);
+    renderer.beginSwapChainRenderPass(commandBuffer);
+    pipeline.bind(commandBuffer);
+    for (uint32_t i = 0; i < textureCount; i++) {
+      float rect[4] = {
+          ((i % columns) * cell - 1.0f + 0.05f * cell) * zoom,
+          ((i / columns) * cell - 1.0f + 0.05f * cell) * zoom,
+          0.9f * cell * zoom,
+          0.9f * cell * zoom};
+      if (rect[0] >= 1.0f || rect[0] + rect[2] <= -1.0f || rect[1] >= 1.0f ||
+          rect[1] + rect[3] <= -1.0f) {
+        continue;  // off screen: neither drawn nor reported, so it falls back to its tail
+      }
+      streamer.reportFootprint(textures[i], rect[2] * 0.5f * extent.width);
+
+      VkDescriptorSet set = descriptorAllocator.allocate(setLayout);
+      VkDescriptorImageInfo imageInfo{
+          sampler,
+          streamer.getImageView(textures[i]),
+          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+      VkWriteDescriptorSet write{};
+      write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      write.dstSet = set;
+      write.dstBinding = 0;
+      write.descriptorCount = 1;
+      write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+      write.pImageInfo = &imageInfo;
+      vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+      vkCmdBindDescriptorSets(
+          commandBuffer,
+          VK_PIPELINE_BIND_POINT_GRAPHICS,
+          pipelineLayout,
+          0,
+          1,
+          &set,
+          0,
+          nullptr);
+      vkCmdPushConstants(
+          commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(rect), rect);
+      vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+    }
+    renderer.endSwapChainRenderPass(commandBuffer);
+    renderer.endFrame();
+  }
+  vkDeviceWaitIdle(device.device());
+
+  std::sort(updateMilliseconds.begin(), updateMilliseconds.end());
+  std::cout << "\tupdate: median " << percentile(updateMilliseconds, 50.0) << " ms, 99th "
+            << percentile(updateMilliseconds, 99.0) << " ms; at most " << mostBiased
+            << " textures held coarser than wanted" << std::endl;
+  streamer.printStats(std::cout);
+
+  vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+  vkDestroySampler(device.device(), sampler, nullptr);
+  return 0;
+}
+
+int runPipelineBenchmark(LveDevice &device, int permutations) {
+  VkRenderPass renderPass = createBenchmarkRenderPass(device);
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  VkPipelineLayout pipelineLayout;
+  if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create benchmark pipeline layout!");
+  }
+
+  auto descs = makePipelinePermutations(permutations, renderPass, pipelineLayout);
+  std::cout << "pipeline benchmark: " << descs.size() << " permutations" << std::endl;
+
+  VkPipelineCache serialCache = createEmptyPipelineCache(device);
+  buildPipelines(device, descs, 1, 1, serialCache, "serial  ");
+  vkDestroyPipelineCache(device.device(), serialCache, nullptr);
+
+  VkPipelineCache parallelCache = createEmptyPipelineCache(device);
+  buildPipelines(device, descs, 0, 16, parallelCache, "parallel");
+  buildPipelines(device, descs, 0, 16, parallelCache, "warm    ");
+  vkDestroyPipelineCache(device.device(), parallelCache, nullptr);
+
+  // the same descriptions twice over while the first set is alive: the registry hands out the
+  // existing pipelines instead of building them again
+  LvePipelineRegistryStats before = device.pipelineRegistry().stats();
+  std::vector<std::unique_ptr<LvePipeline>> pipelines;
+  auto start = Clock::now();
+  for (int pass = 0; pass < 2; pass++) {
+    for (const auto &desc : descs) {
+      pipelines.push_back(
+          std::make_unique<LvePipeline>(device, desc.vertFilepath, desc.fragFilepath, desc.config));
+    }
+  }
+  double dedupSeconds = secondsSince(start);
+  LvePipelineRegistryStats after = device.pipelineRegistry().stats();
+  std::cout << "\tregistry: " << pipelines.size() << " pipelines in " << dedupSeconds * 1000.0
+            << " ms, " << after.pipelineMisses - before.pipelineMisses << " built, "
+            << after.pipelineHits - before.pipelineHits << " shared, " << after.pipelineCount
+            << " VkPipelines and " << after.shaderModuleCount << " shader modules alive"
+            << std::endl;
+
+  // draws over random pipelines: a bind per change of pipeline, before and after sorting
+  struct Draw {
+    const LvePipeline *pipeline;
+    uint32_t firstVertex;
+  };
+  std::mt19937 random{7};
+  std::uniform_int_distribution<size_t> pickPipeline{0, pipelines.size() - 1};
+  std::vector<Draw> draws(10000);
+  for (uint32_t i = 0; i < draws.size(); i++) {
+    draws[i] = {pipelines[pickPipeline(random)].get(), i * 3};
+  }
+  auto countBinds = [&draws]() {
+    uint32_t binds = 0;
+    VkPipeline bound = VK_NULL_HANDLE;
+    for (const Draw &draw : draws) {
+      if (draw.pipeline->getHandle() == bound) continue;
+      bound = draw.pipeline->getHandle();
+      binds++;
+    }
+    return binds;
+  };
+  uint32_t unsortedBinds = countBinds();
+  start = Clock::now();
+  sortDrawsByPipeline(draws, [](const Draw &draw) -> const LvePipeline & {
+    return *draw.pipeline;
+  });
+  double sortSeconds = secondsSince(start);
+  std::cout << "\t" << draws.size() << " draws: " << unsortedBinds << " binds unsorted, "
+            << countBinds() << " sorted by pipeline key (sort took " << sortSeconds * 1000.0
+            << " ms)" << std::endl;
+  pipelines.clear();
+
+  vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+  vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  return 0;
+}
+
+int runAllocatorBenchmark(LveDevice &device, int iterations) {
+  // keep the dedicated path under the driver's allocation limit so both paths run the same ops
+  size_t maxLive = std::min<size_t>(4096, device.properties.limits.maxMemoryAllocationCount / 2);
+  auto ops = makeAllocationSequence(iterations, maxLive);
+
+  struct LiveBuffer {
+    VkBuffer buffer;
+    LveAllocation *allocation;
+    VkDeviceMemory memory;
+  };
+
+  // sub-allocated path
+  std::vector<LiveBuffer> live;
+  auto start = Clock::now();
+  for (const auto &op : ops) {
+    if (op.create) {
+      LiveBuffer entry{};
+      device.createBuffer(op.size, op.usage, op.properties, entry.buffer, entry.allocation);
+      live.push_back(entry);
+    } else {
+      device.destroyBuffer(live[op.victim].buffer, live[op.victim].allocation);
+      live[op.victim] = live.back();
+      live.pop_back();
+    }
+  }
+  double subAllocatedSeconds = secondsSince(start);
+  LveAllocatorStats stats = device.allocator().getStats();
+
+  std::cout << "allocator benchmark: " << ops.size() << " operations, " << live.size()
+            << " buffers live at the end" << std::endl;
+  std::cout << "\tsub-allocated: " << subAllocatedSeconds * 1000.0 << " ms, "
+            << stats.deviceMemoryAllocations << " vkAllocateMemory objects" << std::endl;
+  device.allocator().dumpStats(std::cout);
+
+  // compaction: free every other buffer so blocks are left half empty, then defragment
+  for (size_t i = live.size(); i-- > 0;) {
+    if (i % 2 == 0) {
+      device.destroyBuffer(live[i].buffer, live[i].allocation);
+      live.erase(live.begin() + i);
+    }
+  }
+  LveAllocatorStats before = device.allocator().getStats();
+  start = Clock::now();
+  VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+  LveDefragmentation defrag = device.allocator().beginDefragmentation(commandBuffer);
+  device.endSingleTimeCommands(commandBuffer);
+  for (auto &move : defrag.moves) {
+    for (auto &entry : live) {
+      if (entry.buffer == move.oldBuffer) entry.buffer = move.newBuffer;
+    }
+  }
+  VkDeviceSize bytesMoved = defrag.bytesMoved;
+  size_t movedCount = defrag.moves.size();
+  device.allocator().endDefragmentation(defrag);
+  LveAllocatorStats after = device.allocator().getStats();
+  std::cout << "\tdefragmentation: moved " << movedCount << " buffers (" << bytesMoved / 1024
+            << " KiB) in " << secondsSince(start) * 1000.0 << " ms, blocks " << before.blockCount
+            << " -> " << after.blockCount << ", fragmentation " << before.fragmentation << " -> "
+            << after.fragmentation << std::endl;
+
+  for (auto &entry : live) {
+    device.destroyBuffer(entry.buffer, entry.allocation);
+  }
+  live.clear();
+
+  // baseline: one vkAllocateMemory per buffer, bound at offset 0
+  start = Clock::now();
+  size_t peakAllocations = 0;
+  for (const auto &op : ops) {
+    if (op.create) {
+      VkBufferCreateInfo bufferInfo{};
+      bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      bufferInfo.size = op.size;
+      bufferInfo.usage = op.usage;
+      bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+      LiveBuffer entry{};
+      if (vkCreateBuffer(device.device(), &bufferInfo, nullptr, &entry.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create benchmark buffer!");
+      }
+      VkMemoryRequirements memRequirements;
+      vkGetBufferMemoryRequirements(device.device(), entry.buffer, &memRequirements);
+      VkMemoryAllocateInfo allocInfo{};
+      allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      allocInfo.allocationSize = memRequirements.size;
+      allocInfo.memoryTypeIndex =
+          device.findMemoryType(memRequirements.memoryTypeBits, op.properties);
+      if (vkAllocateMemory(device.device(), &allocInfo, nullptr, &entry.memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate benchmark buffer memory!");
+      }
+      vkBindBufferMemory(device.device(), entry.buffer, entry.memory, 0);
+      live.push_back(entry);
+      peakAllocations = std::max(peakAllocations, live.size());
+    } else {
+      vkDestroyBuffer(device.device(), live[op.victim].buffer, nullptr);
+      vkFreeMemory(device.device(), live[op.victim].memory, nullptr);
+      live[op.victim] = live.back();
+      live.pop_back();
+    }
+  }
+  double dedicatedSeconds = secondsSince(start);
+  for (auto &entry : live) {
+    vkDestroyBuffer(device.device(), entry.buffer, nullptr);
+    vkFreeMemory(device.device(), entry.memory, nullptr);
+  }
+  std::cout << "\tdedicated:     " << dedicatedSeconds * 1000.0 << " ms, peak "
+            << peakAllocations << " vkAllocateMemory objects" << std::endl;
+  return 0;
+}
+
+}  // namespace lve
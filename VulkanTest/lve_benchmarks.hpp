@@ -0,0 +1,81 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std lib headers
+#include <string>
+
+namespace lve {
+
+// Stress test for the device memory sub-allocator: replays one random create/destroy sequence
+// through LveAllocator and through one vkAllocateMemory per buffer, then runs a compaction pass.
+int runAllocatorBenchmark(LveDevice &device, int iterations);
+
+// Builds the same set of pipeline state permutations one at a time on a single worker and then
+// batched across all hardware threads, each starting from an empty VkPipelineCache.
+int runPipelineBenchmark(LveDevice &device, int permutations);
+
+// Writes a grid mesh of at least the given triangle count as text OBJ and as an .lvemesh
+// container, then times loading each one on its own and loaded through LveMeshPool.
+int runMeshLoadBenchmark(LveDevice &device, uint32_t triangles);
+
+// Runs a rippled grid mesh of the given triangle count through LveMeshOptimizer, reports the
+// triangle count and simplification error of each level of detail, then renders a field of its
+// instances receding from the camera offscreen: once all at full detail and once with
+// LveLodSelector picking each instance's level, comparing triangles drawn and frame time.
+int runLodBenchmark(LveDevice &device, uint32_t triangles, int frames);
+
+// Records the same frame of single-triangle draws on 1, 2, 4, ... up to every hardware thread
+// through LveParallelRecorder, against inline recording on the calling thread.
+int runRecordingBenchmark(LveDevice &device, uint32_t draws, int frames);
+
+// Allocates and writes the same per-frame descriptor sets twice: once creating a fresh layout and
+// pool for every set, and once through the device layout cache with LveDescriptorAllocator.
+int runDescriptorBenchmark(LveDevice &device, uint32_t setsPerFrame, int frames);
+
+// Draws one triangle per object, each reading its own range of a storage buffer: once through a
+// descriptor set per object bound before every draw, and once through LveBindlessHeap, bound once
+// per frame with the object's handle pushed per draw. Needs descriptor indexing.
+int runBindlessBenchmark(LveDevice &device, uint32_t objects, int frames);
+
+// Writes per-object uniform data for a number of offscreen frames twice: once through a
+// host-visible buffer created per object, and once through LveUniformRing.
+int runUniformBenchmark(LveDevice &device, uint32_t objects, int frames);
+
+// Renders full screen layers of a fragment shader with four shading variants, each once with the
+// variant's values passed as push constants and branched on per fragment, and once as a pipeline
+// specialized for it, and compares their GPU time. Needs timestamp queries.
+int runSpecializationBenchmark(LveDevice &device, int frames);
+
+// Writes RGBA8 KTX2 textures with full mip chains and renders them offscreen as a grid of quads
+// that zooms in until one fills the screen, streaming their levels through LveTextureStreamer
+// under a budget smaller than all of them. Reports the CPU time of the streamer's update and its
+// residency, requests and evictions.
+int runTextureStreamingBenchmark(LveDevice &device, uint32_t textures, int frames);
+
+// Builds a scene of the given object count, 1024 roots with an 8-way tree below them, and times
+// LveScene::update with every object moving each frame and with 1% of them moving, comparing the
+// scalar path, SIMD on one thread and SIMD across every hardware thread. Needs no device.
+int runSceneBenchmark(uint32_t objects, int frames);
+
+// Compiles a deferred frame of nine passes, one of them dead, through LveRenderGraph and records
+// and submits it for a number of frames, reporting the culling, barriers and transient memory
+// aliasing next to what one barrier per image use and an image per attachment would cost.
+int runRenderGraphBenchmark(LveDevice &device, int frames);
+
+struct LveFrameBenchmarkOptions {
+  std::string scene = "triangle";  // triangle, draw-calls, overdraw, instanced or culled
+  int frames = 1000;
+  int warmupFrames = 60;  // rendered but left out of the statistics
+  uint32_t width = 1280;
+  uint32_t height = 720;
+  // a file rather than stdout, which also carries the device's startup logging
+  std::string outputPath = "frame_benchmark.json";
+  std::string tracePath;  // non-empty writes the GPU profiler's Chrome trace of measured frames
+};
+
+// Renders a scene offscreen through LveRenderer and reports frame time percentiles as JSON.
+// Intended for a headless device, so it runs the same on a workstation GPU and on lavapipe.
+int runFrameBenchmark(LveDevice &device, const LveFrameBenchmarkOptions &options);
+
+}  // namespace lve
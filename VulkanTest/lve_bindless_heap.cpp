@@ -0,0 +1,203 @@
+#include "lve_bindless_heap.hpp"
+
+// std headers
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve {
+
+LveBindlessHeap::LveBindlessHeap(
+    LveDevice &device,
+    uint32_t framesInFlight,
+    uint32_t maxSampledImages,
+    uint32_t maxSamplers,
+    uint32_t maxStorageBuffers)
+    : lveDevice{device}, retired(std::max(1u, framesInFlight)) {
+  if (!lveDevice.supportsBindless()) {
+    throw std::runtime_error("bindless heap requires descriptor indexing support!");
+  }
+
+  const auto &limits = lveDevice.descriptorIndexingProperties;
+  slots[SAMPLED_IMAGE_BINDING].capacity = std::min(
+      {maxSampledImages,
+       limits.maxDescriptorSetUpdateAfterBindSampledImages,
+       limits.maxPerStageDescriptorUpdateAfterBindSampledImages});
+  slots[SAMPLER_BINDING].capacity = std::min(
+      {maxSamplers,
+       limits.maxDescriptorSetUpdateAfterBindSamplers,
+       limits.maxPerStageDescriptorUpdateAfterBindSamplers});
+  slots[STORAGE_BUFFER_BINDING].capacity = std::min(
+      {maxStorageBuffers,
+       limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+       limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+
+  const std::array<VkDescriptorType, BINDING_COUNT> types = {
+      VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+      VK_DESCRIPTOR_TYPE_SAMPLER,
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+
+  std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> bindings{};
+  std::array<VkDescriptorBindingFlagsEXT, BINDING_COUNT> bindingFlags{};
+  std::array<VkDescriptorPoolSize, BINDING_COUNT> poolSizes{};
+  for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = types[i];
+    bindings[i].descriptorCount = std::max(1u, slots[i].capacity);
+    bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+    // slots nothing has written yet are never read, and writing one slot must not invalidate
+    // command buffers in flight that read others
+    bindingFlags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT |
+                      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+    poolSizes[i].type = types[i];
+    poolSizes[i].descriptorCount = bindings[i].descriptorCount;
+  }
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo{};
+  flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+  flagsInfo.bindingCount = BINDING_COUNT;
+  flagsInfo.pBindingFlags = bindingFlags.data();
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.pNext = &flagsInfo;
+  layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+  layoutInfo.bindingCount = BINDING_COUNT;
+  layoutInfo.pBindings = bindings.data();
+  if (vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create bindless descriptor set layout!");
+  }
+
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+  poolInfo.maxSets = 1;
+  poolInfo.poolSizeCount = BINDING_COUNT;
+  poolInfo.pPoolSizes = poolSizes.data();
+  if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) !=
+      VK_SUCCESS) {
+    vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+    throw std::runtime_error("failed to create bindless descriptor pool!");
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = descriptorPool;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts = &descriptorSetLayout;
+  if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+    vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+    throw std::runtime_error("failed to allocate bindless descriptor set!");
+  }
+}
+
+LveBindlessHeap::~LveBindlessHeap() {
+  // destroying the pool frees the set
+  vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+  vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+}
+
+void LveBindlessHeap::beginFrame(uint32_t frameIndex) {
+  std::lock_guard<std::mutex> lock{mutex};
+  currentFrame = frameIndex % static_cast<uint32_t>(retired.size());
+  for (const RetiredHandle &retiredHandle : retired[currentFrame]) {
+    slots[retiredHandle.binding].freeList.push_back(retiredHandle.handle);
+  }
+  retired[currentFrame].clear();
+}
+
+LveBindlessHandle LveBindlessHeap::addSampledImage(
+    VkImageView imageView, VkImageLayout imageLayout) {
+  VkDescriptorImageInfo imageInfo{VK_NULL_HANDLE, imageView, imageLayout};
+  std::lock_guard<std::mutex> lock{mutex};
+  LveBindlessHandle handle = allocate(SAMPLED_IMAGE_BINDING);
+  write(SAMPLED_IMAGE_BINDING, handle, &imageInfo, nullptr);
+  return handle;
+}
+
+LveBindlessHandle LveBindlessHeap::addSampler(VkSampler sampler) {
+  VkDescriptorImageInfo imageInfo{sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+  std::lock_guard<std::mutex> lock{mutex};
+  LveBindlessHandle handle = allocate(SAMPLER_BINDING);
+  write(SAMPLER_BINDING, handle, &imageInfo, nullptr);
+  return handle;
+}
+
+LveBindlessHandle LveBindlessHeap::addStorageBuffer(
+    VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+  VkDescriptorBufferInfo bufferInfo{buffer, offset, range};
+  std::lock_guard<std::mutex> lock{mutex};
+  LveBindlessHandle handle = allocate(STORAGE_BUFFER_BINDING);
+  write(STORAGE_BUFFER_BINDING, handle, nullptr, &bufferInfo);
+  return handle;
+}
+
+void LveBindlessHeap::bind(
+    VkCommandBuffer commandBuffer,
+    VkPipelineBindPoint bindPoint,
+    VkPipelineLayout pipelineLayout,
+    uint32_t set) const {
+  vkCmdBindDescriptorSets(
+      commandBuffer,
+      bindPoint,
+      pipelineLayout,
+      set,
+      1,
+      &descriptorSet,
+      0,
+      nullptr);
+}
+
+uint32_t LveBindlessHeap::liveCount(uint32_t binding) const {
+  std::lock_guard<std::mutex> lock{mutex};
+  uint32_t pending = 0;
+  for (const auto &frameRetired : retired) {
+    for (const RetiredHandle &retiredHandle : frameRetired) {
+      if (retiredHandle.binding == binding) pending++;
+    }
+  }
+  const SlotAllocator &allocator = slots[binding];
+  return allocator.highWater - static_cast<uint32_t>(allocator.freeList.size()) - pending;
+}
+
+LveBindlessHandle LveBindlessHeap::allocate(uint32_t binding) {
+  SlotAllocator &allocator = slots[binding];
+  if (!allocator.freeList.empty()) {
+    LveBindlessHandle handle = allocator.freeList.back();
+    allocator.freeList.pop_back();
+    return handle;
+  }
+  if (allocator.highWater == allocator.capacity) {
+    throw std::runtime_error("bindless heap is full!");
+  }
+  return allocator.highWater++;
+}
+
+void LveBindlessHeap::retire(uint32_t binding, LveBindlessHandle handle) {
+  if (handle == LVE_BINDLESS_INVALID_HANDLE) return;
+  std::lock_guard<std::mutex> lock{mutex};
+  retired[currentFrame].push_back({binding, handle});
+}
+
+void LveBindlessHeap::write(
+    uint32_t binding,
+    LveBindlessHandle handle,
+    const VkDescriptorImageInfo *imageInfo,
+    const VkDescriptorBufferInfo *bufferInfo) {
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = descriptorSet;
+  write.dstBinding = binding;
+  write.dstArrayElement = handle;
+  write.descriptorCount = 1;
+  write.descriptorType = binding == SAMPLED_IMAGE_BINDING ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+                         : binding == SAMPLER_BINDING     ? VK_DESCRIPTOR_TYPE_SAMPLER
+                                                          : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  write.pImageInfo = imageInfo;
+  write.pBufferInfo = bufferInfo;
+  vkUpdateDescriptorSets(lveDevice.device(), 1, &write, 0, nullptr);
+}
+
+}  // namespace lve
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+
+// std lib headers
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+// Index of a descriptor in one of the heap's arrays, passed to shaders through push constants or
+// storage buffers instead of binding a set per resource.
+using LveBindlessHandle = uint32_t;
+constexpr LveBindlessHandle LVE_BINDLESS_INVALID_HANDLE = UINT32_MAX;
+
+// One global descriptor set holding every sampled image, sampler and storage buffer in large
+// update-after-bind arrays, so a whole frame's draws share a single vkCmdBindDescriptorSets.
+// Descriptors can be added while frames using the set are in flight; freed slots are only reused
+// once every frame that could still read them has finished.
+//
+// Shaders declare the set as below (the shader compiler has no #include, so copy it):
+//   #extension GL_EXT_nonuniform_qualifier : require
+//   layout(set = 0, binding = 0) uniform texture2D bindlessImages[];
+//   layout(set = 0, binding = 1) uniform sampler bindlessSamplers[];
+//   layout(set = 0, binding = 2) readonly buffer BindlessBuffer { uint data[]; } bindlessBuffers[];
+// and sample with
+//   texture(sampler2D(bindlessImages[nonuniformEXT(image)], bindlessSamplers[sampler]), uv)
+// where nonuniformEXT is needed whenever a handle can differ within a draw.
+class LveBindlessHeap {
+ public:
+  static constexpr uint32_t SAMPLED_IMAGE_BINDING = 0;
+  static constexpr uint32_t SAMPLER_BINDING = 1;
+  static constexpr uint32_t STORAGE_BUFFER_BINDING = 2;
+
+  // Capacities are clamped to the device's update-after-bind limits. Throws when the device does
+  // not support descriptor indexing; check LveDevice::supportsBindless first.
+  LveBindlessHeap(
+      LveDevice &device,
+      uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT,
+      uint32_t maxSampledImages = 16384,
+      uint32_t maxSamplers = 256,
+      uint32_t maxStorageBuffers = 16384);
+  ~LveBindlessHeap();
+
+  LveBindlessHeap(const LveBindlessHeap &) = delete;
+  LveBindlessHeap &operator=(const LveBindlessHeap &) = delete;
+
+  // Recycles the handles freed framesInFlight frames ago. Call once per frame after
+  // LveRenderer::beginFrame, which has waited for the frame that last used frameIndex.
+  void beginFrame(uint32_t frameIndex);
+
+  // Writes the descriptor into a free slot and returns its handle. Safe to call from any thread.
+  LveBindlessHandle addSampledImage(
+      VkImageView imageView,
+      VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  LveBindlessHandle addSampler(VkSampler sampler);
+  LveBindlessHandle addStorageBuffer(
+      VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+  // The handle must no longer be used by draws recorded after this call; its slot is reused once
+  // the frames already in flight are done with it.
+  void freeSampledImage(LveBindlessHandle handle) { retire(SAMPLED_IMAGE_BINDING, handle); }
+  void freeSampler(LveBindlessHandle handle) { retire(SAMPLER_BINDING, handle); }
+  void freeStorageBuffer(LveBindlessHandle handle) { retire(STORAGE_BUFFER_BINDING, handle); }
+
+  // Binds the heap as descriptor set `set` of pipelineLayout, which must have been created with
+  // getDescriptorSetLayout() at that index.
+  void bind(
+      VkCommandBuffer commandBuffer,
+      VkPipelineBindPoint bindPoint,
+      VkPipelineLayout pipelineLayout,
+      uint32_t set = 0) const;
+
+  VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+  VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+  uint32_t capacity(uint32_t binding) const { return slots[binding].capacity; }
+  uint32_t liveCount(uint32_t binding) const;
+
+ private:
+  static constexpr uint32_t BINDING_COUNT = 3;
+
+  // free slots of one binding: never-used slots above highWater, recycled ones in freeList
+  struct SlotAllocator {
+    uint32_t capacity = 0;
+    uint32_t highWater = 0;
+    std::vector<uint32_t> freeList;
+  };
+  struct RetiredHandle {
+    uint32_t binding;
+    LveBindlessHandle handle;
+  };
+
+  LveBindlessHandle allocate(uint32_t binding);
+  void retire(uint32_t binding, LveBindlessHandle handle);
+  void write(
+      uint32_t binding,
+      LveBindlessHandle handle,
+      const VkDescriptorImageInfo *imageInfo,
+      const VkDescriptorBufferInfo *bufferInfo);
+
+  LveDevice &lveDevice;
+  VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+  VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+  VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+  // guards the allocators, the retired lists and descriptor writes to the set
+  mutable std::mutex mutex;
+  std::array<SlotAllocator, BINDING_COUNT> slots;
+  // handles freed while recording frame i, recycled when frame i comes around again
+  std::vector<std::vector<RetiredHandle>> retired;
+  uint32_t currentFrame = 0;
+};
+
+}  // namespace lve
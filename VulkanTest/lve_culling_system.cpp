@@ -0,0 +1,628 @@
+#include "lve_culling_system.hpp"
+
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+// matches the push constant block shared by cull.comp and cull_compact.comp
+struct CullPushConstants {
+  float viewProjection[16];
+  uint32_t instanceCount;
+  uint32_t drawCommandCount;
+  uint32_t occlusion;
+  uint32_t compact;
+  float pyramidSize[2];
+  uint32_t pyramidLevels;
+  uint32_t statsIndex;
+};
+
+struct HizPushConstants {
+  int32_t sourceSize[2];
+  int32_t destinationSize[2];
+};
+
+uint32_t previousPowerOfTwo(uint32_t value) {
+  uint32_t result = 1;
+  while (result * 2 <= value) result *= 2;
+  return result;
+}
+
+uint32_t groupCount(uint32_t invocations, uint32_t groupSize) {
+  return (invocations + groupSize - 1) / groupSize;
+}
+
+bool hasStencilComponent(VkFormat format) {
+  return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+}
+
+}  // namespace
+
+LveCullingSystem::LveCullingSystem(
+    LveDevice &device,
+    LveIndirectDrawSystem &drawSystem,
+    VkExtent2D depthExtent,
+    uint32_t framesInFlight)
+    : lveDevice{device},
+      drawSystem{drawSystem},
+      depthExtent{depthExtent},
+      framesInFlight{framesInFlight},
+      statsPending(framesInFlight, false) {
+  // culled commands point firstInstance at their slice of the visible instance list
+  if (!lveDevice.enabledFeatures.drawIndirectFirstInstance) {
+    throw std::runtime_error("GPU culling requires drawIndirectFirstInstance!");
+  }
+  createPyramid();
+  createBuffers();
+  createDescriptorSets();
+  createPipelineLayouts();
+  createPipelines();
+}
+
+LveCullingSystem::~LveCullingSystem() {
+  cullPipeline.reset();
+  compactPipeline.reset();
+  hizPipeline.reset();
+  vkDestroyPipelineLayout(lveDevice.device(), cullPipelineLayout, nullptr);
+  vkDestroyPipelineLayout(lveDevice.device(), hizPipelineLayout, nullptr);
+  vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+
+  vkDestroySampler(lveDevice.device(), pyramidSampler, nullptr);
+  for (auto levelView : pyramidLevelViews) {
+    vkDestroyImageView(lveDevice.device(), levelView, nullptr);
+  }
+  vkDestroyImageView(lveDevice.device(), pyramidView, nullptr);
+  lveDevice.destroyImage(pyramidImage, pyramidMemory);
+
+  lveDevice.destroyBuffer(drawInstanceCountBuffer, drawInstanceCountMemory);
+  lveDevice.destroyBuffer(statsBuffer, statsMemory);
+}
+
+void LveCullingSystem::createPyramid() {
+  pyramidExtent.width = previousPowerOfTwo(depthExtent.width);
+  pyramidExtent.height = previousPowerOfTwo(depthExtent.height);
+  pyramidLevels = 1;
+  while ((std::max(pyramidExtent.width, pyramidExtent.height) >> pyramidLevels) > 0) {
+    pyramidLevels++;
+  }
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = pyramidExtent.width;
+  imageInfo.extent.height = pyramidExtent.height;
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = pyramidLevels;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = VK_FORMAT_R32_SFLOAT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  lveDevice.createImageWithInfo(
+      imageInfo,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      pyramidImage,
+      pyramidMemory,
+      LveMemoryCategory::RenderTarget);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = pyramidImage;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = VK_FORMAT_R32_SFLOAT;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = pyramidLevels;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = 1;
+  if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &pyramidView) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create depth pyramid view!");
+  }
+
+  pyramidLevelViews.resize(pyramidLevels);
+  viewInfo.subresourceRange.levelCount = 1;
+  for (uint32_t level = 0; level < pyramidLevels; level++) {
+    viewInfo.subresourceRange.baseMipLevel = level;
+    if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &pyramidLevelViews[level]) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create depth pyramid level view!");
+    }
+  }
+
+  // texelFetch ignores the sampler; the cull shader picks levels explicitly with textureLod
+  VkSamplerCreateInfo samplerInfo{};
+  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  samplerInfo.magFilter = VK_FILTER_NEAREST;
+  samplerInfo.minFilter = VK_FILTER_NEAREST;
+  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.minLod = 0.0f;
+  samplerInfo.maxLod = static_cast<float>(pyramidLevels);
+  if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &pyramidSampler) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create depth pyramid sampler!");
+  }
+}
+
+void LveCullingSystem::createBuffers() {
+  lveDevice.createBuffer(
+      sizeof(uint32_t) * drawSystem.maxInstanceCount(),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      drawInstanceCountBuffer,
+      drawInstanceCountMemory,
+      LveMemoryCategory::Indirect);
+  // written by the GPU and read by the CPU once the frame slot comes around again
+  lveDevice.createBuffer(
+      sizeof(LveCullingStats) * framesInFlight,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      statsBuffer,
+      statsMemory);
+}
+
+void LveCullingSystem::createDescriptorSets() {
+  // bindings 0-9 are storage buffers and 10 is the pyramid, see cull.comp
+  std::vector<VkDescriptorSetLayoutBinding> cullBindings(11);
+  for (uint32_t i = 0; i < cullBindings.size(); i++) {
+    cullBindings[i].binding = i;
+    cullBindings[i].descriptorType = i < 10 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                                            : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    cullBindings[i].descriptorCount = 1;
+    cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  cullSetLayout = lveDevice.descriptorLayoutCache().getLayout(cullBindings);
+
+  std::vector<VkDescriptorSetLayoutBinding> hizBindings(2);
+  hizBindings[0].binding = 0;
+  hizBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  hizBindings[0].descriptorCount = 1;
+  hizBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  hizBindings[1].binding = 1;
+  hizBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  hizBindings[1].descriptorCount = 1;
+  hizBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  hizSetLayout = lveDevice.descriptorLayoutCache().getLayout(hizBindings);
+
+  uint32_t hizSetCount = framesInFlight + pyramidLevels - 1;
+  std::array<VkDescriptorPoolSize, 3> poolSizes{};
+  poolSizes[0] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 10};
+  poolSizes[1] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 + hizSetCount};
+  poolSizes[2] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, hizSetCount};
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.maxSets = 1 + hizSetCount;
+  poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+  poolInfo.pPoolSizes = poolSizes.data();
+  if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create culling descriptor pool!");
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = descriptorPool;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts = &cullSetLayout;
+  if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &cullSet) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate cull descriptor set!");
+  }
+
+  std::vector<VkDescriptorSetLayout> hizLayouts(hizSetCount, hizSetLayout);
+  std::vector<VkDescriptorSet> hizSets(hizSetCount);
+  allocInfo.descriptorSetCount = hizSetCount;
+  allocInfo.pSetLayouts = hizLayouts.data();
+  if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, hizSets.data()) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate depth pyramid descriptor sets!");
+  }
+  hizDepthSets.assign(hizSets.begin(), hizSets.begin() + framesInFlight);
+  hizLevelSets.assign(hizSets.begin() + framesInFlight, hizSets.end());
+
+  std::array<VkDescriptorBufferInfo, 10> bufferInfos{};
+  bufferInfos[0] = {drawSystem.getTranslationScaleBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[1] = {drawSystem.getRotationBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[2] = {drawSystem.getInstanceDrawBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[3] = {drawSystem.getDrawBoundsBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[4] = {drawSystem.getSourceDrawCommandBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[5] = {drawInstanceCountBuffer, 0, VK_WHOLE_SIZE};
+  bufferInfos[6] = {drawSystem.getVisibleInstanceBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[7] = {drawSystem.getDrawCommandBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[8] = {drawSystem.getDrawCountBuffer(), 0, VK_WHOLE_SIZE};
+  bufferInfos[9] = {statsBuffer, 0, VK_WHOLE_SIZE};
+  VkDescriptorImageInfo pyramidInfo{pyramidSampler, pyramidView, VK_IMAGE_LAYOUT_GENERAL};
+
+  std::vector<VkWriteDescriptorSet> writes;
+  for (uint32_t i = 0; i < cullBindings.size(); i++) {
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = cullSet;
+    write.dstBinding = i;
+    write.descriptorCount = 1;
+    write.descriptorType = cullBindings[i].descriptorType;
+    if (i < bufferInfos.size()) {
+      write.pBufferInfo = &bufferInfos[i];
+    } else {
+      write.pImageInfo = &pyramidInfo;
+    }
+    writes.push_back(write);
+  }
+
+  // level i is reduced from level i - 1; level 0 is written per frame in buildPyramid
+  std::vector<VkDescriptorImageInfo> levelInfos(2 * hizLevelSets.size());
+  for (uint32_t i = 0; i < hizLevelSets.size(); i++) {
+    levelInfos[2 * i] = {pyramidSampler, pyramidLevelViews[i], VK_IMAGE_LAYOUT_GENERAL};
+    levelInfos[2 * i + 1] = {VK_NULL_HANDLE, pyramidLevelViews[i + 1], VK_IMAGE_LAYOUT_GENERAL};
+    for (uint32_t binding = 0; binding < 2; binding++) {
+      VkWriteDescriptorSet write{};
+      write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      write.dstSet = hizLevelSets[i];
+      write.dstBinding = binding;
+      write.descriptorCount = 1;
+      write.descriptorType = hizBindings[binding].descriptorType;
+      write.pImageInfo = &levelInfos[2 * i + binding];
+      writes.push_back(write);
+    }
+  }
+
+  vkUpdateDescriptorSets(
+      lveDevice.device(),
+      static_cast<uint32_t>(writes.size()),
+      writes.data(),
+      0,
+      nullptr);
+}
+
+void LveCullingSystem::createPipelineLayouts() {
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(CullPushConstants);
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &cullSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  if (vkCreatePipelineLayout(
+          lveDevice.device(),
+          &pipelineLayoutInfo,
+          nullptr,
+          &cullPipelineLayout) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create cull pipeline layout!");
+  }
+
+  pushConstantRange.size = sizeof(HizPushConstants);
+  pipelineLayoutInfo.pSetLayouts = &hizSetLayout;
+  if (vkCreatePipelineLayout(
+          lveDevice.device(),
+          &pipelineLayoutInfo,
+          nullptr,
+          &hizPipelineLayout) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+  }
+}
+
+void LveCullingSystem::createPipelines() {
+  cullPipeline =
+      std::make_unique<LveComputePipeline>(lveDevice, CULL_SHADER_PATH, cullPipelineLayout);
+  compactPipeline =
+      std::make_unique<LveComputePipeline>(lveDevice, COMPACT_SHADER_PATH, cullPipelineLayout);
+  hizPipeline = std::make_unique<LveComputePipeline>(lveDevice, HIZ_SHADER_PATH, hizPipelineLayout);
+}
+
+void LveCullingSystem::readStats(int frameIndex) {
+  // the renderer waited for this slot's previous frame before handing it out again
+  if (statsPending[frameIndex]) {
+    const char *mapped = static_cast<const char *>(statsMemory->mapped);
+    std::memcpy(&stats, mapped + sizeof(LveCullingStats) * frameIndex, sizeof(LveCullingStats));
+  }
+  statsPending[frameIndex] = true;
+}
+
+void LveCullingSystem::cull(
+    VkCommandBuffer commandBuffer,
+    int frameIndex,
+    const std::array<float, 16> &viewProjection,
+    const LveDepthAttachment &previousDepth) {
+  uint32_t instanceCount = drawSystem.instanceCount();
+  uint32_t drawCommandCount = drawSystem.drawCommandCount();
+  if (instanceCount == 0) return;
+
+  LveProfileScope scope{lveDevice.profiler(), commandBuffer, "culling"};
+  readStats(frameIndex);
+
+  // the previous frame's draws may still be reading what this pass is about to overwrite
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      0,
+      nullptr);
+  vkCmdFillBuffer(
+      commandBuffer,
+      drawInstanceCountBuffer,
+      0,
+      sizeof(uint32_t) * drawCommandCount,
+      0);
+  vkCmdFillBuffer(commandBuffer, drawSystem.getDrawCountBuffer(), 0, sizeof(uint32_t), 0);
+  vkCmdFillBuffer(
+      commandBuffer,
+      statsBuffer,
+      sizeof(LveCullingStats) * frameIndex,
+      sizeof(LveCullingStats),
+      0);
+
+  bool occlusion = occlusionEnabled && previousDepth.image != VK_NULL_HANDLE &&
+                   previousDepth.extent.width == depthExtent.width &&
+                   previousDepth.extent.height == depthExtent.height;
+  if (occlusion) {
+    buildPyramid(commandBuffer, frameIndex, previousDepth);
+  } else if (!pyramidInitialized) {
+    // the cull set always references the pyramid, so give it a valid layout
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = pyramidImage;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, pyramidLevels, 0, 1};
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &barrier);
+    pyramidInitialized = true;
+  }
+
+  VkMemoryBarrier clearBarrier{};
+  clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      &clearBarrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+
+  CullPushConstants push{};
+  std::copy(viewProjection.begin(), viewProjection.end(), push.viewProjection);
+  push.instanceCount = instanceCount;
+  push.drawCommandCount = drawCommandCount;
+  push.occlusion = occlusion ? 1 : 0;
+  // without a GPU draw count the draw system issues every command, so keep them in place
+  push.compact = lveDevice.drawIndexedIndirectCount() != nullptr ? 1 : 0;
+  push.pyramidSize[0] = static_cast<float>(pyramidExtent.width);
+  push.pyramidSize[1] = static_cast<float>(pyramidExtent.height);
+  push.pyramidLevels = pyramidLevels;
+  push.statsIndex = static_cast<uint32_t>(frameIndex);
+
+  vkCmdBindDescriptorSets(
+      commandBuffer,
+      VK_PIPELINE_BIND_POINT_COMPUTE,
+      cullPipelineLayout,
+      0,
+      1,
+      &cullSet,
+      0,
+      nullptr);
+  vkCmdPushConstants(
+      commandBuffer,
+      cullPipelineLayout,
+      VK_SHADER_STAGE_COMPUTE_BIT,
+      0,
+      sizeof(CullPushConstants),
+      &push);
+  cullPipeline->bind(commandBuffer);
+  vkCmdDispatch(commandBuffer, groupCount(instanceCount, WORKGROUP_SIZE), 1, 1);
+
+  VkMemoryBarrier cullBarrier{};
+  cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  cullBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      &cullBarrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+
+  compactPipeline->bind(commandBuffer);
+  vkCmdDispatch(commandBuffer, groupCount(drawCommandCount, WORKGROUP_SIZE), 1, 1);
+
+  VkMemoryBarrier drawBarrier{};
+  drawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  drawBarrier.dstAccessMask =
+      VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+          VK_PIPELINE_STAGE_HOST_BIT,
+      0,
+      1,
+      &drawBarrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+}
+
+void LveCullingSystem::buildPyramid(
+    VkCommandBuffer commandBuffer, int frameIndex, const LveDepthAttachment &depth) {
+  VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+  if (hasStencilComponent(depth.format)) depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  VkDescriptorImageInfo depthInfo{
+      pyramidSampler,
+      depth.view,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+  VkDescriptorImageInfo levelInfo{VK_NULL_HANDLE, pyramidLevelViews[0], VK_IMAGE_LAYOUT_GENERAL};
+  std::array<VkWriteDescriptorSet, 2> writes{};
+  for (uint32_t binding = 0; binding < writes.size(); binding++) {
+    writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[binding].dstSet = hizDepthSets[frameIndex];
+    writes[binding].dstBinding = binding;
+    writes[binding].descriptorCount = 1;
+  }
+  writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  writes[0].pImageInfo = &depthInfo;
+  writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  writes[1].pImageInfo = &levelInfo;
+  vkUpdateDescriptorSets(
+      lveDevice.device(),
+      static_cast<uint32_t>(writes.size()),
+      writes.data(),
+      0,
+      nullptr);
+
+  // depth from the previous frame's render pass becomes readable; last frame's cull shader
+  // must be done sampling the pyramid before it is overwritten
+  std::array<VkImageMemoryBarrier, 2> barriers{};
+  barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[0].image = depth.image;
+  barriers[0].subresourceRange = {depthAspect, 0, 1, 0, 1};
+  barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barriers[1].srcAccessMask = 0;
+  barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barriers[1].oldLayout =
+      pyramidInitialized ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED;
+  barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barriers[1].image = pyramidImage;
+  barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, pyramidLevels, 0, 1};
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      static_cast<uint32_t>(barriers.size()),
+      barriers.data());
+  pyramidInitialized = true;
+
+  hizPipeline->bind(commandBuffer);
+  VkExtent2D source = depth.extent;
+  for (uint32_t level = 0; level < pyramidLevels; level++) {
+    VkExtent2D destination{
+        std::max(1u, pyramidExtent.width >> level),
+        std::max(1u, pyramidExtent.height >> level)};
+    VkDescriptorSet set = level == 0 ? hizDepthSets[frameIndex] : hizLevelSets[level - 1];
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        hizPipelineLayout,
+        0,
+        1,
+        &set,
+        0,
+        nullptr);
+
+    HizPushConstants push{};
+    push.sourceSize[0] = static_cast<int32_t>(source.width);
+    push.sourceSize[1] = static_cast<int32_t>(source.height);
+    push.destinationSize[0] = static_cast<int32_t>(destination.width);
+    push.destinationSize[1] = static_cast<int32_t>(destination.height);
+    vkCmdPushConstants(
+        commandBuffer,
+        hizPipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(HizPushConstants),
+        &push);
+    vkCmdDispatch(
+        commandBuffer,
+        groupCount(destination.width, HIZ_WORKGROUP_SIZE),
+        groupCount(destination.height, HIZ_WORKGROUP_SIZE),
+        1);
+
+    // the next level, and finally the cull shader, read what was just written
+    VkImageMemoryBarrier levelBarrier{};
+    levelBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    levelBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    levelBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    levelBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    levelBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    levelBarrier.image = pyramidImage;
+    levelBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &levelBarrier);
+    source = destination;
+  }
+
+  // hand the depth image back for this frame's render pass, which may render into it again
+  VkImageMemoryBarrier depthBarrier = barriers[0];
+  depthBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  depthBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &depthBarrier);
+}
+
+}  // namespace lve
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_indirect_draw_system.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_renderer.hpp"
+
+// std lib headers
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+// Results of the culling pass recorded framesInFlight frames ago.
+struct LveCullingStats {
+  uint32_t visibleInstances = 0;
+  uint32_t frustumCulledInstances = 0;
+  uint32_t occlusionCulledInstances = 0;
+  uint32_t visibleDrawCommands = 0;
+};
+
+// GPU culling for an LveIndirectDrawSystem. Each frame, before the render pass, cull() records
+//   1. a hierarchical depth (Hi-Z) pyramid built from the previous frame's depth, each texel
+//      holding the farthest depth of the texels below it,
+//   2. one invocation per instance testing its bounding sphere against the frustum planes and
+//      the pyramid, appending survivors to the instance list of their draw command,
+//   3. one invocation per draw command compacting the commands that kept any instance.
+// The draw system then renders straight from the compacted commands and the GPU-written count.
+// Occlusion uses last frame's depth with this frame's camera, so an object moving out from
+// behind an occluder can be missing for one frame.
+class LveCullingSystem {
+ public:
+  static constexpr const char *CULL_SHADER_PATH = "shaders/cull.comp.spv";
+  static constexpr const char *COMPACT_SHADER_PATH = "shaders/cull_compact.comp.spv";
+  static constexpr const char *HIZ_SHADER_PATH = "shaders/hiz_reduce.comp.spv";
+  static constexpr uint32_t WORKGROUP_SIZE = 64;
+  static constexpr uint32_t HIZ_WORKGROUP_SIZE = 8;
+
+  // depthExtent is the size of the depth attachments culled against; frames whose depth has a
+  // different extent are only frustum culled.
+  LveCullingSystem(
+      LveDevice &device,
+      LveIndirectDrawSystem &drawSystem,
+      VkExtent2D depthExtent,
+      uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+  ~LveCullingSystem();
+
+  LveCullingSystem(const LveCullingSystem &) = delete;
+  LveCullingSystem &operator=(const LveCullingSystem &) = delete;
+
+  // Records the culling passes; call outside a render pass, after beginFrame. A null
+  // previousDepth.image skips the occlusion test.
+  void cull(
+      VkCommandBuffer commandBuffer,
+      int frameIndex,
+      const std::array<float, 16> &viewProjection,
+      const LveDepthAttachment &previousDepth);
+
+  // Counts are written by the GPU and read back without stalling, so they trail by
+  // framesInFlight frames.
+  const LveCullingStats &lastStats() const { return stats; }
+
+  void setOcclusionEnabled(bool enabled) { occlusionEnabled = enabled; }
+
+ private:
+  void createPyramid();
+  void createBuffers();
+  void createDescriptorSets();
+  void createPipelineLayouts();
+  void createPipelines();
+  void buildPyramid(VkCommandBuffer commandBuffer, int frameIndex, const LveDepthAttachment &depth);
+  void readStats(int frameIndex);
+
+  LveDevice &lveDevice;
+  LveIndirectDrawSystem &drawSystem;
+  VkExtent2D depthExtent;
+  uint32_t framesInFlight;
+  bool occlusionEnabled = true;
+  LveCullingStats stats;
+  std::vector<bool> statsPending;
+
+  // the pyramid's first level is the largest power of two no bigger than the depth extent
+  VkExtent2D pyramidExtent;
+  uint32_t pyramidLevels;
+  VkImage pyramidImage;
+  LveAllocation *pyramidMemory;
+  VkImageView pyramidView;  // every level, sampled by the cull shader
+  std::vector<VkImageView> pyramidLevelViews;
+  bool pyramidInitialized = false;
+  VkSampler pyramidSampler;  // nearest, so every read returns a stored farthest depth
+
+  VkBuffer drawInstanceCountBuffer;
+  LveAllocation *drawInstanceCountMemory;
+  VkBuffer statsBuffer;  // host visible, one LveCullingStats per frame slot
+  LveAllocation *statsMemory;
+
+  VkDescriptorSetLayout cullSetLayout;  // both owned by the device layout cache
+  VkDescriptorSetLayout hizSetLayout;
+  VkDescriptorPool descriptorPool;
+  VkDescriptorSet cullSet;
+  std::vector<VkDescriptorSet> hizDepthSets;  // per frame slot, pointed at that frame's depth
+  std::vector<VkDescriptorSet> hizLevelSets;  // level i - 1 into level i, for i > 0
+  VkPipelineLayout cullPipelineLayout;
+  VkPipelineLayout hizPipelineLayout;
+  std::unique_ptr<LveComputePipeline> cullPipeline;
+  std::unique_ptr<LveComputePipeline> compactPipeline;
+  std::unique_ptr<LveComputePipeline> hizPipeline;
+};
+
+}  // namespace lve
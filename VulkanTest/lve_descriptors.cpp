@@ -0,0 +1,217 @@
+#include "lve_descriptors.hpp"
+
+// std headers
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+namespace {
+
+void hashCombine(size_t &seed, size_t value) {
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+}  // namespace
+
+LveDescriptorSetLayoutCache::LveDescriptorSetLayoutCache(VkDevice device) : device{device} {}
+
+LveDescriptorSetLayoutCache::~LveDescriptorSetLayoutCache() {
+  for (auto &entry : layouts) {
+    vkDestroyDescriptorSetLayout(device, entry.second, nullptr);
+  }
+}
+
+VkDescriptorSetLayout LveDescriptorSetLayoutCache::getLayout(
+    std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags) {
+  std::sort(
+      bindings.begin(),
+      bindings.end(),
+      [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+        return a.binding < b.binding;
+      });
+  LayoutKey key{flags, bindings, std::vector<std::vector<VkSampler>>(bindings.size())};
+  // immutable samplers are compared by handle, so the key must not point at the caller's array;
+  // they stay with their binding, since which binding has them changes the layout
+  for (size_t i = 0; i < bindings.size(); i++) {
+    const VkDescriptorSetLayoutBinding &binding = bindings[i];
+    key.bindings[i].pImmutableSamplers = nullptr;
+    // ignored by Vulkan for every other type
+    bool takesSamplers = binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                         binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    if (!takesSamplers || binding.pImmutableSamplers == nullptr) continue;
+    key.immutableSamplers[i].assign(
+        binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+  }
+
+  std::lock_guard<std::mutex> lock{mutex};
+  auto found = layouts.find(key);
+  if (found != layouts.end()) {
+    hits++;
+    return found->second;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.flags = flags;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+  VkDescriptorSetLayout layout;
+  if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create descriptor set layout!");
+  }
+  layouts.emplace(std::move(key), layout);
+  return layout;
+}
+
+uint32_t LveDescriptorSetLayoutCache::layoutCount() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return static_cast<uint32_t>(layouts.size());
+}
+
+uint64_t LveDescriptorSetLayoutCache::hitCount() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return hits;
+}
+
+bool LveDescriptorSetLayoutCache::LayoutKey::operator==(const LayoutKey &other) const {
+  if (flags != other.flags || bindings.size() != other.bindings.size() ||
+      immutableSamplers != other.immutableSamplers) {
+    return false;
+  }
+  for (size_t i = 0; i < bindings.size(); i++) {
+    const VkDescriptorSetLayoutBinding &a = bindings[i];
+    const VkDescriptorSetLayoutBinding &b = other.bindings[i];
+    if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+        a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t LveDescriptorSetLayoutCache::LayoutKeyHash::operator()(const LayoutKey &key) const {
+  size_t seed = std::hash<uint32_t>{}(key.flags);
+  for (const auto &binding : key.bindings) {
+    hashCombine(seed, binding.binding);
+    hashCombine(seed, static_cast<size_t>(binding.descriptorType));
+    hashCombine(seed, binding.descriptorCount);
+    hashCombine(seed, binding.stageFlags);
+  }
+  for (size_t i = 0; i < key.immutableSamplers.size(); i++) {
+    if (key.immutableSamplers[i].empty()) continue;
+    hashCombine(seed, i);
+    for (VkSampler sampler : key.immutableSamplers[i]) {
+      hashCombine(seed, std::hash<VkSampler>{}(sampler));
+    }
+  }
+  return seed;
+}
+
+const LveDescriptorAllocator::PoolSizeRatios LveDescriptorAllocator::DEFAULT_POOL_SIZE_RATIOS = {
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f}};
+
+LveDescriptorAllocator::LveDescriptorAllocator(
+    VkDevice device, uint32_t framesInFlight, uint32_t setsPerPool, PoolSizeRatios poolSizeRatios)
+    : device{device},
+      setsPerPool{std::max(1u, setsPerPool)},
+      poolSizeRatios{std::move(poolSizeRatios)},
+      frames(std::max(1u, framesInFlight)) {}
+
+LveDescriptorAllocator::~LveDescriptorAllocator() {
+  // destroying a pool frees its sets
+  for (auto &frame : frames) {
+    for (VkDescriptorPool pool : frame.pools) {
+      vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+  }
+}
+
+void LveDescriptorAllocator::beginFrame(uint32_t frameIndex) {
+  std::lock_guard<std::mutex> lock{mutex};
+  currentFrame = frameIndex % static_cast<uint32_t>(frames.size());
+  FramePools &frame = frames[currentFrame];
+  frame.stats = LveDescriptorAllocatorStats{};
+  if (frame.pools.empty()) return;
+  // the current pool may hold sets too, every pool after it is untouched
+  for (uint32_t i = 0; i <= frame.current && i < frame.pools.size(); i++) {
+    vkResetDescriptorPool(device, frame.pools[i], 0);
+    frame.stats.poolResets++;
+  }
+  frame.current = 0;
+}
+
+VkDescriptorSet LveDescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+  std::lock_guard<std::mutex> lock{mutex};
+  FramePools &frame = frames[currentFrame];
+
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts = &layout;
+
+  while (true) {
+    bool freshPool = frame.current == frame.pools.size();
+    if (freshPool) {
+      frame.pools.push_back(createPool());
+      frame.stats.poolsCreated++;
+    }
+    allocInfo.descriptorPool = frame.pools[frame.current];
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+    if (result == VK_SUCCESS) {
+      frame.stats.setsAllocated++;
+      return set;
+    }
+    // an empty pool that cannot hold the set never will, so growing would not help. A used one
+    // moves on to the next pool whatever the error: OUT_OF_POOL_MEMORY needs maintenance1, and a
+    // Vulkan 1.0 driver without it reports an exhausted pool as FRAGMENTED_POOL or any failure
+    if (freshPool) {
+      throw std::runtime_error(
+          "failed to allocate descriptor set (VkResult " + std::to_string(result) + ")!");
+    }
+    frame.current++;
+  }
+}
+
+LveDescriptorAllocatorStats LveDescriptorAllocator::frameStats() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return frames[currentFrame].stats;
+}
+
+uint32_t LveDescriptorAllocator::poolCount() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  size_t count = 0;
+  for (const auto &frame : frames) {
+    count += frame.pools.size();
+  }
+  return static_cast<uint32_t>(count);
+}
+
+VkDescriptorPool LveDescriptorAllocator::createPool() {
+  std::vector<VkDescriptorPoolSize> poolSizes;
+  poolSizes.reserve(poolSizeRatios.size());
+  for (const auto &ratio : poolSizeRatios) {
+    uint32_t count = static_cast<uint32_t>(ratio.second * static_cast<float>(setsPerPool));
+    poolSizes.push_back({ratio.first, std::max(1u, count)});
+  }
+
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.maxSets = setsPerPool;
+  poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+  poolInfo.pPoolSizes = poolSizes.data();
+  VkDescriptorPool pool;
+  if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create descriptor pool!");
+  }
+  return pool;
+}
+
+}  // namespace lve
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+// Device-wide cache of descriptor set layouts keyed by their bindings, so systems asking for the
+// same layout share one VkDescriptorSetLayout instead of each creating their own. Layouts belong
+// to the cache and live until the device is destroyed; never destroy one yourself.
+class LveDescriptorSetLayoutCache {
+ public:
+  explicit LveDescriptorSetLayoutCache(VkDevice device);
+  ~LveDescriptorSetLayoutCache();
+
+  LveDescriptorSetLayoutCache(const LveDescriptorSetLayoutCache &) = delete;
+  LveDescriptorSetLayoutCache &operator=(const LveDescriptorSetLayoutCache &) = delete;
+
+  // Binding order does not matter. Layouts that need a pNext chain (binding flags) are not
+  // cached; create those directly. Safe to call from any thread.
+  VkDescriptorSetLayout getLayout(
+      std::vector<VkDescriptorSetLayoutBinding> bindings,
+      VkDescriptorSetLayoutCreateFlags flags = 0);
+
+  uint32_t layoutCount() const;
+  uint64_t hitCount() const;
+
+ private:
+  struct LayoutKey {
+    VkDescriptorSetLayoutCreateFlags flags = 0;
+    std::vector<VkDescriptorSetLayoutBinding> bindings;  // sorted, pImmutableSamplers cleared
+    // per binding, empty for bindings without immutable samplers
+    std::vector<std::vector<VkSampler>> immutableSamplers;
+
+    bool operator==(const LayoutKey &other) const;
+  };
+  struct LayoutKeyHash {
+    size_t operator()(const LayoutKey &key) const;
+  };
+
+  VkDevice device;
+  mutable std::mutex mutex;
+  std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> layouts;
+  uint64_t hits = 0;
+};
+
+// Counters for one frame of an LveDescriptorAllocator.
+struct LveDescriptorAllocatorStats {
+  uint32_t setsAllocated = 0;
+  uint32_t poolsCreated = 0;
+  uint32_t poolResets = 0;
+};
+
+// Hands out transient descriptor sets for a frame linearly from a list of pools per frame in
+// flight. A full pool moves allocation on to the next one, creating it if needed, so the list
+// grows to the busiest frame and then stays put. beginFrame resets the frame's used pools with
+// one vkResetDescriptorPool each instead of freeing sets one by one.
+class LveDescriptorAllocator {
+ public:
+  // Descriptors of each type per pool, as a multiple of setsPerPool.
+  using PoolSizeRatios = std::vector<std::pair<VkDescriptorType, float>>;
+
+  static const PoolSizeRatios DEFAULT_POOL_SIZE_RATIOS;
+
+  LveDescriptorAllocator(
+      VkDevice device,
+      uint32_t framesInFlight,
+      uint32_t setsPerPool = 256,
+      PoolSizeRatios poolSizeRatios = DEFAULT_POOL_SIZE_RATIOS);
+  ~LveDescriptorAllocator();
+
+  LveDescriptorAllocator(const LveDescriptorAllocator &) = delete;
+  LveDescriptorAllocator &operator=(const LveDescriptorAllocator &) = delete;
+
+  // Resets the pools of frameIndex. Call after LveRenderer::beginFrame, which has waited for the
+  // fence of the frame that last used them.
+  void beginFrame(uint32_t frameIndex);
+
+  // Valid until frameIndex comes around again. Safe to call from any thread.
+  VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+  // counters since beginFrame for the current frame
+  LveDescriptorAllocatorStats frameStats() const;
+  uint32_t poolCount() const;
+
+ private:
+  struct FramePools {
+    std::vector<VkDescriptorPool> pools;
+    uint32_t current = 0;  // pools before this one are full
+    LveDescriptorAllocatorStats stats;
+  };
+
+  VkDescriptorPool createPool();
+
+  VkDevice device;
+  uint32_t setsPerPool;
+  PoolSizeRatios poolSizeRatios;
+
+  mutable std::mutex mutex;
+  std::vector<FramePools> frames;
+  uint32_t currentFrame = 0;
+};
+
+}  // namespace lve
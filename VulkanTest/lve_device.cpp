@@ -1,6 +1,10 @@
 #include "lve_device.hpp"
+#include "lve_device_selector.hpp"
+#include "lve_pipeline_registry.hpp"
+#include "lve_upload_manager.hpp"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -47,24 +51,54 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-LveDevice::LveDevice(LveWindow &window) : window{window} {
+LveDevice::LveDevice(LveWindow &window) : LveDevice{&window, LveDeviceUsage::Present} {}
+
+LveDevice::LveDevice(LveWindow &window, std::unique_ptr<LveShaderCompiler> shaderCompiler)
+    : LveDevice{&window, LveDeviceUsage::Present, std::move(shaderCompiler)} {}
+
+LveDevice::LveDevice() : LveDevice{nullptr, LveDeviceUsage::Offscreen} {}
+
+LveDevice::LveDevice(LveDeviceUsage usage) : LveDevice{nullptr, usage} {}
+
+LveDevice::LveDevice(
+    LveWindow *window, LveDeviceUsage usage, std::unique_ptr<LveShaderCompiler> shaderCompiler)
+    : window{window}, usage{usage}, shaderCompiler_{std::move(shaderCompiler)} {
+  if ((window != nullptr) != (usage == LveDeviceUsage::Present)) {
+    throw std::runtime_error("a device presents exactly when it has a window!");
+  }
   createInstance();
   setupDebugMessenger();
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
+  createAllocator();
+  createPipelineCache();
+  createDescriptorLayoutCache();
+  createShaderCompiler();
+  createPipelineRegistry();
   createCommandPool();
+  createUploadManager();
+  createProfiler();
 }
 
 LveDevice::~LveDevice() {
+  profiler_.reset();
+  uploadManager_.reset();
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  pipelineRegistry_.reset();
+  shaderCompiler_.reset();
+  descriptorLayoutCache_.reset();
+  pipelineCache_.reset();
+  allocator_.reset();
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (surface_ != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -86,6 +120,27 @@ void LveDevice::createInstance() {
   createInfo.pApplicationInfo = &appInfo;
 
   auto extensions = getRequiredExtensions();
+  // optional, needed to query descriptor indexing support on a 1.0 instance
+  uint32_t availableCount = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, nullptr);
+  std::vector<VkExtensionProperties> available(availableCount);
+  vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, available.data());
+  bool externalMemoryCapabilitiesAvailable = false;
+  for (const auto &extension : available) {
+    if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) ==
+        0) {
+      extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+      properties2Enabled = true;
+    }
+    if (strcmp(extension.extensionName, VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME) == 0) {
+      externalMemoryCapabilitiesAvailable = true;
+    }
+  }
+  // optional, reports device UUIDs for the device selector
+  if (properties2Enabled && externalMemoryCapabilitiesAvailable) {
+    extensions.push_back(VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME);
+    deviceIdPropertiesEnabled = true;
+  }
   createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
   createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -109,27 +164,17 @@ void LveDevice::createInstance() {
 }
 
 void LveDevice::pickPhysicalDevice() {
-  uint32_t deviceCount = 0;
-  vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
-  if (deviceCount == 0) {
-    throw std::runtime_error("failed to find GPUs with Vulkan support!");
-  }
-  std::cout << "Device count: " << deviceCount << std::endl;
-  std::vector<VkPhysicalDevice> devices(deviceCount);
-  vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
-
-  for (const auto &device : devices) {
-    if (isDeviceSuitable(device)) {
-      physicalDevice = device;
-      break;
-    }
-  }
-
-  if (physicalDevice == VK_NULL_HANDLE) {
-    throw std::runtime_error("failed to find a suitable GPU!");
+  PFN_vkGetPhysicalDeviceProperties2KHR getProperties2 = nullptr;
+  if (deviceIdPropertiesEnabled) {
+    getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
   }
+  LveDeviceSelector selector{instance, getProperties2, optionalDeviceExtensions};
+  physicalDevice = selector.select(
+      [this](VkPhysicalDevice device) { return deviceRejectReason(device); });
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  graphicsQueueSupported = findQueueFamilies(physicalDevice).graphicsSupported;
   std::cout << "physical device: " << properties.deviceName << std::endl;
 }
 
@@ -137,7 +182,11 @@ void LveDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {
+      indices.graphicsFamily,
+      indices.presentFamily,
+      indices.transferFamily,
+      indices.computeFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -149,8 +198,18 @@ void LveDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
-  deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // optional, scored by the device selector; software drivers may lack it
+  deviceFeatures.samplerAnisotropy = supportedFeatures.samplerAnisotropy;
+  // optional, the profiler only records timestamps without it
+  deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+  // optional, indirect draws fall back to one call per command without them
+  deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+  deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+  enabledFeatures = deviceFeatures;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -158,9 +217,49 @@ void LveDevice::createLogicalDevice() {
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      physicalDevice,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+
+  enabledDeviceExtensions = getRequiredDeviceExtensions();
+  for (const char *optional : optionalDeviceExtensions) {
+    // enabling them without it on the instance would make vkCreateDevice invalid usage
+    bool needsProperties2 = std::any_of(
+        properties2DeviceExtensions.begin(),
+        properties2DeviceExtensions.end(),
+        [optional](const char *name) { return strcmp(optional, name) == 0; });
+    if (needsProperties2 && !properties2Enabled) continue;
+    for (const auto &extension : availableExtensions) {
+      if (strcmp(optional, extension.extensionName) == 0) {
+        enabledDeviceExtensions.push_back(optional);
+        break;
+      }
+    }
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+  indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+  bindlessSupported = queryDescriptorIndexingFeatures(indexingFeatures);
+  if (bindlessSupported) {
+    createInfo.pNext = &indexingFeatures;
+  }
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+  synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+  bool synchronization2Supported = querySynchronization2Feature();
+  if (synchronization2Supported) {
+    synchronization2Features.synchronization2 = VK_TRUE;
+    synchronization2Features.pNext = const_cast<void *>(createInfo.pNext);
+    createInfo.pNext = &synchronization2Features;
+  }
+
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledDeviceExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledDeviceExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -177,6 +276,116 @@ void LveDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+  vkGetDeviceQueue(device_, indices.computeFamily, 0, &computeQueue_);
+
+  if (isExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+    drawIndexedIndirectCount_ = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+  }
+  if (synchronization2Supported) {
+    pipelineBarrier2_ = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdPipelineBarrier2KHR"));
+  }
+}
+
+bool LveDevice::querySynchronization2Feature() {
+  if (!properties2Enabled || !isExtensionEnabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+    return false;
+  }
+  auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+      vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+  if (getFeatures2 == nullptr) {
+    return false;
+  }
+
+  VkPhysicalDeviceSynchronization2FeaturesKHR supported = {};
+  supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+  VkPhysicalDeviceFeatures2KHR features2 = {};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+  features2.pNext = &supported;
+  getFeatures2(physicalDevice, &features2);
+  return supported.synchronization2 == VK_TRUE;
+}
+
+bool LveDevice::queryDescriptorIndexingFeatures(
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT &enabled) {
+  if (!properties2Enabled || !isExtensionEnabled(VK_KHR_MAINTENANCE3_EXTENSION_NAME) ||
+      !isExtensionEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+    return false;
+  }
+  auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+      vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+  auto getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+      vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
+  if (getFeatures2 == nullptr || getProperties2 == nullptr) {
+    return false;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported = {};
+  supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+  VkPhysicalDeviceFeatures2KHR features2 = {};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+  features2.pNext = &supported;
+  getFeatures2(physicalDevice, &features2);
+
+  // the bindless heap indexes image and buffer arrays with non-uniform handles and writes
+  // descriptors while earlier frames that use other slots of the same set are still in flight
+  if (!supported.shaderSampledImageArrayNonUniformIndexing ||
+      !supported.shaderStorageBufferArrayNonUniformIndexing ||
+      !supported.descriptorBindingSampledImageUpdateAfterBind ||
+      !supported.descriptorBindingStorageBufferUpdateAfterBind ||
+      !supported.descriptorBindingUpdateUnusedWhilePending ||
+      !supported.descriptorBindingPartiallyBound || !supported.runtimeDescriptorArray) {
+    return false;
+  }
+  enabled.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  enabled.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+  enabled.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  enabled.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+  enabled.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+  enabled.descriptorBindingPartiallyBound = VK_TRUE;
+  enabled.runtimeDescriptorArray = VK_TRUE;
+
+  descriptorIndexingProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+  VkPhysicalDeviceProperties2KHR properties2 = {};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+  properties2.pNext = &descriptorIndexingProperties;
+  getProperties2(physicalDevice, &properties2);
+  return true;
+}
+
+void LveDevice::createAllocator() {
+  // live heap budgets come through the properties2 instance extension
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+  if (properties2Enabled && isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+    getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+  }
+  allocator_ = std::make_unique<LveAllocator>(
+      physicalDevice,
+      device_,
+      properties.limits.bufferImageGranularity,
+      LveAllocator::DEFAULT_BLOCK_SIZE,
+      getMemoryProperties2);
+}
+
+void LveDevice::createPipelineCache() {
+  pipelineCache_ = std::make_unique<LvePipelineCache>(device_, properties);
+}
+
+void LveDevice::createDescriptorLayoutCache() {
+  descriptorLayoutCache_ = std::make_unique<LveDescriptorSetLayoutCache>(device_);
+}
+
+void LveDevice::createShaderCompiler() {
+  if (shaderCompiler_) return;
+  shaderCompiler_ = std::make_unique<LveShaderCompiler>();
+}
+
+void LveDevice::createPipelineRegistry() {
+  pipelineRegistry_ = std::make_unique<LvePipelineRegistry>(device_, *shaderCompiler_);
 }
 
 void LveDevice::createCommandPool() {
@@ -193,24 +402,54 @@ void LveDevice::createCommandPool() {
   }
 }
 
-void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+bool LveDevice::isExtensionEnabled(const char *extensionName) {
+  for (const char *enabled : enabledDeviceExtensions) {
+    if (strcmp(enabled, extensionName) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
 
-bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
-  QueueFamilyIndices indices = findQueueFamilies(device);
+void LveDevice::createUploadManager() {
+  uploadManager_ = std::make_unique<LveUploadManager>(*this);
+}
 
-  bool extensionsSupported = checkDeviceExtensionSupport(device);
+void LveDevice::createProfiler() {
+  QueueFamilyIndices indices = findPhysicalQueueFamilies();
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
-    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
-    swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
-  }
+  profiler_ = std::make_unique<LveProfiler>(
+      device_,
+      properties,
+      queueFamilies[indices.graphicsFamily].timestampValidBits,
+      enabledFeatures.pipelineStatisticsQuery == VK_TRUE);
+}
 
-  VkPhysicalDeviceFeatures supportedFeatures;
-  vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+void LveDevice::createSurface() {
+  if (isHeadless()) return;
+  window->createWindowSurface(instance, &surface_);
+}
 
-  return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+std::string LveDevice::deviceRejectReason(VkPhysicalDevice device) {
+  QueueFamilyIndices indices = findQueueFamilies(device);
+  if (usage == LveDeviceUsage::Compute) {
+    return indices.computeFamilyHasValue ? "" : "no compute queue";
+  }
+  if (!indices.graphicsFamilyHasValue) return "no graphics queue";
+  // headless devices never present, so there is no swap chain to be adequate for
+  if (isHeadless()) return "";
+
+  if (!indices.presentFamilyHasValue) return "no queue can present to the window";
+  if (!checkDeviceExtensionSupport(device)) return "no swap chain extension";
+  SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
+  if (swapChainSupport.formats.empty() || swapChainSupport.presentModes.empty()) {
+    return "no swap chain formats or present modes for the window";
+  }
+  return "";
 }
 
 void LveDevice::populateDebugMessengerCreateInfo(
@@ -261,11 +500,13 @@ bool LveDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> LveDevice::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -274,6 +515,11 @@ std::vector<const char *> LveDevice::getRequiredExtensions() {
   return extensions;
 }
 
+std::vector<const char *> LveDevice::getRequiredDeviceExtensions() {
+  if (isHeadless()) return {};
+  return deviceExtensions;
+}
+
 void LveDevice::hasGflwRequiredInstanceExtensions() {
   uint32_t extensionCount = 0;
   vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
@@ -308,6 +554,7 @@ bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
       &extensionCount,
       availableExtensions.data());
 
+  auto deviceExtensions = getRequiredDeviceExtensions();
   std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
   for (const auto &extension : availableExtensions) {
@@ -327,24 +574,62 @@ QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
   vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
   int i = 0;
+  bool computeFamilyHasGraphics = false;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT &&
+        !indices.graphicsFamilyHasValue) {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
     }
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
+    if (!isHeadless()) {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    }
+    if (queueFamily.queueCount > 0 && presentSupport && !indices.presentFamilyHasValue) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
     }
-    if (indices.isComplete()) {
-      break;
+    // prefer a family that also does graphics, so compute work needs no ownership transfers
+    bool withGraphics = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT &&
+        (!indices.computeFamilyHasValue || (withGraphics && !computeFamilyHasGraphics))) {
+      indices.computeFamily = i;
+      indices.computeFamilyHasValue = true;
+      computeFamilyHasGraphics = withGraphics;
+    }
+    // a family with transfer but neither graphics nor compute is usually a DMA engine
+    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+        !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) &&
+        !indices.transferFamilyHasValue) {
+      indices.transferFamily = i;
+      indices.transferFamilyHasValue = true;
     }
 
     i++;
   }
 
+  // a compute device without graphics submits everything to its compute queue
+  indices.graphicsSupported = indices.graphicsFamilyHasValue;
+  if (usage == LveDeviceUsage::Compute && !indices.graphicsFamilyHasValue &&
+      indices.computeFamilyHasValue) {
+    indices.graphicsFamily = indices.computeFamily;
+    indices.graphicsFamilyHasValue = true;
+  }
+
+  // headless frames are never presented; alias the present queue to graphics
+  if (isHeadless() && indices.graphicsFamilyHasValue) {
+    indices.presentFamily = indices.graphicsFamily;
+    indices.presentFamilyHasValue = true;
+  }
+
+  if (!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue) {
+    indices.transferFamily = indices.graphicsFamily;
+    indices.transferFamilyHasValue = true;
+  }
+  if (!indices.computeFamilyHasValue && indices.graphicsFamilyHasValue) {
+    indices.computeFamily = indices.graphicsFamily;
+  }
+
   return indices;
 }
 
@@ -408,30 +693,19 @@ void LveDevice::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    LveAllocation *&bufferMemory,
+    LveMemoryCategory category) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
   bufferInfo.usage = usage;
   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-  if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-    throw std::runtime_error("failed to create vertex buffer!");
-  }
-
-  VkMemoryRequirements memRequirements;
-  vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
-  }
+  bufferMemory = allocator_->createBuffer(bufferInfo, properties, buffer, category);
+}
 
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+void LveDevice::destroyBuffer(VkBuffer buffer, LveAllocation *bufferMemory) {
+  allocator_->destroyBuffer(buffer, bufferMemory);
 }
 
 VkCommandBuffer LveDevice::beginSingleTimeCommands() {
@@ -509,26 +783,13 @@ void LveDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
-  if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
-    throw std::runtime_error("failed to create image!");
-  }
-
-  VkMemoryRequirements memRequirements;
-  vkGetImageMemoryRequirements(device_, image, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
-  }
+    LveAllocation *&imageMemory,
+    LveMemoryCategory category) {
+  imageMemory = allocator_->createImage(imageInfo, properties, image, category);
+}
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
-    throw std::runtime_error("failed to bind image memory!");
-  }
+void LveDevice::destroyImage(VkImage image, LveAllocation *imageMemory) {
+  allocator_->destroyImage(image, imageMemory);
 }
 
 }  // namespace lve
\ No newline at end of file
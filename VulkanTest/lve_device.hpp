@@ -1,13 +1,22 @@
 #pragma once
 
+#include "lve_allocator.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_pipeline_cache.hpp"
+#include "lve_profiler.hpp"
+#include "lve_shader_compiler.hpp"
 #include "lve_window.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+class LvePipelineRegistry;
+class LveUploadManager;
+
 struct SwapChainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
@@ -15,11 +24,26 @@ struct SwapChainSupportDetails {
 };
 
 struct QueueFamilyIndices {
+  // the family every frame and single time command is submitted to; for a compute device
+  // without graphics its computeFamily
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  uint32_t transferFamily;  // a transfer-only family if the device has one, else graphicsFamily
+  uint32_t computeFamily;   // preferably one with graphics too; graphicsFamily if none computes
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool transferFamilyHasValue = false;
+  bool computeFamilyHasValue = false;
+  bool graphicsSupported = false;  // false when graphicsFamily is a compute family
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+  bool hasDedicatedTransfer() { return transferFamilyHasValue && transferFamily != graphicsFamily; }
+};
+
+// What the device is created for, which decides what a physical device needs to qualify.
+enum class LveDeviceUsage {
+  Present,    // rendering to a window: graphics and present queues and the swap chain extension
+  Offscreen,  // rendering without a surface: a graphics queue
+  Compute,    // compute and transfer work: a compute queue, with or without graphics
 };
 
 class LveDevice {
@@ -31,6 +55,15 @@ class LveDevice {
 #endif
 
   LveDevice(LveWindow &window);
+  // Takes over a shader compiler created, and possibly prefetched into, ahead of the device.
+  LveDevice(LveWindow &window, std::unique_ptr<LveShaderCompiler> shaderCompiler);
+  // Headless: no surface, no swap chain extension and no GLFW calls; render with
+  // LveOffscreenTarget. Any device with a graphics queue qualifies, including software drivers.
+  LveDevice();
+  // Headless for Offscreen or Compute usage. A Compute device may have no graphics queue at all,
+  // e.g. a render node or a dedicated compute accelerator; it runs compute pipelines and uploads
+  // but cannot render.
+  explicit LveDevice(LveDeviceUsage usage);
   ~LveDevice();
 
   // Not copyable or movable
@@ -44,6 +77,28 @@ class LveDevice {
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  VkQueue transferQueue() { return transferQueue_; }
+  VkQueue computeQueue() { return computeQueue_; }
+  LveAllocator &allocator() { return *allocator_; }
+  LvePipelineCache &pipelineCache() { return *pipelineCache_; }
+  LvePipelineRegistry &pipelineRegistry() { return *pipelineRegistry_; }
+  LveDescriptorSetLayoutCache &descriptorLayoutCache() { return *descriptorLayoutCache_; }
+  LveUploadManager &uploadManager() { return *uploadManager_; }
+  LveProfiler &profiler() { return *profiler_; }
+  LveShaderCompiler &shaderCompiler() { return *shaderCompiler_; }
+  bool isExtensionEnabled(const char *extensionName);
+  // true when VK_EXT_descriptor_indexing is enabled with the features LveBindlessHeap relies on
+  bool supportsBindless() const { return bindlessSupported; }
+  bool isHeadless() const { return window == nullptr; }
+  LveDeviceUsage getUsage() const { return usage; }
+  // false only for a Compute device without a graphics queue
+  bool hasGraphicsQueue() const { return graphicsQueueSupported; }
+  // null unless VK_KHR_draw_indirect_count is enabled
+  PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount() const {
+    return drawIndexedIndirectCount_;
+  }
+  // null unless VK_KHR_synchronization2 is enabled with its feature; see LveRenderGraph
+  PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2() const { return pipelineBarrier2_; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -52,12 +107,15 @@ class LveDevice {
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // Memory comes from the device allocator; release it with destroyBuffer, never vkFreeMemory.
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LveAllocation *&bufferMemory,
+      LveMemoryCategory category = LveMemoryCategory::General);
+  void destroyBuffer(VkBuffer buffer, LveAllocation *bufferMemory);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -68,21 +126,42 @@ class LveDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LveAllocation *&imageMemory,
+      LveMemoryCategory category = LveMemoryCategory::General);
+  void destroyImage(VkImage image, LveAllocation *imageMemory);
 
   VkPhysicalDeviceProperties properties;
+  VkPhysicalDeviceFeatures enabledFeatures = {};
+  // descriptor limits for update-after-bind sets; only filled in when supportsBindless()
+  VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties = {};
 
  private:
+  LveDevice(
+      LveWindow *window,
+      LveDeviceUsage usage,
+      std::unique_ptr<LveShaderCompiler> shaderCompiler = nullptr);
+
   void createInstance();
   void setupDebugMessenger();
   void createSurface();
   void pickPhysicalDevice();
   void createLogicalDevice();
+  bool queryDescriptorIndexingFeatures(VkPhysicalDeviceDescriptorIndexingFeaturesEXT &enabled);
+  bool querySynchronization2Feature();
+  void createAllocator();
+  void createPipelineCache();
+  void createDescriptorLayoutCache();
+  void createShaderCompiler();
+  void createPipelineRegistry();
   void createCommandPool();
+  void createUploadManager();
+  void createProfiler();
 
   // helper functions
-  bool isDeviceSuitable(VkPhysicalDevice device);
+  // why the device does not meet the usage's requirements, or empty when it does
+  std::string deviceRejectReason(VkPhysicalDevice device);
   std::vector<const char *> getRequiredExtensions();
+  std::vector<const char *> getRequiredDeviceExtensions();
   bool checkValidationLayerSupport();
   QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
@@ -93,16 +172,48 @@ class LveDevice {
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  LveWindow &window;
+  LveWindow *window = nullptr;  // null when headless
+  LveDeviceUsage usage;
   VkCommandPool commandPool;
+  std::unique_ptr<LveAllocator> allocator_;
+  std::unique_ptr<LvePipelineCache> pipelineCache_;
+  std::unique_ptr<LveDescriptorSetLayoutCache> descriptorLayoutCache_;
+  std::unique_ptr<LveShaderCompiler> shaderCompiler_;
+  std::unique_ptr<LvePipelineRegistry> pipelineRegistry_;
+  std::unique_ptr<LveUploadManager> uploadManager_;
+  std::unique_ptr<LveProfiler> profiler_;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+  VkQueue computeQueue_;
+  PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount_ = nullptr;
+  PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2_ = nullptr;
+  bool properties2Enabled = false;  // VK_KHR_get_physical_device_properties2 on the instance
+  // VK_KHR_external_memory_capabilities on the instance, which device UUIDs are reported through
+  bool deviceIdPropertiesEnabled = false;
+  bool graphicsQueueSupported = true;
+  bool bindlessSupported = false;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  // enabled when the device supports them, features depending on them check isExtensionEnabled
+  const std::vector<const char *> optionalDeviceExtensions = {
+      VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+      VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
+      VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+      VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+      VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+      VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME};
+  // the optional extensions that require VK_KHR_get_physical_device_properties2 on the instance
+  const std::vector<const char *> properties2DeviceExtensions = {
+      VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+      VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+      VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+      VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME};
+  std::vector<const char *> enabledDeviceExtensions;
 };
 
 }  // namespace lve
\ No newline at end of file
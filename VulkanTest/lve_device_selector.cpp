@@ -0,0 +1,262 @@
+#include "lve_device_selector.hpp"
+
+// std headers
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+std::string explicitOverride;
+
+std::string toLower(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return text;
+}
+
+const char *deviceTypeName(VkPhysicalDeviceType type) {
+  switch (type) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+      return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+      return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      return "cpu";
+    default:
+      return "other";
+  }
+}
+
+std::string queueFlagNames(VkQueueFlags flags) {
+  std::string names;
+  auto add = [&names](const char *name) {
+    if (!names.empty()) names += "+";
+    names += name;
+  };
+  if (flags & VK_QUEUE_GRAPHICS_BIT) add("graphics");
+  if (flags & VK_QUEUE_COMPUTE_BIT) add("compute");
+  if (flags & VK_QUEUE_TRANSFER_BIT) add("transfer");
+  return names.empty() ? "none" : names;
+}
+
+}  // namespace
+
+void LveDeviceSelector::setOverride(const std::string &nameOrUuid) {
+  explicitOverride = nameOrUuid;
+}
+
+std::string LveDeviceSelector::activeOverride() {
+  if (!explicitOverride.empty()) return explicitOverride;
+  const char *variable = std::getenv(OVERRIDE_VARIABLE);
+  return variable ? variable : "";
+}
+
+LveDeviceSelector::LveDeviceSelector(
+    VkInstance instance,
+    PFN_vkGetPhysicalDeviceProperties2KHR getProperties2,
+    const std::vector<const char *> &optionalExtensions)
+    : instance{instance}, getProperties2{getProperties2}, optionalExtensions{optionalExtensions} {}
+
+LveDeviceCandidate LveDeviceSelector::evaluate(VkPhysicalDevice device) const {
+  LveDeviceCandidate candidate{};
+  candidate.physicalDevice = device;
+  vkGetPhysicalDeviceProperties(device, &candidate.properties);
+  vkGetPhysicalDeviceFeatures(device, &candidate.features);
+
+  if (getProperties2 != nullptr) {
+    VkPhysicalDeviceIDPropertiesKHR idProperties{};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES_KHR;
+    VkPhysicalDeviceProperties2KHR properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+    properties2.pNext = &idProperties;
+    getProperties2(device, &properties2);
+    std::ostringstream uuid;
+    for (uint8_t byte : idProperties.deviceUUID) {
+      uuid << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+    }
+    candidate.uuid = uuid.str();
+  }
+
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+    const VkMemoryHeap &heap = memoryProperties.memoryHeaps[i];
+    if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+      candidate.deviceLocalBytes = std::max(candidate.deviceLocalBytes, heap.size);
+    }
+  }
+
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+  for (const auto &queueFamily : queueFamilies) {
+    if (queueFamily.queueCount > 0) candidate.queueFlags |= queueFamily.queueFlags;
+  }
+
+  uint32_t extensionCount = 0;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+  for (const char *optional : optionalExtensions) {
+    for (const auto &extension : extensions) {
+      if (std::strcmp(optional, extension.extensionName) == 0) {
+        candidate.optionalExtensions.push_back(optional);
+        break;
+      }
+    }
+  }
+  return candidate;
+}
+
+int64_t LveDeviceSelector::score(const LveDeviceCandidate &candidate) {
+  // the type outweighs everything else together, which only orders devices of the same type
+  int64_t total = 0;
+  switch (candidate.properties.deviceType) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      total += 40000;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+      total += 30000;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+      total += 20000;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      total += 10000;
+      break;
+    default:
+      break;
+  }
+
+  const VkPhysicalDeviceLimits &limits = candidate.properties.limits;
+  const VkDeviceSize gibibyte = 1024ull * 1024 * 1024;
+  total += std::min<int64_t>(static_cast<int64_t>(candidate.deviceLocalBytes / gibibyte), 16) * 100;
+  total += std::min<int64_t>(limits.maxImageDimension2D / 1024, 32) * 10;
+  total += std::min<int64_t>(limits.maxComputeSharedMemorySize / 1024, 64) * 2;
+
+  total += static_cast<int64_t>(candidate.optionalExtensions.size()) * 50;
+  const VkPhysicalDeviceFeatures &features = candidate.features;
+  for (VkBool32 supported :
+       {features.samplerAnisotropy,
+        features.multiDrawIndirect,
+        features.drawIndirectFirstInstance,
+        features.pipelineStatisticsQuery,
+        limits.timestampComputeAndGraphics}) {
+    if (supported) total += 25;
+  }
+  return total;
+}
+
+bool LveDeviceSelector::matches(
+    const LveDeviceCandidate &candidate, const std::string &nameOrUuid) {
+  std::string wanted = toLower(nameOrUuid);
+  std::string hex;
+  for (char c : wanted) {
+    if (c != '-') hex += c;
+  }
+  if (!candidate.uuid.empty() && hex == candidate.uuid) return true;
+  return toLower(candidate.properties.deviceName).find(wanted) != std::string::npos;
+}
+
+VkPhysicalDevice LveDeviceSelector::select(
+    const std::function<std::string(VkPhysicalDevice)> &rejectReason) {
+  uint32_t deviceCount = 0;
+  vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+  if (deviceCount == 0) {
+    throw std::runtime_error("failed to find GPUs with Vulkan support!");
+  }
+  std::vector<VkPhysicalDevice> devices(deviceCount);
+  vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+  candidates_.clear();
+  selected = SIZE_MAX;
+  std::string overrideName = activeOverride();
+  bool overrideMatched = false;
+  for (VkPhysicalDevice device : devices) {
+    LveDeviceCandidate candidate = evaluate(device);
+    candidate.rejectReason = rejectReason(device);
+    if (!overrideName.empty() && matches(candidate, overrideName)) {
+      overrideMatched = true;
+    } else if (!overrideName.empty() && candidate.eligible()) {
+      candidate.rejectReason = "not selected by " + overrideName;
+    }
+    if (candidate.eligible()) candidate.score = score(candidate);
+    candidates_.push_back(candidate);
+  }
+
+  for (size_t i = 0; i < candidates_.size(); i++) {
+    if (!candidates_[i].eligible()) continue;
+    if (selected == SIZE_MAX || candidates_[i].score > candidates_[selected].score) {
+      selected = i;
+    }
+  }
+  printReport(std::cout);
+
+  if (!overrideName.empty() && !overrideMatched) {
+    throw std::runtime_error("device override '" + overrideName + "' matches no physical device!");
+  }
+  if (!overrideName.empty() && selected == SIZE_MAX) {
+    throw std::runtime_error("device override '" + overrideName + "' matches no usable device!");
+  }
+  if (selected == SIZE_MAX) {
+    throw std::runtime_error("failed to find a suitable GPU!");
+  }
+  return candidates_[selected].physicalDevice;
+}
+
+void LveDeviceSelector::printReport(std::ostream &out) const {
+  std::string overrideName = activeOverride();
+  out << "physical devices";
+  if (!overrideName.empty()) out << " (override: " << overrideName << ")";
+  out << ":" << std::endl;
+
+  for (size_t i = 0; i < candidates_.size(); i++) {
+    const LveDeviceCandidate &candidate = candidates_[i];
+    const VkPhysicalDeviceProperties &properties = candidate.properties;
+    out << (i == selected ? "  * " : "    ") << "[" << i << "] " << properties.deviceName << ", "
+        << deviceTypeName(properties.deviceType) << ", ";
+    if (candidate.eligible()) {
+      out << "score " << candidate.score;
+    } else {
+      out << "rejected: " << candidate.rejectReason;
+    }
+    out << std::endl;
+
+    out << "        uuid " << (candidate.uuid.empty() ? "unavailable" : candidate.uuid)
+        << ", vendor 0x" << std::hex << properties.vendorID << " device 0x" << properties.deviceID
+        << std::dec << ", api " << VK_VERSION_MAJOR(properties.apiVersion) << "."
+        << VK_VERSION_MINOR(properties.apiVersion) << "."
+        << VK_VERSION_PATCH(properties.apiVersion) << ", driver " << properties.driverVersion
+        << std::endl;
+    out << "        " << candidate.deviceLocalBytes / (1024 * 1024) << " MiB device local, queues "
+        << queueFlagNames(candidate.queueFlags) << ", max image "
+        << properties.limits.maxImageDimension2D << ", compute shared memory "
+        << properties.limits.maxComputeSharedMemorySize / 1024 << " KiB" << std::endl;
+
+    out << "        features:";
+    const VkPhysicalDeviceFeatures &features = candidate.features;
+    if (features.samplerAnisotropy) out << " samplerAnisotropy";
+    if (features.multiDrawIndirect) out << " multiDrawIndirect";
+    if (features.drawIndirectFirstInstance) out << " drawIndirectFirstInstance";
+    if (features.pipelineStatisticsQuery) out << " pipelineStatisticsQuery";
+    if (properties.limits.timestampComputeAndGraphics) out << " timestamps";
+    for (const std::string &extension : candidate.optionalExtensions) {
+      out << " " << extension;
+    }
+    out << std::endl;
+  }
+}
+
+}  // namespace lve
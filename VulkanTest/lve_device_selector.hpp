@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// A physical device as the selector saw it.
+struct LveDeviceCandidate {
+  VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+  VkPhysicalDeviceProperties properties{};
+  VkPhysicalDeviceFeatures features{};
+  std::string uuid;                   // lower case hex, empty when the driver cannot report it
+  VkDeviceSize deviceLocalBytes = 0;  // of the largest device local heap
+  VkQueueFlags queueFlags = 0;        // over all of its queue families
+  std::vector<std::string> optionalExtensions;  // of the ones asked for, those it supports
+  std::string rejectReason;                     // empty when it meets the requirements
+  int64_t score = 0;
+
+  bool eligible() const { return rejectReason.empty(); }
+};
+
+// Ranks every physical device instead of taking the first one that works, so a machine with an
+// integrated and a discrete GPU lands on the discrete one. Devices that fail the caller's
+// requirements are rejected; the rest are scored by type first (discrete, integrated, virtual,
+// CPU), then by device local memory, limits, and the optional features and extensions they
+// support.
+//
+// An override picks a device by name (a case-insensitive substring) or by UUID, ahead of the
+// score: setOverride, e.g. from the command line, or else the LVE_DEVICE environment variable.
+// An override that matches no usable device is an error rather than a silent fallback.
+class LveDeviceSelector {
+ public:
+  static constexpr const char *OVERRIDE_VARIABLE = "LVE_DEVICE";
+
+  // Set before the device is created; takes precedence over LVE_DEVICE.
+  static void setOverride(const std::string &nameOrUuid);
+  // the override in effect, empty for none
+  static std::string activeOverride();
+
+  // getProperties2 reads the device UUIDs; null when the instance cannot report them.
+  LveDeviceSelector(
+      VkInstance instance,
+      PFN_vkGetPhysicalDeviceProperties2KHR getProperties2,
+      const std::vector<const char *> &optionalExtensions);
+
+  // rejectReason returns why a device cannot be used, or an empty string when it can. Prints the
+  // capability report, then returns the chosen device or throws when there is none.
+  VkPhysicalDevice select(const std::function<std::string(VkPhysicalDevice)> &rejectReason);
+
+  const std::vector<LveDeviceCandidate> &candidates() const { return candidates_; }
+  void printReport(std::ostream &out) const;
+
+ private:
+  LveDeviceCandidate evaluate(VkPhysicalDevice device) const;
+  static int64_t score(const LveDeviceCandidate &candidate);
+  static bool matches(const LveDeviceCandidate &candidate, const std::string &nameOrUuid);
+
+  VkInstance instance;
+  PFN_vkGetPhysicalDeviceProperties2KHR getProperties2;
+  std::vector<const char *> optionalExtensions;
+  std::vector<LveDeviceCandidate> candidates_;
+  size_t selected = SIZE_MAX;
+};
+
+}  // namespace lve
@@ -0,0 +1,397 @@
+#include "lve_indirect_draw_system.hpp"
+
+#include "lve_mesh_optimizer.hpp"
+
+// std headers
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace lve {
+
+LveIndirectDrawSystem::LveIndirectDrawSystem(
+    LveDevice &device,
+    LveMeshPool &meshPool,
+    VkRenderPass renderPass,
+    uint32_t maxInstances,
+    uint32_t maxMaterials)
+    : lveDevice{device},
+      meshPool{meshPool},
+      maxInstances{maxInstances},
+      maxMaterials{maxMaterials},
+      materialColors(maxMaterials, {1.0f, 1.0f, 1.0f, 1.0f}) {
+  createBuffers();
+  createDescriptorSet();
+  createPipelineLayout();
+  createPipeline(renderPass);
+}
+
+LveIndirectDrawSystem::~LveIndirectDrawSystem() {
+  lvePipeline.reset();
+  vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+  vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+
+  lveDevice.destroyBuffer(translationScaleBuffer, translationScaleMemory);
+  lveDevice.destroyBuffer(rotationBuffer, rotationMemory);
+  lveDevice.destroyBuffer(materialIdBuffer, materialIdMemory);
+  lveDevice.destroyBuffer(materialColorBuffer, materialColorMemory);
+  lveDevice.destroyBuffer(drawCommandBuffer, drawCommandMemory);
+  lveDevice.destroyBuffer(drawCountBuffer, drawCountMemory);
+  lveDevice.destroyBuffer(instanceDrawBuffer, instanceDrawMemory);
+  lveDevice.destroyBuffer(drawBoundsBuffer, drawBoundsMemory);
+  lveDevice.destroyBuffer(sourceDrawCommandBuffer, sourceDrawCommandMemory);
+  lveDevice.destroyBuffer(visibleInstanceBuffer, visibleInstanceMemory);
+}
+
+void LveIndirectDrawSystem::createBuffers() {
+  const VkBufferUsageFlags storage =
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  // the draw commands and count are also storage buffers so compute passes can rewrite them
+  const VkBufferUsageFlags indirect = storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+  lveDevice.createBuffer(
+      sizeof(float) * 4 * maxInstances,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      translationScaleBuffer,
+      translationScaleMemory,
+      LveMemoryCategory::Indirect);
+  lveDevice.createBuffer(
+      sizeof(float) * 4 * maxInstances,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      rotationBuffer,
+      rotationMemory,
+      LveMemoryCategory::Indirect);
+  lveDevice.createBuffer(
+      sizeof(uint32_t) * maxInstances,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      materialIdBuffer,
+      materialIdMemory,
+      LveMemoryCategory::Indirect);
+  lveDevice.createBuffer(
+      sizeof(float) * 4 * maxMaterials,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      materialColorBuffer,
+      materialColorMemory,
+      LveMemoryCategory::Indirect);
+  // at most one command per mesh, and no mesh can be drawn without an instance
+  lveDevice.createBuffer(
+      sizeof(VkDrawIndexedIndirectCommand) * maxInstances,
+      indirect,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      drawCommandBuffer,
+      drawCommandMemory,
+      LveMemoryCategory::Indirect);
+  lveDevice.createBuffer(
+      sizeof(uint32_t),
+      indirect,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      drawCountBuffer,
+      drawCountMemory,
+      LveMemoryCategory::Indirect);
+
+  lveDevice.createBuffer(
+      sizeof(uint32_t) * maxInstances,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      instanceDrawBuffer,
+      instanceDrawMemory,
+      LveMemoryCategory::Indirect);
+  lveDevice.createBuffer(
+      sizeof(float) * 4 * maxInstances,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      drawBoundsBuffer,
+      drawBoundsMemory,
+      LveMemoryCategory::Indirect);
+  lveDevice.createBuffer(
+      sizeof(VkDrawIndexedIndirectCommand) * maxInstances,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      sourceDrawCommandBuffer,
+      sourceDrawCommandMemory,
+      LveMemoryCategory::Indirect);
+  lveDevice.createBuffer(
+      sizeof(uint32_t) * maxInstances,
+      storage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      visibleInstanceBuffer,
+      visibleInstanceMemory,
+      LveMemoryCategory::Indirect);
+}
+
+void LveIndirectDrawSystem::createDescriptorSet() {
+  std::vector<VkDescriptorSetLayoutBinding> bindings(5);
+  for (uint32_t i = 0; i < bindings.size(); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  }
+  descriptorSetLayout = lveDevice.descriptorLayoutCache().getLayout(bindings);
+
+  VkDescriptorPoolSize poolSize{};
+  poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  poolSize.descriptorCount = static_cast<uint32_t>(bindings.size());
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.maxSets = 1;
+  poolInfo.poolSizeCount = 1;
+  poolInfo.pPoolSizes = &poolSize;
+  if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create instance descriptor pool!");
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = descriptorPool;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts = &descriptorSetLayout;
+  if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate instance descriptor set!");
+  }
+
+  std::array<VkDescriptorBufferInfo, 5> bufferInfos{};
+  bufferInfos[0] = {translationScaleBuffer, 0, VK_WHOLE_SIZE};
+  bufferInfos[1] = {rotationBuffer, 0, VK_WHOLE_SIZE};
+  bufferInfos[2] = {materialIdBuffer, 0, VK_WHOLE_SIZE};
+  bufferInfos[3] = {materialColorBuffer, 0, VK_WHOLE_SIZE};
+  bufferInfos[4] = {visibleInstanceBuffer, 0, VK_WHOLE_SIZE};
+  std::array<VkWriteDescriptorSet, 5> writes{};
+  for (uint32_t i = 0; i < writes.size(); i++) {
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].dstSet = descriptorSet;
+    writes[i].dstBinding = i;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[i].pBufferInfo = &bufferInfos[i];
+  }
+  vkUpdateDescriptorSets(
+      lveDevice.device(),
+      static_cast<uint32_t>(writes.size()),
+      writes.data(),
+      0,
+      nullptr);
+}
+
+void LveIndirectDrawSystem::createPipelineLayout() {
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(float) * 16;
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create indirect pipeline layout!");
+  }
+}
+
+void LveIndirectDrawSystem::createPipeline(VkRenderPass renderPass) {
+  auto pipelineConfig = LvePipeline::defaultPipelineConfigInfo();
+  pipelineConfig.bindingDescriptions = LveVertex::getBindingDescriptions();
+  pipelineConfig.attributeDescriptions = LveVertex::getAttributeDescriptions();
+  pipelineConfig.renderPass = renderPass;
+  pipelineConfig.pipelineLayout = pipelineLayout;
+  lvePipeline =
+      std::make_unique<LvePipeline>(lveDevice, VERT_SHADER_PATH, FRAG_SHADER_PATH, pipelineConfig);
+}
+
+void LveIndirectDrawSystem::setMaterialColor(uint32_t materialId, float r, float g, float b) {
+  if (materialId >= maxMaterials) {
+    throw std::runtime_error("material id out of range!");
+  }
+  materialColors[materialId] = {r, g, b, 1.0f};
+}
+
+uint32_t LveIndirectDrawSystem::addInstance(
+    const LveMeshHandle &mesh,
+    const std::array<float, 3> &translation,
+    float scale,
+    const std::array<float, 4> &rotation,
+    uint32_t materialId) {
+  if (instances.size() >= maxInstances) {
+    throw std::runtime_error("too many instances for the indirect draw system!");
+  }
+  if (materialId >= maxMaterials) {
+    throw std::runtime_error("material id out of range!");
+  }
+  instances.push_back(
+      {mesh, {translation[0], translation[1], translation[2], scale}, rotation, materialId});
+  return static_cast<uint32_t>(instances.size() - 1);
+}
+
+uint32_t LveIndirectDrawSystem::addInstance(
+    const LveMeshLodChain &chain,
+    const LveLodSelector &selector,
+    const std::array<float, 3> &translation,
+    float scale,
+    const std::array<float, 4> &rotation,
+    uint32_t materialId,
+    uint32_t *level) {
+  uint32_t selected = selector.selectLevel(chain, translation, scale);
+  if (level) *level = selected;
+  return addInstance(chain.levels[selected], translation, scale, rotation, materialId);
+}
+
+void LveIndirectDrawSystem::clearInstances() { instances.clear(); }
+
+void LveIndirectDrawSystem::upload(LveRenderer &renderer) {
+  // instances of one mesh must be contiguous so that one command covers all of them
+  std::vector<uint32_t> order(instances.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    return instances[a].mesh.firstIndex < instances[b].mesh.firstIndex;
+  });
+
+  std::vector<std::array<float, 4>> translationScales(instances.size());
+  std::vector<std::array<float, 4>> rotations(instances.size());
+  std::vector<uint32_t> materialIds(instances.size());
+  std::vector<uint32_t> instanceDraws(instances.size());
+  std::vector<uint32_t> visibleInstances(instances.size());
+  std::vector<std::array<float, 4>> drawBounds;
+  drawCommands.clear();
+  for (uint32_t i = 0; i < order.size(); i++) {
+    const PendingInstance &instance = instances[order[i]];
+    translationScales[i] = instance.translationScale;
+    rotations[i] = instance.rotation;
+    materialIds[i] = instance.materialId;
+
+    if (drawCommands.empty() || drawCommands.back().firstIndex != instance.mesh.firstIndex) {
+      VkDrawIndexedIndirectCommand command{};
+      command.indexCount = instance.mesh.indexCount;
+      command.instanceCount = 0;
+      command.firstIndex = instance.mesh.firstIndex;
+      command.vertexOffset = instance.mesh.vertexOffset;
+      command.firstInstance = i;
+      drawCommands.push_back(command);
+      const float *sphere = instance.mesh.boundingSphere;
+      drawBounds.push_back({sphere[0], sphere[1], sphere[2], sphere[3]});
+    }
+    drawCommands.back().instanceCount++;
+    instanceDraws[i] = static_cast<uint32_t>(drawCommands.size() - 1);
+    visibleInstances[i] = i;
+  }
+  uploadedInstances = static_cast<uint32_t>(instances.size());
+  uint32_t drawCount = static_cast<uint32_t>(drawCommands.size());
+
+  // frames in flight may still read every buffer written below
+  renderer.waitForSubmittedFrames();
+  LveUploadManager &uploadManager = lveDevice.uploadManager();
+  uploadManager.uploadBuffer(
+      materialColorBuffer,
+      0,
+      materialColors.data(),
+      sizeof(float) * 4 * materialColors.size());
+  uploadManager.uploadBuffer(drawCountBuffer, 0, &drawCount, sizeof(uint32_t));
+  if (uploadedInstances > 0) {
+    uploadManager.uploadBuffer(
+        translationScaleBuffer,
+        0,
+        translationScales.data(),
+        sizeof(float) * 4 * uploadedInstances);
+    uploadManager.uploadBuffer(
+        rotationBuffer,
+        0,
+        rotations.data(),
+        sizeof(float) * 4 * uploadedInstances);
+    uploadManager.uploadBuffer(
+        materialIdBuffer,
+        0,
+        materialIds.data(),
+        sizeof(uint32_t) * uploadedInstances);
+    uploadManager.uploadBuffer(
+        drawCommandBuffer,
+        0,
+        drawCommands.data(),
+        sizeof(VkDrawIndexedIndirectCommand) * drawCount);
+    uploadManager.uploadBuffer(
+        sourceDrawCommandBuffer,
+        0,
+        drawCommands.data(),
+        sizeof(VkDrawIndexedIndirectCommand) * drawCount);
+    uploadManager.uploadBuffer(
+        drawBoundsBuffer,
+        0,
+        drawBounds.data(),
+        sizeof(float) * 4 * drawCount);
+    uploadManager.uploadBuffer(
+        instanceDrawBuffer,
+        0,
+        instanceDraws.data(),
+        sizeof(uint32_t) * uploadedInstances);
+    uploadManager.uploadBuffer(
+        visibleInstanceBuffer,
+        0,
+        visibleInstances.data(),
+        sizeof(uint32_t) * uploadedInstances);
+  }
+  uploadManager.wait(uploadManager.flush());
+}
+
+void LveIndirectDrawSystem::render(
+    VkCommandBuffer commandBuffer, const std::array<float, 16> &viewProjection) {
+  if (drawCommands.empty()) return;
+
+  lvePipeline->bind(commandBuffer);
+  meshPool.bind(commandBuffer);
+  vkCmdBindDescriptorSets(
+      commandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      pipelineLayout,
+      0,
+      1,
+      &descriptorSet,
+      0,
+      nullptr);
+  vkCmdPushConstants(
+      commandBuffer,
+      pipelineLayout,
+      VK_SHADER_STAGE_VERTEX_BIT,
+      0,
+      sizeof(float) * 16,
+      viewProjection.data());
+
+  const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+  uint32_t drawCount = static_cast<uint32_t>(drawCommands.size());
+  const VkPhysicalDeviceFeatures &features = lveDevice.enabledFeatures;
+  if (!features.drawIndirectFirstInstance) {
+    // indirect commands would have to use firstInstance 0; issue the same draws directly
+    for (const auto &command : drawCommands) {
+      vkCmdDrawIndexed(
+          commandBuffer,
+          command.indexCount,
+          command.instanceCount,
+          command.firstIndex,
+          command.vertexOffset,
+          command.firstInstance);
+    }
+  } else if (lveDevice.drawIndexedIndirectCount() != nullptr) {
+    // the count comes from the GPU, so a culling pass can shrink it without a CPU round trip
+    lveDevice.drawIndexedIndirectCount()(
+        commandBuffer,
+        drawCommandBuffer,
+        0,
+        drawCountBuffer,
+        0,
+        maxInstances,
+        stride);
+  } else if (features.multiDrawIndirect) {
+    vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, 0, drawCount, stride);
+  } else {
+    for (uint32_t i = 0; i < drawCount; i++) {
+      vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, i * stride, 1, stride);
+    }
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_mesh_pool.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_renderer.hpp"
+
+// std lib headers
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+class LveLodSelector;
+
+// Draws every instance of every mesh in an LveMeshPool with one pipeline bind and one indirect
+// draw call. Instances are grouped by mesh into one VkDrawIndexedIndirectCommand per mesh, and
+// per-instance data lives in structure-of-arrays storage buffers:
+//   set 0, binding 0: vec4 translation (xyz) and uniform scale (w)
+//   set 0, binding 1: vec4 rotation quaternion
+//   set 0, binding 2: uint material id
+//   set 0, binding 3: vec4 material color, indexed by material id
+//   set 0, binding 4: uint instance index, indexed by gl_InstanceIndex
+// The indirection through binding 4 lets a culling pass compact the visible instances without
+// moving their data; upload() writes the identity mapping and the unculled draw commands.
+class LveIndirectDrawSystem {
+ public:
+  static constexpr const char *VERT_SHADER_PATH = "shaders/indirect.vert.spv";
+  static constexpr const char *FRAG_SHADER_PATH = "shaders/indirect.frag.spv";
+
+  LveIndirectDrawSystem(
+      LveDevice &device,
+      LveMeshPool &meshPool,
+      VkRenderPass renderPass,
+      uint32_t maxInstances,
+      uint32_t maxMaterials = 256);
+  ~LveIndirectDrawSystem();
+
+  LveIndirectDrawSystem(const LveIndirectDrawSystem &) = delete;
+  LveIndirectDrawSystem &operator=(const LveIndirectDrawSystem &) = delete;
+
+  void setMaterialColor(uint32_t materialId, float r, float g, float b);
+  uint32_t addInstance(
+      const LveMeshHandle &mesh,
+      const std::array<float, 3> &translation,
+      float scale,
+      const std::array<float, 4> &rotation,
+      uint32_t materialId);
+  // Adds an instance of the level of chain that selector picks for its distance to the camera.
+  // Levels are separate meshes to the draw commands, so re-adding the instances ahead of an upload
+  // as the camera moves switches their levels. level, when given, receives the level picked.
+  uint32_t addInstance(
+      const LveMeshLodChain &chain,
+      const LveLodSelector &selector,
+      const std::array<float, 3> &translation,
+      float scale,
+      const std::array<float, 4> &rotation,
+      uint32_t materialId,
+      uint32_t *level = nullptr);
+  void clearInstances();
+
+  // Sorts instances by mesh, uploads the instance arrays and the draw commands, and waits for the
+  // copies. The buffers are overwritten in place, possibly from the transfer queue, so this first
+  // waits for every frame renderer has submitted. Call between frames, since the renderer
+  // acquires the buffers at the next beginFrame.
+  void upload(LveRenderer &renderer);
+
+  // viewProjection is a column-major 4x4 matrix, pushed as a constant.
+  void render(VkCommandBuffer commandBuffer, const std::array<float, 16> &viewProjection);
+
+  uint32_t instanceCount() const { return uploadedInstances; }
+  uint32_t drawCommandCount() const { return static_cast<uint32_t>(drawCommands.size()); }
+  uint32_t maxInstanceCount() const { return maxInstances; }
+  VkBuffer getDrawCommandBuffer() const { return drawCommandBuffer; }
+  VkBuffer getDrawCountBuffer() const { return drawCountBuffer; }
+
+  // Inputs and outputs of LveCullingSystem. The source commands are the unculled commands from
+  // the last upload; each instance knows which of them draws it, and each command carries the
+  // bounding sphere of its mesh.
+  VkBuffer getTranslationScaleBuffer() const { return translationScaleBuffer; }
+  VkBuffer getRotationBuffer() const { return rotationBuffer; }
+  VkBuffer getInstanceDrawBuffer() const { return instanceDrawBuffer; }
+  VkBuffer getDrawBoundsBuffer() const { return drawBoundsBuffer; }
+  VkBuffer getSourceDrawCommandBuffer() const { return sourceDrawCommandBuffer; }
+  VkBuffer getVisibleInstanceBuffer() const { return visibleInstanceBuffer; }
+
+ private:
+  struct PendingInstance {
+    LveMeshHandle mesh;
+    std::array<float, 4> translationScale;
+    std::array<float, 4> rotation;
+    uint32_t materialId;
+  };
+
+  void createBuffers();
+  void createDescriptorSet();
+  void createPipelineLayout();
+  void createPipeline(VkRenderPass renderPass);
+
+  LveDevice &lveDevice;
+  LveMeshPool &meshPool;
+  uint32_t maxInstances;
+  uint32_t maxMaterials;
+
+  std::vector<PendingInstance> instances;
+  std::vector<std::array<float, 4>> materialColors;
+  std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+  uint32_t uploadedInstances = 0;
+
+  VkBuffer translationScaleBuffer;
+  LveAllocation *translationScaleMemory;
+  VkBuffer rotationBuffer;
+  LveAllocation *rotationMemory;
+  VkBuffer materialIdBuffer;
+  LveAllocation *materialIdMemory;
+  VkBuffer materialColorBuffer;
+  LveAllocation *materialColorMemory;
+  VkBuffer drawCommandBuffer;
+  LveAllocation *drawCommandMemory;
+  VkBuffer drawCountBuffer;
+  LveAllocation *drawCountMemory;
+  VkBuffer instanceDrawBuffer;
+  LveAllocation *instanceDrawMemory;
+  VkBuffer drawBoundsBuffer;
+  LveAllocation *drawBoundsMemory;
+  VkBuffer sourceDrawCommandBuffer;
+  LveAllocation *sourceDrawCommandMemory;
+  VkBuffer visibleInstanceBuffer;
+  LveAllocation *visibleInstanceMemory;
+
+  VkDescriptorSetLayout descriptorSetLayout;  // owned by the device layout cache
+  VkDescriptorPool descriptorPool;
+  VkDescriptorSet descriptorSet;
+  VkPipelineLayout pipelineLayout;
+  std::unique_ptr<LvePipeline> lvePipeline;
+};
+
+}  // namespace lve
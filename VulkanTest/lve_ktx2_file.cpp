@@ -0,0 +1,129 @@
+#include "lve_ktx2_file.hpp"
+
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+const unsigned char KTX2_IDENTIFIER[12] =
+    {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+constexpr uint32_t SUPERCOMPRESSION_NONE = 0;
+constexpr uint32_t SUPERCOMPRESSION_BASIS_LZ = 1;
+
+}  // namespace
+
+LveKtx2File::LveKtx2File(const std::string &path) : file{path} {
+  if (file.size() < sizeof(LveKtx2Header) ||
+      std::memcmp(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+    throw std::runtime_error(path + " is not a KTX2 file!");
+  }
+  fileHeader = reinterpret_cast<const LveKtx2Header *>(file.data());
+
+  if (fileHeader->supercompressionScheme == SUPERCOMPRESSION_BASIS_LZ ||
+      fileHeader->vkFormat == VK_FORMAT_UNDEFINED) {
+    throw std::runtime_error(path + " holds Basis Universal data, transcode it to BCn first!");
+  }
+  if (fileHeader->supercompressionScheme != SUPERCOMPRESSION_NONE) {
+    throw std::runtime_error(path + " is supercompressed, which is not supported!");
+  }
+  if (formatBlock(format()).bytes == 0) {
+    throw std::runtime_error(
+        path + " has unsupported format " + std::to_string(fileHeader->vkFormat) + "!");
+  }
+  if (fileHeader->pixelWidth == 0 || fileHeader->pixelHeight == 0 ||
+      fileHeader->pixelDepth > 1 || fileHeader->layerCount > 1 || fileHeader->faceCount != 1) {
+    throw std::runtime_error(path + " is not a single 2D texture!");
+  }
+
+  // a level count of 0 asks the loader to generate mips; there is only the base level then
+  uint32_t levelCount = std::max(1u, fileHeader->levelCount);
+  uint32_t fullChain = 1;
+  while ((std::max(fileHeader->pixelWidth, fileHeader->pixelHeight) >> fullChain) > 0) {
+    fullChain++;
+  }
+  if (levelCount > fullChain) {
+    throw std::runtime_error(path + " has more mip levels than its size allows!");
+  }
+  uint64_t indexEnd = sizeof(LveKtx2Header) + uint64_t{sizeof(LveKtx2Level)} * levelCount;
+  if (indexEnd > file.size()) {
+    throw std::runtime_error(path + " is truncated!");
+  }
+  levels.resize(levelCount);
+  std::memcpy(
+      levels.data(),
+      file.data() + sizeof(LveKtx2Header),
+      sizeof(LveKtx2Level) * levelCount);
+
+  // uploads trust these sizes, so reject levels that would read outside the file or the image
+  LveFormatBlock block = formatBlock(format());
+  for (uint32_t level = 0; level < levelCount; level++) {
+    const LveKtx2Level &entry = levels[level];
+    uint64_t blocksWide = (levelWidth(level) + block.width - 1) / block.width;
+    uint64_t blocksHigh = (levelHeight(level) + block.height - 1) / block.height;
+    if (entry.byteOffset > file.size() || entry.byteLength > file.size() - entry.byteOffset ||
+        entry.byteLength != blocksWide * blocksHigh * block.bytes) {
+      throw std::runtime_error(
+          path + " has a bad index entry for mip level " + std::to_string(level) + "!");
+    }
+  }
+}
+
+uint32_t LveKtx2File::levelWidth(uint32_t level) const {
+  return std::max(1u, fileHeader->pixelWidth >> level);
+}
+
+uint32_t LveKtx2File::levelHeight(uint32_t level) const {
+  return std::max(1u, fileHeader->pixelHeight >> level);
+}
+
+const unsigned char *LveKtx2File::levelData(uint32_t level) const {
+  return file.data() + levels[level].byteOffset;
+}
+
+LveFormatBlock LveKtx2File::formatBlock(VkFormat format) {
+  switch (format) {
+    case VK_FORMAT_R8_UNORM:
+      return {1, 1, 1};
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R16_SFLOAT:
+      return {1, 1, 2};
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_R16G16_SFLOAT:
+    case VK_FORMAT_R32_SFLOAT:
+      return {1, 1, 4};
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+      return {1, 1, 8};
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+      return {1, 1, 16};
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+      return {4, 4, 8};
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+      return {4, 4, 16};
+    default:
+      return {};
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "lve_mapped_file.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// Fixed part of a KTX2 file, as laid out on disk (little endian).
+struct LveKtx2Header {
+  unsigned char identifier[12];
+  uint32_t vkFormat;
+  uint32_t typeSize;
+  uint32_t pixelWidth;
+  uint32_t pixelHeight;
+  uint32_t pixelDepth;
+  uint32_t layerCount;
+  uint32_t faceCount;
+  uint32_t levelCount;
+  uint32_t supercompressionScheme;
+  uint32_t dfdByteOffset;
+  uint32_t dfdByteLength;
+  uint32_t kvdByteOffset;
+  uint32_t kvdByteLength;
+  uint64_t sgdByteOffset;
+  uint64_t sgdByteLength;
+};
+static_assert(sizeof(LveKtx2Header) == 80, "KTX2 header must match the file layout");
+
+struct LveKtx2Level {
+  uint64_t byteOffset;
+  uint64_t byteLength;
+  uint64_t uncompressedByteLength;
+};
+
+// Texel block of a format: the smallest unit its data can be addressed in.
+struct LveFormatBlock {
+  uint32_t width = 1;
+  uint32_t height = 1;
+  uint32_t bytes = 0;  // 0 for formats the loader does not know
+};
+
+// A memory-mapped KTX2 texture whose mip levels upload straight from the mapping. Only 2D,
+// single-layer, non-cube textures in a format the GPU samples directly are accepted: plain
+// RGBA8-style formats and BC1-7. Basis Universal (BasisLZ, UASTC) and zstd supercompressed files
+// are rejected, since transcoding them needs the Basis and zstd libraries; transcode those to BCn
+// offline (for example with `ktx transcode --target bc7`).
+class LveKtx2File {
+ public:
+  explicit LveKtx2File(const std::string &path);
+
+  LveKtx2File(const LveKtx2File &) = delete;
+  LveKtx2File &operator=(const LveKtx2File &) = delete;
+
+  VkFormat format() const { return static_cast<VkFormat>(fileHeader->vkFormat); }
+  uint32_t width() const { return fileHeader->pixelWidth; }
+  uint32_t height() const { return fileHeader->pixelHeight; }
+  uint32_t levelCount() const { return static_cast<uint32_t>(levels.size()); }
+
+  // Level 0 is the full-size image, each following level half as large.
+  uint32_t levelWidth(uint32_t level) const;
+  uint32_t levelHeight(uint32_t level) const;
+  const unsigned char *levelData(uint32_t level) const;
+  uint64_t levelSize(uint32_t level) const { return levels[level].byteLength; }
+
+  static LveFormatBlock formatBlock(VkFormat format);
+
+ private:
+  LveMappedFile file;
+  const LveKtx2Header *fileHeader = nullptr;
+  std::vector<LveKtx2Level> levels;
+};
+
+}  // namespace lve
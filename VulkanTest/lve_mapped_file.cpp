@@ -0,0 +1,102 @@
+#include "lve_mapped_file.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// std headers
+#include <stdexcept>
+
+namespace lve {
+
+#ifdef _WIN32
+
+LveMappedFile::LveMappedFile(const std::string &path) {
+  HANDLE file = CreateFileA(
+      path.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+      nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  fileHandle = file;
+
+  LARGE_INTEGER fileSize{};
+  if (!GetFileSizeEx(file, &fileSize)) {
+    CloseHandle(file);
+    throw std::runtime_error("failed to query the size of " + path);
+  }
+  mappedSize = static_cast<size_t>(fileSize.QuadPart);
+  // an empty file cannot be mapped, and there is nothing to read anyway
+  if (mappedSize == 0) return;
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    throw std::runtime_error("failed to map " + path);
+  }
+  mappingHandle = mapping;
+
+  mapped = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (mapped == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    throw std::runtime_error("failed to map " + path);
+  }
+}
+
+LveMappedFile::~LveMappedFile() {
+  if (mapped != nullptr) UnmapViewOfFile(mapped);
+  if (mappingHandle != nullptr) CloseHandle(static_cast<HANDLE>(mappingHandle));
+  if (fileHandle != nullptr) CloseHandle(static_cast<HANDLE>(fileHandle));
+}
+
+#else
+
+LveMappedFile::LveMappedFile(const std::string &path) {
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+
+  struct stat status {};
+  if (fstat(file, &status) != 0) {
+    close(file);
+    throw std::runtime_error("failed to query the size of " + path);
+  }
+  mappedSize = static_cast<size_t>(status.st_size);
+  if (mappedSize == 0) {
+    close(file);
+    return;
+  }
+
+  void *address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, file, 0);
+  // the mapping keeps the file referenced on its own
+  close(file);
+  if (address == MAP_FAILED) {
+    throw std::runtime_error("failed to map " + path);
+  }
+  // sections are read front to back exactly once, on their way into staging memory
+  madvise(address, mappedSize, MADV_SEQUENTIAL);
+  mapped = static_cast<const unsigned char *>(address);
+}
+
+LveMappedFile::~LveMappedFile() {
+  if (mapped != nullptr) munmap(const_cast<unsigned char *>(mapped), mappedSize);
+}
+
+#endif
+
+}  // namespace lve
@@ -0,0 +1,32 @@
+#pragma once
+
+// std lib headers
+#include <cstddef>
+#include <string>
+
+namespace lve {
+
+// Read-only memory mapping of a whole file. The mapping starts on a page boundary, so data at a
+// suitably aligned offset inside the file is suitably aligned in memory, and pages are only read
+// from disk when they are first touched.
+class LveMappedFile {
+ public:
+  explicit LveMappedFile(const std::string &path);
+  ~LveMappedFile();
+
+  LveMappedFile(const LveMappedFile &) = delete;
+  LveMappedFile &operator=(const LveMappedFile &) = delete;
+
+  const unsigned char *data() const { return mapped; }
+  size_t size() const { return mappedSize; }
+
+ private:
+  const unsigned char *mapped = nullptr;
+  size_t mappedSize = 0;
+#ifdef _WIN32
+  void *fileHandle = nullptr;
+  void *mappingHandle = nullptr;
+#endif
+};
+
+}  // namespace lve
@@ -0,0 +1,152 @@
+#include "lve_mesh_file.hpp"
+
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+constexpr char LveMeshFile::MAGIC[4];
+
+LveMeshFile::LveMeshFile(const std::string &path) : file{path} {
+  if (file.size() < sizeof(LveMeshFileHeader)) {
+    throw std::runtime_error(path + " is too small to be a mesh file!");
+  }
+  fileHeader = reinterpret_cast<const LveMeshFileHeader *>(file.data());
+  if (std::memcmp(fileHeader->magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error(path + " is not a mesh file!");
+  }
+  if (fileHeader->version != VERSION) {
+    throw std::runtime_error(
+        path + " has mesh format version " + std::to_string(fileHeader->version) + ", expected " +
+        std::to_string(VERSION) + "!");
+  }
+  if (fileHeader->vertexStride != sizeof(LveVertex)) {
+    throw std::runtime_error(path + " was written with a different vertex layout!");
+  }
+  if (fileHeader->fileSize != file.size()) {
+    throw std::runtime_error(path + " is truncated!");
+  }
+
+  vertexData = reinterpret_cast<const LveVertex *>(section(
+      fileHeader->vertexSectionOffset,
+      uint64_t{sizeof(LveVertex)} * fileHeader->vertexCount,
+      path));
+  indexData = reinterpret_cast<const uint32_t *>(section(
+      fileHeader->indexSectionOffset,
+      uint64_t{sizeof(uint32_t)} * fileHeader->indexCount,
+      path));
+  submeshData = reinterpret_cast<const LveSubmesh *>(section(
+      fileHeader->submeshSectionOffset,
+      uint64_t{sizeof(LveSubmesh)} * fileHeader->submeshCount,
+      path));
+  lodData = reinterpret_cast<const LveMeshLod *>(section(
+      fileHeader->lodSectionOffset,
+      uint64_t{sizeof(LveMeshLod)} * fileHeader->lodCount,
+      path));
+
+  // the pool trusts indices and ranges, so reject anything that would read out of bounds there
+  for (uint32_t i = 0; i < fileHeader->submeshCount; i++) {
+    const LveSubmesh &submesh = submeshData[i];
+    if (uint64_t{submesh.firstIndex} + submesh.indexCount > fileHeader->indexCount) {
+      throw std::runtime_error(path + " has a submesh outside its index range!");
+    }
+  }
+  for (uint32_t i = 0; i < fileHeader->lodCount; i++) {
+    const LveMeshLod &lod = lodData[i];
+    if (lod.submesh >= fileHeader->submeshCount ||
+        uint64_t{lod.firstIndex} + lod.indexCount > fileHeader->indexCount) {
+      throw std::runtime_error(path + " has a level of detail outside its index range!");
+    }
+  }
+  // every submesh and level draws from this one section, so checking it whole covers them all;
+  // the upload reads it right after, so the pages it brings in are not wasted
+  uint32_t maxIndex = 0;
+  for (uint32_t i = 0; i < fileHeader->indexCount; i++) {
+    maxIndex = std::max(maxIndex, indexData[i]);
+  }
+  if (fileHeader->indexCount > 0 && maxIndex >= fileHeader->vertexCount) {
+    throw std::runtime_error(path + " has an index past its last vertex!");
+  }
+}
+
+const unsigned char *LveMeshFile::section(
+    uint64_t offset, uint64_t bytes, const std::string &path) const {
+  if (offset % SECTION_ALIGNMENT != 0 || offset > file.size() || bytes > file.size() - offset) {
+    throw std::runtime_error(path + " has a section outside the file!");
+  }
+  return file.data() + offset;
+}
+
+void LveMeshFile::write(const std::string &path, const LveMeshData &mesh) {
+  LveMeshFileHeader header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.vertexStride = sizeof(LveVertex);
+  header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+  header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+  header.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+  header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+  header.vertexSectionOffset = alignUp(sizeof(LveMeshFileHeader), SECTION_ALIGNMENT);
+  header.indexSectionOffset = alignUp(
+      header.vertexSectionOffset + sizeof(LveVertex) * mesh.vertices.size(),
+      SECTION_ALIGNMENT);
+  header.submeshSectionOffset = alignUp(
+      header.indexSectionOffset + sizeof(uint32_t) * mesh.indices.size(),
+      SECTION_ALIGNMENT);
+  header.lodSectionOffset = alignUp(
+      header.submeshSectionOffset + sizeof(LveSubmesh) * mesh.submeshes.size(),
+      SECTION_ALIGNMENT);
+  header.fileSize = header.lodSectionOffset + sizeof(LveMeshLod) * mesh.lods.size();
+
+  // written beside the target and renamed, like the pipeline cache
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream out{tempPath, std::ios::binary | std::ios::trunc};
+    if (!out.is_open()) {
+      throw std::runtime_error("failed to open " + tempPath + "!");
+    }
+    auto writeSection = [&out](uint64_t offset, const void *data, size_t bytes) {
+      static const char padding[SECTION_ALIGNMENT] = {};
+      uint64_t position = static_cast<uint64_t>(out.tellp());
+      out.write(padding, static_cast<std::streamsize>(offset - position));
+      out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+    };
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeSection(
+        header.vertexSectionOffset,
+        mesh.vertices.data(),
+        sizeof(LveVertex) * mesh.vertices.size());
+    writeSection(
+        header.indexSectionOffset,
+        mesh.indices.data(),
+        sizeof(uint32_t) * mesh.indices.size());
+    writeSection(
+        header.submeshSectionOffset,
+        mesh.submeshes.data(),
+        sizeof(LveSubmesh) * mesh.submeshes.size());
+    writeSection(header.lodSectionOffset, mesh.lods.data(), sizeof(LveMeshLod) * mesh.lods.size());
+    if (!out) {
+      throw std::runtime_error("failed to write " + tempPath + "!");
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if (error) {
+    std::filesystem::remove(tempPath, error);
+    throw std::runtime_error("failed to replace " + path + "!");
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "lve_mapped_file.hpp"
+#include "lve_mesh_pool.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// A run of indices drawn with one material.
+struct LveSubmesh {
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+  uint32_t materialId = 0;
+  uint32_t reserved = 0;
+};
+
+// A simplified version of a submesh. The submesh itself is the full-detail level; its reduced
+// levels follow one another in the LOD table, finest first. error is the largest distance, in mesh
+// units, between the simplified surface and the original.
+struct LveMeshLod {
+  uint32_t submesh = 0;
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+  float error = 0.0f;
+};
+
+struct LveMeshData {
+  std::vector<LveVertex> vertices;
+  std::vector<uint32_t> indices;
+  std::vector<LveSubmesh> submeshes;
+  std::vector<LveMeshLod> lods;
+};
+
+// On-disk layout, little endian. Every section starts at a multiple of SECTION_ALIGNMENT from
+// the start of the file, so once mapped each one can be used in place as an array.
+struct LveMeshFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t vertexStride;  // sizeof(LveVertex) when written; a mismatch means a different layout
+  uint32_t vertexCount;
+  uint32_t indexCount;
+  uint32_t submeshCount;
+  uint32_t lodCount;
+  uint32_t reserved;
+  uint64_t vertexSectionOffset;
+  uint64_t indexSectionOffset;
+  uint64_t submeshSectionOffset;
+  uint64_t lodSectionOffset;
+  uint64_t fileSize;
+};
+
+// A mesh container file (".lvemesh") opened through a memory mapping. Nothing is copied on
+// load: the accessors point into the mapping, and LveMeshPool::addMeshFile copies from there
+// straight into staging memory.
+class LveMeshFile {
+ public:
+  static constexpr char MAGIC[4] = {'L', 'V', 'E', 'M'};
+  static constexpr uint32_t VERSION = 2;  // 2: LOD table
+  static constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+  // Throws when the file is not a mesh container of this version or is truncated.
+  explicit LveMeshFile(const std::string &path);
+
+  LveMeshFile(const LveMeshFile &) = delete;
+  LveMeshFile &operator=(const LveMeshFile &) = delete;
+
+  static void write(const std::string &path, const LveMeshData &mesh);
+
+  const LveMeshFileHeader &header() const { return *fileHeader; }
+  const LveVertex *vertices() const { return vertexData; }
+  const uint32_t *indices() const { return indexData; }
+  const LveSubmesh *submeshes() const { return submeshData; }
+  const LveMeshLod *lods() const { return lodData; }
+  uint32_t vertexCount() const { return fileHeader->vertexCount; }
+  uint32_t indexCount() const { return fileHeader->indexCount; }
+  uint32_t submeshCount() const { return fileHeader->submeshCount; }
+  uint32_t lodCount() const { return fileHeader->lodCount; }
+
+ private:
+  const unsigned char *section(uint64_t offset, uint64_t bytes, const std::string &path) const;
+
+  LveMappedFile file;
+  const LveMeshFileHeader *fileHeader;
+  const LveVertex *vertexData;
+  const uint32_t *indexData;
+  const LveSubmesh *submeshData;
+  const LveMeshLod *lodData;
+};
+
+}  // namespace lve
@@ -0,0 +1,758 @@
+#include "lve_mesh_optimizer.hpp"
+
+// std headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+using Vec3 = std::array<float, 3>;
+
+Vec3 positionOf(const LveVertex &vertex) {
+  return {vertex.position[0], vertex.position[1], vertex.position[2]};
+}
+
+Vec3 subtract(const Vec3 &a, const Vec3 &b) { return {a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+
+Vec3 cross(const Vec3 &a, const Vec3 &b) {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+float dot(const Vec3 &a, const Vec3 &b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+float length(const Vec3 &a) { return std::sqrt(dot(a, a)); }
+
+// Unnormalized face normal; its length is twice the triangle's area.
+Vec3 faceNormal(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2) {
+  return cross(subtract(p1, p0), subtract(p2, p0));
+}
+
+// Triangles around each vertex, as compressed rows.
+struct VertexAdjacency {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+
+  VertexAdjacency(const uint32_t *indices, size_t indexCount, uint32_t vertexCount)
+      : offsets(vertexCount + 1, 0), triangles(indexCount) {
+    for (size_t i = 0; i < indexCount; i++) offsets[indices[i] + 1]++;
+    for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; i++) {
+      triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  uint32_t count(uint32_t vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+};
+
+// FIFO post-transform cache, as found in most hardware.
+class FifoCache {
+ public:
+  FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+      : cacheSize{cacheSize}, timestamps(vertexCount, 0), time{cacheSize + 1} {}
+
+  // Returns true on a miss.
+  bool access(uint32_t vertex) {
+    if (time - timestamps[vertex] <= cacheSize) return false;
+    timestamps[vertex] = time++;
+    return true;
+  }
+  // Evicts everything.
+  void reset() { time += cacheSize + 1; }
+
+ private:
+  uint32_t cacheSize;
+  std::vector<uint32_t> timestamps;
+  uint32_t time;
+};
+
+// Tipsify. Fans around one vertex at a time and moves on to the neighbour that will stay in the
+// cache longest; when no neighbour has triangles left it falls back to recently used vertices,
+// then to input order. clusterStarts receives the first triangle after each such dead end.
+void tipsify(
+    const uint32_t *indices,
+    size_t indexCount,
+    uint32_t vertexCount,
+    uint32_t cacheSize,
+    std::vector<uint32_t> &output,
+    std::vector<uint32_t> *clusterStarts) {
+  VertexAdjacency adjacency{indices, indexCount, vertexCount};
+  std::vector<uint32_t> live(vertexCount);
+  for (uint32_t v = 0; v < vertexCount; v++) live[v] = adjacency.count(v);
+  std::vector<uint32_t> cacheTime(vertexCount, 0);
+  std::vector<char> emitted(indexCount / 3, 0);
+  std::vector<uint32_t> deadEnds;
+  std::vector<uint32_t> candidates;
+  uint32_t timeStamp = cacheSize + 1;
+  uint32_t cursor = 0;
+  output.clear();
+  output.reserve(indexCount);
+
+  auto skipDeadEnd = [&]() -> int64_t {
+    while (!deadEnds.empty()) {
+      uint32_t vertex = deadEnds.back();
+      deadEnds.pop_back();
+      if (live[vertex] > 0) return vertex;
+    }
+    for (; cursor < vertexCount; cursor++) {
+      if (live[cursor] > 0) return cursor;
+    }
+    return -1;
+  };
+
+  int64_t fanning = skipDeadEnd();
+  bool afterDeadEnd = true;
+  while (fanning >= 0) {
+    candidates.clear();
+    uint32_t vertex = static_cast<uint32_t>(fanning);
+    for (uint32_t i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++) {
+      uint32_t triangle = adjacency.triangles[i];
+      if (emitted[triangle]) continue;
+      emitted[triangle] = 1;
+      if (afterDeadEnd && clusterStarts != nullptr) {
+        clusterStarts->push_back(static_cast<uint32_t>(output.size() / 3));
+      }
+      afterDeadEnd = false;
+      for (int k = 0; k < 3; k++) {
+        uint32_t corner = indices[3 * size_t{triangle} + k];
+        output.push_back(corner);
+        deadEnds.push_back(corner);
+        candidates.push_back(corner);
+        live[corner]--;
+        if (timeStamp - cacheTime[corner] > cacheSize) cacheTime[corner] = timeStamp++;
+      }
+    }
+
+    int64_t best = -1;
+    int64_t bestPriority = -1;
+    for (uint32_t candidate : candidates) {
+      if (live[candidate] == 0) continue;
+      // prefer the vertex that entered the cache earliest, as long as fanning around it does
+      // not push it out before its triangles are done
+      int64_t priority = 0;
+      if (timeStamp - cacheTime[candidate] + 2 * live[candidate] <= cacheSize) {
+        priority = timeStamp - cacheTime[candidate];
+      }
+      if (priority > bestPriority) {
+        best = candidate;
+        bestPriority = priority;
+      }
+    }
+    if (best < 0) {
+      best = skipDeadEnd();
+      afterDeadEnd = true;
+    }
+    fanning = best;
+  }
+}
+
+// Quadric error metric (Garland and Heckbert 1997) weighted by area, so evaluate() returns a
+// squared distance in mesh units.
+struct Quadric {
+  double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+  double weight = 0;
+
+  void addPlane(double a, double b, double c, double d, double w) {
+    a2 += w * a * a;
+    ab += w * a * b;
+    ac += w * a * c;
+    ad += w * a * d;
+    b2 += w * b * b;
+    bc += w * b * c;
+    bd += w * b * d;
+    c2 += w * c * c;
+    cd += w * c * d;
+    d2 += w * d * d;
+    weight += w;
+  }
+
+  Quadric &operator+=(const Quadric &other) {
+    a2 += other.a2;
+    ab += other.ab;
+    ac += other.ac;
+    ad += other.ad;
+    b2 += other.b2;
+    bc += other.bc;
+    bd += other.bd;
+    c2 += other.c2;
+    cd += other.cd;
+    d2 += other.d2;
+    weight += other.weight;
+    return *this;
+  }
+
+  double evaluate(const Vec3 &p) const {
+    if (weight <= 0.0) return 0.0;
+    double x = p[0], y = p[1], z = p[2];
+    double r = a2 * x * x + b2 * y * y + c2 * z * z +
+               2.0 * (ab * x * y + ac * x * z + bc * y * z) + 2.0 * (ad * x + bd * y + cd * z) +
+               d2;
+    return std::fabs(r) / weight;
+  }
+};
+
+void computeMeshletBounds(
+    LveMeshlet &meshlet, const LveMeshlets &meshlets, const LveVertex *vertices) {
+  const uint32_t *local = meshlets.vertices.data() + meshlet.vertexOffset;
+  const uint8_t *triangles = meshlets.triangles.data() + meshlet.triangleOffset;
+
+  Vec3 minimum = positionOf(vertices[local[0]]);
+  Vec3 maximum = minimum;
+  for (uint32_t i = 1; i < meshlet.vertexCount; i++) {
+    Vec3 p = positionOf(vertices[local[i]]);
+    for (int axis = 0; axis < 3; axis++) {
+      minimum[axis] = std::min(minimum[axis], p[axis]);
+      maximum[axis] = std::max(maximum[axis], p[axis]);
+    }
+  }
+  Vec3 center{};
+  for (int axis = 0; axis < 3; axis++) center[axis] = 0.5f * (minimum[axis] + maximum[axis]);
+  float radius = 0.0f;
+  for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+    radius = std::max(radius, length(subtract(positionOf(vertices[local[i]]), center)));
+  }
+  std::copy(center.begin(), center.end(), meshlet.center);
+  meshlet.radius = radius;
+  std::copy(center.begin(), center.end(), meshlet.coneApex);
+
+  auto unitNormal = [&](uint32_t triangle, Vec3 &p0, Vec3 &normal) {
+    p0 = positionOf(vertices[local[triangles[3 * triangle]]]);
+    Vec3 p1 = positionOf(vertices[local[triangles[3 * triangle + 1]]]);
+    Vec3 p2 = positionOf(vertices[local[triangles[3 * triangle + 2]]]);
+    normal = faceNormal(p0, p1, p2);
+    float normalLength = length(normal);
+    if (normalLength == 0.0f) return false;
+    for (float &component : normal) component /= normalLength;
+    return true;
+  };
+
+  Vec3 axis{0.0f, 0.0f, 0.0f};
+  Vec3 p0{};
+  Vec3 normal{};
+  for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+    if (!unitNormal(t, p0, normal)) continue;
+    for (int k = 0; k < 3; k++) axis[k] += normal[k];
+  }
+  float axisLength = length(axis);
+  if (axisLength == 0.0f) return;
+  for (float &component : axis) component /= axisLength;
+  std::copy(axis.begin(), axis.end(), meshlet.coneAxis);
+
+  float minimumDot = 1.0f;
+  for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+    if (unitNormal(t, p0, normal)) minimumDot = std::min(minimumDot, dot(normal, axis));
+  }
+  // normals spread over more than a hemisphere: some triangle always faces the camera
+  if (minimumDot <= 0.0f) return;
+
+  // move the apex back along the axis until it is behind every triangle's plane
+  float maxT = 0.0f;
+  for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+    if (!unitNormal(t, p0, normal)) continue;
+    maxT = std::max(maxT, dot(subtract(center, p0), normal) / dot(axis, normal));
+  }
+  for (int k = 0; k < 3; k++) meshlet.coneApex[k] = center[k] - axis[k] * maxT;
+  meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+}
+
+}  // namespace
+
+LveVertexCacheStats LveMeshOptimizer::analyzeVertexCache(
+    const uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize) {
+  LveVertexCacheStats stats{};
+  if (indexCount < 3) return stats;
+
+  FifoCache cache{vertexCount, cacheSize};
+  std::vector<char> referenced(vertexCount, 0);
+  uint32_t misses = 0;
+  uint32_t uniqueVertices = 0;
+  for (size_t i = 0; i < indexCount; i++) {
+    if (cache.access(indices[i])) misses++;
+    if (!referenced[indices[i]]) {
+      referenced[indices[i]] = 1;
+      uniqueVertices++;
+    }
+  }
+  stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+  stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+  return stats;
+}
+
+void LveMeshOptimizer::optimizeVertexCache(
+    uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize) {
+  std::vector<uint32_t> ordered;
+  tipsify(indices, indexCount, vertexCount, cacheSize, ordered, nullptr);
+  std::copy(ordered.begin(), ordered.end(), indices);
+}
+
+void LveMeshOptimizer::optimizeOverdraw(
+    uint32_t *indices,
+    size_t indexCount,
+    const LveVertex *vertices,
+    uint32_t vertexCount,
+    float threshold,
+    uint32_t cacheSize) {
+  uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+  if (triangleCount == 0) return;
+
+  std::vector<uint32_t> ordered;
+  std::vector<uint32_t> hardStarts;
+  tipsify(indices, indexCount, vertexCount, cacheSize, ordered, &hardStarts);
+  hardStarts.push_back(triangleCount);
+
+  // Within each dead-end cluster, split again wherever the ACMR since the last split has come
+  // down to the cluster's own ACMR times threshold: each piece then reuses the cache about as
+  // well as the cluster did, wherever it ends up in the new order.
+  FifoCache cache{vertexCount, cacheSize};
+  std::vector<uint32_t> clusterStarts;
+  for (size_t c = 0; c + 1 < hardStarts.size(); c++) {
+    uint32_t begin = hardStarts[c];
+    uint32_t end = hardStarts[c + 1];
+    cache.reset();
+    uint32_t clusterMisses = 0;
+    for (size_t i = 3 * size_t{begin}; i < 3 * size_t{end}; i++) {
+      if (cache.access(ordered[i])) clusterMisses++;
+    }
+    float targetAcmr = threshold * clusterMisses / static_cast<float>(end - begin);
+
+    cache.reset();
+    clusterStarts.push_back(begin);
+    uint32_t start = begin;
+    uint32_t misses = 0;
+    for (uint32_t t = begin; t + 1 < end; t++) {
+      for (int k = 0; k < 3; k++) {
+        if (cache.access(ordered[3 * size_t{t} + k])) misses++;
+      }
+      if (static_cast<float>(misses) / static_cast<float>(t + 1 - start) <= targetAcmr) {
+        clusterStarts.push_back(t + 1);
+        start = t + 1;
+        misses = 0;
+        cache.reset();
+      }
+    }
+  }
+  clusterStarts.push_back(triangleCount);
+  size_t clusterCount = clusterStarts.size() - 1;
+
+  // Draw clusters that face away from the middle of the mesh first: on a closed mesh they are
+  // the ones in front, so the clusters behind them fail the depth test.
+  std::vector<Vec3> centroids(clusterCount, Vec3{0.0f, 0.0f, 0.0f});
+  std::vector<Vec3> normals(clusterCount, Vec3{0.0f, 0.0f, 0.0f});
+  std::vector<float> areas(clusterCount, 0.0f);
+  Vec3 meshCentroid{0.0f, 0.0f, 0.0f};
+  float meshArea = 0.0f;
+  for (size_t c = 0; c < clusterCount; c++) {
+    for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+      Vec3 p0 = positionOf(vertices[ordered[3 * size_t{t}]]);
+      Vec3 p1 = positionOf(vertices[ordered[3 * size_t{t} + 1]]);
+      Vec3 p2 = positionOf(vertices[ordered[3 * size_t{t} + 2]]);
+      Vec3 normal = faceNormal(p0, p1, p2);
+      float area = 0.5f * length(normal);
+      for (int k = 0; k < 3; k++) {
+        float centroid = (p0[k] + p1[k] + p2[k]) / 3.0f;
+        centroids[c][k] += centroid * area;
+        meshCentroid[k] += centroid * area;
+        normals[c][k] += normal[k];
+      }
+      areas[c] += area;
+      meshArea += area;
+    }
+  }
+
+  std::vector<float> sortKeys(clusterCount, 0.0f);
+  if (meshArea > 0.0f) {
+    for (float &component : meshCentroid) component /= meshArea;
+    for (size_t c = 0; c < clusterCount; c++) {
+      float normalLength = length(normals[c]);
+      if (areas[c] == 0.0f || normalLength == 0.0f) continue;
+      Vec3 centroid{};
+      for (int k = 0; k < 3; k++) centroid[k] = centroids[c][k] / areas[c];
+      sortKeys[c] = dot(subtract(centroid, meshCentroid), normals[c]) / normalLength;
+    }
+  }
+  std::vector<size_t> order(clusterCount);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) {
+    return sortKeys[a] > sortKeys[b];
+  });
+
+  size_t write = 0;
+  for (size_t c : order) {
+    for (size_t i = 3 * size_t{clusterStarts[c]}; i < 3 * size_t{clusterStarts[c + 1]}; i++) {
+      indices[write++] = ordered[i];
+    }
+  }
+}
+
+uint32_t LveMeshOptimizer::optimizeVertexFetch(LveMeshData &mesh) {
+  constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+  std::vector<LveVertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+  for (uint32_t &index : mesh.indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = static_cast<uint32_t>(vertices.size());
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+  mesh.vertices = std::move(vertices);
+  return static_cast<uint32_t>(mesh.vertices.size());
+}
+
+size_t LveMeshOptimizer::simplify(
+    uint32_t *destination,
+    const uint32_t *indices,
+    size_t indexCount,
+    const LveVertex *vertices,
+    uint32_t vertexCount,
+    size_t targetIndexCount,
+    float maxError,
+    float *resultError) {
+  std::vector<uint32_t> result(indices, indices + indexCount);
+
+  std::vector<Quadric> quadrics(vertexCount);
+  for (size_t i = 0; i < indexCount; i += 3) {
+    Vec3 p0 = positionOf(vertices[indices[i]]);
+    Vec3 normal = faceNormal(
+        p0, positionOf(vertices[indices[i + 1]]), positionOf(vertices[indices[i + 2]]));
+    float normalLength = length(normal);
+    if (normalLength == 0.0f) continue;
+    for (float &component : normal) component /= normalLength;
+    double d = -dot(normal, p0);
+    for (size_t k = 0; k < 3; k++) {
+      quadrics[indices[i + k]].addPlane(normal[0], normal[1], normal[2], d, 0.5 * normalLength);
+    }
+  }
+
+  // an edge not shared by exactly two triangles is on a border or non-manifold; its vertices
+  // stay where they are
+  std::vector<char> locked(vertexCount, 0);
+  std::vector<uint64_t> edges;
+  auto collectEdges = [&edges, &result]() {
+    edges.clear();
+    edges.reserve(result.size());
+    for (size_t i = 0; i < result.size(); i += 3) {
+      for (size_t k = 0; k < 3; k++) {
+        uint64_t a = result[i + k];
+        uint64_t b = result[i + (k + 1) % 3];
+        edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+  };
+  collectEdges();
+  for (size_t i = 0; i < edges.size();) {
+    size_t run = i;
+    while (run < edges.size() && edges[run] == edges[i]) run++;
+    if (run - i != 2) {
+      locked[edges[i] >> 32] = 1;
+      locked[edges[i] & 0xffffffff] = 1;
+    }
+    i = run;
+  }
+
+  struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double cost;
+  };
+  std::vector<Collapse> collapses;
+  std::vector<uint32_t> remap(vertexCount);
+  std::iota(remap.begin(), remap.end(), 0u);
+  std::vector<char> touched(vertexCount, 0);
+  double maxErrorSquared = static_cast<double>(maxError) * maxError;
+  double reachedErrorSquared = 0.0;
+
+  while (result.size() > targetIndexCount) {
+    VertexAdjacency adjacency{result.data(), result.size(), vertexCount};
+    collectEdges();
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    collapses.clear();
+    for (uint64_t edge : edges) {
+      uint32_t a = static_cast<uint32_t>(edge >> 32);
+      uint32_t b = static_cast<uint32_t>(edge & 0xffffffff);
+      Quadric combined = quadrics[a];
+      combined += quadrics[b];
+      double costAB = locked[a] ? std::numeric_limits<double>::max()
+                                : combined.evaluate(positionOf(vertices[b]));
+      double costBA = locked[b] ? std::numeric_limits<double>::max()
+                                : combined.evaluate(positionOf(vertices[a]));
+      Collapse collapse = costAB <= costBA ? Collapse{a, b, costAB} : Collapse{b, a, costBA};
+      if (collapse.cost <= maxErrorSquared) collapses.push_back(collapse);
+    }
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) {
+      return x.cost < y.cost;
+    });
+
+    // a collapse must not turn any surviving triangle around its moving vertex inside out
+    auto flips = [&](uint32_t from, uint32_t to) {
+      Vec3 target = positionOf(vertices[to]);
+      for (uint32_t i = adjacency.offsets[from]; i < adjacency.offsets[from + 1]; i++) {
+        size_t base = 3 * size_t{adjacency.triangles[i]};
+        uint32_t corners[3] = {
+            remap[result[base]], remap[result[base + 1]], remap[result[base + 2]]};
+        if (corners[0] == to || corners[1] == to || corners[2] == to) continue;
+        Vec3 before[3];
+        Vec3 after[3];
+        for (int k = 0; k < 3; k++) {
+          before[k] = positionOf(vertices[corners[k]]);
+          after[k] = corners[k] == from ? target : before[k];
+        }
+        Vec3 normalBefore = faceNormal(before[0], before[1], before[2]);
+        Vec3 normalAfter = faceNormal(after[0], after[1], after[2]);
+        if (dot(normalBefore, normalAfter) <= 0.0f) return true;
+      }
+      return false;
+    };
+
+    // collapses in one pass never share a vertex, so each sees an up-to-date neighbourhood
+    std::fill(touched.begin(), touched.end(), 0);
+    size_t trianglesLeft = result.size() / 3;
+    size_t targetTriangles = targetIndexCount / 3;
+    size_t collapsed = 0;
+    for (const Collapse &collapse : collapses) {
+      if (trianglesLeft <= targetTriangles) break;
+      if (touched[collapse.from] || touched[collapse.to]) continue;
+      if (flips(collapse.from, collapse.to)) continue;
+
+      for (uint32_t i = adjacency.offsets[collapse.from];
+           i < adjacency.offsets[collapse.from + 1];
+           i++) {
+        size_t base = 3 * size_t{adjacency.triangles[i]};
+        for (size_t k = 0; k < 3; k++) {
+          if (remap[result[base + k]] == collapse.to) trianglesLeft--;
+        }
+      }
+      remap[collapse.from] = collapse.to;
+      quadrics[collapse.to] += quadrics[collapse.from];
+      touched[collapse.from] = 1;
+      touched[collapse.to] = 1;
+      reachedErrorSquared = std::max(reachedErrorSquared, collapse.cost);
+      collapsed++;
+    }
+    if (collapsed == 0) break;
+
+    size_t write = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      uint32_t a = remap[result[i]];
+      uint32_t b = remap[result[i + 1]];
+      uint32_t c = remap[result[i + 2]];
+      if (a == b || b == c || a == c) continue;
+      result[write++] = a;
+      result[write++] = b;
+      result[write++] = c;
+    }
+    result.resize(write);
+  }
+
+  std::copy(result.begin(), result.end(), destination);
+  if (resultError != nullptr) *resultError = static_cast<float>(std::sqrt(reachedErrorSquared));
+  return result.size();
+}
+
+LveMeshlets LveMeshOptimizer::buildMeshlets(
+    const uint32_t *indices,
+    size_t indexCount,
+    const LveVertex *vertices,
+    uint32_t vertexCount,
+    uint32_t maxVertices,
+    uint32_t maxTriangles) {
+  // local indices are bytes, and 0xff marks a vertex that is not in the current meshlet
+  if (maxVertices < 3 || maxVertices > 255 || maxTriangles == 0) {
+    throw std::runtime_error("meshlet limits out of range!");
+  }
+  constexpr uint8_t NOT_IN_MESHLET = 0xff;
+
+  LveMeshlets result{};
+  std::vector<uint8_t> slot(vertexCount, NOT_IN_MESHLET);
+  LveMeshlet current{};
+  auto finish = [&]() {
+    if (current.triangleCount == 0) return;
+    for (uint32_t i = 0; i < current.vertexCount; i++) {
+      slot[result.vertices[current.vertexOffset + i]] = NOT_IN_MESHLET;
+    }
+    computeMeshletBounds(current, result, vertices);
+    result.meshlets.push_back(current);
+    current = LveMeshlet{};
+    current.vertexOffset = static_cast<uint32_t>(result.vertices.size());
+    current.triangleOffset = static_cast<uint32_t>(result.triangles.size());
+  };
+
+  // triangles are taken in index order, so a cache-optimized mesh gives compact meshlets
+  for (size_t i = 0; i + 2 < indexCount; i += 3) {
+    uint32_t corners[3] = {indices[i], indices[i + 1], indices[i + 2]};
+    if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2]) {
+      continue;
+    }
+    uint32_t newVertices = 0;
+    for (uint32_t corner : corners) {
+      if (slot[corner] == NOT_IN_MESHLET) newVertices++;
+    }
+    if (current.vertexCount + newVertices > maxVertices || current.triangleCount == maxTriangles) {
+      finish();
+    }
+    for (uint32_t corner : corners) {
+      if (slot[corner] == NOT_IN_MESHLET) {
+        slot[corner] = static_cast<uint8_t>(current.vertexCount++);
+        result.vertices.push_back(corner);
+      }
+      result.triangles.push_back(slot[corner]);
+    }
+    current.triangleCount++;
+  }
+  finish();
+  return result;
+}
+
+LveMeshOptimizeReport LveMeshOptimizer::optimize(
+    LveMeshData &mesh, const LveMeshOptimizeOptions &options) {
+  if (!mesh.lods.empty()) {
+    throw std::runtime_error("mesh already has levels of detail!");
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  if (mesh.submeshes.empty()) {
+    mesh.submeshes.push_back({0, static_cast<uint32_t>(mesh.indices.size()), 0, 0});
+  }
+
+  LveMeshOptimizeReport report{};
+  uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+  report.verticesBefore = vertexCount;
+  auto analyze = [&mesh, &options](uint32_t vertexCount) {
+    return analyzeVertexCache(
+        mesh.indices.data(), mesh.indices.size(), vertexCount, options.cacheSize);
+  };
+  report.before = analyze(vertexCount);
+
+  for (const LveSubmesh &submesh : mesh.submeshes) {
+    optimizeVertexCache(
+        mesh.indices.data() + submesh.firstIndex,
+        submesh.indexCount,
+        vertexCount,
+        options.cacheSize);
+  }
+  report.afterVertexCache = analyze(vertexCount);
+
+  for (const LveSubmesh &submesh : mesh.submeshes) {
+    optimizeOverdraw(
+        mesh.indices.data() + submesh.firstIndex,
+        submesh.indexCount,
+        mesh.vertices.data(),
+        vertexCount,
+        options.overdrawThreshold,
+        options.cacheSize);
+  }
+  report.afterOverdraw = analyze(vertexCount);
+
+  // every level is simplified from the full-detail one, so errors do not compound
+  std::vector<uint32_t> simplified;
+  for (uint32_t s = 0; s < mesh.submeshes.size(); s++) {
+    LveSubmesh submesh = mesh.submeshes[s];
+    size_t previousCount = submesh.indexCount;
+    for (uint32_t level = 0; level < options.maxLodLevels; level++) {
+      size_t targetCount = static_cast<size_t>(previousCount * options.lodReduction) / 3 * 3;
+      if (targetCount < 3) break;
+      simplified.resize(submesh.indexCount);
+      float error = 0.0f;
+      size_t count = simplify(
+          simplified.data(),
+          mesh.indices.data() + submesh.firstIndex,
+          submesh.indexCount,
+          mesh.vertices.data(),
+          vertexCount,
+          targetCount,
+          std::numeric_limits<float>::max(),
+          &error);
+      // stop once simplification stalls, e.g. on a mesh that is mostly locked border vertices
+      if (count == 0 || count >= previousCount - (previousCount - targetCount) / 2) break;
+
+      optimizeVertexCache(simplified.data(), count, vertexCount, options.cacheSize);
+      LveMeshLod lod{};
+      lod.submesh = s;
+      lod.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+      lod.indexCount = static_cast<uint32_t>(count);
+      lod.error = error;
+      mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.begin() + count);
+      mesh.lods.push_back(lod);
+      previousCount = count;
+    }
+  }
+  report.lods = mesh.lods;
+
+  report.verticesAfter = optimizeVertexFetch(mesh);
+
+  uint64_t meshletVertices = 0;
+  uint64_t meshletTriangles = 0;
+  uint32_t cullable = 0;
+  for (const LveSubmesh &submesh : mesh.submeshes) {
+    LveMeshlets meshlets = buildMeshlets(
+        mesh.indices.data() + submesh.firstIndex,
+        submesh.indexCount,
+        mesh.vertices.data(),
+        report.verticesAfter,
+        options.maxMeshletVertices,
+        options.maxMeshletTriangles);
+    for (const LveMeshlet &meshlet : meshlets.meshlets) {
+      meshletVertices += meshlet.vertexCount;
+      meshletTriangles += meshlet.triangleCount;
+      if (meshlet.coneCutoff < 1.0f) cullable++;
+    }
+    report.meshletCount += static_cast<uint32_t>(meshlets.meshlets.size());
+  }
+  if (report.meshletCount > 0) {
+    report.meshletAverageVertices = static_cast<float>(meshletVertices) / report.meshletCount;
+    report.meshletAverageTriangles = static_cast<float>(meshletTriangles) / report.meshletCount;
+    report.meshletBackfaceCullable = static_cast<float>(cullable) / report.meshletCount;
+  }
+
+  report.milliseconds = std::chrono::duration<double, std::milli>(
+                            std::chrono::high_resolution_clock::now() - start)
+                            .count();
+  return report;
+}
+
+void LveMeshOptimizeReport::print(std::ostream &out) const {
+  out << "mesh optimizer: " << milliseconds << " ms" << std::endl;
+  out << "\tACMR " << before.acmr << " -> " << afterVertexCache.acmr << " (vertex cache) -> "
+      << afterOverdraw.acmr << " (overdraw)" << std::endl;
+  out << "\tATVR " << before.atvr << " -> " << afterVertexCache.atvr << " (vertex cache) -> "
+      << afterOverdraw.atvr << " (overdraw)" << std::endl;
+  out << "\tvertices " << verticesBefore << " -> " << verticesAfter << " (vertex fetch)"
+      << std::endl;
+  for (const LveMeshLod &lod : lods) {
+    out << "\tsubmesh " << lod.submesh << " lod: " << lod.indexCount / 3 << " triangles, error "
+        << lod.error << std::endl;
+  }
+  out << "\t" << meshletCount << " meshlets, " << meshletAverageVertices << " vertices and "
+      << meshletAverageTriangles << " triangles on average, "
+      << meshletBackfaceCullable * 100.0f << "% with a usable normal cone" << std::endl;
+}
+
+LveLodSelector::LveLodSelector(float verticalFov, uint32_t viewportHeight, float maxPixelError)
+    : projectionScale{static_cast<float>(viewportHeight) / (2.0f * std::tan(0.5f * verticalFov))},
+      maxPixelError{maxPixelError} {}
+
+uint32_t LveLodSelector::selectLevel(
+    const LveMeshLodChain &chain, const std::array<float, 3> &translation, float scale) const {
+  // the nearest point of the bounding sphere, wherever the rotation puts it, so the projected
+  // error is never underestimated
+  const float *sphere = chain.levels[0].boundingSphere;
+  Vec3 sphereCenter{sphere[0], sphere[1], sphere[2]};
+  float reach = scale * (length(sphereCenter) + sphere[3]);
+  float distance = length(subtract(translation, cameraPosition)) - reach;
+  if (distance <= 0.0f) return 0;
+
+  for (uint32_t level = static_cast<uint32_t>(chain.levels.size()); level-- > 1;) {
+    if (chain.errors[level] * scale * projectionScale / distance <= maxPixelError) return level;
+  }
+  return 0;
+}
+
+}  // namespace lve
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "lve_mesh_file.hpp"
+#include "lve_mesh_pool.hpp"
+
+// std lib headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace lve {
+
+// Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache.
+struct LveVertexCacheStats {
+  float acmr = 0.0f;  // transformed vertices per triangle: 3 at worst, about 0.5 for a good grid
+  float atvr = 0.0f;  // transformed vertices per referenced vertex: 1 is perfect
+};
+
+// A cluster of at most maxVertices vertices and maxTriangles triangles, with bounds for culling
+// whole clusters. Triangles index the meshlet's own vertex list, which indexes the mesh.
+struct LveMeshlet {
+  uint32_t vertexOffset = 0;    // into LveMeshlets::vertices
+  uint32_t triangleOffset = 0;  // into LveMeshlets::triangles, three bytes per triangle
+  uint32_t vertexCount = 0;
+  uint32_t triangleCount = 0;
+  float center[3] = {0.0f, 0.0f, 0.0f};
+  float radius = 0.0f;
+  // every triangle faces away from a camera at c when
+  //   dot(normalize(coneApex - c), coneAxis) >= coneCutoff
+  // a cutoff of 1 means the normals are too spread out for the test to ever pass
+  float coneApex[3] = {0.0f, 0.0f, 0.0f};
+  float coneAxis[3] = {0.0f, 0.0f, 0.0f};
+  float coneCutoff = 1.0f;
+};
+
+struct LveMeshlets {
+  std::vector<LveMeshlet> meshlets;
+  std::vector<uint32_t> vertices;
+  std::vector<uint8_t> triangles;
+};
+
+struct LveMeshOptimizeOptions {
+  uint32_t cacheSize = 16;
+  // how much vertex cache efficiency the overdraw pass may give up, as a factor on ACMR
+  float overdrawThreshold = 1.05f;
+  uint32_t maxLodLevels = 4;  // reduced levels per submesh, on top of the full-detail one
+  float lodReduction = 0.5f;  // triangle count of each level relative to the previous one
+  uint32_t maxMeshletVertices = 64;
+  uint32_t maxMeshletTriangles = 124;
+};
+
+struct LveMeshOptimizeReport {
+  LveVertexCacheStats before;
+  LveVertexCacheStats afterVertexCache;
+  LveVertexCacheStats afterOverdraw;
+  uint32_t verticesBefore = 0;
+  uint32_t verticesAfter = 0;
+  std::vector<LveMeshLod> lods;
+  uint32_t meshletCount = 0;
+  float meshletAverageVertices = 0.0f;
+  float meshletAverageTriangles = 0.0f;
+  float meshletBackfaceCullable = 0.0f;  // share of meshlets with a usable normal cone
+  double milliseconds = 0.0;
+
+  void print(std::ostream &out) const;
+};
+
+// Offline and load-time mesh processing. Each step works on index ranges so submeshes are
+// processed independently; optimize() runs them all in order:
+//   1. vertex cache ordering (Tipsify: Sander, Nehab and Barczak 2007)
+//   2. overdraw ordering: the cache-ordered triangles are split into clusters, which are sorted
+//      so that outward-facing clusters draw first, while ACMR stays within the threshold
+//   3. a simplification-based LOD chain (quadric error edge collapse), each level cache-ordered
+//   4. vertex fetch ordering, which also drops vertices no index refers to
+//   5. meshlet clustering, reported but not stored, since nothing draws meshlets yet
+class LveMeshOptimizer {
+ public:
+  static LveMeshOptimizeReport optimize(
+      LveMeshData &mesh, const LveMeshOptimizeOptions &options = LveMeshOptimizeOptions{});
+
+  static LveVertexCacheStats analyzeVertexCache(
+      const uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+  // The steps below reorder indices in place.
+  static void optimizeVertexCache(
+      uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = 16);
+  static void optimizeOverdraw(
+      uint32_t *indices,
+      size_t indexCount,
+      const LveVertex *vertices,
+      uint32_t vertexCount,
+      float threshold = 1.05f,
+      uint32_t cacheSize = 16);
+  // Renumbers vertices in order of first use across every index of the mesh, removing unused
+  // ones. Returns the new vertex count.
+  static uint32_t optimizeVertexFetch(LveMeshData &mesh);
+
+  // Collapses edges until at most targetIndexCount indices are left or the next collapse would
+  // move the surface by more than maxError (mesh units). Border and non-manifold vertices never
+  // move, so open edges and attribute seams are preserved. Writes at most indexCount indices to
+  // destination, returns how many were written and the error reached in resultError.
+  static size_t simplify(
+      uint32_t *destination,
+      const uint32_t *indices,
+      size_t indexCount,
+      const LveVertex *vertices,
+      uint32_t vertexCount,
+      size_t targetIndexCount,
+      float maxError,
+      float *resultError = nullptr);
+
+  static LveMeshlets buildMeshlets(
+      const uint32_t *indices,
+      size_t indexCount,
+      const LveVertex *vertices,
+      uint32_t vertexCount,
+      uint32_t maxVertices = 64,
+      uint32_t maxTriangles = 124);
+};
+
+// Picks the coarsest level of a chain whose error, projected to the screen at the object's
+// distance, stays under a pixel budget. LveIndirectDrawSystem::addInstance takes one to draw each
+// instance at its own level.
+class LveLodSelector {
+ public:
+  // verticalFov in radians, viewportHeight in pixels.
+  LveLodSelector(float verticalFov, uint32_t viewportHeight, float maxPixelError = 1.0f);
+
+  void setCameraPosition(const std::array<float, 3> &position) { cameraPosition = position; }
+  void setMaxPixelError(float pixels) { maxPixelError = pixels; }
+
+  // translation and scale place the mesh in the world, as in LveIndirectDrawSystem::addInstance.
+  uint32_t selectLevel(
+      const LveMeshLodChain &chain, const std::array<float, 3> &translation, float scale) const;
+  const LveMeshHandle &select(
+      const LveMeshLodChain &chain, const std::array<float, 3> &translation, float scale) const {
+    return chain.levels[selectLevel(chain, translation, scale)];
+  }
+
+ private:
+  float projectionScale;  // pixels per world unit at distance 1
+  float maxPixelError;
+  std::array<float, 3> cameraPosition{0.0f, 0.0f, 0.0f};
+};
+
+}  // namespace lve
@@ -0,0 +1,160 @@
+#include "lve_mesh_pool.hpp"
+
+#include "lve_mesh_file.hpp"
+
+// std headers
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace lve {
+
+std::vector<VkVertexInputBindingDescription> LveVertex::getBindingDescriptions() {
+  std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+  bindingDescriptions[0].binding = 0;
+  bindingDescriptions[0].stride = sizeof(LveVertex);
+  bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> LveVertex::getAttributeDescriptions() {
+  std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+  attributeDescriptions[0].binding = 0;
+  attributeDescriptions[0].location = 0;
+  attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+  attributeDescriptions[0].offset = offsetof(LveVertex, position);
+  attributeDescriptions[1].binding = 0;
+  attributeDescriptions[1].location = 1;
+  attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+  attributeDescriptions[1].offset = offsetof(LveVertex, color);
+  return attributeDescriptions;
+}
+
+LveMeshPool::LveMeshPool(LveDevice &device, uint32_t maxVertices, uint32_t maxIndices)
+    : lveDevice{device}, maxVertices{maxVertices}, maxIndices{maxIndices} {
+  lveDevice.createBuffer(
+      sizeof(LveVertex) * maxVertices,
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      vertexBuffer,
+      vertexMemory,
+      LveMemoryCategory::Mesh);
+  lveDevice.createBuffer(
+      sizeof(uint32_t) * maxIndices,
+      VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      indexBuffer,
+      indexMemory,
+      LveMemoryCategory::Mesh);
+}
+
+LveMeshPool::~LveMeshPool() {
+  lveDevice.destroyBuffer(vertexBuffer, vertexMemory);
+  lveDevice.destroyBuffer(indexBuffer, indexMemory);
+}
+
+LveMeshHandle LveMeshPool::addMesh(
+    const std::vector<LveVertex> &vertices, const std::vector<uint32_t> &indices) {
+  return addMesh(
+      vertices.data(),
+      static_cast<uint32_t>(vertices.size()),
+      indices.data(),
+      static_cast<uint32_t>(indices.size()));
+}
+
+LveMeshHandle LveMeshPool::addMesh(
+    const LveVertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount) {
+  if (usedVertices + vertexCount > maxVertices || usedIndices + indexCount > maxIndices) {
+    throw std::runtime_error("mesh pool is full!");
+  }
+
+  LveMeshHandle mesh{};
+  mesh.firstIndex = usedIndices;
+  mesh.indexCount = indexCount;
+  mesh.vertexOffset = static_cast<int32_t>(usedVertices);
+  computeBoundingSphere(vertices, vertexCount, mesh.boundingSphere);
+
+  // indices stay relative to the mesh; vertexOffset rebases them at draw time
+  LveUploadManager &uploadManager = lveDevice.uploadManager();
+  uploadManager.uploadBuffer(
+      vertexBuffer,
+      sizeof(LveVertex) * usedVertices,
+      vertices,
+      sizeof(LveVertex) * vertexCount);
+  lastUploadTicket = uploadManager.uploadBuffer(
+      indexBuffer,
+      sizeof(uint32_t) * usedIndices,
+      indices,
+      sizeof(uint32_t) * indexCount);
+
+  usedVertices += vertexCount;
+  usedIndices += indexCount;
+  return mesh;
+}
+
+std::vector<LveMeshLodChain> LveMeshPool::addMeshFile(const LveMeshFile &file) {
+  LveMeshHandle whole =
+      addMesh(file.vertices(), file.vertexCount(), file.indices(), file.indexCount());
+  if (file.submeshCount() == 0) return {LveMeshLodChain{{whole}, {0.0f}}};
+
+  // reduced levels keep the bounding sphere of the whole mesh, which contains them all
+  auto rangeOf = [&whole](uint32_t firstIndex, uint32_t indexCount) {
+    LveMeshHandle handle = whole;
+    handle.firstIndex = whole.firstIndex + firstIndex;
+    handle.indexCount = indexCount;
+    return handle;
+  };
+  std::vector<LveMeshLodChain> chains(file.submeshCount());
+  for (uint32_t i = 0; i < file.submeshCount(); i++) {
+    const LveSubmesh &submesh = file.submeshes()[i];
+    chains[i].levels.push_back(rangeOf(submesh.firstIndex, submesh.indexCount));
+    chains[i].errors.push_back(0.0f);
+  }
+  for (uint32_t i = 0; i < file.lodCount(); i++) {
+    const LveMeshLod &lod = file.lods()[i];
+    chains[lod.submesh].levels.push_back(rangeOf(lod.firstIndex, lod.indexCount));
+    chains[lod.submesh].errors.push_back(lod.error);
+  }
+  return chains;
+}
+
+void LveMeshPool::computeBoundingSphere(
+    const LveVertex *vertices, uint32_t vertexCount, float sphere[4]) {
+  if (vertexCount == 0) return;
+
+  // centered on the bounding box; not minimal, but cheap and never smaller than the mesh
+  float minimum[3] = {vertices[0].position[0], vertices[0].position[1], vertices[0].position[2]};
+  float maximum[3] = {minimum[0], minimum[1], minimum[2]};
+  for (uint32_t i = 1; i < vertexCount; i++) {
+    for (int axis = 0; axis < 3; axis++) {
+      minimum[axis] = std::min(minimum[axis], vertices[i].position[axis]);
+      maximum[axis] = std::max(maximum[axis], vertices[i].position[axis]);
+    }
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    sphere[axis] = 0.5f * (minimum[axis] + maximum[axis]);
+  }
+
+  float radiusSquared = 0.0f;
+  for (uint32_t i = 0; i < vertexCount; i++) {
+    float distanceSquared = 0.0f;
+    for (int axis = 0; axis < 3; axis++) {
+      float d = vertices[i].position[axis] - sphere[axis];
+      distanceSquared += d * d;
+    }
+    radiusSquared = std::max(radiusSquared, distanceSquared);
+  }
+  sphere[3] = std::sqrt(radiusSquared);
+}
+
+void LveMeshPool::bind(VkCommandBuffer commandBuffer) {
+  VkBuffer buffers[] = {vertexBuffer};
+  VkDeviceSize offsets[] = {0};
+  vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+  vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+}  // namespace lve
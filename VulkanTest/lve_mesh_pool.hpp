@@ -0,0 +1,82 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_upload_manager.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+class LveMeshFile;
+
+struct LveVertex {
+  float position[3];
+  float color[3];
+
+  static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+  static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+};
+
+// Where a mesh lives inside the pool's shared buffers, in the terms vkCmdDrawIndexed expects.
+struct LveMeshHandle {
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+  int32_t vertexOffset = 0;
+  // mesh-space center (xyz) and radius (w), used to cull instances of the mesh
+  float boundingSphere[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// Levels of detail of one mesh, finest first; errors[i] is the geometric error of levels[i] in
+// mesh units (0 for the full-detail level). LveLodSelector picks between them.
+struct LveMeshLodChain {
+  std::vector<LveMeshHandle> levels;
+  std::vector<float> errors;
+};
+
+// One device-local vertex buffer and one index buffer shared by every mesh, so that any number
+// of meshes can be drawn with a single vertex/index buffer binding. Capacity is fixed up front;
+// meshes are appended and live as long as the pool.
+class LveMeshPool {
+ public:
+  LveMeshPool(LveDevice &device, uint32_t maxVertices, uint32_t maxIndices);
+  ~LveMeshPool();
+
+  LveMeshPool(const LveMeshPool &) = delete;
+  LveMeshPool &operator=(const LveMeshPool &) = delete;
+
+  // Copies the mesh in through the upload manager; wait on lastUpload before drawing it.
+  LveMeshHandle addMesh(const std::vector<LveVertex> &vertices, const std::vector<uint32_t> &indices);
+  LveMeshHandle addMesh(
+      const LveVertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount);
+  // Uploads the whole file straight from its mapping and returns the level-of-detail chain of
+  // each submesh (or of the whole mesh when it has none). All handles share the file's vertices.
+  std::vector<LveMeshLodChain> addMeshFile(const LveMeshFile &file);
+  LveUploadTicket lastUpload() const { return lastUploadTicket; }
+
+  void bind(VkCommandBuffer commandBuffer);
+
+  VkBuffer getVertexBuffer() const { return vertexBuffer; }
+  VkBuffer getIndexBuffer() const { return indexBuffer; }
+  uint32_t vertexCount() const { return usedVertices; }
+  uint32_t indexCount() const { return usedIndices; }
+
+ private:
+  static void computeBoundingSphere(
+      const LveVertex *vertices, uint32_t vertexCount, float sphere[4]);
+
+  LveDevice &lveDevice;
+  uint32_t maxVertices;
+  uint32_t maxIndices;
+  uint32_t usedVertices = 0;
+  uint32_t usedIndices = 0;
+  LveUploadTicket lastUploadTicket = 0;
+
+  VkBuffer vertexBuffer;
+  LveAllocation *vertexMemory;
+  VkBuffer indexBuffer;
+  LveAllocation *indexMemory;
+};
+
+}  // namespace lve
@@ -0,0 +1,135 @@
+#include "lve_obj_loader.hpp"
+
+// std headers
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace lve {
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char *skipSpaces(const char *cursor, const char *end) {
+  while (cursor < end && isSpace(*cursor)) cursor++;
+  return cursor;
+}
+
+const char *skipToken(const char *cursor, const char *end) {
+  while (cursor < end && !isSpace(*cursor)) cursor++;
+  return cursor;
+}
+
+// Parses up to count floats; returns how many were found.
+int parseFloats(const char *cursor, const char *end, float *values, int count) {
+  int parsed = 0;
+  while (parsed < count) {
+    cursor = skipSpaces(cursor, end);
+    if (cursor >= end) break;
+    char *next = nullptr;
+    values[parsed] = std::strtof(cursor, &next);
+    if (next == cursor) break;
+    cursor = next;
+    parsed++;
+  }
+  return parsed;
+}
+
+}  // namespace
+
+LveMeshData LveObjLoader::load(const std::string &path) {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to open file: " + path);
+  }
+  // the whole file is read at once; line-by-line stream reads dominate the parse otherwise
+  std::string text(static_cast<size_t>(file.tellg()), '\0');
+  file.seekg(0);
+  file.read(&text[0], static_cast<std::streamsize>(text.size()));
+  file.close();
+
+  LveMeshData mesh{};
+  std::unordered_map<std::string, uint32_t> materialIds;
+  LveSubmesh current{};
+  std::vector<uint32_t> polygon;
+
+  auto finishSubmesh = [&]() {
+    current.indexCount = static_cast<uint32_t>(mesh.indices.size()) - current.firstIndex;
+    if (current.indexCount > 0) mesh.submeshes.push_back(current);
+    current.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+  };
+
+  const char *cursor = text.data();
+  const char *end = text.data() + text.size();
+  size_t lineNumber = 0;
+  while (cursor < end) {
+    const char *lineEnd = cursor;
+    while (lineEnd < end && *lineEnd != '\n') lineEnd++;
+    lineNumber++;
+
+    const char *keyword = skipSpaces(cursor, lineEnd);
+    const char *keywordEnd = skipToken(keyword, lineEnd);
+    std::string_view name{keyword, static_cast<size_t>(keywordEnd - keyword)};
+
+    if (name == "v") {
+      float values[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+      int parsed = parseFloats(keywordEnd, lineEnd, values, 6);
+      if (parsed < 3) {
+        throw std::runtime_error(
+            path + ":" + std::to_string(lineNumber) + ": vertex needs three coordinates!");
+      }
+      LveVertex vertex{};
+      for (int i = 0; i < 3; i++) {
+        vertex.position[i] = values[i];
+        vertex.color[i] = parsed >= 6 ? values[3 + i] : 1.0f;
+      }
+      mesh.vertices.push_back(vertex);
+    } else if (name == "f") {
+      polygon.clear();
+      const char *corner = skipSpaces(keywordEnd, lineEnd);
+      while (corner < lineEnd) {
+        // only the position index of "v/vt/vn" is used
+        char *next = nullptr;
+        long index = std::strtol(corner, &next, 10);
+        if (next == corner || index == 0) {
+          throw std::runtime_error(
+              path + ":" + std::to_string(lineNumber) + ": malformed face!");
+        }
+        long vertexCount = static_cast<long>(mesh.vertices.size());
+        long resolved = index > 0 ? index - 1 : vertexCount + index;
+        if (resolved < 0 || resolved >= vertexCount) {
+          throw std::runtime_error(
+              path + ":" + std::to_string(lineNumber) + ": face index out of range!");
+        }
+        polygon.push_back(static_cast<uint32_t>(resolved));
+        corner = skipSpaces(skipToken(next, lineEnd), lineEnd);
+      }
+      for (size_t i = 2; i < polygon.size(); i++) {
+        mesh.indices.push_back(polygon[0]);
+        mesh.indices.push_back(polygon[i - 1]);
+        mesh.indices.push_back(polygon[i]);
+      }
+    } else if (name == "usemtl") {
+      finishSubmesh();
+      const char *material = skipSpaces(keywordEnd, lineEnd);
+      std::string materialName{material, static_cast<size_t>(lineEnd - material)};
+      while (!materialName.empty() && isSpace(materialName.back())) materialName.pop_back();
+      auto inserted = materialIds.emplace(
+          materialName, static_cast<uint32_t>(materialIds.size()));
+      current.materialId = inserted.first->second;
+    } else if (name == "o" || name == "g") {
+      finishSubmesh();
+    }
+    // everything else (vt, vn, s, mtllib, comments) has no place in LveVertex
+
+    cursor = lineEnd + 1;
+  }
+  finishSubmesh();
+
+  return mesh;
+}
+
+}  // namespace lve
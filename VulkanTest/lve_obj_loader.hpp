@@ -0,0 +1,20 @@
+#pragma once
+
+#include "lve_mesh_file.hpp"
+
+// std lib headers
+#include <string>
+
+namespace lve {
+
+// Minimal Wavefront OBJ reader, used by the mesh converter and as the text-format baseline in
+// the load benchmarks. Reads positions with optional per-vertex colors ("v x y z [r g b]") and
+// faces, which are fan-triangulated. Texture coordinates and normals in face corners are skipped
+// since LveVertex has no room for them, so each position becomes exactly one vertex. A new
+// submesh starts at every "o", "g" and "usemtl"; materials are numbered in order of first use.
+class LveObjLoader {
+ public:
+  static LveMeshData load(const std::string &path);
+};
+
+}  // namespace lve
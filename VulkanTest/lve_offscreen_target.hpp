@@ -0,0 +1,74 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <vector>
+
+namespace lve {
+
+// Stand-in for LveSwapChain when there is no surface: one color and depth image per frame slot,
+// rendered with a render pass compatible with the swap chain's so the same pipelines work in
+// both. Frames are never presented; the color image is left in TRANSFER_SRC_OPTIMAL for readback.
+class LveOffscreenTarget {
+ public:
+  static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_B8G8R8A8_SRGB;
+
+  LveOffscreenTarget(
+      LveDevice &deviceRef,
+      VkExtent2D extent,
+      uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+  ~LveOffscreenTarget();
+
+  LveOffscreenTarget(const LveOffscreenTarget &) = delete;
+  LveOffscreenTarget &operator=(const LveOffscreenTarget &) = delete;
+
+  VkFramebuffer getFrameBuffer(int index) { return framebuffers[index]; }
+  VkRenderPass getRenderPass() { return renderPass; }
+  VkImage getColorImage(int index) { return colorImages[index]; }
+  // stored and sampleable, as in LveSwapChain
+  VkImage getDepthImage(int index) { return depthImages[index]; }
+  VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
+  size_t imageCount() { return colorImages.size(); }
+  VkExtent2D getExtent() { return extent; }
+  float extentAspectRatio() {
+    return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+  }
+  VkFormat findDepthFormat();
+
+  // Same contract as LveSwapChain: blocks until the next slot's previous frame has retired and
+  // returns that slot as the image index.
+  VkResult acquireNextImage(uint32_t *imageIndex);
+  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  double lastCpuWaitMilliseconds() const { return cpuWaitMilliseconds; }
+  VkFence getInFlightFence(size_t frameIndex) { return inFlightFences[frameIndex]; }
+
+ private:
+  void createImages();
+  void createRenderPass();
+  void createFramebuffers();
+  void createSyncObjects();
+
+  LveDevice &device;
+  VkExtent2D extent;
+  uint32_t maxFramesInFlight;
+
+  VkRenderPass renderPass;
+  std::vector<VkImage> colorImages;
+  std::vector<LveAllocation *> colorImageMemorys;
+  std::vector<VkImageView> colorImageViews;
+  std::vector<VkImage> depthImages;
+  std::vector<LveAllocation *> depthImageMemorys;
+  std::vector<VkImageView> depthImageViews;
+  std::vector<VkFramebuffer> framebuffers;
+
+  std::vector<VkFence> inFlightFences;
+  size_t currentFrame = 0;
+  double cpuWaitMilliseconds = 0.0;
+};
+
+}  // namespace lve
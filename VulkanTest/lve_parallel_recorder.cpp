@@ -0,0 +1,108 @@
+#include "lve_parallel_recorder.hpp"
+
+// std headers
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve {
+
+LveParallelRecorder::LveParallelRecorder(
+    LveDevice &device, LveThreadPool &threadPool, uint32_t framesInFlight)
+    : lveDevice{device}, threadPool{threadPool} {
+  QueueFamilyIndices queueFamilyIndices = lveDevice.findPhysicalQueueFamilies();
+
+  // no RESET_COMMAND_BUFFER_BIT: buffers are only ever reset with their pool
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+  commandPools.resize(framesInFlight);
+  for (auto &framePools : commandPools) {
+    framePools.resize(threadPool.threadCount() + 1);
+    for (auto &threadCommandPool : framePools) {
+      if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &threadCommandPool.pool) !=
+          VK_SUCCESS) {
+        throw std::runtime_error("failed to create recording command pool!");
+      }
+    }
+  }
+}
+
+LveParallelRecorder::~LveParallelRecorder() {
+  // destroying a pool frees its command buffers
+  for (auto &framePools : commandPools) {
+    for (auto &threadCommandPool : framePools) {
+      vkDestroyCommandPool(lveDevice.device(), threadCommandPool.pool, nullptr);
+    }
+  }
+}
+
+void LveParallelRecorder::beginFrame(uint32_t frameIndex) {
+  currentFrame = frameIndex;
+  for (auto &threadCommandPool : commandPools[currentFrame]) {
+    if (threadCommandPool.used == 0) continue;
+    vkResetCommandPool(lveDevice.device(), threadCommandPool.pool, 0);
+    threadCommandPool.used = 0;
+  }
+}
+
+VkCommandBuffer LveParallelRecorder::nextSecondary(ThreadCommandPool &threadCommandPool) {
+  if (threadCommandPool.used == threadCommandPool.buffers.size()) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandPool = threadCommandPool.pool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate secondary command buffer!");
+    }
+    threadCommandPool.buffers.push_back(commandBuffer);
+  }
+  return threadCommandPool.buffers[threadCommandPool.used++];
+}
+
+void LveParallelRecorder::record(
+    VkCommandBuffer primary,
+    VkRenderPass renderPass,
+    VkFramebuffer framebuffer,
+    uint32_t itemCount,
+    uint32_t chunkSize,
+    const RecordFunction &recordChunk) {
+  if (itemCount == 0) return;
+  chunkSize = std::max(1u, chunkSize);
+  uint32_t chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+  secondaries.assign(chunkCount, VK_NULL_HANDLE);
+
+  VkCommandBufferInheritanceInfo inheritanceInfo{};
+  inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritanceInfo.renderPass = renderPass;
+  inheritanceInfo.subpass = 0;
+  inheritanceInfo.framebuffer = framebuffer;
+
+  threadPool.parallelFor(chunkCount, [&](uint32_t chunk) {
+    ThreadCommandPool &threadCommandPool = commandPools[currentFrame][threadPool.workerIndex()];
+    VkCommandBuffer commandBuffer = nextSecondary(threadCommandPool);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                      VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+      throw std::runtime_error("failed to begin secondary command buffer!");
+    }
+    uint32_t first = chunk * chunkSize;
+    recordChunk(commandBuffer, first, std::min(chunkSize, itemCount - first));
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to record secondary command buffer!");
+    }
+    // each chunk writes only its own slot
+    secondaries[chunk] = commandBuffer;
+  });
+
+  vkCmdExecuteCommands(primary, chunkCount, secondaries.data());
+}
+
+}  // namespace lve
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_thread_pool.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace lve {
+
+// Records a render pass's draws on every thread of an LveThreadPool. Each thread has its own
+// command pool per frame in flight, since a VkCommandPool must only be used from one thread at a
+// time; the pools of a frame are reset as a whole when the frame comes around again, and their
+// secondary command buffers are reused rather than freed.
+class LveParallelRecorder {
+ public:
+  // Called on a pool thread with a secondary command buffer that continues the render pass, to
+  // record items [first, first + count). The buffer inherits no state: bind pipelines, vertex
+  // buffers and descriptor sets and set the viewport and scissor
+  // (LvePipeline::setViewportAndScissor) in every chunk.
+  using RecordFunction =
+      std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)>;
+
+  LveParallelRecorder(LveDevice &device, LveThreadPool &threadPool, uint32_t framesInFlight);
+  ~LveParallelRecorder();
+
+  LveParallelRecorder(const LveParallelRecorder &) = delete;
+  LveParallelRecorder &operator=(const LveParallelRecorder &) = delete;
+
+  // Resets the command pools of frameIndex. Call after LveRenderer::beginFrame, which has waited
+  // for the frame that last used them.
+  void beginFrame(uint32_t frameIndex);
+
+  // Splits [0, itemCount) into chunks of at most chunkSize items, records each chunk into its own
+  // secondary command buffer on the thread pool and executes them from primary in item order.
+  // primary must be inside renderPass (subpass 0), begun with
+  // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS; framebuffer may be VK_NULL_HANDLE.
+  void record(
+      VkCommandBuffer primary,
+      VkRenderPass renderPass,
+      VkFramebuffer framebuffer,
+      uint32_t itemCount,
+      uint32_t chunkSize,
+      const RecordFunction &recordChunk);
+
+  uint32_t threadCount() const { return threadPool.threadCount(); }
+
+ private:
+  // one per thread per frame in flight
+  struct ThreadCommandPool {
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> buffers;
+    uint32_t used = 0;
+  };
+
+  VkCommandBuffer nextSecondary(ThreadCommandPool &threadPool);
+
+  LveDevice &lveDevice;
+  LveThreadPool &threadPool;
+  uint32_t currentFrame = 0;
+  // [frame][thread], with an extra thread slot for callers outside the pool
+  std::vector<std::vector<ThreadCommandPool>> commandPools;
+  std::vector<VkCommandBuffer> secondaries;
+};
+
+}  // namespace lve
@@ -1,23 +1,157 @@
 #include "lve_pipeline.hpp"
 
-#include <fstream>
+#include "lve_pipeline_registry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <unordered_map>
 #include <stdexcept>
 #include <iostream>
 #include <assert.h>
 
+namespace
+{
+	// Everything a VkGraphicsPipelineCreateInfo points at that is not owned by the config. Filled
+	// in place because pipelineInfo points into the state itself.
+	struct PipelineCreateState
+	{
+		VkPipelineShaderStageCreateInfo shaderStages[2];
+		VkSpecializationInfo specializationInfo{};
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+		VkPipelineViewportStateCreateInfo viewportInfo{};
+		VkPipelineColorBlendStateCreateInfo colorBlendInfo{};
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
+		VkPipelineCreationFeedbackEXT creationFeedback{};
+		VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+
+		PipelineCreateState() = default;
+		PipelineCreateState(const PipelineCreateState&) = delete;
+		PipelineCreateState& operator=(const PipelineCreateState&) = delete;
+
+		void fill(lve::LveDevice& device, const lve::PipelineConfigInfo& config, VkShaderModule vertShaderModule, VkShaderModule fragShaderModule)
+		{
+			shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+			shaderStages[0].module = vertShaderModule;
+			shaderStages[0].pName = "main";
+			shaderStages[0].flags = 0;
+			shaderStages[0].pNext = nullptr;
+			shaderStages[0].pSpecializationInfo = nullptr;
+			shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+			shaderStages[1].module = fragShaderModule;
+			shaderStages[1].pName = "main";
+			shaderStages[1].flags = 0;
+			shaderStages[1].pNext = nullptr;
+			shaderStages[1].pSpecializationInfo = nullptr;
+			if (!config.specialization.empty())
+			{
+				specializationInfo = config.specialization.info();
+				shaderStages[0].pSpecializationInfo = &specializationInfo;
+				shaderStages[1].pSpecializationInfo = &specializationInfo;
+			}
+
+			vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(config.bindingDescriptions.size());
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(config.attributeDescriptions.size());
+			vertexInputInfo.pVertexBindingDescriptions = config.bindingDescriptions.data();
+			vertexInputInfo.pVertexAttributeDescriptions = config.attributeDescriptions.data();
+
+			// the config is passed around by value, so re-point its internal pointers at this copy
+			viewportInfo = config.viewportInfo;
+			colorBlendInfo = config.colorBlendInfo;
+			colorBlendInfo.pAttachments = &config.colorBlendAttachment;
+			dynamicStateInfo = config.dynamicStateInfo;
+			dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(config.dynamicStateEnables.size());
+			dynamicStateInfo.pDynamicStates = config.dynamicStateEnables.data();
+
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipelineInfo.stageCount = 2;
+			pipelineInfo.pStages = shaderStages;
+			pipelineInfo.pVertexInputState = &vertexInputInfo;
+			pipelineInfo.pInputAssemblyState = &config.inputAssemblyInfo;
+			pipelineInfo.pViewportState = &viewportInfo;
+			pipelineInfo.pRasterizationState = &config.rasterizationInfo;
+			pipelineInfo.pMultisampleState = &config.multisampleInfo;
+			pipelineInfo.pColorBlendState = &colorBlendInfo;
+			pipelineInfo.pDepthStencilState = &config.depthStencilInfo;
+			pipelineInfo.pDynamicState = &dynamicStateInfo;
+
+			pipelineInfo.layout = config.pipelineLayout;
+			pipelineInfo.renderPass = config.renderPass;
+			pipelineInfo.subpass = config.subpass;
+
+			pipelineInfo.basePipelineIndex = -1;
+			pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+			// creation feedback tells us whether the driver actually found the pipeline in the cache
+			if (device.isExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME))
+			{
+				feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+				feedbackInfo.pPipelineCreationFeedback = &creationFeedback;
+				pipelineInfo.pNext = &feedbackInfo;
+			}
+		}
+
+		void record(lve::LvePipelineCache& pipelineCache, const std::string& name, double milliseconds) const
+		{
+			bool feedbackValid = (creationFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) != 0;
+			bool cacheHit = feedbackValid
+				? (creationFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) != 0
+				: pipelineCache.loadedFromDisk();
+			pipelineCache.recordCreation(name, milliseconds, cacheHit, feedbackValid);
+		}
+	};
+
+	VkShaderModule loadShaderModule(lve::LveDevice& device, const std::vector<char>& code)
+	{
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create shader module!");
+		}
+		return shaderModule;
+	}
+
+	// how the pipeline cache report lists a pipeline, with its variant if it has one
+	std::string pipelineName(const std::string& vertFilepath, const std::string& fragFilepath, const lve::PipelineConfigInfo& config)
+	{
+		std::string name = vertFilepath + " + " + fragFilepath;
+		if (!config.specialization.empty())
+		{
+			name += " <" + config.specialization.describe() + ">";
+		}
+		return name;
+	}
+}
+
 lve::LvePipeline::LvePipeline(LveDevice& device, const std::string& vertFilepath, const std::string& fragFilePath, const PipelineConfigInfo& config) : lveDevice{device}
 {
 	createGraphicsPipline(vertFilepath, fragFilePath, config);
 }
 
+lve::LvePipeline::LvePipeline(LveDevice& device, VkPipeline pipeline, uint64_t key) : lveDevice{device}, graphicsPipeline{pipeline}, pipelineKey{key}
+{
+}
+
 lve::LvePipeline::~LvePipeline()
 {
-	vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
-	vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-	vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+	lveDevice.pipelineRegistry().release(graphicsPipeline);
 }
 
-lve::PipelineConfigInfo lve::LvePipeline::defaultPipelineConfigInfo(uint32_t width, uint32_t height)
+void lve::LvePipeline::bind(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+}
+
+lve::PipelineConfigInfo lve::LvePipeline::defaultPipelineConfigInfo()
 {
 	PipelineConfigInfo configInfo{};
 
@@ -25,21 +159,11 @@ lve::PipelineConfigInfo lve::LvePipeline::defaultPipelineConfigInfo(uint32_t wid
 	configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	configInfo.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
-	configInfo.viewport.x = 0.0f;
-	configInfo.viewport.y = 0.0f;
-	configInfo.viewport.width = static_cast<float>(width);
-	configInfo.viewport.height = static_cast<float>(height);
-	configInfo.viewport.minDepth = 0.0f;
-	configInfo.viewport.maxDepth = 1.0f;
-
-	configInfo.scissor.offset = { 0, 0 };
-	configInfo.scissor.extent = { width, height };
-
 	configInfo.viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	configInfo.viewportInfo.viewportCount = 1;
-	configInfo.viewportInfo.pViewports = &configInfo.viewport;
+	configInfo.viewportInfo.pViewports = nullptr;
 	configInfo.viewportInfo.scissorCount = 1;
-	configInfo.viewportInfo.pScissors = &configInfo.scissor;
+	configInfo.viewportInfo.pScissors = nullptr;
 
 	configInfo.rasterizationInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 	configInfo.rasterizationInfo.depthClampEnable = VK_FALSE;
@@ -93,25 +217,27 @@ lve::PipelineConfigInfo lve::LvePipeline::defaultPipelineConfigInfo(uint32_t wid
 	configInfo.depthStencilInfo.front = {};  // Optional
 	configInfo.depthStencilInfo.back = {};   // Optional
 
+	configInfo.dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	configInfo.dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+	configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+	configInfo.dynamicStateInfo.flags = 0;
+
 	return configInfo;
 }
 
-std::vector<char> lve::LvePipeline::readFile(const std::string& filepath)
+void lve::LvePipeline::setViewportAndScissor(VkCommandBuffer commandBuffer, VkExtent2D extent)
 {
-	std::ifstream file(filepath, std::ios::ate, std::ios::binary);
-	if (!file.is_open())
-	{
-		throw std::runtime_error("Failed to open file: " + filepath);
-	}
-
-	size_t fileSize = static_cast<size_t>(file.tellg());
-	std::vector<char> buffer(fileSize);
-
-	file.seekg(0);
-	file.read(buffer.data(), fileSize);
-
-	file.close();
-	return buffer;
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(extent.width);
+	viewport.height = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	VkRect2D scissor{ { 0, 0 }, extent };
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 }
 
 void lve::LvePipeline::createGraphicsPipline(const std::string& vertFilepath, const std::string& fragFilePath, const PipelineConfigInfo& config)
@@ -120,72 +246,270 @@ void lve::LvePipeline::createGraphicsPipline(const std::string& vertFilepath, co
 	assert(config.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no renderPass provided in config");
 
 
-	auto vertCode = readFile(vertFilepath);
-	auto fragCode = readFile(fragFilePath);
-
-	createShaderModule(vertCode, &vertShaderModule);
-	createShaderModule(fragCode, &fragShaderModule);
-
-	VkPipelineShaderStageCreateInfo shaderStages[2];
-	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-	shaderStages[0].module = vertShaderModule;
-	shaderStages[0].pName = "main";
-	shaderStages[0].flags = 0;
-	shaderStages[0].pNext = nullptr;
-	shaderStages[0].pSpecializationInfo = nullptr;
-	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	shaderStages[1].module = fragShaderModule;
-	shaderStages[1].pName = "main";
-	shaderStages[1].flags = 0;
-	shaderStages[1].pNext = nullptr;
-	shaderStages[1].pSpecializationInfo = nullptr;
-
-	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexAttributeDescriptionCount = 0;
-	vertexInputInfo.vertexAttributeDescriptionCount = 0;
-	vertexInputInfo.pVertexAttributeDescriptions = nullptr;
-	vertexInputInfo.pVertexBindingDescriptions = nullptr;
-
-	VkGraphicsPipelineCreateInfo pipelineInfo{};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = shaderStages;
-	pipelineInfo.pVertexInputState = &vertexInputInfo;
-	pipelineInfo.pInputAssemblyState = &config.inputAssemblyInfo;
-	pipelineInfo.pViewportState = &config.viewportInfo;
-	pipelineInfo.pRasterizationState = &config.rasterizationInfo;
-	pipelineInfo.pMultisampleState = &config.multisampleInfo;
-	pipelineInfo.pColorBlendState = &config.colorBlendInfo;
-	pipelineInfo.pDepthStencilState = &config.depthStencilInfo;
-	pipelineInfo.pDynamicState = nullptr;
-
-	pipelineInfo.layout = config.pipelineLayout;
-	pipelineInfo.renderPass = config.renderPass;
-	pipelineInfo.subpass = config.subpass;
+	// modules are compiled from the GLSL source when it is present, see LveShaderCompiler::loadSpirv
+	LvePipelineRegistry& registry = lveDevice.pipelineRegistry();
+	VkShaderModule vertShaderModule = registry.acquireShaderModule(vertFilepath);
+	VkShaderModule fragShaderModule;
+	try
+	{
+		fragShaderModule = registry.acquireShaderModule(fragFilePath);
+	}
+	catch (...)
+	{
+		// a shader that fails to compile, e.g. while hot reloading
+		registry.releaseShaderModule(vertShaderModule);
+		throw;
+	}
+	LvePipelineStateKey key = LvePipelineRegistry::makeKey(vertShaderModule, fragShaderModule, config);
+	pipelineKey = key.hash;
+
+	if (!registry.tryAcquire(key, graphicsPipeline))
+	{
+		PipelineCreateState state;
+		state.fill(lveDevice, config, vertShaderModule, fragShaderModule);
+
+		LvePipelineCache& pipelineCache = lveDevice.pipelineCache();
+		auto start = std::chrono::high_resolution_clock::now();
+		if (vkCreateGraphicsPipelines(lveDevice.device(), pipelineCache.handle(), 1, &state.pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+		{
+			registry.releaseShaderModule(vertShaderModule);
+			registry.releaseShaderModule(fragShaderModule);
+			throw std::runtime_error("Failed to create graphics pipeline!");
+		}
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		state.record(pipelineCache, pipelineName(vertFilepath, fragFilePath, config), milliseconds);
+		graphicsPipeline = registry.add(key, graphicsPipeline, vertShaderModule, fragShaderModule);
+	}
 
-	pipelineInfo.basePipelineIndex = -1;
-	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	// a registered pipeline holds its own references to the modules
+	registry.releaseShaderModule(vertShaderModule);
+	registry.releaseShaderModule(fragShaderModule);
+}
+
+std::vector<std::future<std::unique_ptr<lve::LvePipeline>>> lve::LvePipeline::createPipelines(
+	LveDevice& device,
+	const std::vector<PipelineBuildDesc>& descs,
+	LveThreadPool& threadPool,
+	const PipelineBatchOptions& options)
+{
+	// the jobs outlive this call, so they share one copy of the descriptions and the modules
+	struct SharedBatch {
+		LveDevice* device;
+		std::vector<PipelineBuildDesc> descs;
+		std::vector<LvePipelineStateKey> keys;
+		std::vector<VkShaderModule> vertModules;
+		std::vector<VkShaderModule> fragModules;
+		std::map<std::string, VkShaderModule> modules;
+		// descriptions repeating an earlier one in the batch, by the index of the one that is built
+		std::map<size_t, std::vector<size_t>> duplicates;
+		std::vector<std::promise<std::unique_ptr<LvePipeline>>> promises;
+
+		~SharedBatch()
+		{
+			// registered pipelines hold their own references to the modules
+			for (auto& module : modules)
+			{
+				device->pipelineRegistry().releaseShaderModule(module.second);
+			}
+		}
+	};
+
+	LvePipelineRegistry& registry = device.pipelineRegistry();
+	auto batch = std::make_shared<SharedBatch>();
+	batch->device = &device;
+	batch->descs = descs;
+	batch->promises.resize(descs.size());
+
+	std::vector<std::future<std::unique_ptr<LvePipeline>>> futures;
+	futures.reserve(descs.size());
+	for (auto& promise : batch->promises)
+	{
+		futures.push_back(promise.get_future());
+	}
 
-	if (vkCreateGraphicsPipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+	auto moduleFor = [&](const std::string& filepath) {
+		auto it = batch->modules.find(filepath);
+		if (it != batch->modules.end()) return it->second;
+		VkShaderModule module = registry.acquireShaderModule(filepath);
+		batch->modules.emplace(filepath, module);
+		return module;
+	};
+	std::vector<size_t> toBuild;
+	std::unordered_map<LvePipelineStateKey, size_t, LvePipelineStateKeyHash> firstWithKey;
+	for (size_t i = 0; i < batch->descs.size(); i++)
 	{
-		throw std::runtime_error("Failed to create graphics pipeline!");
+		const auto& desc = batch->descs[i];
+		assert(desc.config.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no pipelineLayout provided in config");
+		assert(desc.config.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no renderPass provided in config");
+		batch->vertModules.push_back(moduleFor(desc.vertFilepath));
+		batch->fragModules.push_back(moduleFor(desc.fragFilepath));
+		batch->keys.push_back(LvePipelineRegistry::makeKey(batch->vertModules[i], batch->fragModules[i], desc.config));
+
+		VkPipeline existing;
+		if (registry.tryAcquire(batch->keys[i], existing))
+		{
+			std::unique_ptr<LvePipeline> pipeline{ new LvePipeline(device, existing, batch->keys[i].hash) };
+			if (options.onReady)
+			{
+				options.onReady(i, *pipeline);
+			}
+			batch->promises[i].set_value(std::move(pipeline));
+			continue;
+		}
+		auto first = firstWithKey.emplace(batch->keys[i], i);
+		if (!first.second)
+		{
+			batch->duplicates[first.first->second].push_back(i);
+			continue;
+		}
+		toBuild.push_back(i);
 	}
 
+	// enough groups to keep every worker busy, but never more pipelines per call than requested
+	size_t groupSize = std::max<size_t>(1, toBuild.size() / (threadPool.threadCount() * 4));
+	groupSize = std::min<size_t>(groupSize, std::max(1u, options.maxPipelinesPerCall));
+
+	PipelineBatchOptions jobOptions = options;
+	for (size_t first = 0; first < toBuild.size(); first += groupSize)
+	{
+		std::vector<size_t> group(toBuild.begin() + first, toBuild.begin() + std::min(first + groupSize, toBuild.size()));
+		threadPool.submit([batch, jobOptions, group]() {
+			// the pool's own future is dropped, so whatever throws in here goes to the descriptions still
+			// waiting on the group instead of getting lost with it
+			std::vector<bool> settled(batch->descs.size(), false);
+			try
+			{
+				LveDevice& device = *batch->device;
+				LvePipelineRegistry& registry = device.pipelineRegistry();
+				bool useDeviceCache = jobOptions.cache == VK_NULL_HANDLE;
+				VkPipelineCache cache = useDeviceCache ? device.pipelineCache().handle() : jobOptions.cache;
+				size_t count = group.size();
+
+				std::vector<PipelineCreateState> states(count);
+				std::vector<VkGraphicsPipelineCreateInfo> pipelineInfos(count);
+				for (size_t i = 0; i < count; i++)
+				{
+					size_t index = group[i];
+					states[i].fill(device, batch->descs[index].config, batch->vertModules[index], batch->fragModules[index]);
+					pipelineInfos[i] = states[i].pipelineInfo;
+				}
+
+				std::vector<VkPipeline> pipelines(count, VK_NULL_HANDLE);
+				auto start = std::chrono::high_resolution_clock::now();
+				VkResult result = vkCreateGraphicsPipelines(device.device(), cache, static_cast<uint32_t>(count), pipelineInfos.data(), nullptr, pipelines.data());
+				double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+				// a failed call can still return some valid pipelines; only the null ones failed
+				for (size_t i = 0; i < count; i++)
+				{
+					size_t index = group[i];
+					auto duplicates = batch->duplicates.find(index);
+					std::vector<size_t> ready{ index };
+					if (duplicates != batch->duplicates.end())
+					{
+						ready.insert(ready.end(), duplicates->second.begin(), duplicates->second.end());
+					}
+
+					if (pipelines[i] == VK_NULL_HANDLE)
+					{
+						for (size_t readyIndex : ready)
+						{
+							batch->promises[readyIndex].set_exception(std::make_exception_ptr(std::runtime_error(
+								"Failed to create graphics pipeline (VkResult " + std::to_string(result) + ")!")));
+							settled[readyIndex] = true;
+						}
+						continue;
+					}
+
+					const auto& desc = batch->descs[index];
+					if (useDeviceCache)
+					{
+						states[i].record(device.pipelineCache(), pipelineName(desc.vertFilepath, desc.fragFilepath, desc.config), milliseconds / count);
+					}
+
+					const LvePipelineStateKey& key = batch->keys[index];
+					VkPipeline registered = registry.add(key, pipelines[i], batch->vertModules[index], batch->fragModules[index]);
+					// every repeat takes its reference before the first one is handed out and could be released
+					std::vector<std::unique_ptr<LvePipeline>> built;
+					built.emplace_back(new LvePipeline(device, registered, key.hash));
+					for (size_t r = 1; r < ready.size(); r++)
+					{
+						VkPipeline shared;
+						registry.tryAcquire(key, shared);
+						built.emplace_back(new LvePipeline(device, shared, key.hash));
+					}
+					for (size_t r = 0; r < ready.size(); r++)
+					{
+						if (jobOptions.onReady)
+						{
+							jobOptions.onReady(ready[r], *built[r]);
+						}
+						batch->promises[ready[r]].set_value(std::move(built[r]));
+						settled[ready[r]] = true;
+					}
+				}
+			}
+			catch (...)
+			{
+				for (size_t index : group)
+				{
+					std::vector<size_t> waiting{ index };
+					auto duplicates = batch->duplicates.find(index);
+					if (duplicates != batch->duplicates.end())
+					{
+						waiting.insert(waiting.end(), duplicates->second.begin(), duplicates->second.end());
+					}
+					for (size_t waitingIndex : waiting)
+					{
+						if (!settled[waitingIndex]) batch->promises[waitingIndex].set_exception(std::current_exception());
+					}
+				}
+			}
+		});
+	}
+
+	return futures;
 }
 
-void lve::LvePipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
+lve::LveComputePipeline::LveComputePipeline(LveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout, const LveSpecializationConstants& specialization) : lveDevice{device}
 {
-	VkShaderModuleCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+	assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: no pipelineLayout provided");
+
+	VkShaderModule compShaderModule = loadShaderModule(lveDevice, lveDevice.shaderCompiler().loadSpirv(compFilepath));
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = compShaderModule;
+	pipelineInfo.stage.pName = "main";
+	VkSpecializationInfo specializationInfo = specialization.info();
+	pipelineInfo.stage.pSpecializationInfo = specialization.empty() ? nullptr : &specializationInfo;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.basePipelineIndex = -1;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-	if (vkCreateShaderModule(lveDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+	LvePipelineCache& pipelineCache = lveDevice.pipelineCache();
+	auto start = std::chrono::high_resolution_clock::now();
+	VkResult result = vkCreateComputePipelines(lveDevice.device(), pipelineCache.handle(), 1, &pipelineInfo, nullptr, &computePipeline);
+	vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+	if (result != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to create shader module!");
+		throw std::runtime_error("Failed to create compute pipeline!");
 	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 
+	std::string name = specialization.empty() ? compFilepath : compFilepath + " <" + specialization.describe() + ">";
+	pipelineCache.recordCreation(name, milliseconds, pipelineCache.loadedFromDisk(), false);
+}
+
+lve::LveComputePipeline::~LveComputePipeline()
+{
+	vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+}
+
+void lve::LveComputePipeline::bind(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
 }
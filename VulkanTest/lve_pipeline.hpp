@@ -1,15 +1,22 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_specialization.hpp"
+#include "lve_thread_pool.hpp"
 
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
 	struct PipelineConfigInfo {
-		VkViewport viewport;
-		VkRect2D scissor;
+		// empty for shaders that generate their vertices, like simple_shader.vert
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+		// viewport and scissor are dynamic; set them with setViewportAndScissor while recording
 		VkPipelineViewportStateCreateInfo viewportInfo;
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -17,11 +24,36 @@ namespace lve {
 		VkPipelineColorBlendAttachmentState colorBlendAttachment;
 		VkPipelineColorBlendStateCreateInfo colorBlendInfo;
 		VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
+		std::vector<VkDynamicState> dynamicStateEnables{};
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+		// shader variant: values for the vertex and fragment shaders' constant_id declarations
+		LveSpecializationConstants specialization{};
 		VkPipelineLayout pipelineLayout = nullptr;
+		// the swap chain's, an LveOffscreenTarget's or a pass's from LveRenderGraph::renderPass
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
 	};
 
+	struct PipelineBuildDesc {
+		std::string vertFilepath;
+		std::string fragFilepath;
+		PipelineConfigInfo config;
+	};
+
+	class LvePipeline;
+
+	struct PipelineBatchOptions {
+		// upper bound on the pipelines handed to a single vkCreateGraphicsPipelines call
+		uint32_t maxPipelinesPerCall = 16;
+		// VK_NULL_HANDLE builds into the device cache and records timings in its report
+		VkPipelineCache cache = VK_NULL_HANDLE;
+		// called with the description index as each pipeline is ready: on a worker thread once it is
+		// built, or on the calling thread when the registry already had it
+		std::function<void(size_t, LvePipeline&)> onReady;
+	};
+
+	// A reference to a pipeline in the device's LvePipelineRegistry: constructing one with the same
+	// shaders and config as a live one shares its VkPipeline instead of building another.
 	class LvePipeline
 	{
 	public:
@@ -31,21 +63,57 @@ namespace lve {
 		LvePipeline(const LvePipeline&) = delete;
 		void operator=(const LvePipeline&) = delete;
 
-		static PipelineConfigInfo defaultPipelineConfigInfo(uint32_t width, uint32_t height);
+		void bind(VkCommandBuffer commandBuffer);
+		VkPipeline getHandle() const { return graphicsPipeline; }
+		// hash of the full pipeline state, equal for pipelines sharing a VkPipeline;
+		// see sortDrawsByPipeline
+		uint64_t getKey() const { return pipelineKey; }
+
+		// Viewport and scissor are dynamic state, so pipelines built from it survive window resizes.
+		static PipelineConfigInfo defaultPipelineConfigInfo();
+		// covers the whole extent; needed once per command buffer before drawing with such pipelines
+		static void setViewportAndScissor(VkCommandBuffer commandBuffer, VkExtent2D extent);
+
+		// Compiles every description on the thread pool, grouped into multi-pipeline
+		// vkCreateGraphicsPipelines calls. Each future is ready as soon as its group is built;
+		// shader modules come from the registry and are shared by all pipelines using them.
+		// Descriptions the registry already has, or that repeat an earlier one, are not built again.
+		static std::vector<std::future<std::unique_ptr<LvePipeline>>> createPipelines(
+			LveDevice& device,
+			const std::vector<PipelineBuildDesc>& descs,
+			LveThreadPool& threadPool,
+			const PipelineBatchOptions& options = {});
 
 	private:
-		static std::vector<char> readFile(const std::string& filepath);
+		// adopts a registry reference taken by createPipelines
+		LvePipeline(LveDevice& device, VkPipeline pipeline, uint64_t key);
 
 		void createGraphicsPipline(const std::string& vertFilepath, const std::string& fragFilePath, const PipelineConfigInfo& config);
 
-		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
-
 		LveDevice& lveDevice;
 
 		VkPipeline graphicsPipeline;
-		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
+		uint64_t pipelineKey = 0;
+
+	};
+
+	// A single compute shader stage. Built through the device pipeline cache like LvePipeline; the
+	// shader module is only needed while the pipeline is created.
+	class LveComputePipeline
+	{
+	public:
+		LveComputePipeline(LveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout, const LveSpecializationConstants& specialization = {});
+		~LveComputePipeline();
+
+		LveComputePipeline(const LveComputePipeline&) = delete;
+		void operator=(const LveComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+
+	private:
+		LveDevice& lveDevice;
 
+		VkPipeline computePipeline;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "lve_pipeline_cache.hpp"
+
+// std headers
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+// layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE, as written at the start of every cache blob
+struct PipelineCacheHeader {
+  uint32_t headerSize;
+  uint32_t headerVersion;
+  uint32_t vendorID;
+  uint32_t deviceID;
+  uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+}  // namespace
+
+LvePipelineCache::LvePipelineCache(
+    VkDevice device, const VkPhysicalDeviceProperties &properties, std::string path)
+    : device{device}, properties{properties}, path{std::move(path)} {
+  auto start = std::chrono::high_resolution_clock::now();
+
+  std::vector<char> data = readCacheFile();
+  if (!data.empty() && !isCompatible(data)) {
+    std::cout << "pipeline cache: discarding " << this->path
+              << " (written by a different device or driver)" << std::endl;
+    data.clear();
+  }
+
+  VkPipelineCacheCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  createInfo.initialDataSize = data.size();
+  createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+  if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+    // a corrupt blob that slipped past the header check should not prevent startup
+    createInfo.initialDataSize = 0;
+    createInfo.pInitialData = nullptr;
+    data.clear();
+    if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create pipeline cache!");
+    }
+  }
+  loaded = !data.empty();
+  loadMilliseconds = std::chrono::duration<double, std::milli>(
+                         std::chrono::high_resolution_clock::now() - start)
+                         .count();
+}
+
+LvePipelineCache::~LvePipelineCache() {
+  save();
+  vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+std::vector<char> LvePipelineCache::readCacheFile() const {
+  std::ifstream file{path, std::ios::ate | std::ios::binary};
+  if (!file.is_open()) {
+    return {};
+  }
+  size_t fileSize = static_cast<size_t>(file.tellg());
+  std::vector<char> buffer(fileSize);
+  file.seekg(0);
+  file.read(buffer.data(), fileSize);
+  return buffer;
+}
+
+bool LvePipelineCache::isCompatible(const std::vector<char> &data) const {
+  if (data.size() < sizeof(PipelineCacheHeader)) {
+    return false;
+  }
+  PipelineCacheHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  return header.headerSize >= sizeof(PipelineCacheHeader) &&
+         header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+         std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void LvePipelineCache::save() {
+  size_t dataSize = 0;
+  if (vkGetPipelineCacheData(device, cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+    return;
+  }
+  std::vector<char> data(dataSize);
+  if (vkGetPipelineCacheData(device, cache, &dataSize, data.data()) != VK_SUCCESS) {
+    std::cerr << "pipeline cache: failed to read cache data" << std::endl;
+    return;
+  }
+
+  // failing to persist the cache only costs the next startup, so report and carry on
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+    if (!file.write(data.data(), dataSize)) {
+      std::cerr << "pipeline cache: failed to write " << tempPath << std::endl;
+      return;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if (error) {
+    std::cerr << "pipeline cache: failed to replace " << path << ": " << error.message()
+              << std::endl;
+    std::filesystem::remove(tempPath, error);
+  }
+}
+
+void LvePipelineCache::recordCreation(
+    const std::string &name, double milliseconds, bool cacheHit, bool feedbackValid) {
+  std::lock_guard<std::mutex> lock{recordMutex};
+  records.push_back({name, milliseconds, cacheHit, feedbackValid});
+}
+
+void LvePipelineCache::printReport(std::ostream &out) {
+  std::lock_guard<std::mutex> lock{recordMutex};
+  double hitTotal = 0.0;
+  double missTotal = 0.0;
+  size_t hits = 0;
+
+  out << "pipeline cache: " << (loaded ? "loaded " : "no usable cache at ") << path << " in "
+      << loadMilliseconds << " ms" << std::endl;
+  for (const auto &record : records) {
+    out << "\t" << (record.cacheHit ? "hit  " : "miss ") << record.milliseconds << " ms  "
+        << record.name << (record.feedbackValid ? "" : " (inferred)") << std::endl;
+    if (record.cacheHit) {
+      hits++;
+      hitTotal += record.milliseconds;
+    } else {
+      missTotal += record.milliseconds;
+    }
+  }
+  size_t misses = records.size() - hits;
+  out << "\t" << hits << " hits";
+  if (hits > 0) out << " (avg " << hitTotal / hits << " ms)";
+  out << ", " << misses << " misses";
+  if (misses > 0) out << " (avg " << missTotal / misses << " ms)";
+  out << std::endl;
+}
+
+}  // namespace lve
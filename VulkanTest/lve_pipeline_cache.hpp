@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+struct LvePipelineCreationRecord {
+  std::string name;
+  double milliseconds;
+  bool cacheHit;
+  bool feedbackValid;  // false when the hit was inferred rather than reported by the driver
+};
+
+// Device-wide VkPipelineCache persisted between runs. The blob is only accepted when its header
+// matches the current driver (vendorID, deviceID and pipelineCacheUUID); otherwise the cache
+// starts empty and is overwritten on shutdown.
+class LvePipelineCache {
+ public:
+  static constexpr const char *DEFAULT_PATH = "pipeline_cache.bin";
+
+  LvePipelineCache(
+      VkDevice device,
+      const VkPhysicalDeviceProperties &properties,
+      std::string path = DEFAULT_PATH);
+  ~LvePipelineCache();
+
+  LvePipelineCache(const LvePipelineCache &) = delete;
+  LvePipelineCache &operator=(const LvePipelineCache &) = delete;
+
+  VkPipelineCache handle() const { return cache; }
+  bool loadedFromDisk() const { return loaded; }
+
+  // Writes the cache to a temporary file and renames it over the previous one, so an
+  // interrupted write never leaves a truncated cache behind.
+  void save();
+
+  void recordCreation(const std::string &name, double milliseconds, bool cacheHit, bool feedbackValid);
+  void printReport(std::ostream &out);
+
+ private:
+  std::vector<char> readCacheFile() const;
+  bool isCompatible(const std::vector<char> &data) const;
+
+  VkDevice device;
+  VkPhysicalDeviceProperties properties;
+  std::string path;
+  VkPipelineCache cache = VK_NULL_HANDLE;
+  bool loaded = false;
+  double loadMilliseconds = 0.0;
+
+  std::mutex recordMutex;
+  std::vector<LvePipelineCreationRecord> records;
+};
+
+}  // namespace lve
@@ -0,0 +1,329 @@
+#include "lve_pipeline_registry.hpp"
+
+// std headers
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace lve {
+
+namespace {
+
+// Appends the fields of a pipeline's state one at a time, so neither struct padding nor the
+// pointers inside the create infos end up in the key.
+class KeyWriter {
+ public:
+  explicit KeyWriter(std::vector<uint32_t> &words) : words{words} {}
+
+  void add(uint32_t value) { words.push_back(value); }
+  void add(int32_t value) { words.push_back(static_cast<uint32_t>(value)); }
+  void add(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    words.push_back(bits);
+  }
+  template <typename Handle>
+  void addHandle(Handle handle) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &handle, sizeof(handle));
+    words.push_back(static_cast<uint32_t>(bits));
+    words.push_back(static_cast<uint32_t>(bits >> 32));
+  }
+
+  void add(const VkStencilOpState &state) {
+    add(static_cast<uint32_t>(state.failOp));
+    add(static_cast<uint32_t>(state.passOp));
+    add(static_cast<uint32_t>(state.depthFailOp));
+    add(static_cast<uint32_t>(state.compareOp));
+    add(state.compareMask);
+    add(state.writeMask);
+    add(state.reference);
+  }
+
+ private:
+  std::vector<uint32_t> &words;
+};
+
+// 64-bit FNV-1a, as for the shader compiler's cache keys
+uint64_t hashWords(const std::vector<uint32_t> &words) {
+  uint64_t hash = 14695981039346656037ull;
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(words.data());
+  for (size_t i = 0; i < words.size() * sizeof(uint32_t); i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+LvePipelineRegistry::LvePipelineRegistry(VkDevice device, LveShaderCompiler &shaderCompiler)
+    : device{device}, shaderCompiler{shaderCompiler} {}
+
+LvePipelineRegistry::~LvePipelineRegistry() {
+  // whatever is left was never released; the device is going away, so destroy it all
+  for (auto &entry : pipelines) {
+    vkDestroyPipeline(device, entry.first, nullptr);
+  }
+  for (auto &entry : shaderModules) {
+    vkDestroyShaderModule(device, entry.first, nullptr);
+  }
+}
+
+std::filesystem::file_time_type LvePipelineRegistry::sourceWriteTime(
+    const std::string &spirvPath) {
+  std::error_code error;
+  std::string sourcePath = LveShaderCompiler::sourcePathFor(spirvPath);
+  if (sourcePath.empty() || !std::filesystem::exists(sourcePath, error)) {
+    sourcePath = spirvPath;
+  }
+  auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+  return error ? std::filesystem::file_time_type::min() : writeTime;
+}
+
+VkShaderModule LvePipelineRegistry::createShaderModule(const std::vector<char> &code) {
+  VkShaderModuleCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  createInfo.codeSize = code.size();
+  createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+
+  VkShaderModule shaderModule;
+  if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create shader module!");
+  }
+  return shaderModule;
+}
+
+VkShaderModule LvePipelineRegistry::acquireShaderModule(const std::string &spirvPath) {
+  auto writeTime = sourceWriteTime(spirvPath);
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto current = currentModules.find(spirvPath);
+    if (current != currentModules.end()) {
+      ShaderModuleEntry &entry = shaderModules.at(current->second);
+      if (entry.writeTime == writeTime) {
+        entry.refCount++;
+        counters.shaderModuleHits++;
+        return current->second;
+      }
+    }
+  }
+
+  // compiling can take a while, so it runs without the lock
+  VkShaderModule module = createShaderModule(shaderCompiler.loadSpirv(spirvPath));
+
+  std::lock_guard<std::mutex> lock{mutex};
+  auto current = currentModules.find(spirvPath);
+  if (current != currentModules.end()) {
+    ShaderModuleEntry &entry = shaderModules.at(current->second);
+    if (entry.writeTime == writeTime) {
+      // another thread loaded the same version meanwhile
+      vkDestroyShaderModule(device, module, nullptr);
+      entry.refCount++;
+      counters.shaderModuleHits++;
+      return current->second;
+    }
+  }
+  // an older version stays alive for the pipelines still built from it
+  shaderModules[module] = ShaderModuleEntry{spirvPath, writeTime, 1};
+  currentModules[spirvPath] = module;
+  counters.shaderModuleMisses++;
+  return module;
+}
+
+void LvePipelineRegistry::releaseShaderModule(VkShaderModule module) {
+  std::lock_guard<std::mutex> lock{mutex};
+  releaseShaderModuleLocked(module);
+}
+
+void LvePipelineRegistry::releaseShaderModuleLocked(VkShaderModule module) {
+  auto it = shaderModules.find(module);
+  if (it == shaderModules.end()) {
+    throw std::runtime_error("released a shader module the registry does not own!");
+  }
+  if (--it->second.refCount > 0) return;
+
+  auto current = currentModules.find(it->second.path);
+  if (current != currentModules.end() && current->second == module) {
+    currentModules.erase(current);
+  }
+  vkDestroyShaderModule(device, module, nullptr);
+  shaderModules.erase(it);
+}
+
+LvePipelineStateKey LvePipelineRegistry::makeKey(
+    VkShaderModule vertModule, VkShaderModule fragModule, const PipelineConfigInfo &config) {
+  LvePipelineStateKey key{};
+  key.words.reserve(128);
+  KeyWriter writer{key.words};
+
+  // modules stand for their code: a registered pipeline keeps its modules, and so their
+  // handles, alive
+  writer.addHandle(vertModule);
+  writer.addHandle(fragModule);
+
+  writer.add(static_cast<uint32_t>(config.bindingDescriptions.size()));
+  for (const auto &binding : config.bindingDescriptions) {
+    writer.add(binding.binding);
+    writer.add(binding.stride);
+    writer.add(static_cast<uint32_t>(binding.inputRate));
+  }
+  writer.add(static_cast<uint32_t>(config.attributeDescriptions.size()));
+  for (const auto &attribute : config.attributeDescriptions) {
+    writer.add(attribute.location);
+    writer.add(attribute.binding);
+    writer.add(static_cast<uint32_t>(attribute.format));
+    writer.add(attribute.offset);
+  }
+
+  // viewports and scissors are dynamic; only their counts are baked in
+  writer.add(config.viewportInfo.flags);
+  writer.add(config.viewportInfo.viewportCount);
+  writer.add(config.viewportInfo.scissorCount);
+
+  const auto &inputAssembly = config.inputAssemblyInfo;
+  writer.add(inputAssembly.flags);
+  writer.add(static_cast<uint32_t>(inputAssembly.topology));
+  writer.add(inputAssembly.primitiveRestartEnable);
+
+  const auto &rasterization = config.rasterizationInfo;
+  writer.add(rasterization.flags);
+  writer.add(rasterization.depthClampEnable);
+  writer.add(rasterization.rasterizerDiscardEnable);
+  writer.add(static_cast<uint32_t>(rasterization.polygonMode));
+  writer.add(rasterization.cullMode);
+  writer.add(static_cast<uint32_t>(rasterization.frontFace));
+  writer.add(rasterization.depthBiasEnable);
+  writer.add(rasterization.depthBiasConstantFactor);
+  writer.add(rasterization.depthBiasClamp);
+  writer.add(rasterization.depthBiasSlopeFactor);
+  writer.add(rasterization.lineWidth);
+
+  const auto &multisample = config.multisampleInfo;
+  writer.add(multisample.flags);
+  writer.add(static_cast<uint32_t>(multisample.rasterizationSamples));
+  writer.add(multisample.sampleShadingEnable);
+  writer.add(multisample.minSampleShading);
+  uint32_t sampleMaskWords =
+      multisample.pSampleMask ? (static_cast<uint32_t>(multisample.rasterizationSamples) + 31) / 32
+                              : 0;
+  writer.add(sampleMaskWords);
+  for (uint32_t i = 0; i < sampleMaskWords; i++) {
+    writer.add(multisample.pSampleMask[i]);
+  }
+  writer.add(multisample.alphaToCoverageEnable);
+  writer.add(multisample.alphaToOneEnable);
+
+  const auto &blendAttachment = config.colorBlendAttachment;
+  writer.add(blendAttachment.blendEnable);
+  writer.add(static_cast<uint32_t>(blendAttachment.srcColorBlendFactor));
+  writer.add(static_cast<uint32_t>(blendAttachment.dstColorBlendFactor));
+  writer.add(static_cast<uint32_t>(blendAttachment.colorBlendOp));
+  writer.add(static_cast<uint32_t>(blendAttachment.srcAlphaBlendFactor));
+  writer.add(static_cast<uint32_t>(blendAttachment.dstAlphaBlendFactor));
+  writer.add(static_cast<uint32_t>(blendAttachment.alphaBlendOp));
+  writer.add(blendAttachment.colorWriteMask);
+
+  const auto &colorBlend = config.colorBlendInfo;
+  writer.add(colorBlend.flags);
+  writer.add(colorBlend.logicOpEnable);
+  writer.add(static_cast<uint32_t>(colorBlend.logicOp));
+  writer.add(colorBlend.attachmentCount);
+  for (float constant : colorBlend.blendConstants) {
+    writer.add(constant);
+  }
+
+  const auto &depthStencil = config.depthStencilInfo;
+  writer.add(depthStencil.flags);
+  writer.add(depthStencil.depthTestEnable);
+  writer.add(depthStencil.depthWriteEnable);
+  writer.add(static_cast<uint32_t>(depthStencil.depthCompareOp));
+  writer.add(depthStencil.depthBoundsTestEnable);
+  writer.add(depthStencil.stencilTestEnable);
+  writer.add(depthStencil.front);
+  writer.add(depthStencil.back);
+  writer.add(depthStencil.minDepthBounds);
+  writer.add(depthStencil.maxDepthBounds);
+
+  writer.add(static_cast<uint32_t>(config.dynamicStateEnables.size()));
+  for (VkDynamicState state : config.dynamicStateEnables) {
+    writer.add(static_cast<uint32_t>(state));
+  }
+
+  // the variant: each set of specialization constants compiles to different code
+  config.specialization.appendKey(key.words);
+
+  writer.addHandle(config.pipelineLayout);
+  writer.addHandle(config.renderPass);
+  writer.add(config.subpass);
+
+  key.hash = hashWords(key.words);
+  return key;
+}
+
+bool LvePipelineRegistry::tryAcquire(const LvePipelineStateKey &key, VkPipeline &pipeline) {
+  std::lock_guard<std::mutex> lock{mutex};
+  auto it = pipelinesByKey.find(key);
+  if (it == pipelinesByKey.end()) return false;
+  pipelines.at(it->second).refCount++;
+  counters.pipelineHits++;
+  pipeline = it->second;
+  return true;
+}
+
+VkPipeline LvePipelineRegistry::add(
+    const LvePipelineStateKey &key,
+    VkPipeline pipeline,
+    VkShaderModule vertModule,
+    VkShaderModule fragModule) {
+  std::lock_guard<std::mutex> lock{mutex};
+  auto it = pipelinesByKey.find(key);
+  if (it != pipelinesByKey.end()) {
+    // built twice concurrently; keep the first
+    vkDestroyPipeline(device, pipeline, nullptr);
+    pipelines.at(it->second).refCount++;
+    counters.pipelineHits++;
+    return it->second;
+  }
+
+  shaderModules.at(vertModule).refCount++;
+  shaderModules.at(fragModule).refCount++;
+  pipelinesByKey.emplace(key, pipeline);
+  pipelines[pipeline] = PipelineEntry{key, vertModule, fragModule, 1};
+  counters.pipelineMisses++;
+  return pipeline;
+}
+
+void LvePipelineRegistry::release(VkPipeline pipeline) {
+  std::lock_guard<std::mutex> lock{mutex};
+  auto it = pipelines.find(pipeline);
+  if (it == pipelines.end()) {
+    throw std::runtime_error("released a pipeline the registry does not own!");
+  }
+  PipelineEntry &entry = it->second;
+  if (--entry.refCount > 0) return;
+
+  vkDestroyPipeline(device, pipeline, nullptr);
+  pipelinesByKey.erase(entry.key);
+  releaseShaderModuleLocked(entry.vertModule);
+  releaseShaderModuleLocked(entry.fragModule);
+  pipelines.erase(it);
+}
+
+LvePipelineRegistryStats LvePipelineRegistry::stats() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  LvePipelineRegistryStats result = counters;
+  result.pipelineCount = static_cast<uint32_t>(pipelines.size());
+  result.shaderModuleCount = static_cast<uint32_t>(shaderModules.size());
+  return result;
+}
+
+void LvePipelineRegistry::printStats(std::ostream &out) const {
+  LvePipelineRegistryStats current = stats();
+  out << "pipeline registry: " << current.pipelineCount << " pipelines ("
+      << current.pipelineHits << " hits, " << current.pipelineMisses << " misses), "
+      << current.shaderModuleCount << " shader modules (" << current.shaderModuleHits
+      << " hits, " << current.shaderModuleMisses << " misses)" << std::endl;
+}
+
+}  // namespace lve
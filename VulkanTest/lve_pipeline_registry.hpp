@@ -0,0 +1,127 @@
+#pragma once
+
+#include "lve_pipeline.hpp"
+#include "lve_shader_compiler.hpp"
+
+// std lib headers
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+// Everything a graphics pipeline is built from: its shader modules and every field of its
+// PipelineConfigInfo, flattened to words. Equal keys build identical pipelines; the hash only
+// speeds up the lookup.
+struct LvePipelineStateKey {
+  std::vector<uint32_t> words;
+  uint64_t hash = 0;
+
+  bool operator==(const LvePipelineStateKey &other) const {
+    return hash == other.hash && words == other.words;
+  }
+};
+
+struct LvePipelineStateKeyHash {
+  size_t operator()(const LvePipelineStateKey &key) const { return static_cast<size_t>(key.hash); }
+};
+
+struct LvePipelineRegistryStats {
+  uint64_t pipelineHits = 0;
+  uint64_t pipelineMisses = 0;
+  uint64_t shaderModuleHits = 0;
+  uint64_t shaderModuleMisses = 0;
+  uint32_t pipelineCount = 0;
+  uint32_t shaderModuleCount = 0;
+};
+
+// Device-wide registry of graphics pipelines and the shader modules they are built from, so
+// pipelines asking for the same state share one VkPipeline and pipelines using the same shader
+// share one VkShaderModule. Both are reference counted and destroyed with their last reference.
+// LvePipeline goes through it; nothing else needs to.
+//
+// A module is reused until the source it was loaded from (the GLSL next to the .spv path, or the
+// .spv itself) has a newer write time, so pipelines rebuilt by hot reload get a new module, and
+// with it a new key, while the old ones keep theirs. All functions are thread safe.
+class LvePipelineRegistry {
+ public:
+  LvePipelineRegistry(VkDevice device, LveShaderCompiler &shaderCompiler);
+  ~LvePipelineRegistry();
+
+  LvePipelineRegistry(const LvePipelineRegistry &) = delete;
+  LvePipelineRegistry &operator=(const LvePipelineRegistry &) = delete;
+
+  // Returns a reference to the module of spirvPath, loading it on first use or when its source
+  // has changed. Pair with releaseShaderModule.
+  VkShaderModule acquireShaderModule(const std::string &spirvPath);
+  void releaseShaderModule(VkShaderModule module);
+
+  static LvePipelineStateKey makeKey(
+      VkShaderModule vertModule, VkShaderModule fragModule, const PipelineConfigInfo &config);
+  // On a hit adds a reference to the existing pipeline.
+  bool tryAcquire(const LvePipelineStateKey &key, VkPipeline &pipeline);
+  // Registers a newly built pipeline with one reference; the entry keeps references to the
+  // modules for as long as it lives. When the same state was registered meanwhile, destroys
+  // pipeline and returns a reference to the registered one instead.
+  VkPipeline add(
+      const LvePipelineStateKey &key,
+      VkPipeline pipeline,
+      VkShaderModule vertModule,
+      VkShaderModule fragModule);
+  // Drops a reference from tryAcquire or add; the last one destroys the pipeline.
+  void release(VkPipeline pipeline);
+
+  LvePipelineRegistryStats stats() const;
+  void printStats(std::ostream &out) const;
+
+ private:
+  struct ShaderModuleEntry {
+    std::string path;
+    std::filesystem::file_time_type writeTime;
+    uint32_t refCount = 0;
+  };
+  struct PipelineEntry {
+    LvePipelineStateKey key;
+    VkShaderModule vertModule;
+    VkShaderModule fragModule;
+    uint32_t refCount = 0;
+  };
+
+  static std::filesystem::file_time_type sourceWriteTime(const std::string &spirvPath);
+  VkShaderModule createShaderModule(const std::vector<char> &code);
+  void releaseShaderModuleLocked(VkShaderModule module);
+
+  VkDevice device;
+  LveShaderCompiler &shaderCompiler;
+
+  mutable std::mutex mutex;
+  std::unordered_map<VkShaderModule, ShaderModuleEntry> shaderModules;
+  std::unordered_map<std::string, VkShaderModule> currentModules;  // newest module per path
+  std::unordered_map<LvePipelineStateKey, VkPipeline, LvePipelineStateKeyHash> pipelinesByKey;
+  std::unordered_map<VkPipeline, PipelineEntry> pipelines;
+  LvePipelineRegistryStats counters;
+};
+
+// Orders draws so draws using the same pipeline are adjacent, which lets the recording loop bind
+// each pipeline once per run instead of once per draw. The sort is stable, so draws sharing a
+// pipeline keep their order, e.g. back to front for blending. pipelineOf(draw) returns the
+// draw's LvePipeline.
+template <typename Draw, typename PipelineOf>
+void sortDrawsByPipeline(std::vector<Draw> &draws, PipelineOf pipelineOf) {
+  std::stable_sort(draws.begin(), draws.end(), [&pipelineOf](const Draw &a, const Draw &b) {
+    const LvePipeline &pipelineA = pipelineOf(a);
+    const LvePipeline &pipelineB = pipelineOf(b);
+    // the handle separates the rare different states that hash to the same key
+    return std::make_pair(pipelineA.getKey(), pipelineA.getHandle()) <
+           std::make_pair(pipelineB.getKey(), pipelineB.getHandle());
+  });
+}
+
+}  // namespace lve
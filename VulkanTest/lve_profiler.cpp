@@ -0,0 +1,297 @@
+#include "lve_profiler.hpp"
+
+// std headers
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace lve {
+
+// results come back in bit order, which is the member order of LvePipelineStatistics
+static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+static constexpr uint32_t PIPELINE_STATISTIC_COUNT = 6;
+
+static std::string escapeJson(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+LveProfiler::LveProfiler(
+    VkDevice device,
+    const VkPhysicalDeviceProperties &properties,
+    uint32_t timestampValidBits,
+    bool pipelineStatisticsSupported)
+    : device{device},
+      timestampsSupported{timestampValidBits > 0 && properties.limits.timestampPeriod > 0.0f},
+      statisticsSupported{pipelineStatisticsSupported},
+      timestampPeriod{properties.limits.timestampPeriod},
+      timestampMask{timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1} {
+  if (!timestampsSupported) return;
+
+  slots.resize(FRAME_RING_SIZE);
+  for (auto &slot : slots) {
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = MAX_SCOPES_PER_FRAME * 2;
+    if (vkCreateQueryPool(device, &poolInfo, nullptr, &slot.timestampPool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create timestamp query pool!");
+    }
+
+    if (statisticsSupported) {
+      poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+      poolInfo.queryCount = MAX_SCOPES_PER_FRAME;
+      poolInfo.pipelineStatistics = PIPELINE_STATISTICS;
+      if (vkCreateQueryPool(device, &poolInfo, nullptr, &slot.statisticsPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline statistics query pool!");
+      }
+    }
+  }
+}
+
+LveProfiler::~LveProfiler() {
+  for (auto &slot : slots) {
+    vkDestroyQueryPool(device, slot.timestampPool, nullptr);
+    if (slot.statisticsPool != VK_NULL_HANDLE) {
+      vkDestroyQueryPool(device, slot.statisticsPool, nullptr);
+    }
+  }
+}
+
+double LveProfiler::ticksToMilliseconds(uint64_t ticks) const {
+  return static_cast<double>(ticks) * timestampPeriod / 1000000.0;
+}
+
+void LveProfiler::beginFrame(VkCommandBuffer commandBuffer) {
+  if (!timestampsSupported) return;
+
+  currentSlot = static_cast<uint32_t>(frameCounter % FRAME_RING_SIZE);
+  FrameSlot &slot = slots[currentSlot];
+  collect(slot);
+
+  slot.scopes.clear();
+  slot.statisticsQueries = 0;
+  slot.frameNumber = frameCounter++;
+  slot.recorded = true;
+  openDepth = 0;
+
+  vkCmdResetQueryPool(commandBuffer, slot.timestampPool, 0, MAX_SCOPES_PER_FRAME * 2);
+  if (statisticsSupported) {
+    vkCmdResetQueryPool(commandBuffer, slot.statisticsPool, 0, MAX_SCOPES_PER_FRAME);
+  }
+}
+
+uint32_t LveProfiler::beginScope(
+    VkCommandBuffer commandBuffer, const std::string &name, bool pipelineStatistics) {
+  if (!timestampsSupported || frameCounter == 0) return INVALID_SCOPE;
+  FrameSlot &slot = slots[currentSlot];
+  if (slot.scopes.size() >= MAX_SCOPES_PER_FRAME) {
+    droppedScopes++;
+    return INVALID_SCOPE;
+  }
+
+  uint32_t index = static_cast<uint32_t>(slot.scopes.size());
+  Scope scope{name, openDepth++, INVALID_SCOPE, false};
+  vkCmdWriteTimestamp(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      slot.timestampPool,
+      index * 2);
+  if (pipelineStatistics && statisticsSupported) {
+    scope.statisticsQuery = slot.statisticsQueries++;
+    vkCmdBeginQuery(commandBuffer, slot.statisticsPool, scope.statisticsQuery, 0);
+  }
+  slot.scopes.push_back(scope);
+  return index;
+}
+
+void LveProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+  if (scope == INVALID_SCOPE) return;
+  FrameSlot &slot = slots[currentSlot];
+  Scope &entry = slot.scopes[scope];
+
+  if (entry.statisticsQuery != INVALID_SCOPE) {
+    vkCmdEndQuery(commandBuffer, slot.statisticsPool, entry.statisticsQuery);
+  }
+  vkCmdWriteTimestamp(
+      commandBuffer,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      slot.timestampPool,
+      scope * 2 + 1);
+  entry.ended = true;
+  openDepth--;
+}
+
+void LveProfiler::collect(FrameSlot &slot) {
+  if (!slot.recorded) return;
+  slot.recorded = false;
+  if (slot.scopes.empty()) return;
+
+  // every query is followed by its availability word, so nothing here waits on the GPU
+  uint32_t timestampCount = static_cast<uint32_t>(slot.scopes.size()) * 2;
+  std::vector<uint64_t> timestamps(timestampCount * 2);
+  vkGetQueryPoolResults(
+      device,
+      slot.timestampPool,
+      0,
+      timestampCount,
+      timestamps.size() * sizeof(uint64_t),
+      timestamps.data(),
+      2 * sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+  const uint32_t statisticsStride = PIPELINE_STATISTIC_COUNT + 1;
+  std::vector<uint64_t> statistics(slot.statisticsQueries * statisticsStride);
+  if (slot.statisticsQueries > 0) {
+    vkGetQueryPoolResults(
+        device,
+        slot.statisticsPool,
+        0,
+        slot.statisticsQueries,
+        statistics.size() * sizeof(uint64_t),
+        statistics.data(),
+        statisticsStride * sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  }
+
+  for (size_t i = 0; i < slot.scopes.size(); i++) {
+    const Scope &scope = slot.scopes[i];
+    const uint64_t *begin = &timestamps[i * 4];
+    const uint64_t *end = &timestamps[i * 4 + 2];
+    if (!scope.ended || begin[1] == 0 || end[1] == 0) {
+      droppedScopes++;
+      continue;
+    }
+
+    uint64_t beginTicks = begin[0] & timestampMask;
+    uint64_t endTicks = end[0] & timestampMask;
+    // masking the difference also handles a counter that wrapped inside the scope
+    double milliseconds = ticksToMilliseconds((endTicks - beginTicks) & timestampMask);
+
+    RollingAverage &average = averages[scope.name];
+    average.samples.push_back(milliseconds);
+    average.sum += milliseconds;
+    average.last = milliseconds;
+    if (average.samples.size() > AVERAGE_WINDOW) {
+      average.sum -= average.samples.front();
+      average.samples.pop_front();
+    }
+
+    LvePipelineStatistics values{};
+    bool hasStatistics = false;
+    if (scope.statisticsQuery != INVALID_SCOPE) {
+      const uint64_t *result = &statistics[scope.statisticsQuery * statisticsStride];
+      hasStatistics = result[PIPELINE_STATISTIC_COUNT] != 0;
+      if (hasStatistics) {
+        values.inputAssemblyVertices = result[0];
+        values.inputAssemblyPrimitives = result[1];
+        values.vertexShaderInvocations = result[2];
+        values.clippingPrimitives = result[3];
+        values.fragmentShaderInvocations = result[4];
+        values.computeShaderInvocations = result[5];
+        average.hasStatistics = true;
+        average.lastStatistics = values;
+      }
+    }
+
+    if (tracing && traceEvents.size() < MAX_TRACE_EVENTS) {
+      if (!traceStartValid) {
+        traceStartTicks = beginTicks;
+        traceStartValid = true;
+      }
+      traceEvents.push_back(
+          {scope.name, slot.frameNumber, scope.depth, beginTicks, endTicks, hasStatistics, values});
+    }
+  }
+}
+
+std::vector<LveProfileScopeStats> LveProfiler::getAverages() const {
+  std::vector<LveProfileScopeStats> result;
+  for (const auto &entry : averages) {
+    LveProfileScopeStats stats{};
+    stats.name = entry.first;
+    stats.samples = static_cast<uint32_t>(entry.second.samples.size());
+    stats.averageMilliseconds = stats.samples > 0 ? entry.second.sum / stats.samples : 0.0;
+    stats.lastMilliseconds = entry.second.last;
+    stats.hasStatistics = entry.second.hasStatistics;
+    stats.lastStatistics = entry.second.lastStatistics;
+    result.push_back(stats);
+  }
+  return result;
+}
+
+void LveProfiler::printAverages(std::ostream &out) const {
+  if (!timestampsSupported) {
+    out << "gpu profiler: timestamps not supported on the graphics queue" << std::endl;
+    return;
+  }
+  out << "gpu profiler: average of the last " << AVERAGE_WINDOW << " frames, " << droppedScopes
+      << " scopes dropped" << std::endl;
+  for (const auto &stats : getAverages()) {
+    out << "\t" << std::fixed << std::setprecision(3) << stats.averageMilliseconds << " ms  "
+        << stats.name;
+    if (stats.hasStatistics) {
+      out << "  (" << stats.lastStatistics.inputAssemblyPrimitives << " primitives, "
+          << stats.lastStatistics.vertexShaderInvocations << " vs, "
+          << stats.lastStatistics.fragmentShaderInvocations << " fs invocations)";
+    }
+    out << std::defaultfloat << std::endl;
+  }
+}
+
+void LveProfiler::startTrace() {
+  tracing = true;
+  traceStartValid = false;
+  traceEvents.clear();
+}
+
+void LveProfiler::writeChromeTrace(const std::string &path) {
+  // oldest first, so events stay in frame order
+  for (uint32_t i = 1; i <= slots.size(); i++) {
+    collect(slots[(currentSlot + i) % slots.size()]);
+  }
+
+  std::ofstream out{path};
+  if (!out.is_open()) {
+    throw std::runtime_error("failed to open " + path + "!");
+  }
+
+  // complete ("X") events in microseconds; nested scopes stack by time on a single track
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  out << std::fixed << std::setprecision(3);
+  for (size_t i = 0; i < traceEvents.size(); i++) {
+    const TraceEvent &event = traceEvents[i];
+    double start = ticksToMilliseconds((event.beginTicks - traceStartTicks) & timestampMask);
+    double duration = ticksToMilliseconds((event.endTicks - event.beginTicks) & timestampMask);
+    out << "  {\"name\": \"" << escapeJson(event.name)
+        << "\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, \"ts\": "
+        << start * 1000.0 << ", \"dur\": " << duration * 1000.0
+        << ", \"args\": {\"frame\": " << event.frameNumber << ", \"depth\": " << event.depth;
+    if (event.hasStatistics) {
+      const LvePipelineStatistics &statistics = event.statistics;
+      out << ", \"ia_vertices\": " << statistics.inputAssemblyVertices
+          << ", \"ia_primitives\": " << statistics.inputAssemblyPrimitives
+          << ", \"vs_invocations\": " << statistics.vertexShaderInvocations
+          << ", \"clipping_primitives\": " << statistics.clippingPrimitives
+          << ", \"fs_invocations\": " << statistics.fragmentShaderInvocations
+          << ", \"cs_invocations\": " << statistics.computeShaderInvocations;
+    }
+    out << "}}" << (i + 1 < traceEvents.size() ? "," : "") << "\n";
+  }
+  out << "]}" << std::endl;
+
+  traceEvents.clear();
+  traceStartValid = false;
+}
+
+}  // namespace lve
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+struct LvePipelineStatistics {
+  uint64_t inputAssemblyVertices = 0;
+  uint64_t inputAssemblyPrimitives = 0;
+  uint64_t vertexShaderInvocations = 0;
+  uint64_t clippingPrimitives = 0;
+  uint64_t fragmentShaderInvocations = 0;
+  uint64_t computeShaderInvocations = 0;
+};
+
+struct LveProfileScopeStats {
+  std::string name;
+  double averageMilliseconds = 0.0;  // over the last AVERAGE_WINDOW samples
+  double lastMilliseconds = 0.0;
+  uint32_t samples = 0;
+  bool hasStatistics = false;
+  LvePipelineStatistics lastStatistics;
+};
+
+// GPU timestamp and pipeline-statistics queries for the graphics queue. Every frame gets its
+// own query pools out of a ring of FRAME_RING_SIZE, and a frame's results are read when its
+// slot comes around again, by which point the renderer has already waited on that frame's fence.
+// Reading never blocks: queries that are somehow still unavailable are dropped.
+//
+// Not thread safe; scopes are meant to be recorded on the render thread.
+class LveProfiler {
+ public:
+  static constexpr uint32_t FRAME_RING_SIZE = 4;
+  static constexpr uint32_t MAX_SCOPES_PER_FRAME = 256;
+  static constexpr size_t AVERAGE_WINDOW = 120;
+  static constexpr size_t MAX_TRACE_EVENTS = 1 << 20;
+  static constexpr uint32_t INVALID_SCOPE = ~0u;
+
+  LveProfiler(
+      VkDevice device,
+      const VkPhysicalDeviceProperties &properties,
+      uint32_t timestampValidBits,
+      bool pipelineStatisticsSupported);
+  ~LveProfiler();
+
+  LveProfiler(const LveProfiler &) = delete;
+  LveProfiler &operator=(const LveProfiler &) = delete;
+
+  bool isEnabled() const { return timestampsSupported; }
+
+  // Collects the results of the frame that last used the next slot and resets its pools.
+  // Must be recorded outside of a render pass, before any scope of the frame.
+  void beginFrame(VkCommandBuffer commandBuffer);
+
+  // Pipeline statistics scopes must begin and end in the same subpass or both outside of a render
+  // pass, and must not nest inside each other.
+  uint32_t beginScope(
+      VkCommandBuffer commandBuffer, const std::string &name, bool pipelineStatistics = false);
+  void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+  std::vector<LveProfileScopeStats> getAverages() const;
+  void printAverages(std::ostream &out) const;
+
+  // Resolved scopes are kept as Chrome trace events (chrome://tracing, Perfetto) from
+  // startTrace until writeChromeTrace, which also clears them. writeChromeTrace first collects
+  // every pending frame, so call it once the device is idle to include the last frames.
+  void startTrace();
+  void writeChromeTrace(const std::string &path);
+
+ private:
+  struct Scope {
+    std::string name;
+    uint32_t depth;
+    uint32_t statisticsQuery;  // INVALID_SCOPE when not collecting statistics
+    bool ended;
+  };
+
+  struct FrameSlot {
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    VkQueryPool statisticsPool = VK_NULL_HANDLE;
+    uint64_t frameNumber = 0;
+    bool recorded = false;
+    uint32_t statisticsQueries = 0;
+    std::vector<Scope> scopes;
+  };
+
+  struct TraceEvent {
+    std::string name;
+    uint64_t frameNumber;
+    uint32_t depth;
+    uint64_t beginTicks;
+    uint64_t endTicks;
+    bool hasStatistics;
+    LvePipelineStatistics statistics;
+  };
+
+  struct RollingAverage {
+    std::deque<double> samples;
+    double sum = 0.0;
+    double last = 0.0;
+    bool hasStatistics = false;
+    LvePipelineStatistics lastStatistics;
+  };
+
+  void collect(FrameSlot &slot);
+  double ticksToMilliseconds(uint64_t ticks) const;
+
+  VkDevice device;
+  bool timestampsSupported;
+  bool statisticsSupported;
+  double timestampPeriod;  // nanoseconds per tick
+  uint64_t timestampMask;
+
+  std::vector<FrameSlot> slots;
+  uint32_t currentSlot = 0;
+  uint64_t frameCounter = 0;
+  uint32_t openDepth = 0;
+  uint64_t droppedScopes = 0;
+
+  std::map<std::string, RollingAverage> averages;
+  bool tracing = false;
+  uint64_t traceStartTicks = 0;
+  bool traceStartValid = false;
+  std::vector<TraceEvent> traceEvents;
+};
+
+// Profiles the commands recorded during its lifetime.
+class LveProfileScope {
+ public:
+  LveProfileScope(
+      LveProfiler &profiler,
+      VkCommandBuffer commandBuffer,
+      const std::string &name,
+      bool pipelineStatistics = false)
+      : profiler{profiler},
+        commandBuffer{commandBuffer},
+        scope{profiler.beginScope(commandBuffer, name, pipelineStatistics)} {}
+  ~LveProfileScope() { profiler.endScope(commandBuffer, scope); }
+
+  LveProfileScope(const LveProfileScope &) = delete;
+  LveProfileScope &operator=(const LveProfileScope &) = delete;
+
+ private:
+  LveProfiler &profiler;
+  VkCommandBuffer commandBuffer;
+  uint32_t scope;
+};
+
+}  // namespace lve
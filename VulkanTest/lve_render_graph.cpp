@@ -0,0 +1,896 @@
+#include "lve_render_graph.hpp"
+
+#include "lve_pipeline.hpp"
+
+// std headers
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+constexpr VkAccessFlags2KHR WRITE_ACCESS =
+    VK_ACCESS_2_SHADER_WRITE_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR |
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR | VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR |
+    VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+
+bool hasStencil(VkFormat format) {
+  return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+         format == VK_FORMAT_D16_UNORM_S8_UINT;
+}
+
+VkImageUsageFlags usageFlagFor(LveRenderGraphUsage usage) {
+  switch (usage) {
+    case LveRenderGraphUsage::ColorAttachment:
+      return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    case LveRenderGraphUsage::DepthAttachment:
+    case LveRenderGraphUsage::DepthReadOnly:
+      return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    case LveRenderGraphUsage::Sampled:
+      return VK_IMAGE_USAGE_SAMPLED_BIT;
+    case LveRenderGraphUsage::StorageRead:
+    case LveRenderGraphUsage::StorageWrite:
+      return VK_IMAGE_USAGE_STORAGE_BIT;
+    case LveRenderGraphUsage::TransferSrc:
+      return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    case LveRenderGraphUsage::TransferDst:
+      return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  }
+  return 0;
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+double mebibytes(VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+}  // namespace
+
+LveRenderGraph::LveRenderGraph(LveDevice &device, uint32_t framesInFlight)
+    : device{device}, framesInFlight{framesInFlight} {}
+
+LveRenderGraph::~LveRenderGraph() { destroyResources(); }
+
+LveRenderGraph::Image LveRenderGraph::createImage(
+    std::string name, VkFormat format, VkExtent2D extent) {
+  if (compiled) {
+    throw std::runtime_error("failed to add image " + name + " to a compiled render graph!");
+  }
+  ImageState image{};
+  image.name = std::move(name);
+  image.format = format;
+  image.extent = extent;
+  images.push_back(std::move(image));
+  return static_cast<Image>(images.size() - 1);
+}
+
+LveRenderGraph::Image LveRenderGraph::importImage(
+    std::string name,
+    VkFormat format,
+    VkExtent2D extent,
+    VkImageLayout initialLayout,
+    VkImageLayout finalLayout,
+    VkPipelineStageFlags2KHR availableStage) {
+  Image image = createImage(std::move(name), format, extent);
+  images[image].imported = true;
+  images[image].initialLayout = initialLayout;
+  images[image].finalLayout = finalLayout;
+  images[image].availableStage = availableStage;
+  return image;
+}
+
+void LveRenderGraph::setImportedImage(Image image, VkImage handle, VkImageView view) {
+  if (!images.at(image).imported) {
+    throw std::runtime_error("render graph image " + images[image].name + " is not imported!");
+  }
+  images[image].handle = handle;
+  images[image].view = view;
+  std::vector<VkImageView> &importedViews = images[image].importedViews;
+  if (std::find(importedViews.begin(), importedViews.end(), view) == importedViews.end()) {
+    importedViews.push_back(view);
+  }
+}
+
+void LveRenderGraph::invalidateImportedImage(Image image) {
+  if (!images.at(image).imported) {
+    throw std::runtime_error("render graph image " + images[image].name + " is not imported!");
+  }
+  std::vector<VkImageView> &importedViews = images[image].importedViews;
+  for (PassState &pass : passes) {
+    for (auto it = pass.framebuffers.begin(); it != pass.framebuffers.end();) {
+      bool usesImage = std::any_of(
+          it->first.begin(), it->first.end(), [&importedViews](VkImageView view) {
+            return std::find(importedViews.begin(), importedViews.end(), view) !=
+                   importedViews.end();
+          });
+      if (usesImage) {
+        retiredFramebuffers.push_back({it->second, executeCount});
+        it = pass.framebuffers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  importedViews.clear();
+  images[image].handle = VK_NULL_HANDLE;
+  images[image].view = VK_NULL_HANDLE;
+}
+
+LveRenderGraph::Pass LveRenderGraph::addPass(std::string name, ExecuteFunction execute) {
+  if (compiled) {
+    throw std::runtime_error("failed to add pass " + name + " to a compiled render graph!");
+  }
+  PassState pass{};
+  pass.name = std::move(name);
+  pass.execute = std::move(execute);
+  passes.push_back(std::move(pass));
+  return static_cast<Pass>(passes.size() - 1);
+}
+
+void LveRenderGraph::use(Pass pass, Image image, LveRenderGraphUsage usage) {
+  if (image >= images.size()) {
+    throw std::runtime_error("render graph pass " + passes.at(pass).name + " uses no image!");
+  }
+  passes.at(pass).uses.push_back({image, usage});
+}
+
+void LveRenderGraph::clearColor(Pass pass, Image image, VkClearColorValue color) {
+  VkClearValue value{};
+  value.color = color;
+  passes.at(pass).clears[image] = value;
+}
+
+void LveRenderGraph::clearDepth(Pass pass, Image image, float depth) {
+  VkClearValue value{};
+  value.depthStencil = {depth, 0};
+  passes.at(pass).clears[image] = value;
+}
+
+void LveRenderGraph::keepPass(Pass pass) { passes.at(pass).kept = true; }
+
+void LveRenderGraph::compile() {
+  if (compiled) {
+    throw std::runtime_error("render graph compiled twice!");
+  }
+  stats_ = {};
+  stats_.declaredPasses = static_cast<uint32_t>(passes.size());
+
+  // a pass may name an image several times, e.g. as depth test and sampler, in one layout only
+  for (const PassState &pass : passes) {
+    for (const ImageUse &use : pass.uses) {
+      for (const ImageUse &other : pass.uses) {
+        if (other.image == use.image && layoutFor(other) != layoutFor(use)) {
+          throw std::runtime_error(
+              "render graph pass " + pass.name + " uses " + images[use.image].name +
+              " in two layouts!");
+        }
+      }
+    }
+  }
+
+  try {
+    cullPasses();
+    computeLifetimes();
+    createTransientImages();
+    createRenderPasses();
+    planBarriers();
+  } catch (...) {
+    destroyResources();
+    throw;
+  }
+  compiled = true;
+}
+
+void LveRenderGraph::cullPasses() {
+  // walking backwards from what leaves the frame, a pass is needed when it writes something a
+  // needed pass reads; images stay needed all the way up, which keeps every earlier writer
+  std::vector<bool> needed(images.size(), false);
+  for (Image image = 0; image < images.size(); image++) {
+    needed[image] = images[image].imported;
+  }
+  for (size_t i = passes.size(); i-- > 0;) {
+    PassState &pass = passes[i];
+    pass.scheduled = pass.kept;
+    for (const ImageUse &use : pass.uses) {
+      if (isWrite(use.usage) && needed[use.image]) pass.scheduled = true;
+    }
+    if (!pass.scheduled) continue;
+    for (const ImageUse &use : pass.uses) {
+      if (readsContents(pass, use)) needed[use.image] = true;
+    }
+  }
+
+  schedule.clear();
+  for (Pass pass = 0; pass < passes.size(); pass++) {
+    if (passes[pass].scheduled) schedule.push_back(pass);
+  }
+  stats_.scheduledPasses = static_cast<uint32_t>(schedule.size());
+}
+
+void LveRenderGraph::computeLifetimes() {
+  std::vector<bool> written(images.size(), false);
+  for (uint32_t index = 0; index < schedule.size(); index++) {
+    const PassState &pass = passes[schedule[index]];
+    for (const ImageUse &use : pass.uses) {
+      ImageState &image = images[use.image];
+      image.firstUse = std::min(image.firstUse, index);
+      image.lastUse = std::max(image.lastUse, index);
+      image.usageFlags |= usageFlagFor(use.usage);
+
+      // attachments and storage images written without being cleared start out undefined
+      // instead; imported images come with whatever they hold
+      bool hasContents = written[use.image] || image.imported;
+      bool readOnly = use.usage == LveRenderGraphUsage::Sampled ||
+                      use.usage == LveRenderGraphUsage::StorageRead ||
+                      use.usage == LveRenderGraphUsage::TransferSrc ||
+                      use.usage == LveRenderGraphUsage::DepthReadOnly;
+      if (!hasContents && readOnly) {
+        throw std::runtime_error(
+            "render graph pass " + pass.name + " reads " + image.name +
+            " before any pass writes it!");
+      }
+    }
+    for (const ImageUse &use : pass.uses) {
+      if (isWrite(use.usage)) written[use.image] = true;
+    }
+  }
+}
+
+void LveRenderGraph::createTransientImages() {
+  std::map<uint32_t, std::vector<Image>> byMemoryType;
+  for (Image index = 0; index < images.size(); index++) {
+    ImageState &image = images[index];
+    if (image.imported || image.firstUse == UINT32_MAX) continue;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = image.extent.width;
+    imageInfo.extent.height = image.extent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = image.format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = image.usageFlags;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(device.device(), &imageInfo, nullptr, &image.handle) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create render graph image " + image.name + "!");
+    }
+    vkGetImageMemoryRequirements(device.device(), image.handle, &image.requirements);
+    uint32_t memoryTypeIndex = device.findMemoryType(
+        image.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    byMemoryType[memoryTypeIndex].push_back(index);
+
+    stats_.transientImages++;
+    stats_.transientBytes += image.requirements.size;
+  }
+
+  // one allocation per memory type, shared by every image of that type
+  for (auto &entry : byMemoryType) {
+    MemoryGroup group{};
+    group.memoryTypeIndex = entry.first;
+    placeImages(entry.second, group);
+
+    VkMemoryRequirements requirements{};
+    requirements.size = group.size;
+    requirements.alignment = group.alignment;
+    requirements.memoryTypeBits = 1u << group.memoryTypeIndex;
+    group.allocation = device.allocator().allocate(
+        requirements,
+        group.memoryTypeIndex,
+        LveResourceKind::OptimalImage,
+        LveMemoryCategory::RenderTarget);
+    memoryGroups.push_back(group);
+    stats_.aliasedBytes += group.size;
+
+    for (Image index : entry.second) {
+      ImageState &image = images[index];
+      image.memoryGroup = static_cast<uint32_t>(memoryGroups.size() - 1);
+      if (vkBindImageMemory(
+              device.device(),
+              image.handle,
+              group.allocation->memory,
+              group.allocation->offset + image.offset) != VK_SUCCESS) {
+        throw std::runtime_error("failed to bind render graph image " + image.name + "!");
+      }
+
+      VkImageViewCreateInfo viewInfo{};
+      viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      viewInfo.image = image.handle;
+      viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+      viewInfo.format = image.format;
+      viewInfo.subresourceRange.aspectMask =
+          isDepthFormat(image.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+      viewInfo.subresourceRange.baseMipLevel = 0;
+      viewInfo.subresourceRange.levelCount = 1;
+      viewInfo.subresourceRange.baseArrayLayer = 0;
+      viewInfo.subresourceRange.layerCount = 1;
+      if (vkCreateImageView(device.device(), &viewInfo, nullptr, &image.view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render graph image view " + image.name + "!");
+      }
+    }
+  }
+}
+
+void LveRenderGraph::placeImages(std::vector<Image> &placed, MemoryGroup &group) {
+  // largest first, each at the lowest offset not taken by an image alive at the same time
+  std::sort(placed.begin(), placed.end(), [this](Image a, Image b) {
+    if (images[a].requirements.size != images[b].requirements.size) {
+      return images[a].requirements.size > images[b].requirements.size;
+    }
+    return images[a].firstUse < images[b].firstUse;
+  });
+
+  for (size_t i = 0; i < placed.size(); i++) {
+    ImageState &image = images[placed[i]];
+    VkDeviceSize size = image.requirements.size;
+    VkDeviceSize offset = 0;
+    bool moved = true;
+    while (moved) {
+      moved = false;
+      for (size_t j = 0; j < i; j++) {
+        const ImageState &other = images[placed[j]];
+        bool aliveTogether = image.firstUse <= other.lastUse && other.firstUse <= image.lastUse;
+        bool overlaps =
+            offset < other.offset + other.requirements.size && other.offset < offset + size;
+        if (aliveTogether && overlaps) {
+          offset = alignUp(other.offset + other.requirements.size, image.requirements.alignment);
+          moved = true;
+        }
+      }
+    }
+    image.offset = offset;
+    group.size = std::max(group.size, offset + size);
+    group.alignment = std::max(group.alignment, image.requirements.alignment);
+  }
+}
+
+void LveRenderGraph::createRenderPasses() {
+  for (uint32_t index = 0; index < schedule.size(); index++) {
+    PassState &pass = passes[schedule[index]];
+    std::vector<const ImageUse *> colors;
+    const ImageUse *depth = nullptr;
+    for (const ImageUse &use : pass.uses) {
+      if (use.usage == LveRenderGraphUsage::ColorAttachment) colors.push_back(&use);
+      if (use.usage == LveRenderGraphUsage::DepthAttachment ||
+          use.usage == LveRenderGraphUsage::DepthReadOnly) {
+        depth = &use;
+      }
+    }
+    if (colors.empty() && depth == nullptr) continue;
+
+    std::vector<const ImageUse *> attachmentUses = colors;
+    if (depth != nullptr) attachmentUses.push_back(depth);
+    std::vector<VkAttachmentDescription> attachments;
+    for (const ImageUse *use : attachmentUses) {
+      const ImageState &image = images[use->image];
+      if (image.extent.width != images[attachmentUses[0]->image].extent.width ||
+          image.extent.height != images[attachmentUses[0]->image].extent.height) {
+        throw std::runtime_error(
+            "render graph pass " + pass.name + " has attachments of different extents!");
+      }
+
+      auto clear = pass.clears.find(use->image);
+      bool hasContents = image.firstUse < index ||
+                         (image.imported && image.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+      bool readLater = image.lastUse > index || image.imported;
+
+      VkAttachmentDescription attachment{};
+      attachment.format = image.format;
+      attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+      attachment.loadOp = clear != pass.clears.end() ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                          : hasContents              ? VK_ATTACHMENT_LOAD_OP_LOAD
+                                                     : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+      attachment.storeOp = readLater || use->usage == LveRenderGraphUsage::DepthReadOnly
+                               ? VK_ATTACHMENT_STORE_OP_STORE
+                               : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      attachment.stencilLoadOp = attachment.loadOp;
+      attachment.stencilStoreOp = attachment.storeOp;
+      // the graph's barriers do the transitions, the render pass none
+      attachment.initialLayout = layoutFor(*use);
+      attachment.finalLayout = layoutFor(*use);
+      attachments.push_back(attachment);
+
+      pass.attachments.push_back(use->image);
+      pass.clearValues.push_back(clear != pass.clears.end() ? clear->second : VkClearValue{});
+    }
+    pass.extent = images[pass.attachments[0]].extent;
+
+    std::vector<VkAttachmentReference> colorReferences;
+    for (uint32_t i = 0; i < colors.size(); i++) {
+      colorReferences.push_back({i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+    }
+    VkAttachmentReference depthReference{};
+    if (depth != nullptr) {
+      depthReference.attachment = static_cast<uint32_t>(colors.size());
+      depthReference.layout = layoutFor(*depth);
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+    subpass.pColorAttachments = colorReferences.data();
+    subpass.pDepthStencilAttachment = depth != nullptr ? &depthReference : nullptr;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &pass.renderPass) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create render pass for " + pass.name + "!");
+    }
+  }
+}
+
+void LveRenderGraph::planBarriers() {
+  struct Access {
+    VkImageLayout layout;
+    VkPipelineStageFlags2KHR stages = VK_PIPELINE_STAGE_2_NONE_KHR;
+    VkAccessFlags2KHR access = VK_ACCESS_2_NONE_KHR;
+    bool write = false;
+  };
+  struct FirstUse {
+    size_t batch;
+    size_t barrier;
+  };
+
+  std::vector<SyncState> states(images.size());
+  std::vector<FirstUse> transientFirstUses;
+  passBarriers.assign(schedule.size(), {});
+
+  auto barrierFor = [this](Image image) {
+    VkImageMemoryBarrier2KHR barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    VkFormat format = images[image].format;
+    barrier.subresourceRange.aspectMask =
+        !isDepthFormat(format) ? VK_IMAGE_ASPECT_COLOR_BIT
+        : hasStencil(format)   ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+                               : VK_IMAGE_ASPECT_DEPTH_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+  };
+
+  for (size_t index = 0; index < schedule.size(); index++) {
+    const PassState &pass = passes[schedule[index]];
+    std::map<Image, Access> accesses;
+    for (const ImageUse &use : pass.uses) {
+      Access &access = accesses.emplace(use.image, Access{layoutFor(use)}).first->second;
+      access.stages |= stagesFor(pass, use);
+      access.access |= accessFor(pass, use);
+      access.write = access.write || isWrite(use.usage);
+    }
+    stats_.imageUses += static_cast<uint32_t>(accesses.size());
+
+    for (const auto &entry : accesses) {
+      const ImageState &image = images[entry.first];
+      const Access &access = entry.second;
+      SyncState &state = states[entry.first];
+
+      VkImageMemoryBarrier2KHR barrier = barrierFor(entry.first);
+      bool transition = !state.used || access.layout != state.layout;
+      bool needed = true;
+      if (!state.used && image.imported) {
+        barrier.srcStageMask = image.availableStage;
+        barrier.srcAccessMask = image.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED
+                                    ? VK_ACCESS_2_NONE_KHR
+                                    : VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+        barrier.oldLayout = image.initialLayout;
+      } else if (!state.used) {
+        // discards the contents; what it waits for is filled in once every image's last use
+        // is known, below
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        transientFirstUses.push_back({index, passBarriers[index].size()});
+      } else if (transition || access.write) {
+        // write after read needs the readers done, write after write the write available
+        barrier.srcStageMask = state.writeStages | state.visibleStages;
+        barrier.srcAccessMask = state.writeAccess;
+        barrier.oldLayout = state.layout;
+      } else if ((access.stages & ~state.visibleStages) || (access.access & ~state.visibleAccess)) {
+        barrier.srcStageMask = state.writeStages;
+        barrier.srcAccessMask = state.writeAccess;
+        barrier.oldLayout = state.layout;
+      } else {
+        // an earlier barrier already made the last write visible to these reads
+        needed = false;
+      }
+
+      if (needed) {
+        barrier.dstStageMask = access.stages;
+        barrier.dstAccessMask = access.access;
+        barrier.newLayout = access.layout;
+        passBarriers[index].push_back({entry.first, barrier});
+      }
+
+      if (access.write) {
+        state.writeStages = access.stages;
+        state.writeAccess = access.access & WRITE_ACCESS;
+        state.visibleStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+        state.visibleAccess = VK_ACCESS_2_NONE_KHR;
+      } else if (transition) {
+        // later reads in other stages chain onto the stages the transition finished before
+        state.writeStages = access.stages;
+        state.writeAccess = VK_ACCESS_2_NONE_KHR;
+        state.visibleStages = access.stages;
+        state.visibleAccess = access.access;
+      } else {
+        state.visibleStages |= access.stages;
+        state.visibleAccess |= access.access;
+      }
+      state.layout = access.layout;
+      state.used = true;
+    }
+  }
+
+  // The first use of a transient image has to wait for whatever last used its memory: an image
+  // aliasing it earlier in the frame, or any image there, itself included, in the previous frame.
+  for (const FirstUse &firstUse : transientFirstUses) {
+    PlannedBarrier &planned = passBarriers[firstUse.batch][firstUse.barrier];
+    const ImageState &image = images[planned.image];
+    for (Image other = 0; other < images.size(); other++) {
+      const ImageState &candidate = images[other];
+      if (candidate.imported || candidate.memoryGroup != image.memoryGroup) continue;
+      if (candidate.offset >= image.offset + image.requirements.size ||
+          image.offset >= candidate.offset + candidate.requirements.size) {
+        continue;
+      }
+      planned.barrier.srcStageMask |= states[other].writeStages | states[other].visibleStages;
+      planned.barrier.srcAccessMask |= states[other].writeAccess;
+    }
+  }
+
+  finalBarriers.clear();
+  for (Image index = 0; index < images.size(); index++) {
+    const ImageState &image = images[index];
+    const SyncState &state = states[index];
+    // execute only asks for the handles of images a scheduled pass uses; leave the rest alone
+    if (!image.imported || !state.used || image.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+    VkImageLayout layout = state.layout;
+    if (layout == image.finalLayout) continue;
+
+    // whatever uses the image next waits on a semaphore or fence, which covers all stages
+    VkImageMemoryBarrier2KHR barrier = barrierFor(index);
+    barrier.srcStageMask = state.writeStages | state.visibleStages;
+    barrier.srcAccessMask = state.writeAccess;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE_KHR;
+    barrier.dstAccessMask = VK_ACCESS_2_NONE_KHR;
+    barrier.oldLayout = layout;
+    barrier.newLayout = image.finalLayout;
+    finalBarriers.push_back({index, barrier});
+  }
+
+  for (const auto &batch : passBarriers) {
+    if (!batch.empty()) stats_.barrierBatches++;
+    stats_.imageBarriers += static_cast<uint32_t>(batch.size());
+  }
+  if (!finalBarriers.empty()) stats_.barrierBatches++;
+  stats_.imageBarriers += static_cast<uint32_t>(finalBarriers.size());
+}
+
+void LveRenderGraph::execute(VkCommandBuffer commandBuffer) {
+  if (!compiled) {
+    throw std::runtime_error("render graph executed before it was compiled!");
+  }
+  for (const ImageState &image : images) {
+    if (image.imported && image.firstUse != UINT32_MAX && image.handle == VK_NULL_HANDLE) {
+      throw std::runtime_error("render graph image " + image.name + " was never set!");
+    }
+  }
+  destroyRetiredFramebuffers(false);
+
+  for (size_t index = 0; index < schedule.size(); index++) {
+    PassState &pass = passes[schedule[index]];
+    recordBarriers(commandBuffer, passBarriers[index]);
+
+    if (pass.renderPass != VK_NULL_HANDLE) {
+      VkRenderPassBeginInfo renderPassInfo{};
+      renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+      renderPassInfo.renderPass = pass.renderPass;
+      renderPassInfo.framebuffer = framebufferFor(pass);
+      renderPassInfo.renderArea.offset = {0, 0};
+      renderPassInfo.renderArea.extent = pass.extent;
+      renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+      renderPassInfo.pClearValues = pass.clearValues.data();
+      vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+      LvePipeline::setViewportAndScissor(commandBuffer, pass.extent);
+    }
+    if (pass.execute) pass.execute(commandBuffer);
+    if (pass.renderPass != VK_NULL_HANDLE) {
+      vkCmdEndRenderPass(commandBuffer);
+    }
+  }
+  recordBarriers(commandBuffer, finalBarriers);
+  executeCount++;
+}
+
+VkFramebuffer LveRenderGraph::framebufferFor(PassState &pass) {
+  std::vector<VkImageView> views;
+  for (Image image : pass.attachments) {
+    views.push_back(images[image].view);
+  }
+  auto it = pass.framebuffers.find(views);
+  if (it != pass.framebuffers.end()) return it->second;
+
+  // imported attachments get one per view they are set to, e.g. per swap chain image, until
+  // invalidateImportedImage
+  VkFramebufferCreateInfo framebufferInfo{};
+  framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  framebufferInfo.renderPass = pass.renderPass;
+  framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+  framebufferInfo.pAttachments = views.data();
+  framebufferInfo.width = pass.extent.width;
+  framebufferInfo.height = pass.extent.height;
+  framebufferInfo.layers = 1;
+  VkFramebuffer framebuffer;
+  if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create framebuffer for " + pass.name + "!");
+  }
+  pass.framebuffers.emplace(views, framebuffer);
+  return framebuffer;
+}
+
+void LveRenderGraph::destroyRetiredFramebuffers(bool all) {
+  // executed once per frame, so once framesInFlight more frames have been recorded beginFrame
+  // has waited for every frame that used a retired framebuffer
+  auto done = [this, all](const RetiredFramebuffer &retired) {
+    if (!all && executeCount - retired.retiredAt <= framesInFlight) return false;
+    vkDestroyFramebuffer(device.device(), retired.framebuffer, nullptr);
+    return true;
+  };
+  retiredFramebuffers.erase(
+      std::remove_if(retiredFramebuffers.begin(), retiredFramebuffers.end(), done),
+      retiredFramebuffers.end());
+}
+
+void LveRenderGraph::recordBarriers(
+    VkCommandBuffer commandBuffer, const std::vector<PlannedBarrier> &planned) {
+  if (planned.empty()) return;
+  barrierScratch.clear();
+  for (const PlannedBarrier &entry : planned) {
+    barrierScratch.push_back(entry.barrier);
+    barrierScratch.back().image = images[entry.image].handle;
+  }
+
+  if (PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2 = device.pipelineBarrier2()) {
+    VkDependencyInfoKHR dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barrierScratch.size());
+    dependencyInfo.pImageMemoryBarriers = barrierScratch.data();
+    pipelineBarrier2(commandBuffer, &dependencyInfo);
+    return;
+  }
+
+  // Without synchronization2 the batch is one vkCmdPipelineBarrier with the stages merged. The
+  // stages and accesses used here have the same bits in both, only the 64-bit masks are wider.
+  VkPipelineStageFlags srcStages = 0;
+  VkPipelineStageFlags dstStages = 0;
+  legacyBarrierScratch.clear();
+  for (const VkImageMemoryBarrier2KHR &barrier2 : barrierScratch) {
+    srcStages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+    dstStages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+    barrier.dstAccessMask = static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+    barrier.oldLayout = barrier2.oldLayout;
+    barrier.newLayout = barrier2.newLayout;
+    barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+    barrier.image = barrier2.image;
+    barrier.subresourceRange = barrier2.subresourceRange;
+    legacyBarrierScratch.push_back(barrier);
+  }
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      dstStages != 0 ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      static_cast<uint32_t>(legacyBarrierScratch.size()),
+      legacyBarrierScratch.data());
+}
+
+VkRenderPass LveRenderGraph::renderPass(Pass pass) const {
+  if (!compiled) {
+    throw std::runtime_error("render graph render pass asked for before compile!");
+  }
+  return passes.at(pass).renderPass;
+}
+
+VkImage LveRenderGraph::image(Image image) const { return images.at(image).handle; }
+
+VkImageView LveRenderGraph::imageView(Image image) const { return images.at(image).view; }
+
+bool LveRenderGraph::isScheduled(Pass pass) const { return passes.at(pass).scheduled; }
+
+void LveRenderGraph::printReport(std::ostream &out) const {
+  out << "render graph: " << stats_.scheduledPasses << " of " << stats_.declaredPasses
+      << " passes scheduled, " << stats_.imageBarriers << " image barriers in "
+      << stats_.barrierBatches << " "
+      << (device.pipelineBarrier2() ? "vkCmdPipelineBarrier2KHR" : "vkCmdPipelineBarrier")
+      << " calls for " << stats_.imageUses << " image uses" << std::endl;
+
+  uint32_t scheduleIndex = 0;
+  for (const PassState &pass : passes) {
+    if (!pass.scheduled) {
+      out << "\t   -  " << pass.name << " (culled)" << std::endl;
+      continue;
+    }
+    out << "\t" << std::setw(4) << scheduleIndex << "  " << pass.name;
+    const auto &batch = passBarriers[scheduleIndex];
+    if (!batch.empty()) {
+      out << ", barriers:";
+      for (const PlannedBarrier &planned : batch) out << " " << images[planned.image].name;
+    }
+    out << std::endl;
+    scheduleIndex++;
+  }
+
+  out << "transient images:" << std::endl;
+  for (const ImageState &image : images) {
+    if (image.imported) continue;
+    out << "\t" << image.name << " " << image.extent.width << "x" << image.extent.height;
+    if (image.firstUse == UINT32_MAX) {
+      out << ", unused" << std::endl;
+      continue;
+    }
+    out << ", passes " << image.firstUse << "-" << image.lastUse << ", " << std::fixed
+        << std::setprecision(2) << mebibytes(image.requirements.size) << " MiB at "
+        << mebibytes(image.offset) << " MiB of group " << image.memoryGroup << std::defaultfloat
+        << std::endl;
+  }
+
+  VkDeviceSize saved = stats_.transientBytes - stats_.aliasedBytes;
+  out << "transient memory: " << std::fixed << std::setprecision(2)
+      << mebibytes(stats_.transientBytes) << " MiB aliased into " << mebibytes(stats_.aliasedBytes)
+      << " MiB, " << mebibytes(saved) << " MiB saved per frame" << std::defaultfloat << std::endl;
+}
+
+void LveRenderGraph::destroyResources() {
+  destroyRetiredFramebuffers(true);
+  for (PassState &pass : passes) {
+    for (auto &entry : pass.framebuffers) {
+      vkDestroyFramebuffer(device.device(), entry.second, nullptr);
+    }
+    pass.framebuffers.clear();
+    if (pass.renderPass != VK_NULL_HANDLE) {
+      vkDestroyRenderPass(device.device(), pass.renderPass, nullptr);
+      pass.renderPass = VK_NULL_HANDLE;
+    }
+  }
+  for (ImageState &image : images) {
+    if (image.imported) continue;
+    if (image.view != VK_NULL_HANDLE) vkDestroyImageView(device.device(), image.view, nullptr);
+    if (image.handle != VK_NULL_HANDLE) vkDestroyImage(device.device(), image.handle, nullptr);
+    image.view = VK_NULL_HANDLE;
+    image.handle = VK_NULL_HANDLE;
+  }
+  for (MemoryGroup &group : memoryGroups) {
+    device.allocator().free(group.allocation);
+  }
+  memoryGroups.clear();
+}
+
+bool LveRenderGraph::isDepthFormat(VkFormat format) const {
+  return format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D16_UNORM ||
+         format == VK_FORMAT_X8_D24_UNORM_PACK32 || hasStencil(format);
+}
+
+bool LveRenderGraph::isAttachment(LveRenderGraphUsage usage) const {
+  return usage == LveRenderGraphUsage::ColorAttachment ||
+         usage == LveRenderGraphUsage::DepthAttachment ||
+         usage == LveRenderGraphUsage::DepthReadOnly;
+}
+
+bool LveRenderGraph::isWrite(LveRenderGraphUsage usage) const {
+  return usage == LveRenderGraphUsage::ColorAttachment ||
+         usage == LveRenderGraphUsage::DepthAttachment ||
+         usage == LveRenderGraphUsage::StorageWrite || usage == LveRenderGraphUsage::TransferDst;
+}
+
+bool LveRenderGraph::readsContents(const PassState &pass, const ImageUse &use) const {
+  switch (use.usage) {
+    case LveRenderGraphUsage::ColorAttachment:
+    case LveRenderGraphUsage::DepthAttachment:
+      // loaded unless cleared
+      return pass.clears.count(use.image) == 0;
+    case LveRenderGraphUsage::TransferDst:
+      return false;
+    default:
+      return true;
+  }
+}
+
+VkImageLayout LveRenderGraph::layoutFor(const ImageUse &use) const {
+  switch (use.usage) {
+    case LveRenderGraphUsage::ColorAttachment:
+      return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    case LveRenderGraphUsage::DepthAttachment:
+      return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    case LveRenderGraphUsage::DepthReadOnly:
+      return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    case LveRenderGraphUsage::Sampled:
+      // sampling depth in the read-only depth layout lets it be tested in the same pass
+      return isDepthFormat(images[use.image].format)
+                 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                 : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    case LveRenderGraphUsage::StorageRead:
+    case LveRenderGraphUsage::StorageWrite:
+      return VK_IMAGE_LAYOUT_GENERAL;
+    case LveRenderGraphUsage::TransferSrc:
+      return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    case LveRenderGraphUsage::TransferDst:
+      return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  }
+  return VK_IMAGE_LAYOUT_UNDEFINED;
+}
+
+VkPipelineStageFlags2KHR LveRenderGraph::stagesFor(
+    const PassState &pass, const ImageUse &use) const {
+  bool graphics = false;
+  for (const ImageUse &other : pass.uses) {
+    if (isAttachment(other.usage)) graphics = true;
+  }
+  switch (use.usage) {
+    case LveRenderGraphUsage::ColorAttachment:
+      return VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+    case LveRenderGraphUsage::DepthAttachment:
+    case LveRenderGraphUsage::DepthReadOnly:
+      return VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR |
+             VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+    case LveRenderGraphUsage::Sampled:
+    case LveRenderGraphUsage::StorageRead:
+    case LveRenderGraphUsage::StorageWrite:
+      // the graph does not know which shader of a graphics pass reads, so it covers both
+      return graphics ? VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR |
+                            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR
+                      : VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+    case LveRenderGraphUsage::TransferSrc:
+    case LveRenderGraphUsage::TransferDst:
+      return VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+  }
+  return VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+}
+
+VkAccessFlags2KHR LveRenderGraph::accessFor(const PassState &pass, const ImageUse &use) const {
+  switch (use.usage) {
+    case LveRenderGraphUsage::ColorAttachment:
+      return readsContents(pass, use) ? VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR |
+                                            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR
+                                      : VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+    case LveRenderGraphUsage::DepthAttachment:
+      return VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR |
+             VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+    case LveRenderGraphUsage::DepthReadOnly:
+      return VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR;
+    case LveRenderGraphUsage::Sampled:
+    case LveRenderGraphUsage::StorageRead:
+      return VK_ACCESS_2_SHADER_READ_BIT_KHR;
+    case LveRenderGraphUsage::StorageWrite:
+      return VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR;
+    case LveRenderGraphUsage::TransferSrc:
+      return VK_ACCESS_2_TRANSFER_READ_BIT_KHR;
+    case LveRenderGraphUsage::TransferDst:
+      return VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+  }
+  return VK_ACCESS_2_NONE_KHR;
+}
+
+}  // namespace lve
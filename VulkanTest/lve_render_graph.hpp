@@ -0,0 +1,241 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// How a pass uses an image. The usage decides the layout, stages and access the graph
+// synchronizes on, and the VkImageUsageFlags transient images are created with.
+enum class LveRenderGraphUsage {
+  ColorAttachment,  // loaded unless cleared with clearColor, then stored if anything reads it later
+  DepthAttachment,  // tested and written; loaded unless cleared with clearDepth
+  DepthReadOnly,    // tested but not written, in a read-only layout that can be sampled alongside
+  Sampled,          // read through a sampler in the pass's shaders
+  StorageRead,      // read as a storage image
+  StorageWrite,     // written, and possibly read, as a storage image
+  TransferSrc,
+  TransferDst,
+};
+
+struct LveRenderGraphStats {
+  uint32_t declaredPasses = 0;
+  uint32_t scheduledPasses = 0;  // the rest were culled
+  uint32_t barrierBatches = 0;   // pipeline barrier calls per frame
+  uint32_t imageBarriers = 0;
+  uint32_t imageUses = 0;  // the barriers it would take to synchronize every use on its own
+  uint32_t transientImages = 0;
+  VkDeviceSize transientBytes = 0;  // what the transient images take with memory of their own
+  VkDeviceSize aliasedBytes = 0;    // what they take aliased; the difference is saved every frame
+};
+
+// A frame graph. Passes are declared in submission order with the images they read and write;
+// compile then culls the passes nothing depends on, creates the transient images, and plans the
+// synchronization, so execute records the frame without any hand-written barrier:
+//
+//   auto albedo = graph.createImage("albedo", VK_FORMAT_R8G8B8A8_UNORM, extent);
+//   auto gbuffer = graph.addPass("gbuffer", [&](VkCommandBuffer commandBuffer) { ... });
+//   graph.use(gbuffer, albedo, LveRenderGraphUsage::ColorAttachment);
+//   graph.clearColor(gbuffer, albedo, {});
+//   auto lighting = graph.addPass("lighting", ...);
+//   graph.use(lighting, albedo, LveRenderGraphUsage::Sampled);
+//   graph.use(lighting, output, LveRenderGraphUsage::ColorAttachment);
+//   graph.compile();
+//   pipelineConfig.renderPass = graph.renderPass(lighting);
+//   ...
+//   graph.execute(commandBuffer);  // every frame
+//
+// Passes with attachments run inside a render pass the graph creates, with the viewport and
+// scissor set to the attachments' extent; the rest, compute and transfer passes, outside of one.
+// Each pass gets at most one batch of barriers ahead of it: through vkCmdPipelineBarrier2KHR when
+// the device has synchronization2, else the same batch through vkCmdPipelineBarrier. Reads that
+// an earlier barrier already made visible, in the same layout, need none. Shader accesses are
+// synchronized for the vertex and fragment stages in a pass with attachments, and for the compute
+// stage in one without; other stages, such as tessellation or geometry shaders, are not covered.
+//
+// Transient images live for one frame, from the first scheduled pass using them to the last.
+// Images whose lifetimes do not overlap share memory, so a chain of passes costs the peak of what
+// is alive at once rather than the sum. Their contents do not survive the frame; all frames in
+// flight share them, which is safe as long as the frames are submitted to the one queue.
+//
+// Imported images, such as the swap chain image, are not owned by the graph and are kept, and so
+// are passes marked with keepPass; everything else is culled unless a kept pass depends on it.
+// Framebuffers are cached per set of attachment views, so when the views an imported image was
+// set to are destroyed, e.g. with a recreated swap chain, call invalidateImportedImage.
+// The graph is built once and compiled once; rebuild it when an extent changes.
+class LveRenderGraph {
+ public:
+  using Image = uint32_t;
+  using Pass = uint32_t;
+  using ExecuteFunction = std::function<void(VkCommandBuffer)>;
+
+  // execute is expected once per frame, with framesInFlight frames in flight
+  explicit LveRenderGraph(
+      LveDevice &device, uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+  ~LveRenderGraph();
+
+  LveRenderGraph(const LveRenderGraph &) = delete;
+  LveRenderGraph &operator=(const LveRenderGraph &) = delete;
+
+  Image createImage(std::string name, VkFormat format, VkExtent2D extent);
+  // An image the frame starts with in initialLayout, written before availableStage, and that the
+  // graph leaves in finalLayout, e.g. UNDEFINED with COLOR_ATTACHMENT_OUTPUT for a freshly
+  // acquired swap chain image and PRESENT_SRC_KHR. Set its handle with setImportedImage. An
+  // imported image no scheduled pass uses is left untouched, final layout included.
+  Image importImage(
+      std::string name,
+      VkFormat format,
+      VkExtent2D extent,
+      VkImageLayout initialLayout,
+      VkImageLayout finalLayout,
+      VkPipelineStageFlags2KHR availableStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR);
+  // before each execute that should use a different image, e.g. the next swap chain image
+  void setImportedImage(Image image, VkImage handle, VkImageView view);
+  // The views image has been set to are going away: drops the framebuffers made for them, so a
+  // new view that reuses a handle never finds a stale one, and destroys them once the frames in
+  // flight have moved past. Set the image again before the next execute.
+  void invalidateImportedImage(Image image);
+
+  Pass addPass(std::string name, ExecuteFunction execute);
+  void use(Pass pass, Image image, LveRenderGraphUsage usage);
+  // for a color or depth attachment: cleared on load, so the pass does not read the old contents
+  void clearColor(Pass pass, Image image, VkClearColorValue color);
+  void clearDepth(Pass pass, Image image, float depth = 1.0f);
+  // kept by the culling even though no kept pass reads what it writes, e.g. because it writes a
+  // buffer the graph does not know about
+  void keepPass(Pass pass);
+
+  // Throws when a pass reads a transient image before any pass writes it, or uses one image in
+  // two layouts at once.
+  void compile();
+  void execute(VkCommandBuffer commandBuffer);
+
+  // for pipelines drawing in the pass; VK_NULL_HANDLE for passes without attachments
+  VkRenderPass renderPass(Pass pass) const;
+  VkImage image(Image image) const;
+  VkImageView imageView(Image image) const;
+  bool isScheduled(Pass pass) const;
+
+  const LveRenderGraphStats &stats() const { return stats_; }
+  // the schedule with its barriers, the transient images with their lifetimes and placement
+  void printReport(std::ostream &out) const;
+
+ private:
+  struct ImageUse {
+    Image image;
+    LveRenderGraphUsage usage;
+  };
+
+  struct PassState {
+    std::string name;
+    ExecuteFunction execute;
+    std::vector<ImageUse> uses;
+    std::map<Image, VkClearValue> clears;
+    bool kept = false;
+    bool scheduled = false;
+
+    // filled in by compile
+    std::vector<Image> attachments;  // colors in declaration order, then the depth attachment
+    std::vector<VkClearValue> clearValues;
+    VkExtent2D extent{};
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;  // by attachment views
+  };
+
+  struct ImageState {
+    std::string name;
+    VkFormat format;
+    VkExtent2D extent;
+    bool imported = false;
+    VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2KHR availableStage = VK_PIPELINE_STAGE_2_NONE_KHR;
+    VkImage handle = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    std::vector<VkImageView> importedViews;  // set since the last invalidateImportedImage
+
+    // filled in by compile, for transient images
+    VkImageUsageFlags usageFlags = 0;
+    uint32_t firstUse = UINT32_MAX;  // schedule indices
+    uint32_t lastUse = 0;
+    uint32_t memoryGroup = UINT32_MAX;
+    VkDeviceSize offset = 0;  // within its memory group
+    VkMemoryRequirements requirements{};
+  };
+
+  struct MemoryGroup {
+    uint32_t memoryTypeIndex;
+    VkDeviceSize size = 0;
+    VkDeviceSize alignment = 1;
+    LveAllocation *allocation = nullptr;
+  };
+
+  struct RetiredFramebuffer {
+    VkFramebuffer framebuffer;
+    uint64_t retiredAt;  // executeCount when it was dropped
+  };
+
+  struct PlannedBarrier {
+    Image image;
+    VkImageMemoryBarrier2KHR barrier;
+  };
+
+  // one image as the passes have left it so far
+  struct SyncState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2KHR writeStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+    VkAccessFlags2KHR writeAccess = VK_ACCESS_2_NONE_KHR;
+    // stages and accesses that have waited for the last write, and need no barrier to read it
+    VkPipelineStageFlags2KHR visibleStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+    VkAccessFlags2KHR visibleAccess = VK_ACCESS_2_NONE_KHR;
+    bool used = false;
+  };
+
+  void cullPasses();
+  void computeLifetimes();
+  void createTransientImages();
+  void placeImages(std::vector<Image> &images, MemoryGroup &group);
+  void createRenderPasses();
+  void planBarriers();
+  void destroyResources();
+  VkFramebuffer framebufferFor(PassState &pass);
+  void destroyRetiredFramebuffers(bool all);
+  void recordBarriers(VkCommandBuffer commandBuffer, const std::vector<PlannedBarrier> &planned);
+
+  bool isDepthFormat(VkFormat format) const;
+  bool isAttachment(LveRenderGraphUsage usage) const;
+  bool isWrite(LveRenderGraphUsage usage) const;
+  bool readsContents(const PassState &pass, const ImageUse &use) const;
+  VkImageLayout layoutFor(const ImageUse &use) const;
+  VkPipelineStageFlags2KHR stagesFor(const PassState &pass, const ImageUse &use) const;
+  VkAccessFlags2KHR accessFor(const PassState &pass, const ImageUse &use) const;
+
+  LveDevice &device;
+  uint32_t framesInFlight;
+  std::vector<ImageState> images;
+  std::vector<PassState> passes;
+  bool compiled = false;
+
+  std::vector<Pass> schedule;
+  // barriers ahead of each scheduled pass, and after the last one for imported images
+  std::vector<std::vector<PlannedBarrier>> passBarriers;
+  std::vector<PlannedBarrier> finalBarriers;
+  std::vector<MemoryGroup> memoryGroups;
+  std::vector<RetiredFramebuffer> retiredFramebuffers;
+  uint64_t executeCount = 0;
+  LveRenderGraphStats stats_;
+
+  // reused by recordBarriers, which runs every frame
+  std::vector<VkImageMemoryBarrier2KHR> barrierScratch;
+  std::vector<VkImageMemoryBarrier> legacyBarrierScratch;
+};
+
+}  // namespace lve
@@ -0,0 +1,266 @@
+#include "lve_renderer.hpp"
+
+#include "lve_pipeline.hpp"
+#include "lve_upload_manager.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+LveRenderer::LveRenderer(
+    LveWindow &window,
+    LveDevice &device,
+    LvePresentPolicy presentPolicy,
+    uint32_t framesInFlight)
+    : lveWindow{&window},
+      lveDevice{device},
+      presentPolicy{presentPolicy},
+      framesInFlight{framesInFlight} {
+  recreateSwapChain();
+  // closed while still minimized: there is nothing to render to, and every accessor needs one
+  if (!lveSwapChain) {
+    throw std::runtime_error("window was closed before a swap chain could be created!");
+  }
+  createCommandBuffers();
+}
+
+LveRenderer::LveRenderer(LveDevice &device, VkExtent2D extent, uint32_t framesInFlight)
+    : lveDevice{device}, framesInFlight{framesInFlight} {
+  offscreenTarget = std::make_unique<LveOffscreenTarget>(lveDevice, extent, framesInFlight);
+  createCommandBuffers();
+}
+
+LveRenderer::~LveRenderer() { freeCommandBuffers(); }
+
+void LveRenderer::recreateSwapChain() {
+  auto extent = lveWindow->getExtent();
+  // a minimized window has no surface to present to; wait until it is restored
+  while (extent.width == 0 || extent.height == 0) {
+    if (lveWindow->shouldClose()) return;
+    glfwWaitEvents();
+    extent = lveWindow->getExtent();
+  }
+  if (lveWindow->wasWindowResized()) {
+    resizePending = true;
+    resizeStart = lveWindow->resizeTime();
+    lveWindow->resetWindowResizedFlag();
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  auto newSwapChain = std::make_unique<LveSwapChain>(
+      lveDevice, extent, presentPolicy, framesInFlight, lveSwapChain.get());
+  if (lveSwapChain) {
+    // frames up to and including the one being submitted may still use the old chain; each
+    // slot's fence has been waited on once frameCounter is past them by framesInFlight, and one
+    // more frame leaves the presentation engine time to release the old images
+    retiredSwapChains.push_back({std::move(lveSwapChain), frameCounter + framesInFlight + 1});
+    resizeStatistics.recreateCount++;
+    resizeStatistics.lastRecreateMilliseconds = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+  }
+  if (newSwapChain->replacedRenderPass()) renderPassChanged = true;
+  lveSwapChain = std::move(newSwapChain);
+  hasPreviousImage = false;
+}
+
+void LveRenderer::destroyRetiredSwapChains() {
+  retiredSwapChains.erase(
+      std::remove_if(
+          retiredSwapChains.begin(),
+          retiredSwapChains.end(),
+          [this](const RetiredSwapChain &retired) {
+            return frameCounter >= retired.destroyAtFrame;
+          }),
+      retiredSwapChains.end());
+}
+
+void LveRenderer::waitForSubmittedFrames() {
+  assert(!isFrameStarted && "Can't wait for submitted frames while a frame is in progress");
+  // a newer swap chain adopts the fences of the one it replaces, so the current slots cover
+  // every frame submitted
+  std::vector<VkFence> fences;
+  for (uint32_t i = 0; i < framesInFlight; i++) {
+    fences.push_back(
+        lveSwapChain ? lveSwapChain->getInFlightFence(i) : offscreenTarget->getInFlightFence(i));
+  }
+  if (vkWaitForFences(
+          lveDevice.device(),
+          static_cast<uint32_t>(fences.size()),
+          fences.data(),
+          VK_TRUE,
+          UINT64_MAX) != VK_SUCCESS) {
+    throw std::runtime_error("failed to wait for submitted frames!");
+  }
+}
+
+LveDepthAttachment LveRenderer::getPreviousDepth() const {
+  LveDepthAttachment depth{};
+  if (!hasPreviousImage) return depth;
+
+  int index = static_cast<int>(previousImageIndex);
+  if (lveSwapChain) {
+    depth.image = lveSwapChain->getDepthImage(index);
+    depth.view = lveSwapChain->getDepthImageView(index);
+    depth.format = lveSwapChain->findDepthFormat();
+  } else {
+    depth.image = offscreenTarget->getDepthImage(index);
+    depth.view = offscreenTarget->getDepthImageView(index);
+    depth.format = offscreenTarget->findDepthFormat();
+  }
+  depth.extent = getSwapChainExtent();
+  return depth;
+}
+
+void LveRenderer::createCommandBuffers() {
+  commandBuffers.resize(framesInFlight);
+
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandPool = lveDevice.getCommandPool();
+  allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+  if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate command buffers!");
+  }
+}
+
+void LveRenderer::freeCommandBuffers() {
+  vkFreeCommandBuffers(
+      lveDevice.device(),
+      lveDevice.getCommandPool(),
+      static_cast<uint32_t>(commandBuffers.size()),
+      commandBuffers.data());
+  commandBuffers.clear();
+}
+
+VkCommandBuffer LveRenderer::beginFrame() {
+  assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+
+  auto frameStart = std::chrono::high_resolution_clock::now();
+  if (frameCounter > 0) {
+    frameStats.frameNumber = frameCounter - 1;
+    frameStats.frameMilliseconds =
+        std::chrono::duration<double, std::milli>(frameStart - lastFrameStart).count();
+  }
+  lastFrameStart = frameStart;
+
+  if (offscreenTarget) {
+    offscreenTarget->acquireNextImage(&currentImageIndex);
+    frameStats.cpuWaitMilliseconds = offscreenTarget->lastCpuWaitMilliseconds();
+    isFrameStarted = true;
+    return beginCommandBuffer();
+  }
+
+  auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
+  frameStats.cpuWaitMilliseconds = lveSwapChain->lastCpuWaitMilliseconds();
+  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+    recreateSwapChain();
+    return nullptr;
+  }
+
+  if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+    throw std::runtime_error("failed to acquire swap chain image!");
+  }
+  destroyRetiredSwapChains();
+
+  isFrameStarted = true;
+  return beginCommandBuffer();
+}
+
+VkCommandBuffer LveRenderer::beginCommandBuffer() {
+  auto commandBuffer = getCurrentCommandBuffer();
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin recording command buffer!");
+  }
+  lveDevice.profiler().beginFrame(commandBuffer);
+  frameScope = lveDevice.profiler().beginScope(commandBuffer, "frame");
+  // resources finished on the transfer queue become usable on this queue from here on
+  lveDevice.uploadManager().recordAcquireBarriers(commandBuffer);
+  return commandBuffer;
+}
+
+void LveRenderer::endFrame() {
+  assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
+  auto commandBuffer = getCurrentCommandBuffer();
+  lveDevice.profiler().endScope(commandBuffer, frameScope);
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record command buffer!");
+  }
+
+  previousImageIndex = currentImageIndex;
+  hasPreviousImage = true;
+  if (offscreenTarget) {
+    if (offscreenTarget->submitCommandBuffers(&commandBuffer, &currentImageIndex) != VK_SUCCESS) {
+      throw std::runtime_error("failed to submit offscreen frame!");
+    }
+  } else {
+    auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+    frameStats.cpuWaitMilliseconds = lveSwapChain->lastCpuWaitMilliseconds();
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
+        lveWindow->wasWindowResized()) {
+      recreateSwapChain();
+    } else if (result != VK_SUCCESS) {
+      throw std::runtime_error("failed to present swap chain image!");
+    } else if (resizePending) {
+      resizePending = false;
+      double latency = std::chrono::duration<double, std::milli>(
+          std::chrono::high_resolution_clock::now() - resizeStart).count();
+      resizeStatistics.measuredResizes++;
+      resizeStatistics.lastLatencyMilliseconds = latency;
+      resizeStatistics.maxLatencyMilliseconds =
+          std::max(resizeStatistics.maxLatencyMilliseconds, latency);
+      resizeStatistics.totalLatencyMilliseconds += latency;
+    }
+  }
+
+  isFrameStarted = false;
+  frameCounter++;
+  currentFrameIndex = (currentFrameIndex + 1) % static_cast<int>(framesInFlight);
+}
+
+void LveRenderer::beginSwapChainRenderPass(
+    VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+  assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
+  assert(
+      commandBuffer == getCurrentCommandBuffer() &&
+      "Can't begin render pass on command buffer from a different frame");
+
+  VkRenderPassBeginInfo renderPassInfo{};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  renderPassInfo.renderPass = getSwapChainRenderPass();
+  renderPassInfo.framebuffer = getCurrentFramebuffer();
+
+  renderPassInfo.renderArea.offset = {0, 0};
+  renderPassInfo.renderArea.extent = getSwapChainExtent();
+
+  std::array<VkClearValue, 2> clearValues{};
+  clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
+  clearValues[1].depthStencil = {1.0f, 0};
+  renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+  renderPassInfo.pClearValues = clearValues.data();
+
+  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+  if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+    LvePipeline::setViewportAndScissor(commandBuffer, getSwapChainExtent());
+  }
+}
+
+void LveRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+  assert(isFrameStarted && "Can't call endSwapChainRenderPass if frame is not in progress");
+  assert(
+      commandBuffer == getCurrentCommandBuffer() &&
+      "Can't end render pass on command buffer from a different frame");
+  vkCmdEndRenderPass(commandBuffer);
+}
+
+}  // namespace lve
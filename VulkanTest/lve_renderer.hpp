@@ -0,0 +1,173 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_offscreen_target.hpp"
+#include "lve_swap_chain.hpp"
+#include "lve_window.hpp"
+
+// std
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+struct LveFrameStats {
+  uint64_t frameNumber = 0;
+  double frameMilliseconds = 0.0;    // CPU time from one beginFrame to the next
+  double cpuWaitMilliseconds = 0.0;  // part of it spent blocked on the GPU or the presentation engine
+};
+
+// Swap chain recreations, and how long after the window was resized a frame at the new size was
+// presented.
+struct LveResizeStats {
+  uint32_t recreateCount = 0;
+  uint32_t measuredResizes = 0;
+  double lastRecreateMilliseconds = 0.0;  // CPU time spent building the new swap chain
+  double lastLatencyMilliseconds = 0.0;   // from the resize event to the first present after it
+  double maxLatencyMilliseconds = 0.0;
+  double totalLatencyMilliseconds = 0.0;
+};
+
+// A depth attachment left behind by a submitted frame, in DEPTH_STENCIL_ATTACHMENT_OPTIMAL.
+struct LveDepthAttachment {
+  VkImage image = VK_NULL_HANDLE;
+  VkImageView view = VK_NULL_HANDLE;
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  VkExtent2D extent{};
+};
+
+// Owns the swap chain and one command buffer per frame in flight. While the GPU executes frame N
+// the CPU records frame N + 1 into the next slot; beginFrame only blocks once every slot is busy.
+// Constructed without a window it renders into an LveOffscreenTarget instead, with the same API.
+//
+// When the window is resized the swap chain is rebuilt from the old one without waiting for the
+// device: the frames in flight finish on the old chain, which is destroyed once their slots have
+// come around again. The render pass is kept when the formats match, so pipelines survive, and
+// replaced otherwise, see wasRenderPassChanged; viewport and scissor are dynamic and set by
+// beginSwapChainRenderPass.
+class LveRenderer {
+ public:
+  // Waits while the window is minimized; throws if it is closed before it is restored.
+  LveRenderer(
+      LveWindow &window,
+      LveDevice &device,
+      LvePresentPolicy presentPolicy = LvePresentPolicy::LowLatency,
+      uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+  LveRenderer(
+      LveDevice &device,
+      VkExtent2D extent,
+      uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+  ~LveRenderer();
+
+  LveRenderer(const LveRenderer &) = delete;
+  LveRenderer &operator=(const LveRenderer &) = delete;
+
+  VkRenderPass getSwapChainRenderPass() const {
+    return lveSwapChain ? lveSwapChain->getRenderPass() : offscreenTarget->getRenderPass();
+  }
+  VkExtent2D getSwapChainExtent() const {
+    return lveSwapChain ? lveSwapChain->getSwapChainExtent() : offscreenTarget->getExtent();
+  }
+  float getAspectRatio() const {
+    return lveSwapChain ? lveSwapChain->extentAspectRatio() : offscreenTarget->extentAspectRatio();
+  }
+  // Set when the swap chain was recreated with different formats, e.g. after the window moved to
+  // an HDR display: getSwapChainRenderPass returns a new render pass and every pipeline built
+  // against the old one has to be rebuilt before the next frame is recorded.
+  bool wasRenderPassChanged() const { return renderPassChanged; }
+  void resetRenderPassChangedFlag() { renderPassChanged = false; }
+  bool isFrameInProgress() const { return isFrameStarted; }
+  bool isHeadless() const { return lveWindow == nullptr; }
+
+  VkCommandBuffer getCurrentCommandBuffer() const {
+    assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
+    return commandBuffers[currentFrameIndex];
+  }
+
+  int getFrameIndex() const {
+    assert(isFrameStarted && "Cannot get frame index when frame not in progress");
+    return currentFrameIndex;
+  }
+
+  // Signals once the frame being recorded has completed on the GPU, e.g. for LveUniformRing.
+  VkFence getCurrentFrameFence() const {
+    assert(isFrameStarted && "Cannot get frame fence when frame not in progress");
+    return lveSwapChain ? lveSwapChain->getInFlightFence(currentFrameIndex)
+                        : offscreenTarget->getInFlightFence(currentFrameIndex);
+  }
+
+  // Framebuffer of the current frame, for secondary command buffer inheritance.
+  VkFramebuffer getCurrentFramebuffer() const {
+    assert(isFrameStarted && "Cannot get framebuffer when frame not in progress");
+    return lveSwapChain ? lveSwapChain->getFrameBuffer(currentImageIndex)
+                        : offscreenTarget->getFrameBuffer(currentImageIndex);
+  }
+
+  const LveFrameStats &lastFrameStats() const { return frameStats; }
+  // Frames that went through endFrame; skipped frames, e.g. while minimized, do not count. Once
+  // this is framesInFlight past a frame, beginFrame has waited for that frame's fence.
+  uint64_t submittedFrameCount() const { return frameCounter; }
+  const LveResizeStats &resizeStats() const { return resizeStatistics; }
+
+  // Depth written by the previous frame, for passes that reuse it such as occlusion culling.
+  // image is null before the first frame and after the swap chain has been recreated.
+  LveDepthAttachment getPreviousDepth() const;
+
+  // Blocks until every frame submitted so far has completed, without waiting on other queues;
+  // for writes to buffers the frames read, e.g. LveIndirectDrawSystem::upload. Call outside
+  // beginFrame/endFrame.
+  void waitForSubmittedFrames();
+
+  // Returns VK_NULL_HANDLE when the swap chain had to be recreated and the frame was skipped.
+  VkCommandBuffer beginFrame();
+  void endFrame();
+  // Also sets viewport and scissor to the whole target for inline contents. Pass
+  // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS to draw through LveParallelRecorder, whose chunks
+  // set their own.
+  void beginSwapChainRenderPass(
+      VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+  void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+
+ private:
+  void createCommandBuffers();
+  void freeCommandBuffers();
+  struct RetiredSwapChain {
+    std::unique_ptr<LveSwapChain> swapChain;
+    uint64_t destroyAtFrame;
+  };
+
+  void recreateSwapChain();
+  void destroyRetiredSwapChains();
+  VkCommandBuffer beginCommandBuffer();
+
+  LveWindow *lveWindow = nullptr;
+  LveDevice &lveDevice;
+  LvePresentPolicy presentPolicy = LvePresentPolicy::LowLatency;
+  uint32_t framesInFlight;
+  std::unique_ptr<LveSwapChain> lveSwapChain;
+  // replaced swap chains whose frames may still be executing or presenting
+  std::vector<RetiredSwapChain> retiredSwapChains;
+  std::unique_ptr<LveOffscreenTarget> offscreenTarget;
+  std::vector<VkCommandBuffer> commandBuffers;
+
+  uint32_t currentImageIndex;
+  uint32_t previousImageIndex = 0;
+  bool hasPreviousImage{false};
+  int currentFrameIndex{0};
+  bool isFrameStarted{false};
+
+  uint32_t frameScope = LveProfiler::INVALID_SCOPE;
+
+  LveFrameStats frameStats;
+  uint64_t frameCounter{0};
+  std::chrono::high_resolution_clock::time_point lastFrameStart;
+
+  LveResizeStats resizeStatistics;
+  bool resizePending{false};  // a resize was handled but nothing presented since
+  bool renderPassChanged{false};
+  std::chrono::high_resolution_clock::time_point resizeStart;
+};
+
+}  // namespace lve
@@ -0,0 +1,459 @@
+#include "lve_scene.hpp"
+
+// std headers
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LVE_SCENE_SSE
+#endif
+
+namespace lve {
+
+namespace {
+
+enum LocalColumn : uint32_t { TX, TY, TZ, QX, QY, QZ, QW, SX, SY, SZ };
+
+// One float per object; the reference the SIMD lanes are checked against.
+struct ScalarLanes {
+  static constexpr uint32_t WIDTH = 1;
+  float v;
+
+  static ScalarLanes load(const float *p) { return {*p}; }
+  static ScalarLanes set1(float x) { return {x}; }
+  void store(float *p) const { *p = v; }
+  static ScalarLanes max(ScalarLanes a, ScalarLanes b) { return {std::max(a.v, b.v)}; }
+  static ScalarLanes sqrt(ScalarLanes a) { return {std::sqrt(a.v)}; }
+  friend ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return {a.v + b.v}; }
+  friend ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return {a.v - b.v}; }
+  friend ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return {a.v * b.v}; }
+};
+
+#if defined(__AVX__)
+struct SimdLanes {
+  static constexpr uint32_t WIDTH = 8;
+  __m256 v;
+
+  static SimdLanes load(const float *p) { return {_mm256_loadu_ps(p)}; }
+  static SimdLanes set1(float x) { return {_mm256_set1_ps(x)}; }
+  void store(float *p) const { _mm256_storeu_ps(p, v); }
+  static SimdLanes max(SimdLanes a, SimdLanes b) { return {_mm256_max_ps(a.v, b.v)}; }
+  static SimdLanes sqrt(SimdLanes a) { return {_mm256_sqrt_ps(a.v)}; }
+  friend SimdLanes operator+(SimdLanes a, SimdLanes b) { return {_mm256_add_ps(a.v, b.v)}; }
+  friend SimdLanes operator-(SimdLanes a, SimdLanes b) { return {_mm256_sub_ps(a.v, b.v)}; }
+  friend SimdLanes operator*(SimdLanes a, SimdLanes b) { return {_mm256_mul_ps(a.v, b.v)}; }
+};
+#elif defined(LVE_SCENE_SSE)
+struct SimdLanes {
+  static constexpr uint32_t WIDTH = 4;
+  __m128 v;
+
+  static SimdLanes load(const float *p) { return {_mm_loadu_ps(p)}; }
+  static SimdLanes set1(float x) { return {_mm_set1_ps(x)}; }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+  static SimdLanes max(SimdLanes a, SimdLanes b) { return {_mm_max_ps(a.v, b.v)}; }
+  static SimdLanes sqrt(SimdLanes a) { return {_mm_sqrt_ps(a.v)}; }
+  friend SimdLanes operator+(SimdLanes a, SimdLanes b) { return {_mm_add_ps(a.v, b.v)}; }
+  friend SimdLanes operator-(SimdLanes a, SimdLanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+  friend SimdLanes operator*(SimdLanes a, SimdLanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+};
+#else
+using SimdLanes = ScalarLanes;
+#endif
+
+}  // namespace
+
+struct LveScene::Columns {
+  const float *local[10];
+  float *world[12];
+  const float *localBounds[4];
+  float *worldBounds[4];
+  const uint32_t *parentSlots;
+  uint8_t *dirty;
+};
+
+LveScene::LveScene(LveThreadPool *threadPool, bool useSimd)
+    : threadPool{threadPool}, useSimd{useSimd} {}
+
+uint32_t LveScene::simdWidth() { return SimdLanes::WIDTH; }
+
+uint32_t LveScene::slotOf(LveSceneObjectId object) const {
+  if (object >= idSlots.size() || idSlots[object] == NO_SLOT) {
+    throw std::runtime_error("invalid scene object id!");
+  }
+  return idSlots[object];
+}
+
+LveSceneObjectId LveScene::createObject(
+    LveSceneObjectId parent,
+    const LveTransform &transform,
+    const LveBoundingSphere &bounds,
+    uint32_t renderHandle) {
+  if (parent != LVE_SCENE_NO_PARENT) slotOf(parent);
+
+  LveSceneObjectId object;
+  if (!freeIds.empty()) {
+    object = freeIds.back();
+    freeIds.pop_back();
+  } else {
+    object = static_cast<LveSceneObjectId>(idSlots.size());
+    idSlots.push_back(NO_SLOT);
+  }
+  idSlots[object] = static_cast<uint32_t>(slotIds.size());
+
+  // new objects go to the end until the next update sorts them into their level
+  for (auto &column : local) column.push_back(0.0f);
+  for (auto &column : world) column.push_back(0.0f);
+  for (auto &column : localBounds) column.push_back(0.0f);
+  for (auto &column : worldBounds) column.push_back(0.0f);
+  renderHandles.push_back(renderHandle);
+  parentIds.push_back(parent);
+  parentSlots.push_back(NO_SLOT);
+  slotIds.push_back(object);
+  dirty.push_back(1);
+  removed.push_back(0);
+  structureChanged = true;
+
+  setTransform(object, transform);
+  setLocalBounds(object, bounds);
+  return object;
+}
+
+void LveScene::destroyObject(LveSceneObjectId object) {
+  uint32_t slot = slotOf(object);
+  if (removed[slot]) return;
+  removed[slot] = 1;
+  removedCount++;
+  structureChanged = true;
+}
+
+void LveScene::setParent(LveSceneObjectId object, LveSceneObjectId parent) {
+  uint32_t slot = slotOf(object);
+  for (LveSceneObjectId ancestor = parent; ancestor != LVE_SCENE_NO_PARENT;
+       ancestor = parentIds[slotOf(ancestor)]) {
+    if (ancestor == object) {
+      throw std::runtime_error("cannot parent a scene object below itself!");
+    }
+  }
+  parentIds[slot] = parent;
+  dirty[slot] = 1;
+  structureChanged = true;
+}
+
+void LveScene::setTransform(LveSceneObjectId object, const LveTransform &transform) {
+  setTranslation(object, transform.translation);
+  setRotation(object, transform.rotation);
+  setScale(object, transform.scale);
+}
+
+void LveScene::setTranslation(LveSceneObjectId object, const std::array<float, 3> &translation) {
+  uint32_t slot = slotOf(object);
+  local[TX][slot] = translation[0];
+  local[TY][slot] = translation[1];
+  local[TZ][slot] = translation[2];
+  dirty[slot] = 1;
+}
+
+void LveScene::setRotation(LveSceneObjectId object, const std::array<float, 4> &rotation) {
+  uint32_t slot = slotOf(object);
+  local[QX][slot] = rotation[0];
+  local[QY][slot] = rotation[1];
+  local[QZ][slot] = rotation[2];
+  local[QW][slot] = rotation[3];
+  dirty[slot] = 1;
+}
+
+void LveScene::setScale(LveSceneObjectId object, const std::array<float, 3> &scale) {
+  uint32_t slot = slotOf(object);
+  local[SX][slot] = scale[0];
+  local[SY][slot] = scale[1];
+  local[SZ][slot] = scale[2];
+  dirty[slot] = 1;
+}
+
+void LveScene::setLocalBounds(LveSceneObjectId object, const LveBoundingSphere &bounds) {
+  uint32_t slot = slotOf(object);
+  for (uint32_t i = 0; i < 3; i++) localBounds[i][slot] = bounds.center[i];
+  localBounds[3][slot] = bounds.radius;
+  dirty[slot] = 1;
+}
+
+void LveScene::setRenderHandle(LveSceneObjectId object, uint32_t renderHandle) {
+  renderHandles[slotOf(object)] = renderHandle;
+}
+
+LveTransform LveScene::getTransform(LveSceneObjectId object) const {
+  uint32_t slot = slotOf(object);
+  LveTransform transform{};
+  transform.translation = {local[TX][slot], local[TY][slot], local[TZ][slot]};
+  transform.rotation = {local[QX][slot], local[QY][slot], local[QZ][slot], local[QW][slot]};
+  transform.scale = {local[SX][slot], local[SY][slot], local[SZ][slot]};
+  return transform;
+}
+
+LveSceneObjectId LveScene::getParent(LveSceneObjectId object) const {
+  return parentIds[slotOf(object)];
+}
+
+uint32_t LveScene::getRenderHandle(LveSceneObjectId object) const {
+  return renderHandles[slotOf(object)];
+}
+
+std::array<float, 16> LveScene::getWorldMatrix(LveSceneObjectId object) const {
+  uint32_t slot = slotOf(object);
+  std::array<float, 16> matrix{};
+  for (uint32_t column = 0; column < 4; column++) {
+    for (uint32_t row = 0; row < 3; row++) {
+      matrix[column * 4 + row] = world[column * 3 + row][slot];
+    }
+  }
+  matrix[15] = 1.0f;
+  return matrix;
+}
+
+LveBoundingSphere LveScene::getWorldBounds(LveSceneObjectId object) const {
+  uint32_t slot = slotOf(object);
+  LveBoundingSphere bounds{};
+  bounds.center = {worldBounds[0][slot], worldBounds[1][slot], worldBounds[2][slot]};
+  bounds.radius = worldBounds[3][slot];
+  return bounds;
+}
+
+void LveScene::restructure() {
+  const uint32_t count = static_cast<uint32_t>(slotIds.size());
+  constexpr uint32_t UNKNOWN_DEPTH = UINT32_MAX;
+
+  std::vector<uint32_t> parents(count);
+  for (uint32_t slot = 0; slot < count; slot++) {
+    parents[slot] = parentIds[slot] == LVE_SCENE_NO_PARENT ? NO_SLOT : idSlots[parentIds[slot]];
+  }
+
+  // walk up to the nearest object whose depth is known, then fill in the chain on the way down;
+  // removal spreads to everything below a removed object the same way
+  std::vector<uint32_t> depths(count, UNKNOWN_DEPTH);
+  std::vector<uint8_t> dropped = removed;
+  std::vector<uint32_t> chain;
+  uint32_t maxDepth = 0;
+  for (uint32_t slot = 0; slot < count; slot++) {
+    uint32_t top = slot;
+    while (depths[top] == UNKNOWN_DEPTH && parents[top] != NO_SLOT) {
+      chain.push_back(top);
+      top = parents[top];
+    }
+    if (depths[top] == UNKNOWN_DEPTH) depths[top] = 0;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      depths[*it] = depths[parents[*it]] + 1;
+      dropped[*it] |= dropped[parents[*it]];
+    }
+    chain.clear();
+    maxDepth = std::max(maxDepth, depths[slot]);
+  }
+
+  // counting sort by depth, which keeps the previous order within a level
+  std::vector<uint32_t> starts(maxDepth + 2, 0);
+  for (uint32_t slot = 0; slot < count; slot++) {
+    if (dropped[slot]) {
+      idSlots[slotIds[slot]] = NO_SLOT;
+      freeIds.push_back(slotIds[slot]);
+    } else {
+      starts[depths[slot] + 1]++;
+    }
+  }
+  for (uint32_t level = 1; level < starts.size(); level++) starts[level] += starts[level - 1];
+  while (starts.size() > 1 && starts[starts.size() - 1] == starts[starts.size() - 2]) {
+    starts.pop_back();
+  }
+  const uint32_t liveCount = starts.back();
+
+  std::vector<uint32_t> order(liveCount);
+  std::vector<uint32_t> next(starts.begin(), starts.end() - 1);
+  for (uint32_t slot = 0; slot < count; slot++) {
+    if (!dropped[slot]) order[next[depths[slot]]++] = slot;
+  }
+
+  // within a level, children follow the order of their parents, so siblings are adjacent and a
+  // SIMD batch mostly gathers one parent matrix
+  std::vector<uint32_t> newSlots(count, NO_SLOT);
+  for (uint32_t level = 0; level + 1 < starts.size(); level++) {
+    auto begin = order.begin() + starts[level];
+    auto end = order.begin() + starts[level + 1];
+    if (level > 0) {
+      std::stable_sort(begin, end, [&](uint32_t a, uint32_t b) {
+        return newSlots[parents[a]] < newSlots[parents[b]];
+      });
+    }
+    for (uint32_t i = starts[level]; i < starts[level + 1]; i++) newSlots[order[i]] = i;
+  }
+
+  auto permute = [&order](auto &values) {
+    std::decay_t<decltype(values)> sorted(order.size());
+    for (size_t i = 0; i < order.size(); i++) sorted[i] = values[order[i]];
+    values.swap(sorted);
+  };
+  for (auto &column : local) permute(column);
+  for (auto &column : world) permute(column);
+  for (auto &column : localBounds) permute(column);
+  for (auto &column : worldBounds) permute(column);
+  permute(renderHandles);
+  permute(parentIds);
+  permute(slotIds);
+  permute(dirty);
+
+  parentSlots.resize(liveCount);
+  for (uint32_t i = 0; i < liveCount; i++) {
+    uint32_t parent = parents[order[i]];
+    parentSlots[i] = parent == NO_SLOT ? NO_SLOT : newSlots[parent];
+    idSlots[slotIds[i]] = i;
+  }
+  removed.assign(liveCount, 0);
+  removedCount = 0;
+  levelStarts = std::move(starts);
+}
+
+LveScene::Columns LveScene::columns() {
+  Columns columns{};
+  for (uint32_t i = 0; i < 10; i++) columns.local[i] = local[i].data();
+  for (uint32_t i = 0; i < 12; i++) columns.world[i] = world[i].data();
+  for (uint32_t i = 0; i < 4; i++) {
+    columns.localBounds[i] = localBounds[i].data();
+    columns.worldBounds[i] = worldBounds[i].data();
+  }
+  columns.parentSlots = parentSlots.data();
+  columns.dirty = dirty.data();
+  return columns;
+}
+
+template <typename Lanes>
+uint32_t LveScene::updateBatch(const Columns &c, uint32_t first, bool hasParents) {
+  uint32_t dirtyCount = 0;
+  for (uint32_t lane = 0; lane < Lanes::WIDTH; lane++) {
+    uint32_t slot = first + lane;
+    // parents sit on the previous level, whose flags are final by now
+    if (hasParents) c.dirty[slot] |= c.dirty[c.parentSlots[slot]];
+    dirtyCount += c.dirty[slot];
+  }
+  // clean objects sharing a batch with a dirty one are recomputed to the same values
+  if (dirtyCount == 0) return 0;
+
+  Lanes qx = Lanes::load(c.local[QX] + first);
+  Lanes qy = Lanes::load(c.local[QY] + first);
+  Lanes qz = Lanes::load(c.local[QZ] + first);
+  Lanes qw = Lanes::load(c.local[QW] + first);
+  Lanes sx = Lanes::load(c.local[SX] + first);
+  Lanes sy = Lanes::load(c.local[SY] + first);
+  Lanes sz = Lanes::load(c.local[SZ] + first);
+  Lanes one = Lanes::set1(1.0f);
+  Lanes two = Lanes::set1(2.0f);
+  Lanes xx = qx * qx, yy = qy * qy, zz = qz * qz;
+  Lanes xy = qx * qy, xz = qx * qz, yz = qy * qz;
+  Lanes wx = qw * qx, wy = qw * qy, wz = qw * qz;
+
+  // local matrix: the rotation with each column scaled by its axis, then the translation
+  Lanes m[12] = {
+      (one - two * (yy + zz)) * sx,
+      two * (xy + wz) * sx,
+      two * (xz - wy) * sx,
+      two * (xy - wz) * sy,
+      (one - two * (xx + zz)) * sy,
+      two * (yz + wx) * sy,
+      two * (xz + wy) * sz,
+      two * (yz - wx) * sz,
+      (one - two * (xx + yy)) * sz,
+      Lanes::load(c.local[TX] + first),
+      Lanes::load(c.local[TY] + first),
+      Lanes::load(c.local[TZ] + first)};
+
+  Lanes w[12];
+  if (hasParents) {
+    alignas(32) float gathered[12][Lanes::WIDTH];
+    for (uint32_t lane = 0; lane < Lanes::WIDTH; lane++) {
+      uint32_t parent = c.parentSlots[first + lane];
+      for (uint32_t e = 0; e < 12; e++) gathered[e][lane] = c.world[e][parent];
+    }
+    Lanes p[12];
+    for (uint32_t e = 0; e < 12; e++) p[e] = Lanes::load(gathered[e]);
+
+    for (uint32_t column = 0; column < 4; column++) {
+      for (uint32_t row = 0; row < 3; row++) {
+        Lanes value = p[row] * m[column * 3] + p[3 + row] * m[column * 3 + 1] +
+                      p[6 + row] * m[column * 3 + 2];
+        w[column * 3 + row] = column == 3 ? value + p[9 + row] : value;
+      }
+    }
+  } else {
+    for (uint32_t e = 0; e < 12; e++) w[e] = m[e];
+  }
+  for (uint32_t e = 0; e < 12; e++) w[e].store(c.world[e] + first);
+
+  // the sphere center moves with the matrix and the radius grows with its largest axis scale
+  Lanes cx = Lanes::load(c.localBounds[0] + first);
+  Lanes cy = Lanes::load(c.localBounds[1] + first);
+  Lanes cz = Lanes::load(c.localBounds[2] + first);
+  for (uint32_t row = 0; row < 3; row++) {
+    Lanes center = w[row] * cx + w[3 + row] * cy + w[6 + row] * cz + w[9 + row];
+    center.store(c.worldBounds[row] + first);
+  }
+  Lanes scaleX = w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
+  Lanes scaleY = w[3] * w[3] + w[4] * w[4] + w[5] * w[5];
+  Lanes scaleZ = w[6] * w[6] + w[7] * w[7] + w[8] * w[8];
+  Lanes radius = Lanes::load(c.localBounds[3] + first) *
+                 Lanes::sqrt(Lanes::max(scaleX, Lanes::max(scaleY, scaleZ)));
+  radius.store(c.worldBounds[3] + first);
+  return dirtyCount;
+}
+
+uint32_t LveScene::updateLevel(uint32_t level) {
+  const uint32_t begin = levelStarts[level];
+  const uint32_t end = levelStarts[level + 1];
+  const bool hasParents = level > 0;
+  const Columns c = columns();
+
+  auto updateRange = [this, &c, hasParents](uint32_t first, uint32_t last) {
+    uint32_t updated = 0;
+    uint32_t slot = first;
+    if (useSimd) {
+      for (; slot + SimdLanes::WIDTH <= last; slot += SimdLanes::WIDTH) {
+        updated += updateBatch<SimdLanes>(c, slot, hasParents);
+      }
+    }
+    for (; slot < last; slot++) {
+      updated += updateBatch<ScalarLanes>(c, slot, hasParents);
+    }
+    return updated;
+  };
+
+  uint32_t chunkCount = (end - begin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  if (threadPool == nullptr || chunkCount <= 1) {
+    return updateRange(begin, end);
+  }
+  std::vector<uint32_t> updated(chunkCount, 0);
+  threadPool->parallelFor(chunkCount, [&](uint32_t chunk) {
+    uint32_t first = begin + chunk * CHUNK_SIZE;
+    updated[chunk] = updateRange(first, std::min(first + CHUNK_SIZE, end));
+  });
+  return std::accumulate(updated.begin(), updated.end(), 0u);
+}
+
+LveSceneUpdateStats LveScene::update() {
+  LveSceneUpdateStats stats{};
+  if (structureChanged) {
+    restructure();
+    structureChanged = false;
+    stats.restructured = true;
+  }
+  for (uint32_t level = 0; level + 1 < levelStarts.size(); level++) {
+    stats.updatedObjects += updateLevel(level);
+  }
+  std::fill(dirty.begin(), dirty.end(), 0);
+
+  stats.objectCount = static_cast<uint32_t>(slotIds.size());
+  stats.depthLevels = levelStarts.empty() ? 0 : static_cast<uint32_t>(levelStarts.size()) - 1;
+  return stats;
+}
+
+}  // namespace lve
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "lve_thread_pool.hpp"
+
+// std lib headers
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+using LveSceneObjectId = uint32_t;
+constexpr LveSceneObjectId LVE_SCENE_NO_PARENT = UINT32_MAX;
+
+// Transform relative to the parent: scale, then rotate, then translate.
+struct LveTransform {
+  std::array<float, 3> translation{0.0f, 0.0f, 0.0f};
+  std::array<float, 4> rotation{0.0f, 0.0f, 0.0f, 1.0f};  // unit quaternion, xyzw
+  std::array<float, 3> scale{1.0f, 1.0f, 1.0f};
+};
+
+struct LveBoundingSphere {
+  std::array<float, 3> center{0.0f, 0.0f, 0.0f};
+  float radius = 0.0f;
+};
+
+struct LveSceneUpdateStats {
+  uint32_t objectCount = 0;
+  uint32_t updatedObjects = 0;  // changed since the last update, or below something that was
+  uint32_t depthLevels = 0;
+  bool restructured = false;  // hierarchy changes re-sorted the arrays
+};
+
+// Data-oriented scene: transforms, bounds and render handles of every object live in
+// structure-of-arrays storage, one array per component, instead of one heap node per object.
+// update sorts the arrays by hierarchy depth, so each depth level is one contiguous range whose
+// parents were all finished by the level before. Levels are then split into chunks across the
+// thread pool and each chunk computes local-to-world matrices several objects at a time with SSE
+// or AVX. Setters flag objects dirty and the flag spreads down the hierarchy during update, so
+// unchanged subtrees are skipped a SIMD batch at a time.
+//
+// Object ids stay valid across the re-sorting; the slot an object occupies does not.
+class LveScene {
+ public:
+  // Without a thread pool updates run on the calling thread. useSimd false runs the same update
+  // one object at a time, for comparison.
+  explicit LveScene(LveThreadPool *threadPool = nullptr, bool useSimd = true);
+
+  LveScene(const LveScene &) = delete;
+  LveScene &operator=(const LveScene &) = delete;
+
+  LveSceneObjectId createObject(
+      LveSceneObjectId parent = LVE_SCENE_NO_PARENT,
+      const LveTransform &transform = LveTransform{},
+      const LveBoundingSphere &localBounds = LveBoundingSphere{},
+      uint32_t renderHandle = 0);
+  // Removes the object and everything below it at the next update, which frees their ids for
+  // reuse.
+  void destroyObject(LveSceneObjectId object);
+  // Throws when parent is the object itself or lies below it.
+  void setParent(LveSceneObjectId object, LveSceneObjectId parent);
+
+  void setTransform(LveSceneObjectId object, const LveTransform &transform);
+  void setTranslation(LveSceneObjectId object, const std::array<float, 3> &translation);
+  void setRotation(LveSceneObjectId object, const std::array<float, 4> &rotation);
+  void setScale(LveSceneObjectId object, const std::array<float, 3> &scale);
+  void setLocalBounds(LveSceneObjectId object, const LveBoundingSphere &bounds);
+  void setRenderHandle(LveSceneObjectId object, uint32_t renderHandle);
+
+  LveTransform getTransform(LveSceneObjectId object) const;
+  LveSceneObjectId getParent(LveSceneObjectId object) const;
+  uint32_t getRenderHandle(LveSceneObjectId object) const;
+  // as of the last update; column major, translation in elements 12-14
+  std::array<float, 16> getWorldMatrix(LveSceneObjectId object) const;
+  LveBoundingSphere getWorldBounds(LveSceneObjectId object) const;
+
+  // Recomputes the world matrix and world bounds of every object changed since the last update
+  // and of everything below it. Not safe to call concurrently with the setters.
+  LveSceneUpdateStats update();
+
+  uint32_t objectCount() const { return static_cast<uint32_t>(slotIds.size()) - removedCount; }
+  // objects a SIMD batch handles at once: 8 with AVX, 4 with SSE, 1 without either
+  static uint32_t simdWidth();
+
+ private:
+  struct Columns;
+
+  static constexpr uint32_t NO_SLOT = UINT32_MAX;
+  // objects per thread pool job; a multiple of every SIMD width
+  static constexpr uint32_t CHUNK_SIZE = 16384;
+
+  // Updates the Lanes::WIDTH objects starting at slot first and returns how many were dirty.
+  template <typename Lanes>
+  static uint32_t updateBatch(const Columns &columns, uint32_t first, bool hasParents);
+
+  uint32_t slotOf(LveSceneObjectId object) const;
+  void restructure();
+  uint32_t updateLevel(uint32_t level);
+  Columns columns();
+
+  LveThreadPool *threadPool;
+  bool useSimd;
+
+  // one entry per slot; local is tx ty tz qx qy qz qw sx sy sz, world a column-major 3x4 matrix,
+  // bounds the sphere center xyz and radius
+  std::array<std::vector<float>, 10> local;
+  std::array<std::vector<float>, 12> world;
+  std::array<std::vector<float>, 4> localBounds;
+  std::array<std::vector<float>, 4> worldBounds;
+  std::vector<uint32_t> renderHandles;
+  std::vector<LveSceneObjectId> parentIds;
+  std::vector<uint32_t> parentSlots;  // NO_SLOT for roots; valid once restructured
+  std::vector<LveSceneObjectId> slotIds;
+  std::vector<uint8_t> dirty;
+  std::vector<uint8_t> removed;
+  uint32_t removedCount = 0;
+
+  std::vector<uint32_t> idSlots;  // NO_SLOT for free ids
+  std::vector<LveSceneObjectId> freeIds;
+  // first slot of every depth level, plus the slot count at the end
+  std::vector<uint32_t> levelStarts;
+  bool structureChanged = false;
+};
+
+}  // namespace lve
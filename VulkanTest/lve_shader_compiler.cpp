@@ -0,0 +1,197 @@
+#include "lve_shader_compiler.hpp"
+
+// std headers
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace lve {
+
+namespace {
+
+// bump whenever the compile options change, so stale cache entries stop matching
+constexpr uint32_t CACHE_FORMAT_VERSION = 1;
+
+}  // namespace
+
+LveShaderCompiler::LveShaderCompiler(std::string cacheDirectory)
+    : cacheDirectory{std::move(cacheDirectory)} {
+  if (!compiler.IsValid()) {
+    throw std::runtime_error("failed to create shader compiler!");
+  }
+  options.SetSourceLanguage(shaderc_source_language_glsl);
+  options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+  options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+  std::error_code error;
+  std::filesystem::create_directories(this->cacheDirectory, error);
+}
+
+std::string LveShaderCompiler::sourcePathFor(const std::string &spirvPath) {
+  const std::string extension = ".spv";
+  if (spirvPath.size() <= extension.size() ||
+      spirvPath.compare(spirvPath.size() - extension.size(), extension.size(), extension) != 0) {
+    return "";
+  }
+  return spirvPath.substr(0, spirvPath.size() - extension.size());
+}
+
+std::vector<char> LveShaderCompiler::loadSpirv(const std::string &spirvPath) {
+  auto writeTime = sourceWriteTime(spirvPath);
+  {
+    std::lock_guard<std::mutex> lock{statsMutex};
+    auto it = prefetched.find(spirvPath);
+    if (it != prefetched.end()) {
+      if (it->second.writeTime == writeTime) {
+        prefetchHits++;
+        return it->second.spirv;
+      }
+      // edited since, e.g. by hot reload
+      prefetched.erase(it);
+    }
+  }
+  return loadFromDisk(spirvPath);
+}
+
+void LveShaderCompiler::prefetch(const std::string &spirvPath) {
+  // the write time is read first, so an edit during the load makes the entry stale, not wrong
+  Prefetched entry{sourceWriteTime(spirvPath), loadFromDisk(spirvPath)};
+  std::lock_guard<std::mutex> lock{statsMutex};
+  prefetched[spirvPath] = std::move(entry);
+}
+
+std::vector<char> LveShaderCompiler::loadFromDisk(const std::string &spirvPath) {
+  std::string glslPath = sourcePathFor(spirvPath);
+  if (!glslPath.empty() && std::filesystem::exists(glslPath)) {
+    return compile(glslPath);
+  }
+  return readFile(spirvPath);
+}
+
+std::filesystem::file_time_type LveShaderCompiler::sourceWriteTime(const std::string &spirvPath) {
+  std::error_code error;
+  std::string path = sourcePathFor(spirvPath);
+  if (path.empty() || !std::filesystem::exists(path, error)) path = spirvPath;
+  auto writeTime = std::filesystem::last_write_time(path, error);
+  return error ? std::filesystem::file_time_type::min() : writeTime;
+}
+
+std::vector<char> LveShaderCompiler::compile(const std::string &glslPath) {
+  shaderc_shader_kind kind;
+  if (!shaderKindFor(glslPath, kind)) {
+    throw std::runtime_error("unknown shader stage for " + glslPath + "!");
+  }
+
+  std::vector<char> source = readFile(glslPath);
+  std::string cachePath = cachePathFor(hashSource(kind, source));
+  std::ifstream cached{cachePath, std::ios::ate | std::ios::binary};
+  if (cached.is_open()) {
+    std::vector<char> spirv(static_cast<size_t>(cached.tellg()));
+    cached.seekg(0);
+    cached.read(spirv.data(), spirv.size());
+    if (cached && !spirv.empty() && spirv.size() % sizeof(uint32_t) == 0) {
+      std::lock_guard<std::mutex> lock{statsMutex};
+      cacheHits++;
+      return spirv;
+    }
+  }
+
+  shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
+      source.data(),
+      source.size(),
+      kind,
+      glslPath.c_str(),
+      "main",
+      options);
+  if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+    throw std::runtime_error("failed to compile " + glslPath + ":\n" + result.GetErrorMessage());
+  }
+
+  std::vector<char> spirv(
+      reinterpret_cast<const char *>(result.cbegin()),
+      reinterpret_cast<const char *>(result.cend()));
+  writeCacheFile(cachePath, spirv);
+  {
+    std::lock_guard<std::mutex> lock{statsMutex};
+    compiles++;
+  }
+  return spirv;
+}
+
+std::vector<char> LveShaderCompiler::readFile(const std::string &filepath) {
+  std::ifstream file{filepath, std::ios::ate | std::ios::binary};
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to open file: " + filepath);
+  }
+
+  std::vector<char> buffer(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(buffer.data(), buffer.size());
+  return buffer;
+}
+
+bool LveShaderCompiler::shaderKindFor(const std::string &glslPath, shaderc_shader_kind &kind) {
+  std::string extension = std::filesystem::path(glslPath).extension().string();
+  if (extension == ".vert") {
+    kind = shaderc_vertex_shader;
+  } else if (extension == ".frag") {
+    kind = shaderc_fragment_shader;
+  } else if (extension == ".comp") {
+    kind = shaderc_compute_shader;
+  } else if (extension == ".geom") {
+    kind = shaderc_geometry_shader;
+  } else if (extension == ".tesc") {
+    kind = shaderc_tess_control_shader;
+  } else if (extension == ".tese") {
+    kind = shaderc_tess_evaluation_shader;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+uint64_t LveShaderCompiler::hashSource(shaderc_shader_kind kind, const std::vector<char> &source) {
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](uint8_t byte) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  };
+  uint32_t header[2] = {CACHE_FORMAT_VERSION, static_cast<uint32_t>(kind)};
+  for (size_t i = 0; i < sizeof(header); i++) {
+    mix(reinterpret_cast<const uint8_t *>(header)[i]);
+  }
+  for (char c : source) {
+    mix(static_cast<uint8_t>(c));
+  }
+  return hash;
+}
+
+std::string LveShaderCompiler::cachePathFor(uint64_t hash) const {
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << hash << ".spv";
+  return (std::filesystem::path(cacheDirectory) / name.str()).string();
+}
+
+void LveShaderCompiler::writeCacheFile(const std::string &path, const std::vector<char> &spirv) {
+  // same as LvePipelineCache::save: never leave a truncated entry where a reader can find it.
+  // Concurrent compiles of one source write identical bytes, so the last rename wins harmlessly.
+  std::ostringstream tempPath;
+  tempPath << path << "." << std::this_thread::get_id() << ".tmp";
+  std::error_code error;
+  {
+    std::ofstream file{tempPath.str(), std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) return;  // the cache is an optimization; compiling still succeeded
+    if (!file.write(spirv.data(), spirv.size())) {
+      file.close();
+      std::filesystem::remove(tempPath.str(), error);
+      return;
+    }
+  }
+  std::filesystem::rename(tempPath.str(), path, error);
+  if (error) std::filesystem::remove(tempPath.str(), error);
+}
+
+}  // namespace lve
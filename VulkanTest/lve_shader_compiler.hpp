@@ -0,0 +1,72 @@
+#pragma once
+
+#include <shaderc/shaderc.hpp>
+
+// std lib headers
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+// Compiles GLSL to SPIR-V in process with libshaderc. Results are cached on disk under the
+// 64-bit FNV-1a hash of the stage, the compile options and the source text, so a shader whose
+// source has not changed is never compiled twice, across runs included.
+//
+// Pipelines keep naming their shaders by the SPIR-V path ("shaders/x.vert.spv"). loadSpirv
+// compiles the GLSL next to it ("shaders/x.vert") when that exists and only falls back to the
+// .spv file when it does not, as in a build that ships precompiled shaders.
+class LveShaderCompiler {
+ public:
+  static constexpr const char *DEFAULT_CACHE_DIRECTORY = "shader_cache";
+
+  explicit LveShaderCompiler(std::string cacheDirectory = DEFAULT_CACHE_DIRECTORY);
+
+  LveShaderCompiler(const LveShaderCompiler &) = delete;
+  LveShaderCompiler &operator=(const LveShaderCompiler &) = delete;
+
+  // Thread safe. Throws with the compiler's diagnostics when the GLSL does not compile.
+  std::vector<char> loadSpirv(const std::string &spirvPath);
+  // Loads the shader ahead of time, e.g. on a worker while the device is being created, and
+  // keeps the SPIR-V in memory; loadSpirv hands it out from there for as long as the file it
+  // came from is unchanged. Thread safe.
+  void prefetch(const std::string &spirvPath);
+  std::vector<char> compile(const std::string &glslPath);
+
+  // "shaders/x.vert.spv" -> "shaders/x.vert"; empty when the path does not end in .spv
+  static std::string sourcePathFor(const std::string &spirvPath);
+
+  uint32_t compileCount() const { return compiles; }
+  uint32_t cacheHitCount() const { return cacheHits; }
+  uint32_t prefetchHitCount() const { return prefetchHits; }
+
+ private:
+  struct Prefetched {
+    std::filesystem::file_time_type writeTime;
+    std::vector<char> spirv;
+  };
+
+  static std::vector<char> readFile(const std::string &filepath);
+  // of the GLSL loadSpirv would compile, else of the .spv itself
+  static std::filesystem::file_time_type sourceWriteTime(const std::string &spirvPath);
+  std::vector<char> loadFromDisk(const std::string &spirvPath);
+  static bool shaderKindFor(const std::string &glslPath, shaderc_shader_kind &kind);
+  static uint64_t hashSource(shaderc_shader_kind kind, const std::vector<char> &source);
+  std::string cachePathFor(uint64_t hash) const;
+  void writeCacheFile(const std::string &path, const std::vector<char> &spirv);
+
+  std::string cacheDirectory;
+  shaderc::Compiler compiler;
+  shaderc::CompileOptions options;
+
+  std::mutex statsMutex;
+  uint32_t compiles = 0;
+  uint32_t cacheHits = 0;
+  uint32_t prefetchHits = 0;
+  std::unordered_map<std::string, Prefetched> prefetched;  // guarded by statsMutex
+};
+
+}  // namespace lve
@@ -0,0 +1,128 @@
+#include "lve_shader_hot_reload.hpp"
+
+// std headers
+#include <iostream>
+#include <stdexcept>
+
+namespace lve {
+
+LveShaderHotReload::LveShaderHotReload(LveDevice &device, uint32_t framesInFlight)
+    : lveDevice{device}, framesInFlight{framesInFlight} {
+  watcher = std::thread([this]() { watchLoop(); });
+}
+
+LveShaderHotReload::~LveShaderHotReload() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  stopRequested.notify_all();
+  watcher.join();
+
+  vkDeviceWaitIdle(lveDevice.device());
+  retired.clear();
+}
+
+void LveShaderHotReload::addWatch(
+    const std::vector<std::string> &shaderPaths, std::function<std::function<void()>()> rebuild) {
+  Watch watch{};
+  for (const auto &shaderPath : shaderPaths) {
+    std::string sourcePath = LveShaderCompiler::sourcePathFor(shaderPath);
+    if (sourcePath.empty() || !std::filesystem::exists(sourcePath)) continue;
+    watch.sourcePaths.push_back(sourcePath);
+    watch.writeTimes.push_back(std::filesystem::last_write_time(sourcePath));
+  }
+  // precompiled shaders without a source next to them have nothing to watch, but are still
+  // rebuilt by rebuildAll
+  watch.rebuild = std::move(rebuild);
+
+  std::lock_guard<std::mutex> lock{mutex};
+  watches.push_back(std::move(watch));
+}
+
+uint32_t LveShaderHotReload::update(uint64_t submittedFrames) {
+  this->submittedFrames = submittedFrames;
+  std::vector<std::function<void()>> swaps;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    swaps.swap(pendingSwaps);
+  }
+  for (auto &swap : swaps) {
+    swap();
+  }
+
+  // frames recorded with a retired pipeline were all submitted before it was retired; once
+  // framesInFlight more frames have been submitted, beginFrame has waited on each of their fences
+  while (!retired.empty() && submittedFrames - retired.front().retiredAt > framesInFlight) {
+    retired.pop_front();
+  }
+  return static_cast<uint32_t>(swaps.size());
+}
+
+uint32_t LveShaderHotReload::rebuildAll(uint64_t submittedFrames) {
+  this->submittedFrames = submittedFrames;
+  std::vector<std::function<std::function<void()>()>> rebuilds;
+  std::vector<std::function<void()>> staleSwaps;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    rebuildAllCount++;
+    staleSwaps.swap(pendingSwaps);
+    for (const Watch &watch : watches) {
+      rebuilds.push_back(watch.rebuild);
+    }
+  }
+  // never swapped in, so never used by a frame
+  staleSwaps.clear();
+  for (auto &rebuild : rebuilds) {
+    rebuild()();
+  }
+  return static_cast<uint32_t>(rebuilds.size());
+}
+
+void LveShaderHotReload::retire(std::shared_ptr<void> pipeline) {
+  if (pipeline) {
+    retired.push_back({std::move(pipeline), submittedFrames});
+  }
+}
+
+bool LveShaderHotReload::sourcesChanged(Watch &watch) {
+  bool changed = false;
+  for (size_t i = 0; i < watch.sourcePaths.size(); i++) {
+    std::error_code error;
+    auto writeTime = std::filesystem::last_write_time(watch.sourcePaths[i], error);
+    // editors may delete and recreate a file while saving; try again on the next poll
+    if (error) continue;
+    if (writeTime != watch.writeTimes[i]) {
+      watch.writeTimes[i] = writeTime;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+void LveShaderHotReload::watchLoop() {
+  std::unique_lock<std::mutex> lock{mutex};
+  while (!stopRequested.wait_for(lock, POLL_INTERVAL, [this]() { return stopping; })) {
+    for (size_t i = 0; i < watches.size(); i++) {
+      if (!sourcesChanged(watches[i])) continue;
+
+      // compile and build without the lock so update() never waits on the compiler
+      auto rebuild = watches[i].rebuild;
+      uint64_t startedAfter = rebuildAllCount;
+      lock.unlock();
+      std::function<void()> swap;
+      try {
+        swap = rebuild();
+      } catch (const std::exception &e) {
+        std::cerr << "shader hot reload: " << e.what() << std::endl;
+      }
+      lock.lock();
+      // a rebuildAll meanwhile has rebuilt it already, possibly against a new render pass
+      if (swap && rebuildAllCount == startedAfter) {
+        pendingSwaps.push_back(std::move(swap));
+      }
+    }
+  }
+}
+
+}  // namespace lve
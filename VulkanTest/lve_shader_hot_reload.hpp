@@ -0,0 +1,98 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_shader_compiler.hpp"
+
+// std lib headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+// Watches the GLSL sources of registered pipelines and rebuilds a pipeline on a background thread
+// when one of its sources changes. The rebuilt pipeline replaces the old one in update(), which
+// the render loop calls between frames; the old pipeline is destroyed once every frame that may
+// still be using it has retired. A shader that fails to compile leaves the old pipeline in place
+// and prints the compiler's diagnostics.
+class LveShaderHotReload {
+ public:
+  static constexpr std::chrono::milliseconds POLL_INTERVAL{250};
+
+  LveShaderHotReload(LveDevice &device, uint32_t framesInFlight);
+  // Waits for the device, so retired pipelines can be destroyed safely.
+  ~LveShaderHotReload();
+
+  LveShaderHotReload(const LveShaderHotReload &) = delete;
+  LveShaderHotReload &operator=(const LveShaderHotReload &) = delete;
+
+  // Rebuilds slot with build() whenever the source of one of shaderPaths changes, and on
+  // rebuildAll. shaderPaths are the paths given to the pipeline (".spv"); build runs on the
+  // watcher thread, or the thread calling rebuildAll. slot must outlive this object.
+  template <typename Pipeline>
+  void watch(
+      std::unique_ptr<Pipeline> &slot,
+      const std::vector<std::string> &shaderPaths,
+      std::function<std::unique_ptr<Pipeline>()> build) {
+    addWatch(shaderPaths, [this, &slot, build]() -> std::function<void()> {
+      auto built = std::make_shared<std::unique_ptr<Pipeline>>(build());
+      return [this, &slot, built]() {
+        retire(std::shared_ptr<void>{std::move(slot)});
+        slot = std::move(*built);
+      };
+    });
+  }
+
+  // Swaps in pipelines rebuilt since the last call and destroys retired ones. Call outside
+  // beginFrame/endFrame with LveRenderer::submittedFrameCount(); retired pipelines are kept until
+  // every frame submitted before they were replaced has completed, however many loop iterations
+  // skipped their frame. Returns the number of pipelines swapped.
+  uint32_t update(uint64_t submittedFrames);
+  // Rebuilds every registered pipeline on the calling thread and swaps it in, retiring the old
+  // ones as update does, e.g. once the render pass they were built against has been replaced.
+  // Rebuilds pending or in progress on the watcher thread are dropped. Throws when a pipeline
+  // fails to build, since the old one cannot be used any more.
+  uint32_t rebuildAll(uint64_t submittedFrames);
+
+ private:
+  struct Watch {
+    std::vector<std::string> sourcePaths;
+    std::vector<std::filesystem::file_time_type> writeTimes;
+    // runs on the watcher thread and returns the swap to run on the render thread
+    std::function<std::function<void()>()> rebuild;
+  };
+  struct Retired {
+    std::shared_ptr<void> pipeline;
+    uint64_t retiredAt;
+  };
+
+  void addWatch(
+      const std::vector<std::string> &shaderPaths,
+      std::function<std::function<void()>()> rebuild);
+  void retire(std::shared_ptr<void> pipeline);  // during update
+  void watchLoop();
+  bool sourcesChanged(Watch &watch);
+
+  LveDevice &lveDevice;
+  uint32_t framesInFlight;
+  uint64_t submittedFrames = 0;  // as of the last update
+  std::deque<Retired> retired;
+
+  std::mutex mutex;
+  std::condition_variable stopRequested;
+  bool stopping = false;
+  std::vector<Watch> watches;
+  std::vector<std::function<void()>> pendingSwaps;
+  uint64_t rebuildAllCount = 0;  // a watcher rebuild started before the last one is stale
+  std::thread watcher;
+};
+
+}  // namespace lve
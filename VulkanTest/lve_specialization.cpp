@@ -0,0 +1,96 @@
+#include "lve_specialization.hpp"
+
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace lve {
+
+LveSpecializationConstants &LveSpecializationConstants::set(uint32_t constantId, bool value) {
+  // a SPIR-V bool constant is read as a VkBool32
+  return setWord(constantId, Kind::Bool, value ? VK_TRUE : VK_FALSE);
+}
+
+LveSpecializationConstants &LveSpecializationConstants::set(uint32_t constantId, int32_t value) {
+  return setWord(constantId, Kind::Int, static_cast<uint32_t>(value));
+}
+
+LveSpecializationConstants &LveSpecializationConstants::set(uint32_t constantId, uint32_t value) {
+  return setWord(constantId, Kind::Uint, value);
+}
+
+LveSpecializationConstants &LveSpecializationConstants::set(uint32_t constantId, float value) {
+  uint32_t word;
+  std::memcpy(&word, &value, sizeof(word));
+  return setWord(constantId, Kind::Float, word);
+}
+
+LveSpecializationConstants &LveSpecializationConstants::setWord(
+    uint32_t constantId, Kind kind, uint32_t word) {
+  auto it = std::lower_bound(
+      entries.begin(),
+      entries.end(),
+      constantId,
+      [](const VkSpecializationMapEntry &entry, uint32_t id) { return entry.constantID < id; });
+  size_t index = static_cast<size_t>(it - entries.begin());
+  if (it != entries.end() && it->constantID == constantId) {
+    kinds[index] = kind;
+    data[index] = word;
+    return *this;
+  }
+
+  entries.insert(it, VkSpecializationMapEntry{constantId, 0, sizeof(uint32_t)});
+  kinds.insert(kinds.begin() + index, kind);
+  data.insert(data.begin() + index, word);
+  // the data shifted along with the entries
+  for (size_t i = index; i < entries.size(); i++) {
+    entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+  }
+  return *this;
+}
+
+VkSpecializationInfo LveSpecializationConstants::info() const {
+  VkSpecializationInfo specializationInfo{};
+  specializationInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+  specializationInfo.pMapEntries = entries.data();
+  specializationInfo.dataSize = data.size() * sizeof(uint32_t);
+  specializationInfo.pData = data.data();
+  return specializationInfo;
+}
+
+void LveSpecializationConstants::appendKey(std::vector<uint32_t> &words) const {
+  words.push_back(static_cast<uint32_t>(entries.size()));
+  for (size_t i = 0; i < entries.size(); i++) {
+    words.push_back(entries[i].constantID);
+    words.push_back(data[i]);
+  }
+}
+
+std::string LveSpecializationConstants::describe() const {
+  std::ostringstream out;
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (i > 0) out << " ";
+    out << entries[i].constantID << "=";
+    switch (kinds[i]) {
+      case Kind::Bool:
+        out << (data[i] ? "true" : "false");
+        break;
+      case Kind::Int:
+        out << static_cast<int32_t>(data[i]);
+        break;
+      case Kind::Uint:
+        out << data[i];
+        break;
+      case Kind::Float: {
+        float value;
+        std::memcpy(&value, &data[i], sizeof(value));
+        out << value;
+        break;
+      }
+    }
+  }
+  return out.str();
+}
+
+}  // namespace lve
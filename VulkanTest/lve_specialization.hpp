@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace lve {
+
+// One specialization constant of a struct: the shader's constant_id and the member holding its
+// value. See LveSpecializationConstants::from.
+template <typename Struct, typename Member>
+struct LveSpecializationField {
+  uint32_t constantId;
+  Member Struct::*member;
+};
+
+template <typename Struct, typename Member>
+constexpr LveSpecializationField<Struct, Member> lveSpecializationField(
+    uint32_t constantId, Member Struct::*member) {
+  return {constantId, member};
+}
+
+// Values for a shader's `layout (constant_id = N) const` declarations, set on a pipeline through
+// PipelineConfigInfo::specialization. The driver compiles the pipeline with the values baked in,
+// so branches and loops on them fold away the way they would for a hand-written variant, instead
+// of being evaluated per invocation as with a uniform. The same constants go to every stage;
+// stages ignore ids they do not declare.
+//
+// Constants are bool, int32_t, uint32_t or float, matching the shader's bool, int, uint and
+// float. A variant is usually a struct whose members are its constants:
+//
+//   struct ShadingVariant {
+//     uint32_t lightCount = 1;
+//     bool specular = false;
+//     static constexpr auto specializationFields() {
+//       return std::make_tuple(
+//           lveSpecializationField(0, &ShadingVariant::lightCount),
+//           lveSpecializationField(1, &ShadingVariant::specular));
+//     }
+//   };
+//   config.specialization = LveSpecializationConstants::from(ShadingVariant{4, true});
+//
+// The values are part of the pipeline's registry key, so every variant is its own VkPipeline and
+// its own pipeline cache entry, and equal variants share one.
+class LveSpecializationConstants {
+ public:
+  template <typename Struct>
+  static LveSpecializationConstants from(const Struct &values) {
+    LveSpecializationConstants constants;
+    std::apply(
+        [&](const auto &...fields) {
+          (constants.set(fields.constantId, values.*fields.member), ...);
+        },
+        Struct::specializationFields());
+    return constants;
+  }
+
+  // Adds the constant, or replaces its value when constantId is already set.
+  LveSpecializationConstants &set(uint32_t constantId, bool value);
+  LveSpecializationConstants &set(uint32_t constantId, int32_t value);
+  LveSpecializationConstants &set(uint32_t constantId, uint32_t value);
+  LveSpecializationConstants &set(uint32_t constantId, float value);
+  // anything else would silently convert to one of the above
+  template <typename T>
+  LveSpecializationConstants &set(uint32_t constantId, T value) {
+    static_assert(
+        std::is_enum<T>::value, "specialization constants are bool, int32_t, uint32_t or float");
+    return set(constantId, static_cast<uint32_t>(value));
+  }
+
+  bool empty() const { return entries.empty(); }
+  // Points into this object; valid until it is changed or destroyed.
+  VkSpecializationInfo info() const;
+  // constant ids and values, in constant id order, for the pipeline key
+  void appendKey(std::vector<uint32_t> &words) const;
+  // e.g. "0=4 1=true", for pipeline cache reports
+  std::string describe() const;
+
+ private:
+  enum class Kind : uint32_t { Bool, Int, Uint, Float };
+
+  LveSpecializationConstants &setWord(uint32_t constantId, Kind kind, uint32_t word);
+
+  // sorted by constant id, so the same values set in any order give the same key; every
+  // constant is one 4-byte word of data
+  std::vector<VkSpecializationMapEntry> entries;
+  std::vector<Kind> kinds;
+  std::vector<uint32_t> data;
+};
+
+}  // namespace lve
@@ -0,0 +1,183 @@
+#include "lve_startup.hpp"
+
+// std headers
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+std::string escapeJson(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+}  // namespace
+
+LveStartup::LveStartup(LveThreadPool &threadPool)
+    : threadPool{threadPool}, start{Clock::now()} {}
+
+LveStartup::Stage LveStartup::addStage(
+    std::string name,
+    std::vector<Stage> dependencies,
+    std::function<void()> work,
+    bool onCallingThread) {
+  Stage stage = static_cast<Stage>(stages.size());
+  for (Stage dependency : dependencies) {
+    if (dependency >= stage) {
+      throw std::runtime_error("startup stage " + name + " depends on a stage added after it!");
+    }
+    stages[dependency].dependents.push_back(stage);
+  }
+  StageState state{};
+  state.name = std::move(name);
+  state.work = std::move(work);
+  state.onCallingThread = onCallingThread;
+  state.pendingDependencies = static_cast<uint32_t>(dependencies.size());
+  stages.push_back(std::move(state));
+  return stage;
+}
+
+void LveStartup::run() {
+  std::unique_lock<std::mutex> lock{mutex};
+  for (Stage stage = 0; stage < stages.size(); stage++) {
+    if (stages[stage].pendingDependencies == 0) schedule(stage);
+  }
+
+  while (true) {
+    if (!callingThreadQueue.empty()) {
+      Stage stage = callingThreadQueue.front();
+      callingThreadQueue.pop_front();
+      lock.unlock();
+      execute(stage, 0);
+      lock.lock();
+      continue;
+    }
+    if (runningStages == 0) break;
+    stageFinished.wait(lock);
+  }
+
+  if (failure) std::rethrow_exception(failure);
+}
+
+void LveStartup::schedule(Stage stage) {
+  // called with the mutex held
+  runningStages++;
+  if (stages[stage].onCallingThread) {
+    callingThreadQueue.push_back(stage);
+    stageFinished.notify_all();
+    return;
+  }
+  threadPool.submit([this, stage]() { execute(stage, 1 + threadPool.workerIndex()); });
+}
+
+void LveStartup::execute(Stage stage, uint32_t thread) {
+  bool skipped;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    skipped = failure != nullptr;
+  }
+
+  double begin = elapsedMilliseconds();
+  std::exception_ptr error;
+  if (!skipped) {
+    try {
+      stages[stage].work();
+    } catch (...) {
+      error = std::current_exception();
+    }
+  }
+  double end = elapsedMilliseconds();
+
+  std::lock_guard<std::mutex> lock{mutex};
+  if (!skipped) records.push_back({stages[stage].name, thread, begin, end});
+  runningStages--;
+  finishedStages++;
+  if (error && !failure) {
+    failure = error;
+    // stages waiting for the calling thread never start
+    runningStages -= static_cast<uint32_t>(callingThreadQueue.size());
+    callingThreadQueue.clear();
+  }
+  if (!failure) {
+    for (Stage dependent : stages[stage].dependents) {
+      if (--stages[dependent].pendingDependencies == 0) schedule(dependent);
+    }
+  }
+  stageFinished.notify_all();
+}
+
+double LveStartup::mark(const std::string &name) {
+  double now = elapsedMilliseconds();
+  std::lock_guard<std::mutex> lock{mutex};
+  marks.emplace_back(name, now);
+  return now;
+}
+
+double LveStartup::elapsedMilliseconds() const {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void LveStartup::printSummary(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock{mutex};
+  std::vector<LveStartupStageRecord> sorted = records;
+  std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+    return a.startMilliseconds < b.startMilliseconds;
+  });
+
+  double wallMilliseconds = 0.0;
+  double workMilliseconds = 0.0;
+  for (const auto &record : sorted) {
+    wallMilliseconds = std::max(wallMilliseconds, record.endMilliseconds);
+    workMilliseconds += record.endMilliseconds - record.startMilliseconds;
+  }
+  out << "startup: " << sorted.size() << " stages, " << workMilliseconds << " ms of work in "
+      << wallMilliseconds << " ms" << std::endl;
+  for (const auto &record : sorted) {
+    out << "\t" << std::setw(8) << record.startMilliseconds << " ms +" << std::setw(8)
+        << record.endMilliseconds - record.startMilliseconds << " ms  "
+        << (record.thread == 0 ? std::string{"main"}
+                               : "worker " + std::to_string(record.thread - 1))
+        << "\t" << record.name << std::endl;
+  }
+  for (const auto &instant : marks) {
+    out << "\t" << std::setw(8) << instant.second << " ms  " << instant.first << std::endl;
+  }
+}
+
+void LveStartup::writeChromeTrace(const std::string &path) const {
+  std::ofstream out{path};
+  if (!out.is_open()) {
+    throw std::runtime_error("failed to open " + path + "!");
+  }
+
+  // complete ("X") events per thread and instant ("i") events, in microseconds
+  std::lock_guard<std::mutex> lock{mutex};
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  out << std::fixed << std::setprecision(3);
+  size_t eventCount = records.size() + marks.size();
+  size_t written = 0;
+  for (const auto &record : records) {
+    out << "  {\"name\": \"" << escapeJson(record.name)
+        << "\", \"cat\": \"startup\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << record.thread
+        << ", \"ts\": " << record.startMilliseconds * 1000.0
+        << ", \"dur\": " << (record.endMilliseconds - record.startMilliseconds) * 1000.0 << "}"
+        << (++written < eventCount ? "," : "") << "\n";
+  }
+  for (const auto &instant : marks) {
+    out << "  {\"name\": \"" << escapeJson(instant.first)
+        << "\", \"cat\": \"startup\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 0, \"tid\": 0, "
+        << "\"ts\": " << instant.second * 1000.0 << "}" << (++written < eventCount ? "," : "")
+        << "\n";
+  }
+  out << "]}" << std::endl;
+}
+
+}  // namespace lve
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "lve_thread_pool.hpp"
+
+// std lib headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+struct LveStartupStageRecord {
+  std::string name;
+  uint32_t thread;  // 0 for the thread calling run, 1 + the worker index for pool workers
+  double startMilliseconds;  // since the LveStartup was created
+  double endMilliseconds;
+};
+
+// Runs engine initialisation as a graph of stages instead of one after the other: each stage
+// starts as soon as the stages it depends on have finished, on a thread pool worker, or on the
+// thread calling run for work that must stay there, like GLFW window creation. Every stage is
+// timed from the moment the LveStartup was created, and mark() adds instants such as the first
+// presented frame, so the whole startup can be written out as a Chrome trace.
+//
+// Dependencies must be added before the stages that depend on them, which rules out cycles. A
+// stage that throws stops any stage that has not started yet; run waits for the running ones and
+// rethrows the first exception.
+class LveStartup {
+ public:
+  using Stage = uint32_t;
+
+  explicit LveStartup(LveThreadPool &threadPool);
+
+  LveStartup(const LveStartup &) = delete;
+  LveStartup &operator=(const LveStartup &) = delete;
+
+  Stage addStage(
+      std::string name,
+      std::vector<Stage> dependencies,
+      std::function<void()> work,
+      bool onCallingThread = false);
+  // Not reentrant: a stage may not wait on work it submits to the same pool unless it runs on the
+  // calling thread.
+  void run();
+
+  // records an instant, e.g. "first frame"; returns its time since creation
+  double mark(const std::string &name);
+  double elapsedMilliseconds() const;
+
+  const std::vector<LveStartupStageRecord> &stageRecords() const { return records; }
+  void printSummary(std::ostream &out) const;
+  void writeChromeTrace(const std::string &path) const;
+
+ private:
+  using Clock = std::chrono::high_resolution_clock;
+
+  struct StageState {
+    std::string name;
+    std::function<void()> work;
+    bool onCallingThread;
+    uint32_t pendingDependencies = 0;
+    std::vector<Stage> dependents;
+  };
+
+  void schedule(Stage stage);
+  void execute(Stage stage, uint32_t thread);
+
+  LveThreadPool &threadPool;
+  Clock::time_point start;
+
+  std::vector<StageState> stages;
+  mutable std::mutex mutex;
+  std::condition_variable stageFinished;
+  std::deque<Stage> callingThreadQueue;
+  uint32_t finishedStages = 0;
+  uint32_t runningStages = 0;
+  std::exception_ptr failure;
+
+  std::vector<LveStartupStageRecord> records;
+  std::vector<std::pair<std::string, double>> marks;
+};
+
+}  // namespace lve
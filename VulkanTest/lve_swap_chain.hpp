@@ -0,0 +1,128 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// How the present mode is picked from what the surface supports. Every policy falls back to
+// FIFO, the only mode the spec guarantees.
+enum class LvePresentPolicy {
+  LowLatency,   // MAILBOX: newest frame wins, no tearing
+  PowerSaving,  // FIFO: vsync, the GPU idles once the queue is full
+  Benchmark,    // IMMEDIATE: uncapped, may tear
+};
+
+class LveSwapChain {
+ public:
+  static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+  // With a previous swap chain, e.g. after a resize, the new one is created as its
+  // oldSwapchain and takes over its per-frame fences and semaphores, so frames still in flight
+  // keep pacing the new chain, and its render pass when the formats match, so pipelines built
+  // against it stay valid. previous must then stay alive until the frames in flight that used it
+  // have completed.
+  LveSwapChain(
+      LveDevice &deviceRef,
+      VkExtent2D windowExtent,
+      LvePresentPolicy presentPolicy,
+      uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT,
+      LveSwapChain *previous = nullptr);
+  ~LveSwapChain();
+
+  LveSwapChain(const LveSwapChain &) = delete;
+  LveSwapChain &operator=(const LveSwapChain &) = delete;
+
+  VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
+  VkRenderPass getRenderPass() { return renderPass; }
+  VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+  // depth is stored and sampleable so later passes can read it, see LveCullingSystem
+  VkImage getDepthImage(int index) { return depthImages[index]; }
+  VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
+  size_t imageCount() { return swapChainImages.size(); }
+  uint32_t framesInFlight() const { return maxFramesInFlight; }
+  VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+  VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+  VkPresentModeKHR getPresentMode() { return presentMode; }
+  uint32_t width() { return swapChainExtent.width; }
+  uint32_t height() { return swapChainExtent.height; }
+
+  // true when the formats differ from the previous swap chain's, so pipelines built against its
+  // render pass cannot be used with this one's
+  bool replacedRenderPass() const { return renderPassReplaced; }
+
+  // same attachment formats, so framebuffers and pipelines of one can be used with the other
+  bool compareSwapFormats(const LveSwapChain &other) const {
+    return swapChainImageFormat == other.swapChainImageFormat &&
+           swapChainDepthFormat == other.swapChainDepthFormat;
+  }
+
+  float extentAspectRatio() {
+    return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
+  }
+  VkFormat findDepthFormat();
+
+  // Blocks until the current frame slot's previous submission has retired, then acquires an
+  // image. The time spent blocked is reported through lastCpuWaitMilliseconds.
+  VkResult acquireNextImage(uint32_t *imageIndex);
+  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  double lastCpuWaitMilliseconds() const { return cpuWaitMilliseconds; }
+  // signals when the last frame submitted from this slot has completed
+  VkFence getInFlightFence(size_t frameIndex) { return inFlightFences[frameIndex]; }
+
+ private:
+  void createSwapChain(VkSwapchainKHR oldSwapChain);
+  void createImageViews();
+  void createDepthResources();
+  void createRenderPass();
+  void createFramebuffers();
+  void createSyncObjects();
+  void adoptSyncObjects(LveSwapChain &previous);
+
+  // Helper functions
+  VkSurfaceFormatKHR chooseSwapSurfaceFormat(
+      const std::vector<VkSurfaceFormatKHR> &availableFormats);
+  VkPresentModeKHR chooseSwapPresentMode(
+      const std::vector<VkPresentModeKHR> &availablePresentModes);
+  VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
+
+  VkFormat swapChainImageFormat;
+  VkFormat swapChainDepthFormat;
+  VkExtent2D swapChainExtent;
+  VkPresentModeKHR presentMode;
+
+  std::vector<VkFramebuffer> swapChainFramebuffers;
+  VkRenderPass renderPass;
+
+  std::vector<VkImage> depthImages;
+  std::vector<LveAllocation *> depthImageMemorys;
+  std::vector<VkImageView> depthImageViews;
+  std::vector<VkImage> swapChainImages;
+  std::vector<VkImageView> swapChainImageViews;
+
+  LveDevice &device;
+  VkExtent2D windowExtent;
+  LvePresentPolicy presentPolicy;
+  uint32_t maxFramesInFlight;
+
+  VkSwapchainKHR swapChain;
+  bool recreated = false;
+  bool renderPassReplaced = false;
+
+  // per frame slot
+  std::vector<VkSemaphore> imageAvailableSemaphores;
+  std::vector<VkFence> inFlightFences;
+  // per swap chain image: presentation may still be reading the semaphore of an earlier frame
+  std::vector<VkSemaphore> renderFinishedSemaphores;
+  std::vector<VkFence> imagesInFlight;
+  size_t currentFrame = 0;
+  double cpuWaitMilliseconds = 0.0;
+};
+
+}  // namespace lve
@@ -0,0 +1,394 @@
+#include "lve_texture_streamer.hpp"
+
+// std headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve {
+
+LveTextureStreamer::LveTextureStreamer(
+    LveDevice &device, LveThreadPool &threadPool, const LveTextureStreamerOptions &options)
+    : lveDevice{device},
+      threadPool{threadPool},
+      options{options},
+      retired(std::max(1u, options.framesInFlight)) {}
+
+LveTextureStreamer::~LveTextureStreamer() {
+  // the images may still be the destination of an upload, but not sampled: the owner waits for
+  // the device to go idle before destroying the streamer
+  for (auto &texture : textures) {
+    if (!texture.pending) continue;
+    if (texture.job.valid()) {
+      try {
+        texture.pendingTicket = texture.job.get();
+      } catch (const std::exception &) {
+        continue;  // the upload was never recorded
+      }
+    }
+    lveDevice.uploadManager().wait(texture.pendingTicket);
+  }
+  for (auto &texture : textures) {
+    destroyImage(texture.pendingImage);
+    destroyImage(texture.resident);
+  }
+  for (auto &frameRetired : retired) {
+    for (auto &image : frameRetired) {
+      destroyImage(image);
+    }
+  }
+}
+
+LveTextureId LveTextureStreamer::load(const std::string &path) {
+  Texture texture{};
+  texture.path = path;
+  texture.file = std::make_unique<LveKtx2File>(path);
+  const LveKtx2File &file = *texture.file;
+  try {
+    lveDevice.findSupportedFormat(
+        {file.format()},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+  } catch (const std::runtime_error &) {
+    throw std::runtime_error(path + " has a format this device cannot sample!");
+  }
+
+  texture.tailTopMip = file.levelCount() - 1;
+  for (uint32_t level = 0; level < file.levelCount(); level++) {
+    if (std::max(file.levelWidth(level), file.levelHeight(level)) <= options.residentTailSize) {
+      texture.tailTopMip = level;
+      break;
+    }
+  }
+  texture.residentTopMip = texture.tailTopMip;
+  texture.wantedTopMip = texture.tailTopMip;
+  texture.targetTopMip = texture.tailTopMip;
+
+  texture.resident = createImage(file, texture.tailTopMip);
+  lveDevice.uploadManager().wait(uploadLevels(file, texture.resident.image, texture.tailTopMip));
+  uploadedBytes += levelBytes(file, texture.tailTopMip);
+
+  std::lock_guard<std::mutex> lock{footprintMutex};
+  texture.lastSeenFrame = frameCounter;
+  textures.push_back(std::move(texture));
+  return static_cast<LveTextureId>(textures.size() - 1);
+}
+
+void LveTextureStreamer::reportFootprint(LveTextureId texture, float screenPixels) {
+  std::lock_guard<std::mutex> lock{footprintMutex};
+  Texture &reported = textures.at(texture);
+  reported.footprint = std::max(reported.footprint, screenPixels);
+}
+
+void LveTextureStreamer::update(uint32_t frameIndex, VkCommandBuffer commandBuffer) {
+  currentFrame = frameIndex % static_cast<uint32_t>(retired.size());
+  for (auto &image : retired[currentFrame]) {
+    destroyImage(image);
+  }
+  retired[currentFrame].clear();
+
+  // beginFrame recorded the acquires of the uploads complete by then; a ticket that completed
+  // since queued its acquire in isComplete, so record it here, before anything samples the image
+  if (collectFinishedRequests()) {
+    lveDevice.uploadManager().recordAcquireBarriers(commandBuffer);
+  }
+  updateTargets();
+  issueRequests();
+}
+
+VkImageView LveTextureStreamer::getImageView(LveTextureId texture) const {
+  return textures.at(texture).resident.view;
+}
+
+VkFormat LveTextureStreamer::getFormat(LveTextureId texture) const {
+  return textures.at(texture).file->format();
+}
+
+LveTextureStreamingInfo LveTextureStreamer::getInfo(LveTextureId texture) const {
+  const Texture &streamed = textures.at(texture);
+  LveTextureStreamingInfo info{};
+  info.width = streamed.file->width();
+  info.height = streamed.file->height();
+  info.levelCount = streamed.file->levelCount();
+  info.residentTopMip = streamed.residentTopMip;
+  info.wantedTopMip = streamed.wantedTopMip;
+  info.targetTopMip = streamed.targetTopMip;
+  info.mipBias = streamed.targetTopMip - streamed.wantedTopMip;
+  info.residentBytes = streamed.resident.bytes;
+  info.pending = streamed.pending;
+  info.error = streamed.error;
+  return info;
+}
+
+LveTextureStreamerStats LveTextureStreamer::getStats() const {
+  LveTextureStreamerStats stats{};
+  stats.textureCount = static_cast<uint32_t>(textures.size());
+  stats.budgetBytes = options.budgetBytes;
+  for (const auto &texture : textures) {
+    stats.residentBytes += texture.resident.bytes;
+    if (texture.pending) {
+      stats.pendingRequests++;
+      stats.pendingBytes += texture.pendingImage.bytes;
+    }
+    if (texture.targetTopMip > texture.wantedTopMip) stats.biasedTextures++;
+  }
+  for (const auto &frameRetired : retired) {
+    for (const auto &image : frameRetired) {
+      stats.pendingBytes += image.bytes;
+    }
+  }
+  stats.completedRequests = completedRequests;
+  stats.failedRequests = failedRequests;
+  stats.evictions = evictions;
+  stats.uploadedBytes = uploadedBytes;
+  return stats;
+}
+
+void LveTextureStreamer::printStats(std::ostream &out) const {
+  LveTextureStreamerStats stats = getStats();
+  out << "texture streaming: " << stats.textureCount << " textures, "
+      << stats.residentBytes / 1024 << " KiB resident of " << stats.budgetBytes / 1024
+      << " KiB budget, " << stats.pendingBytes / 1024 << " KiB pending, "
+      << stats.pendingRequests << " requests in flight, " << stats.completedRequests
+      << " completed, " << stats.failedRequests << " failed, " << stats.evictions
+      << " evictions, " << stats.uploadedBytes / 1024 << " KiB uploaded" << std::endl;
+  for (LveTextureId id = 0; id < textures.size(); id++) {
+    LveTextureStreamingInfo info = getInfo(id);
+    out << "\t" << id << ": " << info.width << "x" << info.height << ", mip "
+        << info.residentTopMip << " resident, wanted " << info.wantedTopMip << ", bias "
+        << info.mipBias << ", " << info.residentBytes / 1024 << " KiB"
+        << (info.pending ? ", streaming" : "")
+        << (info.error.empty() ? "" : ", failed: " + info.error) << std::endl;
+  }
+}
+
+LveTextureStreamer::StreamedImage LveTextureStreamer::createImage(
+    const LveKtx2File &file, uint32_t topMip) {
+  StreamedImage streamed{};
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = file.levelWidth(topMip);
+  imageInfo.extent.height = file.levelHeight(topMip);
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = file.levelCount() - topMip;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = file.format();
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  lveDevice.createImageWithInfo(
+      imageInfo,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      streamed.image,
+      streamed.memory,
+      LveMemoryCategory::Texture);
+  streamed.bytes = streamed.memory->size;
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = streamed.image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = file.format();
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = imageInfo.mipLevels;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = 1;
+  if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &streamed.view) != VK_SUCCESS) {
+    lveDevice.destroyImage(streamed.image, streamed.memory);
+    throw std::runtime_error("failed to create streamed texture image view!");
+  }
+  return streamed;
+}
+
+void LveTextureStreamer::destroyImage(StreamedImage &image) {
+  if (image.image == VK_NULL_HANDLE) return;
+  vkDestroyImageView(lveDevice.device(), image.view, nullptr);
+  lveDevice.destroyImage(image.image, image.memory);
+  image = StreamedImage{};
+}
+
+LveUploadTicket LveTextureStreamer::uploadLevels(
+    const LveKtx2File &file, VkImage image, uint32_t topMip) {
+  LveUploadManager &uploadManager = lveDevice.uploadManager();
+  // level groups are kept to half the ring, so a group never waits for the whole ring to drain
+  VkDeviceSize groupLimit = uploadManager.stagingRingSize() / 2;
+  std::vector<LveImageMipData> mips;
+  uint32_t groupBase = 0;
+  VkDeviceSize groupBytes = 0;
+  LveUploadTicket ticket = 0;
+  for (uint32_t level = topMip; level < file.levelCount(); level++) {
+    VkDeviceSize size = file.levelSize(level);
+    if (!mips.empty() && groupBytes + size > groupLimit) {
+      ticket = uploadManager.uploadImageMips(
+          image,
+          groupBase,
+          mips.data(),
+          static_cast<uint32_t>(mips.size()));
+      groupBase += static_cast<uint32_t>(mips.size());
+      mips.clear();
+      groupBytes = 0;
+    }
+    mips.push_back({file.levelWidth(level), file.levelHeight(level), file.levelData(level), size});
+    groupBytes += size;
+  }
+  ticket = uploadManager.uploadImageMips(
+      image,
+      groupBase,
+      mips.data(),
+      static_cast<uint32_t>(mips.size()));
+  uploadManager.flush();
+  return ticket;
+}
+
+bool LveTextureStreamer::collectFinishedRequests() {
+  bool swapped = false;
+  for (auto &texture : textures) {
+    if (!texture.pending) continue;
+    if (texture.job.valid()) {
+      if (texture.job.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+      try {
+        texture.pendingTicket = texture.job.get();
+      } catch (const std::exception &e) {
+        // earlier level groups may have been recorded before the failing one; tickets complete
+        // in order, so once everything submitted so far is done the image is free to go
+        LveUploadManager &uploadManager = lveDevice.uploadManager();
+        uploadManager.wait(uploadManager.flush());
+        destroyImage(texture.pendingImage);
+        texture.pending = false;
+        texture.failedTopMip = texture.pendingTopMip;
+        texture.error = e.what();
+        failedRequests++;
+        std::cerr << "texture streaming: " << texture.path << ": " << e.what() << std::endl;
+        continue;
+      }
+    }
+    if (!lveDevice.uploadManager().isComplete(texture.pendingTicket)) continue;
+
+    if (texture.pendingTopMip > texture.residentTopMip) evictions++;
+    retired[currentFrame].push_back(texture.resident);
+    texture.resident = texture.pendingImage;
+    texture.residentTopMip = texture.pendingTopMip;
+    texture.pendingImage = StreamedImage{};
+    texture.pending = false;
+    texture.error.clear();
+    completedRequests++;
+    swapped = true;
+  }
+  return swapped;
+}
+
+void LveTextureStreamer::updateTargets() {
+  // visible textures in order of footprint, unseen ones first
+  std::vector<std::pair<float, LveTextureId>> priorities;
+  priorities.reserve(textures.size());
+  {
+    std::lock_guard<std::mutex> lock{footprintMutex};
+    frameCounter++;
+    for (LveTextureId id = 0; id < textures.size(); id++) {
+      Texture &texture = textures[id];
+      float priority = 0.0f;
+      if (texture.footprint > 0.0f) {
+        texture.lastSeenFrame = frameCounter;
+        texture.wantedTopMip = wantedTopMip(texture);
+        priority = texture.footprint;
+      } else if (frameCounter - texture.lastSeenFrame > options.unseenFramesBeforeEviction) {
+        texture.wantedTopMip = texture.tailTopMip;
+      }
+      texture.footprint = 0.0f;
+      priorities.push_back({priority, id});
+    }
+  }
+
+  VkDeviceSize total = 0;
+  for (auto &texture : textures) {
+    texture.targetTopMip = texture.wantedTopMip;
+    total += levelBytes(*texture.file, texture.targetTopMip);
+  }
+  if (total <= options.budgetBytes) return;
+
+  // over budget: drop levels from the least visible textures first, down to their tails
+  std::stable_sort(priorities.begin(), priorities.end());
+  for (const auto &priority : priorities) {
+    Texture &texture = textures[priority.second];
+    while (total > options.budgetBytes && texture.targetTopMip < texture.tailTopMip) {
+      total -= texture.file->levelSize(texture.targetTopMip);
+      texture.targetTopMip++;
+    }
+    if (total <= options.budgetBytes) break;
+  }
+}
+
+void LveTextureStreamer::issueRequests() {
+  uint32_t inFlight = 0;
+  std::vector<LveTextureId> evict;
+  std::vector<LveTextureId> refine;
+  for (LveTextureId id = 0; id < textures.size(); id++) {
+    const Texture &texture = textures[id];
+    if (texture.pending) {
+      inFlight++;
+    } else if (texture.targetTopMip == texture.failedTopMip) {
+      continue;
+    } else if (texture.targetTopMip > texture.residentTopMip) {
+      evict.push_back(id);
+    } else if (texture.targetTopMip < texture.residentTopMip) {
+      refine.push_back(id);
+    }
+  }
+  // evictions go first since they free memory; then the textures missing the most detail
+  std::stable_sort(refine.begin(), refine.end(), [this](LveTextureId a, LveTextureId b) {
+    return textures[a].residentTopMip - textures[a].targetTopMip >
+           textures[b].residentTopMip - textures[b].targetTopMip;
+  });
+  std::vector<LveTextureId> requests = std::move(evict);
+  requests.insert(requests.end(), refine.begin(), refine.end());
+
+  for (LveTextureId id : requests) {
+    if (inFlight >= options.maxRequestsInFlight) break;
+    Texture &texture = textures[id];
+    texture.pendingTopMip = texture.targetTopMip;
+    texture.pendingImage = createImage(*texture.file, texture.pendingTopMip);
+    texture.pending = true;
+
+    // the job reads the mapped file, so page faults on cold data happen off the render thread
+    auto promise = std::make_shared<std::promise<LveUploadTicket>>();
+    texture.job = promise->get_future();
+    const LveKtx2File *file = texture.file.get();
+    VkImage image = texture.pendingImage.image;
+    uint32_t topMip = texture.pendingTopMip;
+    threadPool.submit([this, promise, file, image, topMip]() {
+      try {
+        promise->set_value(uploadLevels(*file, image, topMip));
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    });
+    uploadedBytes += levelBytes(*texture.file, topMip);
+    inFlight++;
+  }
+}
+
+uint32_t LveTextureStreamer::wantedTopMip(const Texture &texture) const {
+  float largest = static_cast<float>(std::max(texture.file->width(), texture.file->height()));
+  // one texel per pixel: every halving of the footprint drops one level
+  float level = std::floor(std::log2(largest / std::max(texture.footprint, 1.0f)));
+  if (level <= 0.0f) return 0;
+  return std::min(static_cast<uint32_t>(level), texture.tailTopMip);
+}
+
+VkDeviceSize LveTextureStreamer::levelBytes(const LveKtx2File &file, uint32_t topMip) {
+  VkDeviceSize bytes = 0;
+  for (uint32_t level = topMip; level < file.levelCount(); level++) {
+    bytes += file.levelSize(level);
+  }
+  return bytes;
+}
+
+}  // namespace lve
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_ktx2_file.hpp"
+#include "lve_swap_chain.hpp"
+#include "lve_thread_pool.hpp"
+#include "lve_upload_manager.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+using LveTextureId = uint32_t;
+
+struct LveTextureStreamerOptions {
+  VkDeviceSize budgetBytes = 256ull * 1024 * 1024;
+  // mips no larger than this stay resident from load to destruction, so a texture always has
+  // something to sample
+  uint32_t residentTailSize = 64;
+  uint32_t maxRequestsInFlight = 8;
+  // a texture no footprint was reported for in this many frames falls back to its tail
+  uint32_t unseenFramesBeforeEviction = 120;
+  uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+};
+
+struct LveTextureStreamingInfo {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t levelCount = 0;
+  uint32_t residentTopMip = 0;  // finest mip level in memory
+  uint32_t wantedTopMip = 0;    // finest mip level the reported footprint asks for
+  uint32_t targetTopMip = 0;    // what the budget allows, streamed towards
+  uint32_t mipBias = 0;         // targetTopMip - wantedTopMip, levels given up to the budget
+  VkDeviceSize residentBytes = 0;
+  bool pending = false;
+  std::string error;  // why the last request failed, empty once one succeeds
+};
+
+struct LveTextureStreamerStats {
+  uint32_t textureCount = 0;
+  VkDeviceSize residentBytes = 0;  // images currently sampled from
+  VkDeviceSize pendingBytes = 0;   // images being uploaded or waiting to be retired
+  VkDeviceSize budgetBytes = 0;
+  uint32_t pendingRequests = 0;
+  uint32_t biasedTextures = 0;  // textures held coarser than wanted by the budget
+  uint64_t completedRequests = 0;
+  uint64_t failedRequests = 0;
+  uint64_t evictions = 0;
+  uint64_t uploadedBytes = 0;
+};
+
+// Streams the mip levels of KTX2 textures by on-screen footprint under a memory budget. Each
+// texture lives in an image holding only its resident levels [residentTopMip, levelCount); level
+// 0 of the image is the finest resident mip, so sampling picks the right level with no shader
+// changes. Changing residency builds a new image in the background, uploads its levels straight
+// from the mapped file through the device's upload manager and swaps it in once the copy has
+// completed, retiring the old image once the frames in flight are done with it.
+//
+// The image view of a texture changes when it is swapped, so fetch getImageView every frame and
+// write it into per-frame descriptor sets, e.g. from LveDescriptorAllocator.
+class LveTextureStreamer {
+ public:
+  LveTextureStreamer(
+      LveDevice &device,
+      LveThreadPool &threadPool,
+      const LveTextureStreamerOptions &options = LveTextureStreamerOptions{});
+  ~LveTextureStreamer();
+
+  LveTextureStreamer(const LveTextureStreamer &) = delete;
+  LveTextureStreamer &operator=(const LveTextureStreamer &) = delete;
+
+  // Maps the file and uploads its coarse tail, waiting for that upload; finer levels stream in
+  // as footprints are reported.
+  LveTextureId load(const std::string &path);
+
+  // screenPixels is the larger on-screen extent, in pixels, of a surface showing the whole
+  // texture once. The largest report since the last update wins. Safe to call from any thread.
+  void reportFootprint(LveTextureId texture, float screenPixels);
+
+  // Swaps in finished uploads, recomputes targets against the budget and issues new requests.
+  // Call once per frame after LveRenderer::beginFrame, which has waited for the frame that last
+  // used frameIndex, with the frame's command buffer and before recording anything that samples
+  // the textures: with a dedicated transfer queue, the ownership acquire and layout transition of
+  // a swapped-in image are recorded into commandBuffer ahead of the first use.
+  void update(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+
+  VkImageView getImageView(LveTextureId texture) const;
+  VkFormat getFormat(LveTextureId texture) const;
+  uint32_t textureCount() const { return static_cast<uint32_t>(textures.size()); }
+
+  void setBudget(VkDeviceSize budgetBytes) { options.budgetBytes = budgetBytes; }
+  LveTextureStreamingInfo getInfo(LveTextureId texture) const;
+  LveTextureStreamerStats getStats() const;
+  void printStats(std::ostream &out) const;
+
+ private:
+  struct StreamedImage {
+    VkImage image = VK_NULL_HANDLE;
+    LveAllocation *memory = nullptr;
+    VkImageView view = VK_NULL_HANDLE;
+    VkDeviceSize bytes = 0;
+  };
+
+  struct Texture {
+    std::string path;
+    std::unique_ptr<LveKtx2File> file;
+    uint32_t tailTopMip = 0;  // coarsest top level ever streamed down to
+    StreamedImage resident;
+    uint32_t residentTopMip = 0;
+    uint32_t wantedTopMip = 0;
+    uint32_t targetTopMip = 0;
+    float footprint = 0.0f;  // largest report since the last update
+    uint64_t lastSeenFrame = 0;
+
+    // at most one residency change in flight per texture
+    bool pending = false;
+    uint32_t pendingTopMip = 0;
+    StreamedImage pendingImage;
+    std::future<LveUploadTicket> job;  // copies the levels into the staging ring
+    LveUploadTicket pendingTicket = 0;  // set once job is ready
+
+    // a failed request is not repeated until the target changes
+    std::string error;
+    uint32_t failedTopMip = UINT32_MAX;
+  };
+
+  StreamedImage createImage(const LveKtx2File &file, uint32_t topMip);
+  void destroyImage(StreamedImage &image);
+  LveUploadTicket uploadLevels(const LveKtx2File &file, VkImage image, uint32_t topMip);
+  // returns true when an image was swapped in
+  bool collectFinishedRequests();
+  void updateTargets();
+  void issueRequests();
+  uint32_t wantedTopMip(const Texture &texture) const;
+  static VkDeviceSize levelBytes(const LveKtx2File &file, uint32_t topMip);
+
+  LveDevice &lveDevice;
+  LveThreadPool &threadPool;
+  LveTextureStreamerOptions options;
+
+  std::vector<Texture> textures;
+  // guards footprint and lastSeenFrame of every texture, and growing the texture list
+  mutable std::mutex footprintMutex;
+
+  // images replaced while recording frame i, destroyed when frame i comes around again
+  std::vector<std::vector<StreamedImage>> retired;
+  uint32_t currentFrame = 0;
+  uint64_t frameCounter = 0;
+  uint64_t completedRequests = 0;
+  uint64_t failedRequests = 0;
+  uint64_t evictions = 0;
+  uint64_t uploadedBytes = 0;
+};
+
+}  // namespace lve
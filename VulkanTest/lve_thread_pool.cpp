@@ -0,0 +1,126 @@
+#include "lve_thread_pool.hpp"
+
+// std headers
+#include <algorithm>
+
+namespace lve {
+
+namespace {
+
+// the pool and index of the worker running on this thread, if any
+thread_local const LveThreadPool *currentPool = nullptr;
+thread_local uint32_t currentWorker = 0;
+
+}  // namespace
+
+LveThreadPool::LveThreadPool(uint32_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  queues.reserve(threadCount);
+  for (uint32_t i = 0; i < threadCount; i++) {
+    queues.push_back(std::make_unique<WorkerQueue>());
+  }
+  workers.reserve(threadCount);
+  for (uint32_t i = 0; i < threadCount; i++) {
+    workers.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+LveThreadPool::~LveThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  jobAvailable.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+uint32_t LveThreadPool::workerIndex() const {
+  return currentPool == this ? currentWorker : threadCount();
+}
+
+void LveThreadPool::push(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    uint32_t target = currentPool == this ? currentWorker : nextQueue++ % threadCount();
+    {
+      std::lock_guard<std::mutex> queueLock{queues[target]->mutex};
+      queues[target]->jobs.push_back(std::move(job));
+    }
+    queuedJobs++;
+  }
+  jobAvailable.notify_one();
+}
+
+bool LveThreadPool::tryTake(uint32_t index, std::function<void()> &job) {
+  {
+    // own jobs newest first: they are the most likely to still be in cache
+    WorkerQueue &own = *queues[index];
+    std::lock_guard<std::mutex> lock{own.mutex};
+    if (!own.jobs.empty()) {
+      job = std::move(own.jobs.back());
+      own.jobs.pop_back();
+      return true;
+    }
+  }
+  for (uint32_t offset = 1; offset < threadCount(); offset++) {
+    WorkerQueue &victim = *queues[(index + offset) % threadCount()];
+    std::lock_guard<std::mutex> lock{victim.mutex};
+    if (!victim.jobs.empty()) {
+      job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void LveThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)> &job) {
+  std::vector<std::future<void>> results;
+  results.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    results.push_back(submit([&job, i]() { job(i); }));
+  }
+  // wait for every job before rethrowing, since they reference job
+  for (auto &result : results) result.wait();
+  for (auto &result : results) result.get();
+}
+
+void LveThreadPool::waitIdle() {
+  std::unique_lock<std::mutex> lock{mutex};
+  idle.wait(lock, [this]() { return queuedJobs == 0 && activeJobs == 0; });
+}
+
+void LveThreadPool::workerLoop(uint32_t index) {
+  currentPool = this;
+  currentWorker = index;
+  while (true) {
+    std::function<void()> job;
+    if (tryTake(index, job)) {
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        queuedJobs--;
+        activeJobs++;
+      }
+
+      // exceptions are captured by the packaged_task and surface through the job's future
+      job();
+
+      std::lock_guard<std::mutex> lock{mutex};
+      activeJobs--;
+      if (queuedJobs == 0 && activeJobs == 0) idle.notify_all();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{mutex};
+    if (stopping && queuedJobs == 0) return;
+    // queuedJobs also counts jobs another worker has just taken and not yet accounted for, so
+    // this can wake up to nothing; tryTake then comes up empty and the worker waits again
+    jobAvailable.wait(lock, [this]() { return stopping || queuedJobs > 0; });
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,72 @@
+#pragma once
+
+// std lib headers
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+// Fixed set of worker threads with one job deque each. Jobs submitted from outside the pool are
+// dealt round robin; jobs submitted by a worker go to its own deque. A worker runs its newest
+// job first and, once its deque is empty, steals the oldest job from another worker, so uneven
+// jobs even out without a single contended queue.
+class LveThreadPool {
+ public:
+  // 0 picks one worker per hardware thread
+  explicit LveThreadPool(uint32_t threadCount = 0);
+  ~LveThreadPool();
+
+  LveThreadPool(const LveThreadPool &) = delete;
+  LveThreadPool &operator=(const LveThreadPool &) = delete;
+
+  uint32_t threadCount() const { return static_cast<uint32_t>(queues.size()); }
+  // Index of the calling worker thread in [0, threadCount()), or threadCount() when called from
+  // a thread outside the pool. Lets jobs pick per-thread resources without locking.
+  uint32_t workerIndex() const;
+
+  template <typename F>
+  std::future<void> submit(F &&job) {
+    auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(job));
+    std::future<void> result = task->get_future();
+    push([task]() { (*task)(); });
+    return result;
+  }
+
+  // Runs job(i) for every i in [0, count) across the pool and waits for all of them. Rethrows
+  // the first exception a job threw.
+  void parallelFor(uint32_t count, const std::function<void(uint32_t)> &job);
+
+  // Blocks until every deque is empty and no worker is running a job.
+  void waitIdle();
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  void push(std::function<void()> job);
+  bool tryTake(uint32_t index, std::function<void()> &job);
+  void workerLoop(uint32_t index);
+
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  uint32_t nextQueue = 0;
+
+  // guards the counters below; held while pushing so a job is never taken before it is counted
+  std::mutex mutex;
+  std::condition_variable jobAvailable;
+  std::condition_variable idle;
+  uint64_t queuedJobs = 0;
+  uint32_t activeJobs = 0;
+  bool stopping = false;
+};
+
+}  // namespace lve
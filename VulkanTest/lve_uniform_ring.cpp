@@ -0,0 +1,139 @@
+#include "lve_uniform_ring.hpp"
+
+// std headers
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+LveUniformRing::LveUniformRing(
+    LveDevice &device, uint32_t framesInFlight, VkDeviceSize size, VkBufferUsageFlags usage)
+    : lveDevice{device}, frames(framesInFlight) {
+  const VkPhysicalDeviceLimits &limits = lveDevice.properties.limits;
+  offsetAlignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+  if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+    offsetAlignment = std::max(offsetAlignment, limits.minStorageBufferOffsetAlignment);
+  }
+  ringSize = alignUp(size, offsetAlignment);
+  // dynamic offsets are 32 bit
+  if (framesInFlight == 0 || ringSize == 0 || ringSize > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("failed to create uniform ring with an invalid size!");
+  }
+
+  lveDevice.createBuffer(
+      ringSize,
+      usage,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      buffer,
+      memory,
+      LveMemoryCategory::Uniform);
+}
+
+LveUniformRing::~LveUniformRing() { lveDevice.destroyBuffer(buffer, memory); }
+
+void LveUniformRing::beginFrame(uint32_t frameIndex, VkFence frameFence) {
+  std::lock_guard<std::mutex> lock{mutex};
+  previousStats = frames[currentFrame].stats;
+
+  // the slot's last frame has completed, and every frame older than it with it
+  while (std::find(liveFrames.begin(), liveFrames.end(), frameIndex) != liveFrames.end()) {
+    releaseOldestLocked();
+  }
+
+  currentFrame = frameIndex;
+  frames[frameIndex] = Frame{};
+  frames[frameIndex].fence = frameFence;
+  liveFrames.push_back(frameIndex);
+}
+
+void LveUniformRing::releaseOldestLocked() {
+  Frame &oldest = frames[liveFrames.front()];
+  usedBytes -= oldest.usedBytes;
+  oldest.usedBytes = 0;
+  liveFrames.pop_front();
+  // nothing left in flight: start over at the front so the next frame gets one contiguous range
+  if (usedBytes == 0) head = 0;
+}
+
+LveUniformAllocation LveUniformRing::allocate(VkDeviceSize size) {
+  VkDeviceSize alignedSize = alignUp(std::max<VkDeviceSize>(size, 1), offsetAlignment);
+  if (alignedSize > ringSize) {
+    throw std::runtime_error("uniform allocation does not fit in the ring!");
+  }
+
+  std::lock_guard<std::mutex> lock{mutex};
+  if (liveFrames.empty()) {
+    throw std::runtime_error("uniform ring allocation outside of beginFrame!");
+  }
+  Frame &frame = frames[currentFrame];
+
+  VkDeviceSize start;
+  VkDeviceSize skipped;
+  while (true) {
+    start = head;
+    skipped = 0;
+    if (start + alignedSize > ringSize) {
+      // the tail end is too short; skip it and wrap around
+      skipped = ringSize - start;
+      start = 0;
+    }
+    if (usedBytes + skipped + alignedSize <= ringSize) break;
+
+    // overrun: the space ahead still belongs to the oldest frame in flight
+    if (liveFrames.size() == 1) {
+      throw std::runtime_error("uniform ring is too small for one frame!");
+    }
+    VkFence oldestFence = frames[liveFrames.front()].fence;
+    if (oldestFence == VK_NULL_HANDLE) {
+      throw std::runtime_error("uniform ring overrun into a frame still in flight!");
+    }
+    if (vkGetFenceStatus(lveDevice.device(), oldestFence) != VK_SUCCESS) {
+      auto waitStart = std::chrono::high_resolution_clock::now();
+      vkWaitForFences(
+          lveDevice.device(), 1, &oldestFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+      frame.stats.overruns++;
+      frame.stats.overrunWaitMilliseconds += std::chrono::duration<double, std::milli>(
+          std::chrono::high_resolution_clock::now() - waitStart).count();
+    }
+    releaseOldestLocked();
+  }
+
+  head = start + alignedSize;
+  usedBytes += skipped + alignedSize;
+  frame.usedBytes += skipped + alignedSize;
+  frame.stats.allocations++;
+  frame.stats.bytesWritten += size;
+  frame.stats.bytesUsed += skipped + alignedSize;
+
+  LveUniformAllocation allocation{};
+  allocation.buffer = buffer;
+  allocation.dynamicOffset = static_cast<uint32_t>(start);
+  allocation.size = size;
+  allocation.mapped = static_cast<char *>(memory->mapped) + start;
+  return allocation;
+}
+
+LveUniformAllocation LveUniformRing::write(const void *data, VkDeviceSize size) {
+  LveUniformAllocation allocation = allocate(size);
+  std::memcpy(allocation.mapped, data, static_cast<size_t>(size));
+  return allocation;
+}
+
+LveUniformRingStats LveUniformRing::frameStats() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return frames[currentFrame].stats;
+}
+
+LveUniformRingStats LveUniformRing::lastFrameStats() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return previousStats;
+}
+
+}  // namespace lve
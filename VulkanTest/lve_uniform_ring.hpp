@@ -0,0 +1,107 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+// A sub-range of the ring's buffer. Bind the buffer once with a dynamic uniform or storage
+// descriptor and pass dynamicOffset with each draw; write through mapped until the frame is
+// submitted.
+struct LveUniformAllocation {
+  VkBuffer buffer = VK_NULL_HANDLE;
+  uint32_t dynamicOffset = 0;
+  VkDeviceSize size = 0;
+  void *mapped = nullptr;
+};
+
+// Counters for one frame of an LveUniformRing.
+struct LveUniformRingStats {
+  uint32_t allocations = 0;
+  VkDeviceSize bytesWritten = 0;  // as requested
+  VkDeviceSize bytesUsed = 0;     // including alignment padding and space skipped at the wrap
+  uint32_t overruns = 0;          // allocations that had to wait for an older frame's fence
+  double overrunWaitMilliseconds = 0.0;
+};
+
+// Hands out per-frame uniform data linearly from one persistently mapped, host-coherent buffer,
+// instead of a buffer created and mapped per object. Every frame in flight owns the range it
+// allocated from until beginFrame comes back to its slot, whose fence the renderer has waited on
+// by then; the ring wraps around behind it. Ranges are aligned to
+// minUniformBufferOffsetAlignment (and minStorageBufferOffsetAlignment), so their offsets can be
+// used as dynamic offsets directly.
+//
+// An allocation that would run into a range still owned by an older frame is an overrun. With the
+// frames' fences passed to beginFrame the ring checks the oldest one, reclaims it when it has
+// signaled and otherwise waits for it, counting the stall; without fences it throws. A single
+// frame larger than the ring always throws.
+class LveUniformRing {
+ public:
+  static constexpr VkDeviceSize DEFAULT_SIZE = 16ull * 1024 * 1024;
+
+  LveUniformRing(
+      LveDevice &device,
+      uint32_t framesInFlight,
+      VkDeviceSize size = DEFAULT_SIZE,
+      VkBufferUsageFlags usage =
+          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+  ~LveUniformRing();
+
+  LveUniformRing(const LveUniformRing &) = delete;
+  LveUniformRing &operator=(const LveUniformRing &) = delete;
+
+  // Releases what frameIndex allocated last time. Call after LveRenderer::beginFrame, which has
+  // waited for the frame that last used the slot; frameFence (LveRenderer::getCurrentFrameFence)
+  // signals when this frame completes and lets later overruns wait on it.
+  void beginFrame(uint32_t frameIndex, VkFence frameFence = VK_NULL_HANDLE);
+
+  // Valid until frameIndex comes around again. Safe to call from any thread.
+  LveUniformAllocation allocate(VkDeviceSize size);
+  LveUniformAllocation write(const void *data, VkDeviceSize size);
+  template <typename T>
+  LveUniformAllocation write(const T &data) {
+    return write(&data, sizeof(T));
+  }
+
+  // for a *_DYNAMIC descriptor whose draws each read range bytes at their dynamic offset
+  VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) const { return {buffer, 0, range}; }
+  VkBuffer getBuffer() const { return buffer; }
+  VkDeviceSize size() const { return ringSize; }
+  VkDeviceSize alignment() const { return offsetAlignment; }
+
+  // counters since beginFrame for the current frame
+  LveUniformRingStats frameStats() const;
+  // counters of the frame before the current one, complete once it was submitted
+  LveUniformRingStats lastFrameStats() const;
+
+ private:
+  struct Frame {
+    VkFence fence = VK_NULL_HANDLE;
+    VkDeviceSize usedBytes = 0;  // ring space held, released as a whole
+    LveUniformRingStats stats;
+  };
+
+  // frees the range of the oldest frame in flight
+  void releaseOldestLocked();
+
+  LveDevice &lveDevice;
+  VkBuffer buffer = VK_NULL_HANDLE;
+  LveAllocation *memory = nullptr;
+  VkDeviceSize ringSize;
+  VkDeviceSize offsetAlignment;
+
+  mutable std::mutex mutex;
+  std::vector<Frame> frames;
+  std::deque<uint32_t> liveFrames;  // slots holding ring space, oldest first
+  uint32_t currentFrame = 0;
+  LveUniformRingStats previousStats;
+  VkDeviceSize head = 0;
+  VkDeviceSize usedBytes = 0;  // from the oldest live frame's first byte up to head
+};
+
+}  // namespace lve
@@ -0,0 +1,449 @@
+#include "lve_upload_manager.hpp"
+
+#include "lve_device.hpp"
+
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+LveUploadManager::LveUploadManager(LveDevice &device, VkDeviceSize ringSize)
+    : lveDevice{device}, ringSize{ringSize} {
+  QueueFamilyIndices indices = lveDevice.findPhysicalQueueFamilies();
+  graphicsFamily = indices.graphicsFamily;
+  transferFamily = indices.transferFamily;
+  dedicatedQueue = indices.hasDedicatedTransfer();
+  queue = dedicatedQueue ? lveDevice.transferQueue() : lveDevice.graphicsQueue();
+  copyAlignment = std::max<VkDeviceSize>(
+      16,
+      lveDevice.properties.limits.optimalBufferCopyOffsetAlignment);
+
+  createCommandPool();
+  createStagingRing();
+}
+
+LveUploadManager::~LveUploadManager() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    submitBatch();
+    while (!inFlight.empty()) {
+      waitOldestBatch();
+    }
+  }
+
+  for (auto &batch : recycled) {
+    vkDestroyFence(lveDevice.device(), batch.fence, nullptr);
+  }
+  // destroying the pool frees every command buffer allocated from it
+  vkDestroyCommandPool(lveDevice.device(), commandPool, nullptr);
+  lveDevice.destroyBuffer(ringBuffer, ringMemory);
+}
+
+void LveUploadManager::createCommandPool() {
+  VkCommandPoolCreateInfo poolInfo = {};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.queueFamilyIndex = dedicatedQueue ? transferFamily : graphicsFamily;
+  poolInfo.flags =
+      VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+  if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create upload command pool!");
+  }
+}
+
+void LveUploadManager::createStagingRing() {
+  lveDevice.createBuffer(
+      ringSize,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      ringBuffer,
+      ringMemory,
+      LveMemoryCategory::Staging);
+}
+
+bool LveUploadManager::tryReserve(
+    VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+  if (inFlight.empty() && !recording) {
+    ringHead = 0;
+    ringTail = 0;
+  }
+  bool empty = inFlight.empty() && !recording;
+
+  VkDeviceSize start = alignUp(ringHead, alignment);
+  if (empty) {
+    if (size > ringSize) return false;
+    start = 0;
+  } else if (ringHead >= ringTail) {
+    // live data is [tail, head); the head never catches up with the tail, so equal means empty
+    if (start + size > ringSize) {
+      if (size >= ringTail) return false;
+      start = 0;
+    }
+  } else {
+    // live data wraps: [tail, end) + [0, head)
+    if (start + size >= ringTail) return false;
+  }
+
+  offset = start;
+  ringHead = start + size;
+  return true;
+}
+
+VkDeviceSize LveUploadManager::reserve(VkDeviceSize size, VkDeviceSize alignment) {
+  VkDeviceSize offset = 0;
+  while (!tryReserve(size, alignment, offset)) {
+    collect();
+    if (tryReserve(size, alignment, offset)) break;
+    // out of staging space: the only way forward is to wait for the oldest copies to finish
+    submitBatch();
+    if (inFlight.empty()) {
+      throw std::runtime_error("upload does not fit in the staging ring!");
+    }
+    waitOldestBatch();
+  }
+  return offset;
+}
+
+void LveUploadManager::beginBatch() {
+  if (recording) return;
+
+  if (!recycled.empty()) {
+    current = std::move(recycled.back());
+    recycled.pop_back();
+    vkResetCommandBuffer(current.commandBuffer, 0);
+    vkResetFences(lveDevice.device(), 1, &current.fence);
+  } else {
+    current = Batch{};
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &current.commandBuffer) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate upload command buffer!");
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &current.fence) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload fence!");
+    }
+  }
+
+  current.ticket = nextTicket++;
+  current.copyCount = 0;
+  current.bufferReleases.clear();
+  current.imageReleases.clear();
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(current.commandBuffer, &beginInfo);
+  recording = true;
+}
+
+void LveUploadManager::submitBatch() {
+  if (!recording) return;
+
+  if (dedicatedQueue) {
+    // release ownership to the graphics family; the acquire half is recordAcquireBarriers
+    vkCmdPipelineBarrier(
+        current.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(current.bufferReleases.size()),
+        current.bufferReleases.data(),
+        static_cast<uint32_t>(current.imageReleases.size()),
+        current.imageReleases.data());
+  } else {
+    // same queue as rendering: one barrier makes every copy visible to later submissions
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    vkCmdPipelineBarrier(
+        current.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1,
+        &memoryBarrier,
+        0,
+        nullptr,
+        static_cast<uint32_t>(current.imageReleases.size()),
+        current.imageReleases.data());
+  }
+
+  if (vkEndCommandBuffer(current.commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record upload command buffer!");
+  }
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &current.commandBuffer;
+  if (vkQueueSubmit(queue, 1, &submitInfo, current.fence) != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit upload batch!");
+  }
+
+  current.ringEnd = ringHead;
+  inFlight.push_back(std::move(current));
+  current = Batch{};
+  recording = false;
+}
+
+void LveUploadManager::collect() {
+  while (!inFlight.empty() &&
+         vkGetFenceStatus(lveDevice.device(), inFlight.front().fence) == VK_SUCCESS) {
+    Batch &batch = inFlight.front();
+    completedTicket = batch.ticket;
+    ringTail = batch.ringEnd;
+
+    if (dedicatedQueue) {
+      for (auto barrier : batch.bufferReleases) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        pendingBufferAcquires.push_back(barrier);
+      }
+      for (auto barrier : batch.imageReleases) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        pendingImageAcquires.push_back(barrier);
+      }
+    }
+
+    recycled.push_back(std::move(batch));
+    inFlight.pop_front();
+  }
+}
+
+void LveUploadManager::waitOldestBatch() {
+  vkWaitForFences(
+      lveDevice.device(),
+      1,
+      &inFlight.front().fence,
+      VK_TRUE,
+      std::numeric_limits<uint64_t>::max());
+  collect();
+}
+
+LveUploadTicket LveUploadManager::uploadBuffer(
+    VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size) {
+  std::lock_guard<std::mutex> lock{mutex};
+  LveUploadTicket ticket = 0;
+
+  // uploads larger than the ring are split; each chunk waits only for the space it needs
+  VkDeviceSize done = 0;
+  while (done < size) {
+    VkDeviceSize chunk = std::min(size - done, ringSize / 2);
+    VkDeviceSize offset = reserve(chunk, copyAlignment);
+    beginBatch();
+
+    std::memcpy(
+        static_cast<char *>(ringMemory->mapped) + offset,
+        static_cast<const char *>(data) + done,
+        static_cast<size_t>(chunk));
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = offset;
+    copyRegion.dstOffset = dstOffset + done;
+    copyRegion.size = chunk;
+    vkCmdCopyBuffer(current.commandBuffer, ringBuffer, dstBuffer, 1, &copyRegion);
+
+    VkBufferMemoryBarrier release{};
+    release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    release.dstAccessMask = 0;
+    release.srcQueueFamilyIndex = transferFamily;
+    release.dstQueueFamilyIndex = graphicsFamily;
+    release.buffer = dstBuffer;
+    release.offset = dstOffset + done;
+    release.size = chunk;
+    if (dedicatedQueue) {
+      current.bufferReleases.push_back(release);
+    }
+
+    ticket = current.ticket;
+    done += chunk;
+    if (++current.copyCount >= MAX_COPIES_PER_BATCH) {
+      submitBatch();
+    }
+  }
+  return ticket;
+}
+
+LveUploadTicket LveUploadManager::uploadImage(
+    VkImage dstImage,
+    uint32_t width,
+    uint32_t height,
+    uint32_t layerCount,
+    const void *data,
+    VkDeviceSize size,
+    VkImageLayout finalLayout) {
+  LveImageMipData mip{width, height, data, size};
+  std::lock_guard<std::mutex> lock{mutex};
+  return recordImageUpload(dstImage, layerCount, 0, &mip, 1, finalLayout);
+}
+
+LveUploadTicket LveUploadManager::uploadImageMips(
+    VkImage dstImage,
+    uint32_t baseMipLevel,
+    const LveImageMipData *mips,
+    uint32_t mipCount,
+    VkImageLayout finalLayout) {
+  std::lock_guard<std::mutex> lock{mutex};
+  return recordImageUpload(dstImage, 1, baseMipLevel, mips, mipCount, finalLayout);
+}
+
+LveUploadTicket LveUploadManager::recordImageUpload(
+    VkImage dstImage,
+    uint32_t layerCount,
+    uint32_t baseMipLevel,
+    const LveImageMipData *mips,
+    uint32_t mipCount,
+    VkImageLayout finalLayout) {
+  // one reservation for every level, so the levels cannot wrap around onto each other
+  std::vector<VkDeviceSize> levelOffsets(mipCount);
+  VkDeviceSize totalSize = 0;
+  for (uint32_t level = 0; level < mipCount; level++) {
+    levelOffsets[level] = totalSize;
+    totalSize += (mips[level].size + copyAlignment - 1) / copyAlignment * copyAlignment;
+  }
+  if (totalSize >= ringSize) {
+    throw std::runtime_error("image upload does not fit in the staging ring!");
+  }
+
+  VkDeviceSize offset = reserve(totalSize, copyAlignment);
+  beginBatch();
+
+  std::vector<VkBufferImageCopy> regions(mipCount);
+  for (uint32_t level = 0; level < mipCount; level++) {
+    std::memcpy(
+        static_cast<char *>(ringMemory->mapped) + offset + levelOffsets[level],
+        mips[level].data,
+        static_cast<size_t>(mips[level].size));
+
+    VkBufferImageCopy &region = regions[level];
+    region.bufferOffset = offset + levelOffsets[level];
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = baseMipLevel + level;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = layerCount;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {mips[level].width, mips[level].height, 1};
+  }
+
+  VkImageSubresourceRange range{};
+  range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  range.baseMipLevel = baseMipLevel;
+  range.levelCount = mipCount;
+  range.baseArrayLayer = 0;
+  range.layerCount = layerCount;
+
+  VkImageMemoryBarrier toTransfer{};
+  toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  toTransfer.srcAccessMask = 0;
+  toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toTransfer.image = dstImage;
+  toTransfer.subresourceRange = range;
+  vkCmdPipelineBarrier(
+      current.commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &toTransfer);
+
+  vkCmdCopyBufferToImage(
+      current.commandBuffer,
+      ringBuffer,
+      dstImage,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      mipCount,
+      regions.data());
+
+  // transitions to the final layout, and transfers ownership when on a dedicated queue
+  VkImageMemoryBarrier release = toTransfer;
+  release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  release.dstAccessMask = dedicatedQueue ? 0u : static_cast<VkAccessFlags>(VK_ACCESS_SHADER_READ_BIT);
+  release.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  release.newLayout = finalLayout;
+  if (dedicatedQueue) {
+    release.srcQueueFamilyIndex = transferFamily;
+    release.dstQueueFamilyIndex = graphicsFamily;
+  }
+  current.imageReleases.push_back(release);
+
+  LveUploadTicket ticket = current.ticket;
+  current.copyCount += mipCount;
+  if (current.copyCount >= MAX_COPIES_PER_BATCH) {
+    submitBatch();
+  }
+  return ticket;
+}
+
+LveUploadTicket LveUploadManager::flush() {
+  std::lock_guard<std::mutex> lock{mutex};
+  submitBatch();
+  return nextTicket - 1;
+}
+
+bool LveUploadManager::isComplete(LveUploadTicket ticket) {
+  std::lock_guard<std::mutex> lock{mutex};
+  collect();
+  return ticket <= completedTicket;
+}
+
+void LveUploadManager::wait(LveUploadTicket ticket) {
+  std::lock_guard<std::mutex> lock{mutex};
+  if (recording && current.ticket <= ticket) {
+    submitBatch();
+  }
+  collect();
+  while (completedTicket < ticket && !inFlight.empty()) {
+    waitOldestBatch();
+  }
+}
+
+void LveUploadManager::recordAcquireBarriers(VkCommandBuffer graphicsCommandBuffer) {
+  std::lock_guard<std::mutex> lock{mutex};
+  collect();
+  if (pendingBufferAcquires.empty() && pendingImageAcquires.empty()) return;
+
+  vkCmdPipelineBarrier(
+      graphicsCommandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      0,
+      0,
+      nullptr,
+      static_cast<uint32_t>(pendingBufferAcquires.size()),
+      pendingBufferAcquires.data(),
+      static_cast<uint32_t>(pendingImageAcquires.size()),
+      pendingImageAcquires.data());
+  pendingBufferAcquires.clear();
+  pendingImageAcquires.clear();
+}
+
+}  // namespace lve
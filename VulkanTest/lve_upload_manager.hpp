@@ -0,0 +1,131 @@
+#pragma once
+
+#include "lve_allocator.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+class LveDevice;
+
+// Identifies the submission an upload was recorded into. Tickets complete in increasing order.
+using LveUploadTicket = uint64_t;
+
+// Tightly packed source data of one mip level.
+struct LveImageMipData {
+  uint32_t width;
+  uint32_t height;
+  const void *data;
+  VkDeviceSize size;
+};
+
+// Streams data to device-local resources without stalling the graphics queue. Source data is
+// copied into a persistently mapped staging ring, copies are batched into one command buffer per
+// submission, and each submission runs on the dedicated transfer queue when the device has one.
+// Completion is tracked with a fence per batch and reported through tickets.
+//
+// With a dedicated transfer family, destination resources are released to the graphics family at
+// the end of each batch. The matching acquire barriers have to be recorded on the graphics queue
+// with recordAcquireBarriers before the resources are used there.
+class LveUploadManager {
+ public:
+  static constexpr VkDeviceSize DEFAULT_RING_SIZE = 64ull * 1024 * 1024;
+  static constexpr uint32_t MAX_COPIES_PER_BATCH = 1024;
+
+  LveUploadManager(LveDevice &device, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+  ~LveUploadManager();
+
+  LveUploadManager(const LveUploadManager &) = delete;
+  LveUploadManager &operator=(const LveUploadManager &) = delete;
+
+  LveUploadTicket uploadBuffer(
+      VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size);
+  // Uploads mip 0 of every layer; the image ends up in finalLayout.
+  LveUploadTicket uploadImage(
+      VkImage dstImage,
+      uint32_t width,
+      uint32_t height,
+      uint32_t layerCount,
+      const void *data,
+      VkDeviceSize size,
+      VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  // Uploads mips[i] to level baseMipLevel + i of a single-layer image in one copy; those levels
+  // end up in finalLayout. All of them have to fit in the staging ring at once.
+  LveUploadTicket uploadImageMips(
+      VkImage dstImage,
+      uint32_t baseMipLevel,
+      const LveImageMipData *mips,
+      uint32_t mipCount,
+      VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+  // Submits the batch being recorded, if any, and returns its ticket.
+  LveUploadTicket flush();
+  bool isComplete(LveUploadTicket ticket);
+  void wait(LveUploadTicket ticket);
+
+  // Records queue family ownership acquires for every completed upload not yet acquired. A no-op
+  // when uploads run on the graphics family.
+  void recordAcquireBarriers(VkCommandBuffer graphicsCommandBuffer);
+
+  bool usesDedicatedTransferQueue() const { return dedicatedQueue; }
+  VkDeviceSize stagingRingSize() const { return ringSize; }
+
+ private:
+  struct Batch {
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    LveUploadTicket ticket = 0;
+    VkDeviceSize ringEnd = 0;
+    uint32_t copyCount = 0;
+    std::vector<VkBufferMemoryBarrier> bufferReleases;
+    std::vector<VkImageMemoryBarrier> imageReleases;
+  };
+
+  void createCommandPool();
+  void createStagingRing();
+  void beginBatch();
+  void submitBatch();
+  // retires finished batches without blocking
+  void collect();
+  void waitOldestBatch();
+  VkDeviceSize reserve(VkDeviceSize size, VkDeviceSize alignment);
+  bool tryReserve(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+  LveUploadTicket recordImageUpload(
+      VkImage dstImage,
+      uint32_t layerCount,
+      uint32_t baseMipLevel,
+      const LveImageMipData *mips,
+      uint32_t mipCount,
+      VkImageLayout finalLayout);
+
+  LveDevice &lveDevice;
+  VkQueue queue;
+  uint32_t transferFamily;
+  uint32_t graphicsFamily;
+  bool dedicatedQueue;
+  VkCommandPool commandPool = VK_NULL_HANDLE;
+
+  VkBuffer ringBuffer = VK_NULL_HANDLE;
+  LveAllocation *ringMemory = nullptr;
+  VkDeviceSize ringSize;
+  VkDeviceSize ringHead = 0;
+  VkDeviceSize ringTail = 0;
+  VkDeviceSize copyAlignment;
+
+  std::mutex mutex;
+  Batch current;
+  bool recording = false;
+  std::deque<Batch> inFlight;
+  std::vector<Batch> recycled;
+  LveUploadTicket nextTicket = 1;
+  LveUploadTicket completedTicket = 0;
+
+  std::vector<VkBufferMemoryBarrier> pendingBufferAcquires;
+  std::vector<VkImageMemoryBarrier> pendingImageAcquires;
+};
+
+}  // namespace lve
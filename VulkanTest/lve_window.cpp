@@ -27,7 +27,21 @@ void lve::LveWindow::initWindow()
 {
 	glfwInit();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
 	window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
+	glfwSetWindowUserPointer(window, this);
+	glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+}
+
+void lve::LveWindow::framebufferResizeCallback(GLFWwindow* window, int width, int height)
+{
+	auto lveWindow = reinterpret_cast<LveWindow*>(glfwGetWindowUserPointer(window));
+	if (!lveWindow->framebufferResized)
+	{
+		lveWindow->firstResizeTime = std::chrono::high_resolution_clock::now();
+	}
+	lveWindow->framebufferResized = true;
+	lveWindow->width = width;
+	lveWindow->height = height;
 }
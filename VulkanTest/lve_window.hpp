@@ -3,6 +3,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <chrono>
 #include <string>
 
 namespace lve
@@ -17,15 +18,23 @@ namespace lve
 		LveWindow& operator=(const LveWindow&) = delete;
 
 		bool shouldClose() { return glfwWindowShouldClose(window); }
+		VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
+		bool wasWindowResized() { return framebufferResized; }
+		// when the first resize since the last reset happened, for resize-to-frame latency
+		std::chrono::high_resolution_clock::time_point resizeTime() { return firstResizeTime; }
+		void resetWindowResizedFlag() { framebufferResized = false; }
 
 		void createWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
 
 	private:
+		static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 
 		void initWindow();
 
-		const int width;
-		const int height;
+		int width;
+		int height;
+		bool framebufferResized = false;
+		std::chrono::high_resolution_clock::time_point firstResizeTime;
 
 		std::string windowName;
 		GLFWwindow* window;
@@ -1,16 +1,167 @@
 #include "first_app.hpp"
+#include "lve_benchmarks.hpp"
+#include "lve_device_selector.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_obj_loader.hpp"
 
 //std
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main()
+int main(int argc, char **argv)
 {
-	lve::FirstApp app{};
-
 	try
 	{
+		// --device <name or UUID> picks the physical device ahead of the LVE_DEVICE environment
+		// variable and the selector's own ranking; it goes before any other arguments
+		if (argc > 2 && std::strcmp(argv[1], "--device") == 0)
+		{
+			lve::LveDeviceSelector::setOverride(argv[2]);
+			argv[2] = argv[0];
+			argc -= 2;
+			argv += 2;
+		}
+
+		if (argc > 1 && std::strcmp(argv[1], "--bench-allocator") == 0)
+		{
+			int iterations = argc > 2 ? std::atoi(argv[2]) : 100000;
+			// headless, so the stress run works on display-less machines such as lavapipe
+			lve::LveDevice device{};
+			return lve::runAllocatorBenchmark(device, iterations);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-pipelines") == 0)
+		{
+			int permutations = argc > 2 ? std::atoi(argv[2]) : 500;
+			lve::LveDevice device{};
+			return lve::runPipelineBenchmark(device, permutations);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-recording") == 0)
+		{
+			uint32_t draws = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 200000;
+			int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+			lve::LveDevice device{};
+			return lve::runRecordingBenchmark(device, draws, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-descriptors") == 0)
+		{
+			uint32_t setsPerFrame = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 10000;
+			int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+			lve::LveDevice device{};
+			return lve::runDescriptorBenchmark(device, setsPerFrame, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-bindless") == 0)
+		{
+			uint32_t objects = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 10000;
+			int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+			lve::LveDevice device{};
+			return lve::runBindlessBenchmark(device, objects, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-uniforms") == 0)
+		{
+			uint32_t objects = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 10000;
+			int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+			lve::LveDevice device{};
+			return lve::runUniformBenchmark(device, objects, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-specialization") == 0)
+		{
+			int frames = argc > 2 ? std::atoi(argv[2]) : 300;
+			lve::LveDevice device{};
+			return lve::runSpecializationBenchmark(device, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-texture-streaming") == 0)
+		{
+			uint32_t textures = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 16;
+			int frames = argc > 3 ? std::atoi(argv[3]) : 600;
+			lve::LveDevice device{};
+			return lve::runTextureStreamingBenchmark(device, textures, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-render-graph") == 0)
+		{
+			int frames = argc > 2 ? std::atoi(argv[2]) : 100;
+			lve::LveDevice device{};
+			return lve::runRenderGraphBenchmark(device, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-scene") == 0)
+		{
+			uint32_t objects = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 1000000;
+			int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+			return lve::runSceneBenchmark(objects, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-mesh-load") == 0)
+		{
+			uint32_t triangles = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 1000000;
+			// loading and uploading only, so a compute or transfer device will do
+			lve::LveDevice device{ lve::LveDeviceUsage::Compute };
+			return lve::runMeshLoadBenchmark(device, triangles);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--bench-lod") == 0)
+		{
+			uint32_t triangles = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 20000;
+			int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+			lve::LveDevice device{};
+			return lve::runLodBenchmark(device, triangles, frames);
+		}
+		if (argc > 1 && std::strcmp(argv[1], "--convert-mesh") == 0)
+		{
+			bool optimize = !(argc == 5 && std::strcmp(argv[4], "--no-optimize") == 0);
+			if (argc != 4 && optimize) throw std::runtime_error("usage: --convert-mesh <input.obj> <output.lvemesh> [--no-optimize]");
+			lve::LveMeshData mesh = lve::LveObjLoader::load(argv[2]);
+			if (optimize) lve::LveMeshOptimizer::optimize(mesh).print(std::cout);
+			lve::LveMeshFile::write(argv[3], mesh);
+			std::cout << argv[3] << ": " << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3
+				<< " triangles, " << mesh.submeshes.size() << " submeshes, " << mesh.lods.size() << " reduced levels" << std::endl;
+			return EXIT_SUCCESS;
+		}
+
+		if (argc > 1 && std::strcmp(argv[1], "--bench-frames") == 0)
+		{
+			// no window and no surface: runs on display-less machines, e.g. with lavapipe selected
+			// through VK_ICD_FILENAMES
+			lve::LveFrameBenchmarkOptions options{};
+			for (int i = 2; i + 1 < argc; i += 2)
+			{
+				if (std::strcmp(argv[i], "--scene") == 0) options.scene = argv[i + 1];
+				else if (std::strcmp(argv[i], "--frames") == 0) options.frames = std::atoi(argv[i + 1]);
+				else if (std::strcmp(argv[i], "--warmup") == 0) options.warmupFrames = std::atoi(argv[i + 1]);
+				else if (std::strcmp(argv[i], "--width") == 0) options.width = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+				else if (std::strcmp(argv[i], "--height") == 0) options.height = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+				else if (std::strcmp(argv[i], "--output") == 0) options.outputPath = argv[i + 1];
+				else if (std::strcmp(argv[i], "--trace") == 0) options.tracePath = argv[i + 1];
+				else throw std::runtime_error(std::string("unknown option: ") + argv[i]);
+			}
+			lve::LveDevice device{};
+			return lve::runFrameBenchmark(device, options);
+		}
+
+		lve::LvePresentPolicy presentPolicy = lve::LvePresentPolicy::LowLatency;
+		double startupBudgetMilliseconds = 0.0;
+		for (int i = 1; i + 1 < argc; i++)
+		{
+			if (std::strcmp(argv[i], "--startup-budget") == 0) startupBudgetMilliseconds = std::atof(argv[i + 1]);
+			if (std::strcmp(argv[i], "--present") != 0) continue;
+			if (std::strcmp(argv[i + 1], "fifo") == 0) presentPolicy = lve::LvePresentPolicy::PowerSaving;
+			else if (std::strcmp(argv[i + 1], "immediate") == 0) presentPolicy = lve::LvePresentPolicy::Benchmark;
+		}
+
+		lve::FirstApp app{ presentPolicy };
+		if (startupBudgetMilliseconds > 0.0)
+		{
+			// --startup-budget <ms> renders one frame and fails when it came later than the budget, so
+			// the time-to-first-frame target can gate CI; the stage timings are in startup_trace.json
+			app.run(1);
+			double timeToFirstFrame = app.timeToFirstFrameMilliseconds();
+			std::cout << "time to first frame: " << timeToFirstFrame << " ms, budget " << startupBudgetMilliseconds << " ms" << std::endl;
+			if (timeToFirstFrame == 0.0 || timeToFirstFrame > startupBudgetMilliseconds)
+			{
+				std::cerr << "time to first frame is over the startup budget" << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		}
 		app.run();
 	}
 	catch (const std::exception &e)
@@ -0,0 +1,31 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// the storage buffer array of LveBindlessHeap, bound once for the whole frame
+layout (std430, set = 0, binding = 2) readonly buffer BindlessBuffer { uint data[]; } bindlessBuffers[];
+
+layout (push_constant) uniform Push
+{
+	uint object;  // handle of the object's buffer in the heap
+} push;
+
+layout (location = 0) out vec3 fragColor;
+
+vec2 positions[3] = vec2[] (
+	vec2(0.0, -0.5),
+	vec2(0.5, 0.5),
+	vec2(-0.5, 0.5)
+);
+
+float objectData(uint index)
+{
+	return uintBitsToFloat(bindlessBuffers[push.object].data[index]);
+}
+
+void main() 
+{
+	// xy offset and scale, then the color
+	vec2 offset = vec2(objectData(0), objectData(1));
+	gl_Position = vec4(offset + positions[gl_VertexIndex] * objectData(2), 0.5, 1.0);
+	fragColor = vec3(objectData(4), objectData(5), objectData(6));
+}
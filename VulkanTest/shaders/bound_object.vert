@@ -0,0 +1,25 @@
+#version 450
+
+// the object's own descriptor set, bound before each draw
+layout (std430, set = 0, binding = 0) readonly buffer ObjectBuffer { uint data[]; } object;
+
+layout (location = 0) out vec3 fragColor;
+
+vec2 positions[3] = vec2[] (
+	vec2(0.0, -0.5),
+	vec2(0.5, 0.5),
+	vec2(-0.5, 0.5)
+);
+
+float objectData(uint index)
+{
+	return uintBitsToFloat(object.data[index]);
+}
+
+void main() 
+{
+	// xy offset and scale, then the color
+	vec2 offset = vec2(objectData(0), objectData(1));
+	gl_Position = vec4(offset + positions[gl_VertexIndex] * objectData(2), 0.5, 1.0);
+	fragColor = vec3(objectData(4), objectData(5), objectData(6));
+}
@@ -0,0 +1,31 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+
+layout (location = 0) out vec3 fragColor;
+
+layout (std430, set = 0, binding = 0) readonly buffer TranslationScales { vec4 translationScales[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Rotations { vec4 rotations[]; };
+layout (std430, set = 0, binding = 2) readonly buffer MaterialIds { uint materialIds[]; };
+layout (std430, set = 0, binding = 3) readonly buffer MaterialColors { vec4 materialColors[]; };
+layout (std430, set = 0, binding = 4) readonly buffer VisibleInstances { uint visibleInstances[]; };
+
+layout (push_constant) uniform Push
+{
+	mat4 viewProjection;
+} push;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() 
+{
+	uint instance = visibleInstances[gl_InstanceIndex];
+	vec4 translationScale = translationScales[instance];
+	vec3 world = rotate(rotations[instance], position * translationScale.w) + translationScale.xyz;
+	gl_Position = push.viewProjection * vec4(world, 1.0);
+	fragColor = color * materialColors[materialIds[instance]].rgb;
+}
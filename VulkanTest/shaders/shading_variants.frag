@@ -0,0 +1,46 @@
+#version 450
+
+// -1 reads the value from the push constant and branches on it per fragment; a pipeline
+// specialised with other values has them baked in and the branches folded away
+layout (constant_id = 0) const int SHADING_MODEL = -1;  // 0 lambert, 1 blinn-phong, 2 toon
+layout (constant_id = 1) const int LIGHT_COUNT = -1;
+
+layout (location = 0) in vec2 uv;
+
+layout (location = 0) out vec4 outColor;
+
+layout (push_constant) uniform Push
+{
+	int shadingModel;
+	int lightCount;
+} push;
+
+void main() 
+{
+	int shadingModel = SHADING_MODEL >= 0 ? SHADING_MODEL : push.shadingModel;
+	int lightCount = LIGHT_COUNT >= 0 ? LIGHT_COUNT : push.lightCount;
+
+	vec3 normal = normalize(vec3(uv * 2.0 - 1.0, 1.0));
+	vec3 view = vec3(0.0, 0.0, 1.0);
+	vec3 color = vec3(0.0);
+	for (int i = 0; i < lightCount; i++)
+	{
+		float angle = float(i) * 0.7853982;
+		vec3 light = normalize(vec3(cos(angle), sin(angle), 1.0));
+		float diffuse = max(dot(normal, light), 0.0);
+		if (shadingModel == 0)
+		{
+			color += vec3(diffuse);
+		}
+		else if (shadingModel == 1)
+		{
+			float specular = pow(max(dot(normal, normalize(light + view)), 0.0), 64.0);
+			color += vec3(diffuse) + vec3(specular);
+		}
+		else
+		{
+			color += vec3(floor(diffuse * 4.0) / 4.0);
+		}
+	}
+	outColor = vec4(color / float(max(lightCount, 1)), 1.0);
+}
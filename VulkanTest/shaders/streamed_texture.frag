@@ -0,0 +1,12 @@
+#version 450
+
+// whichever levels LveTextureStreamer has resident; level 0 is the finest of them
+layout (set = 0, binding = 0) uniform sampler2D streamedTexture;
+
+layout (location = 0) in vec2 fragUv;
+
+layout (location = 0) out vec4 outColor;
+void main() 
+{
+	outColor = texture(streamedTexture, fragUv);
+}
@@ -0,0 +1,24 @@
+#version 450
+
+// the quad in normalized device coordinates: its top left corner, then its size
+layout (push_constant) uniform Push
+{
+	vec4 rect;
+} push;
+
+layout (location = 0) out vec2 fragUv;
+
+vec2 corners[6] = vec2[] (
+	vec2(0.0, 0.0),
+	vec2(1.0, 0.0),
+	vec2(1.0, 1.0),
+	vec2(1.0, 1.0),
+	vec2(0.0, 1.0),
+	vec2(0.0, 0.0)
+);
+
+void main() 
+{
+	fragUv = corners[gl_VertexIndex];
+	gl_Position = vec4(push.rect.xy + fragUv * push.rect.zw, 0.5, 1.0);
+}